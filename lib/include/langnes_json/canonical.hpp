@@ -0,0 +1,310 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/stream.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Orders member names by their UTF-16 code units. This is the byte order of
+// UTF-8 except that code points above U+FFFF, which become surrogate pairs,
+// sort before U+E000 to U+FFFF.
+inline bool utf16_less(string_ref a, string_ref b) noexcept {
+    auto length{std::min(a.size(), b.size())};
+    size_t i{};
+    while (i < length && a[i] == b[i]) {
+        ++i;
+    }
+    if (i == length) {
+        return a.size() < b.size();
+    }
+    auto x{static_cast<unsigned char>(a[i])};
+    auto y{static_cast<unsigned char>(b[i])};
+    // Lead bytes 0xee and 0xef start U+E000 to U+FFFF, and lead bytes from
+    // 0xf0 start code points above U+FFFF.
+    if (x >= 0xf0 && y >= 0xee && y < 0xf0) {
+        return true;
+    }
+    if (y >= 0xf0 && x >= 0xee && x < 0xf0) {
+        return false;
+    }
+    return x < y;
+}
+
+// Writes a number the way ECMAScript converts numbers to strings: the
+// shortest digits that convert back to the same double, in plain notation
+// for exponents from -7 up to 21 and in exponential notation otherwise.
+inline void write_canonical_number(std::ostream& os, double v) {
+    if (!std::isfinite(v)) {
+        throw invalid_argument{};
+    }
+    if (v == 0) {
+        os.put('0');
+        return;
+    }
+    if (std::trunc(v) == v && std::fabs(v) < 9007199254740992.0) {
+        os << static_cast<std::int64_t>(v);
+        return;
+    }
+    std::array<char, 32> buffer{};
+    // A normal double has at least 15 significant decimal digits, so the
+    // shortest representation is found by removing trailing zeros from one
+    // of these. Subnormal doubles can have fewer.
+    auto is_subnormal{std::fabs(v) < std::numeric_limits<double>::min()};
+    for (int precision{is_subnormal ? 0 : 14}; precision <= 16; ++precision) {
+        std::snprintf(buffer.data(), buffer.size(), "%.*e", precision, v);
+        if (std::strtod(buffer.data(), nullptr) == v) {
+            break;
+        }
+    }
+    // Split "-d.ddde-xx" into digits and an exponent.
+    std::array<char, 20> digits{};
+    int k{};
+    const auto* p{buffer.data()};
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (*p == '-') {
+        os.put('-');
+        ++p;
+    }
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') {
+            digits[static_cast<size_t>(k++)] = *p;
+        }
+    }
+    auto exponent{std::atoi(p + 1)};
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    while (k > 1 && digits[static_cast<size_t>(k - 1)] == '0') {
+        --k;
+    }
+    auto put_digits = [&](int first, int last) {
+        os.write(&digits[static_cast<size_t>(first)], last - first);
+    };
+    auto put_zeros = [&](int count) {
+        for (; count > 0; --count) {
+            os.put('0');
+        }
+    };
+    // The value is 0.digits * 10^n.
+    auto n{exponent + 1};
+    if (k <= n && n <= 21) {
+        put_digits(0, k);
+        put_zeros(n - k);
+    } else if (0 < n && n <= 21) {
+        put_digits(0, n);
+        os.put('.');
+        put_digits(n, k);
+    } else if (-6 < n && n <= 0) {
+        os << "0.";
+        put_zeros(-n);
+        put_digits(0, k);
+    } else {
+        put_digits(0, 1);
+        if (k > 1) {
+            os.put('.');
+            put_digits(1, k);
+        }
+        os << 'e' << (n - 1 < 0 ? '-' : '+') << std::abs(n - 1);
+    }
+}
+
+class canonical_writer {
+public:
+    explicit canonical_writer(std::ostream& os) noexcept : m_os{os} {}
+
+    void write(const value& v) {
+        using t = value::type;
+        switch (v.get_type()) {
+        case t::object:
+            write_object(dynamic_cast<const object_impl&>(v.impl()));
+            break;
+        case t::array: {
+            m_os.put('[');
+            const auto& array{dynamic_cast<const array_impl&>(v.impl())};
+            if (array.is_packed()) {
+                const auto& numbers{array.numbers()};
+                for (size_t i{}; i < numbers.size(); ++i) {
+                    if (i > 0) {
+                        m_os.put(',');
+                    }
+                    write_canonical_number(m_os, numbers[i]);
+                }
+            } else {
+                const auto& elements{array.elements()};
+                for (size_t i{}; i < elements.size(); ++i) {
+                    if (i > 0) {
+                        m_os.put(',');
+                    }
+                    write(elements[i]);
+                }
+            }
+            m_os.put(']');
+            break;
+        }
+        case t::string: {
+            const auto& s{v.as_string()};
+            write_escaped(m_os, s.data(), s.size());
+            break;
+        }
+        case t::number:
+            write_canonical_number(m_os, v.as_number());
+            break;
+        case t::boolean:
+            m_os << (v.as_boolean() ? "true" : "false");
+            break;
+        case t::null:
+            m_os << "null";
+            break;
+        }
+    }
+
+private:
+    using member = std::pair<const value::string_type*, const value*>;
+
+    void write_member(size_t index, string_ref name, const value& v) {
+        if (index > 0) {
+            m_os.put(',');
+        }
+        write_escaped(m_os, name.data(), name.size());
+        m_os.put(':');
+        write(v);
+    }
+
+    void write_object(const object_impl& object) {
+        m_os.put('{');
+        if (const auto* shape{object.shape()}) {
+            const auto& order{shape_order(*shape)};
+            for (size_t i{}; i < order.size(); ++i) {
+                write_member(i, (*shape)[order[i]],
+                             object.values()[order[i]]);
+            }
+            m_os.put('}');
+            return;
+        }
+        // Members of nested objects are sorted further along the same
+        // vector, which is truncated again afterwards.
+        auto first{m_members.size()};
+        for (const auto& kv : object.members()) {
+            m_members.emplace_back(&kv.first, &kv.second);
+        }
+        std::sort(m_members.begin() + static_cast<std::ptrdiff_t>(first),
+                  m_members.end(), [](const member& a, const member& b) {
+                      return utf16_less(*a.first, *b.first);
+                  });
+        for (auto i{first}; i < m_members.size(); ++i) {
+            auto m{m_members[i]};
+            write_member(i - first, *m.first, *m.second);
+        }
+        m_members.resize(first);
+        m_os.put('}');
+    }
+
+    // Objects with a shared shape share the sorted order of its names.
+    const std::vector<size_t>& shape_order(const object_shape& shape) {
+        auto& order{m_shape_orders[&shape]};
+        if (order.size() != shape.size()) {
+            order.resize(shape.size());
+            for (size_t i{}; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return utf16_less(shape[a], shape[b]);
+            });
+        }
+        return order;
+    }
+
+    std::ostream& m_os;
+    std::vector<member> m_members;
+    std::unordered_map<const object_shape*, std::vector<size_t>>
+        m_shape_orders;
+};
+
+} // namespace detail
+
+/**
+ * Saves a JSON value to a stream in the JSON Canonicalization Scheme
+ * (RFC 8785).
+ *
+ * Object members are sorted by the UTF-16 code units of their names,
+ * numbers are written as IEEE 754 doubles in the shortest form used by
+ * ECMAScript, and only the characters that JSON requires are escaped. The
+ * output is suitable as a cache key or as input to a signature.
+ *
+ * @param os The output stream.
+ * @param v The JSON value.
+ * @throw invalid_argument if a number is not finite.
+ */
+inline void save_canonical(std::ostream& os, const value& v) {
+    detail::canonical_writer{os}.write(v);
+}
+
+/**
+ * Saves a JSON value to a new string in the JSON Canonicalization Scheme
+ * (RFC 8785).
+ *
+ * @param v The JSON value.
+ * @return The saved JSON document.
+ * @throw invalid_argument if a number is not finite.
+ */
+inline std::string save_canonical(const value& v) {
+    std::ostringstream os{std::ios::binary};
+    save_canonical(os, v);
+    return os.str();
+}
+
+/**
+ * Saves a JSON value into a character array with a fixed length in the JSON
+ * Canonicalization Scheme (RFC 8785).
+ *
+ * The output is not null-terminated. If the saved JSON document is longer
+ * than the character array then the output is truncated.
+ *
+ * @param v The JSON value.
+ * @param data The output character array. May be null if @p length is zero.
+ * @param length The length of the output character array in bytes.
+ * @return The length of the saved JSON document in bytes.
+ * @throw invalid_argument if a number is not finite.
+ */
+inline size_t save_canonical(const value& v, char* data, size_t length) {
+    detail::buffer_streambuf buf{data, length};
+    std::ostream os{&buf};
+    save_canonical(os, v);
+    return buf.required_length();
+}
+
+LANGNES_JSON_CXX_NS_END
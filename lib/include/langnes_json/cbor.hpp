@@ -0,0 +1,535 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/binary.hpp"
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/parsing.hpp"
+#include "detail/stream.hpp"
+#include "detail/utf8.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "value.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+namespace cbor {
+
+enum major_type : std::uint8_t {
+    unsigned_integer,
+    negative_integer,
+    byte_string,
+    text_string,
+    array,
+    map,
+    tag,
+    simple
+};
+
+constexpr std::uint8_t indefinite{31};
+constexpr std::uint8_t break_code{0xff};
+
+} // namespace cbor
+
+// Converts a half-precision float.
+inline double half_to_double(std::uint16_t half) noexcept {
+    auto exponent{static_cast<int>((half >> 10U) & 0x1fU)};
+    auto mantissa{static_cast<int>(half & 0x3ffU)};
+    double result{};
+    if (exponent == 0) {
+        result = std::ldexp(mantissa, -24);
+    } else if (exponent == 31) {
+        result = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                               : std::numeric_limits<double>::quiet_NaN();
+    } else {
+        result = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    return (half & 0x8000U) != 0 ? -result : result;
+}
+
+// Converts a double to a half-precision float if that loses nothing.
+inline bool double_to_half(double v, std::uint16_t& result) noexcept {
+    if (std::isnan(v)) {
+        result = 0x7e00;
+        return true;
+    }
+    if (!is_exact_float(v)) {
+        return false;
+    }
+    auto bits{bits_of(static_cast<float>(v))};
+    auto sign{static_cast<std::uint16_t>((bits >> 16U) & 0x8000U)};
+    auto exponent{static_cast<int>((bits >> 23U) & 0xffU)};
+    auto mantissa{bits & 0x7fffffU};
+    if (exponent == 0xff) {
+        result = static_cast<std::uint16_t>(sign | 0x7c00U);
+        return true;
+    }
+    if (exponent == 0) {
+        result = sign;
+        return mantissa == 0;
+    }
+    exponent -= 127;
+    if (exponent >= -14 && exponent <= 15) {
+        result = static_cast<std::uint16_t>(
+            sign | static_cast<unsigned>(exponent + 15) << 10U |
+            mantissa >> 13U);
+        return (mantissa & 0x1fffU) == 0;
+    }
+    if (exponent >= -24 && exponent < -14) {
+        auto shift{static_cast<unsigned>(-1 - exponent)};
+        auto significand{mantissa | 0x800000U};
+        result = static_cast<std::uint16_t>(sign | significand >> shift);
+        return (significand & ((1U << shift) - 1)) == 0;
+    }
+    return false;
+}
+
+// Reads the initial byte of a data item, skipping tags, which have no
+// equivalent in JSON.
+inline std::uint8_t read_cbor_initial(byte_reader& reader);
+
+// Reads the argument that follows an initial byte. Returns false for an
+// indefinite length.
+inline bool read_cbor_argument(byte_reader& reader, std::uint8_t info,
+                               std::uint64_t& result) {
+    if (info < 24) {
+        result = info;
+        return true;
+    }
+    switch (info) {
+    case 24:
+        result = reader.get();
+        return true;
+    case 25:
+        result = reader.get_big_endian<std::uint16_t>();
+        return true;
+    case 26:
+        result = reader.get_big_endian<std::uint32_t>();
+        return true;
+    case 27:
+        result = reader.get_big_endian<std::uint64_t>();
+        return true;
+    case cbor::indefinite:
+        return false;
+    default:
+        throw parsing::unexpected_token{};
+    }
+}
+
+inline std::uint64_t read_cbor_definite_argument(byte_reader& reader,
+                                                 std::uint8_t info) {
+    std::uint64_t result{};
+    if (!read_cbor_argument(reader, info, result)) {
+        throw parsing::unexpected_token{};
+    }
+    return result;
+}
+
+inline std::uint8_t read_cbor_initial(byte_reader& reader) {
+    auto initial{reader.get()};
+    while (initial >> 5U == cbor::tag) {
+        read_cbor_definite_argument(reader, initial & 0x1fU);
+        initial = reader.get();
+    }
+    return initial;
+}
+
+// Reads a byte or text string, which may be split into chunks of the same
+// type. Each chunk of a text string must be valid UTF-8 on its own (RFC 8949
+// section 3.2.3).
+template<typename String>
+void read_cbor_string(byte_reader& reader, const parse_context& ctx,
+                      std::uint8_t major, std::uint8_t info, String& result) {
+    std::uint64_t length{};
+    if (read_cbor_argument(reader, info, length)) {
+        check_string_length(ctx, result.size() + length);
+        auto offset{result.size()};
+        reader.append_string(result, length);
+        if (major == cbor::text_string &&
+            !is_valid_utf8(&result[offset], result.size() - offset)) {
+            throw parse_error{"Invalid UTF-8"};
+        }
+        return;
+    }
+    while (reader.peek() != cbor::break_code) {
+        auto initial{reader.get()};
+        auto chunk_info{static_cast<std::uint8_t>(initial & 0x1fU)};
+        if (initial >> 5U != major || chunk_info == cbor::indefinite) {
+            throw parsing::unexpected_token{};
+        }
+        read_cbor_string(reader, ctx, major, chunk_info, result);
+    }
+    reader.get();
+}
+
+inline value decode_cbor(byte_reader& reader, parse_context& ctx);
+
+inline value decode_cbor_array(byte_reader& reader, parse_context& ctx,
+                               std::uint8_t info) {
+    enter_nesting(ctx);
+    value::array_type elements;
+    std::uint64_t length{};
+    if (read_cbor_argument(reader, info, length)) {
+        elements.reserve(reader.reservable(length));
+        for (std::uint64_t i{}; i < length; ++i) {
+            elements.push_back(decode_cbor(reader, ctx));
+        }
+    } else {
+        while (reader.peek() != cbor::break_code) {
+            elements.push_back(decode_cbor(reader, ctx));
+        }
+        reader.get();
+    }
+    leave_nesting(ctx);
+    return make_array(std::move(elements));
+}
+
+inline value decode_cbor_map(byte_reader& reader, parse_context& ctx,
+                             std::uint8_t info) {
+    enter_nesting(ctx);
+    object_impl object;
+    auto first{ctx.elements.size()};
+    auto first_name{ctx.names.size()};
+    auto decode_member = [&] {
+        auto initial{read_cbor_initial(reader)};
+        if (initial >> 5U != cbor::text_string) {
+            throw parsing::unexpected_token{};
+        }
+        value::string_type name;
+        read_cbor_string(reader, ctx, cbor::text_string, initial & 0x1fU,
+                         name);
+        auto member_value{decode_cbor(reader, ctx)};
+        add_member(ctx, object, std::move(name), std::move(member_value));
+    };
+    std::uint64_t length{};
+    if (read_cbor_argument(reader, info, length)) {
+        if (!ctx.options.share_object_shapes) {
+            // Every member takes at least two bytes.
+            object.members().reserve(reader.reservable(length, 2));
+        }
+        for (std::uint64_t i{}; i < length; ++i) {
+            decode_member();
+        }
+    } else {
+        while (reader.peek() != cbor::break_code) {
+            decode_member();
+        }
+        reader.get();
+    }
+    leave_nesting(ctx);
+    return finish_object(ctx, std::move(object), first_name, first);
+}
+
+inline value decode_cbor_simple(byte_reader& reader, std::uint8_t info) {
+    switch (info) {
+    case 20:
+        return value{make_unique<boolean_impl>(false)};
+    case 21:
+        return value{make_unique<boolean_impl>(true)};
+    case 24:
+        // Other simple values, like undefined, have no JSON equivalent.
+        reader.get();
+        return value{make_unique<null_impl>()};
+    case 25:
+        return make_float_value(
+            half_to_double(reader.get_big_endian<std::uint16_t>()));
+    case 26:
+        return make_float_value(
+            float_from_bits(reader.get_big_endian<std::uint32_t>()));
+    case 27:
+        return make_float_value(
+            double_from_bits(reader.get_big_endian<std::uint64_t>()));
+    default:
+        if (info < 24) {
+            return value{make_unique<null_impl>()};
+        }
+        throw parsing::unexpected_token{};
+    }
+}
+
+inline value decode_cbor(byte_reader& reader, parse_context& ctx) {
+    auto initial{read_cbor_initial(reader)};
+    auto info{static_cast<std::uint8_t>(initial & 0x1fU)};
+    switch (initial >> 5U) {
+    case cbor::unsigned_integer:
+        return value{make_unique<number_impl>(
+            read_cbor_definite_argument(reader, info))};
+    case cbor::negative_integer: {
+        // The value is -1 - argument.
+        auto argument{read_cbor_definite_argument(reader, info)};
+        if (argument > static_cast<std::uint64_t>(
+                           std::numeric_limits<std::int64_t>::max())) {
+            return value{make_unique<number_impl>(
+                -1.0 - static_cast<double>(argument))};
+        }
+        return value{make_unique<number_impl>(
+            -1 - static_cast<std::int64_t>(argument))};
+    }
+    case cbor::byte_string: {
+        std::string bytes;
+        read_cbor_string(reader, ctx, cbor::byte_string, info, bytes);
+        return value{make_unique<string_impl>(to_base64url(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<const std::uint8_t*>(bytes.data()),
+            bytes.size()))};
+    }
+    case cbor::text_string: {
+        value::string_type s;
+        read_cbor_string(reader, ctx, cbor::text_string, info, s);
+        return value{make_unique<string_impl>(std::move(s))};
+    }
+    case cbor::array:
+        return decode_cbor_array(reader, ctx, info);
+    case cbor::map:
+        return decode_cbor_map(reader, ctx, info);
+    default:
+        return decode_cbor_simple(reader, info);
+    }
+}
+
+inline void write_cbor_head(byte_writer& writer, std::uint8_t major,
+                            std::uint64_t argument) {
+    auto m{static_cast<std::uint8_t>(major << 5U)};
+    if (argument < 24) {
+        writer.put(static_cast<std::uint8_t>(m | argument));
+    } else if (argument <= 0xffU) {
+        writer.put(m | 24U);
+        writer.put(static_cast<std::uint8_t>(argument));
+    } else if (argument <= 0xffffU) {
+        writer.put(m | 25U);
+        writer.put_big_endian(static_cast<std::uint16_t>(argument));
+    } else if (argument <= 0xffffffffU) {
+        writer.put(m | 26U);
+        writer.put_big_endian(static_cast<std::uint32_t>(argument));
+    } else {
+        writer.put(m | 27U);
+        writer.put_big_endian(argument);
+    }
+}
+
+inline void write_cbor_integer(byte_writer& writer, std::int64_t v) {
+    if (v >= 0) {
+        write_cbor_head(writer, cbor::unsigned_integer,
+                        static_cast<std::uint64_t>(v));
+    } else {
+        write_cbor_head(writer, cbor::negative_integer,
+                        static_cast<std::uint64_t>(-(v + 1)));
+    }
+}
+
+// Writes integers like write_number() and other numbers as the shortest
+// float that holds them exactly.
+inline void write_cbor_number(byte_writer& writer, double v) {
+    if (is_integral_double(v)) {
+        write_cbor_integer(writer, static_cast<std::int64_t>(v));
+        return;
+    }
+    std::uint16_t half{};
+    if (double_to_half(v, half)) {
+        writer.put(0xf9);
+        writer.put_big_endian(half);
+    } else if (is_exact_float(v)) {
+        writer.put(0xfa);
+        writer.put_big_endian(bits_of(static_cast<float>(v)));
+    } else {
+        writer.put(0xfb);
+        writer.put_big_endian(bits_of(v));
+    }
+}
+
+inline void write_cbor_number(byte_writer& writer, const number_impl& v) {
+    std::int64_t i{};
+    std::uint64_t u{};
+    switch (v.get_kind()) {
+    case number_impl::kind::int64:
+        v.to_int64(i);
+        write_cbor_integer(writer, i);
+        break;
+    case number_impl::kind::uint64:
+        v.to_uint64(u);
+        write_cbor_head(writer, cbor::unsigned_integer, u);
+        break;
+    default:
+        write_cbor_number(writer, v.data());
+    }
+}
+
+inline void write_cbor_string(byte_writer& writer, string_ref s) {
+    write_cbor_head(writer, cbor::text_string, s.size());
+    writer.write(s.data(), s.size());
+}
+
+inline void to_cbor(byte_writer& writer, const value& v) {
+    using t = value::type;
+    switch (v.get_type()) {
+    case t::object: {
+        const auto& object{dynamic_cast<const object_impl&>(v.impl())};
+        write_cbor_head(writer, cbor::map, object.size());
+        if (const auto* shape{object.shape()}) {
+            for (size_t i{}; i < shape->size(); ++i) {
+                write_cbor_string(writer, (*shape)[i]);
+                to_cbor(writer, object.values()[i]);
+            }
+            break;
+        }
+        // Members are written in insertion order.
+        const auto& members{object.members()};
+        for (size_t i{}; i < members.size(); ++i) {
+            const auto& member{members.entry_at(i)};
+            write_cbor_string(writer, member.first);
+            to_cbor(writer, member.second);
+        }
+        break;
+    }
+    case t::array: {
+        const auto& array{dynamic_cast<const array_impl&>(v.impl())};
+        if (array.is_packed()) {
+            write_cbor_head(writer, cbor::array, array.numbers().size());
+            for (auto number : array.numbers()) {
+                write_cbor_number(writer, number);
+            }
+            break;
+        }
+        write_cbor_head(writer, cbor::array, array.elements().size());
+        for (const auto& element : array.elements()) {
+            to_cbor(writer, element);
+        }
+        break;
+    }
+    case t::string:
+        write_cbor_string(writer, v.as_string());
+        break;
+    case t::boolean:
+        writer.put(v.as_boolean() ? 0xf5 : 0xf4);
+        break;
+    case t::null:
+        writer.put(0xf6);
+        break;
+    case t::number:
+        write_cbor_number(writer, dynamic_cast<const number_impl&>(v.impl()));
+        break;
+    default:
+        throw invalid_state{"Unexpected value type"};
+    }
+}
+
+} // namespace detail
+
+/**
+ * Loads a JSON value from CBOR (RFC 8949).
+ *
+ * Data items are converted as described in RFC 8949 section 6.1: tags are
+ * ignored, byte strings become base64url strings, and infinity, NaN and
+ * simple values other than booleans become null. Map keys must be text
+ * strings. Containers are allocated once using the length in their header.
+ * Text strings must be valid UTF-8.
+ *
+ * @param data The CBOR data.
+ * @param length The length of the data in bytes.
+ * @param options Options for loading. The limits, object shape sharing
+ * and memory resource apply. The nesting depth is limited to 1000 unless
+ * another limit is set.
+ * @return The JSON value.
+ * @throw parse_error if the data is malformed or has trailing bytes.
+ */
+inline value load_cbor(const std::uint8_t* data, size_t length,
+                       const parse_options& options = {}) {
+    detail::byte_reader reader{data, length};
+    scoped_resource scope{options.resource};
+    detail::parse_context ctx{detail::with_binary_depth_limit(options)};
+    auto result{detail::decode_cbor(reader, ctx)};
+    if (!reader.at_end()) {
+        throw detail::parsing::unexpected_token{};
+    }
+    return result;
+}
+
+/**
+ * Loads a JSON value from CBOR (RFC 8949).
+ *
+ * @param data The CBOR data.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @throw parse_error if the data is malformed or has trailing bytes.
+ * @see load_cbor(const std::uint8_t*, size_t, const parse_options&)
+ */
+inline value load_cbor(const std::vector<std::uint8_t>& data,
+                       const parse_options& options = {}) {
+    return load_cbor(data.data(), data.size(), options);
+}
+
+/**
+ * Saves a JSON value as CBOR (RFC 8949) to a stream.
+ *
+ * Containers have definite lengths, integers use the shortest encoding and
+ * other numbers use the shortest float that holds them exactly.
+ *
+ * @param os The output stream.
+ * @param v The JSON value.
+ */
+inline void save_cbor(std::ostream& os, const value& v) {
+    detail::byte_writer writer{os};
+    detail::to_cbor(writer, v);
+}
+
+/**
+ * Saves a JSON value as CBOR (RFC 8949).
+ *
+ * @param v The JSON value.
+ * @return The CBOR data.
+ */
+inline std::vector<std::uint8_t> save_cbor(const value& v) {
+    std::vector<std::uint8_t> result;
+    detail::vector_streambuf buf{result};
+    std::ostream os{&buf};
+    save_cbor(os, v);
+    return result;
+}
+
+/**
+ * Saves a JSON value as CBOR (RFC 8949) into a byte array with a fixed
+ * length.
+ *
+ * If the CBOR data is longer than the byte array then the output is
+ * truncated.
+ *
+ * @param v The JSON value.
+ * @param data The output byte array. May be null if @p length is zero.
+ * @param length The length of the output byte array in bytes.
+ * @return The length of the CBOR data in bytes.
+ */
+inline size_t save_cbor(const value& v, std::uint8_t* data, size_t length) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    detail::buffer_streambuf buf{reinterpret_cast<char*>(data), length};
+    std::ostream os{&buf};
+    save_cbor(os, v);
+    return buf.required_length();
+}
+
+LANGNES_JSON_CXX_NS_END
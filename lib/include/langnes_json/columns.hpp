@@ -0,0 +1,328 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/parallel.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+/**
+ * Type of the values in a column.
+ */
+enum class column_type {
+    /// Every value is null or missing.
+    null,
+    /// Booleans, bit-packed in column::boolean_values.
+    boolean,
+    /// Integers in column::int64_values.
+    int64,
+    /// Numbers in column::float64_values.
+    float64,
+    /// Strings in column::offsets and column::string_data.
+    string,
+    /// JSON text of objects, arrays and values of mixed types, stored like
+    /// strings. Also used for integers beyond the range of int64 mixed with
+    /// negative or fractional numbers, which no other type holds exactly.
+    json,
+    /// Non-negative integers in column::uint64_values, used if some are
+    /// beyond the range of int64.
+    uint64
+};
+
+/**
+ * Values of one object member across an array of objects, laid out like
+ * an Apache Arrow array.
+ *
+ * Bitmaps have one bit per row, least significant bit first. Rows that are
+ * null or missing have their validity bit cleared and hold a zero or empty
+ * value.
+ */
+struct column {
+    /// Member name.
+    std::string name;
+    /// Type of the values.
+    column_type type{column_type::null};
+    /// Number of rows.
+    size_t length{};
+    /// Number of null or missing values.
+    size_t null_count{};
+    /// Validity bitmap, or empty if there are no null values.
+    std::vector<std::uint8_t> validity;
+    /// Bit-packed booleans.
+    std::vector<std::uint8_t> boolean_values;
+    /// Integers.
+    std::vector<std::int64_t> int64_values;
+    /// Non-negative integers.
+    std::vector<std::uint64_t> uint64_values;
+    /// Floating-point numbers.
+    std::vector<double> float64_values;
+    /// Offsets of the strings in string_data, with length + 1 entries.
+    std::vector<std::int64_t> offsets;
+    /// UTF-8 data of the strings.
+    std::string string_data;
+};
+
+namespace detail {
+
+inline void set_bit(std::vector<std::uint8_t>& bits, size_t index) noexcept {
+    bits[index / 8] = static_cast<std::uint8_t>(bits[index / 8] |
+                                                (1U << (index % 8)));
+}
+
+// Finds a member in each row, looking up the member index once per shape.
+class column_member_finder {
+public:
+    explicit column_member_finder(const std::string& name) noexcept
+        : m_name{name} {}
+
+    const value* find(const value& row) {
+        const auto& object{dynamic_cast<const object_impl&>(row.impl())};
+        if (const auto* shape{object.shape()}) {
+            if (shape != m_shape) {
+                m_shape = shape;
+                m_index = shape->find(m_name);
+            }
+            return m_index == object_shape::npos ? nullptr
+                                                 : &object.values()[m_index];
+        }
+        return object.find(m_name);
+    }
+
+private:
+    const std::string& m_name;
+    const object_shape* m_shape{};
+    size_t m_index{object_shape::npos};
+};
+
+// Finds the narrowest column type that holds every value.
+inline column_type infer_column_type(const std::vector<const value*>& cells) {
+    bool has_boolean{};
+    bool has_int64{};
+    bool has_negative{};
+    bool has_uint64{};
+    bool has_float64{};
+    bool has_string{};
+    bool has_other{};
+    for (const auto* cell : cells) {
+        if (!cell) {
+            continue;
+        }
+        switch (cell->get_type()) {
+        case value::type::null:
+            break;
+        case value::type::boolean:
+            has_boolean = true;
+            break;
+        case value::type::number: {
+            const auto& number{dynamic_cast<const number_impl&>(cell->impl())};
+            switch (number.get_kind()) {
+            case number_impl::kind::int64:
+                has_int64 = true;
+                has_negative = has_negative || number.data() < 0;
+                break;
+            case number_impl::kind::uint64:
+                has_uint64 = true;
+                break;
+            default:
+                has_float64 = true;
+            }
+            break;
+        }
+        case value::type::string:
+            has_string = true;
+            break;
+        default:
+            has_other = true;
+        }
+    }
+    auto has_number{has_int64 || has_uint64 || has_float64};
+    auto kinds{static_cast<int>(has_boolean) + static_cast<int>(has_number) +
+               static_cast<int>(has_string) + static_cast<int>(has_other)};
+    if (kinds == 0) {
+        return column_type::null;
+    }
+    if (kinds > 1 || has_other ||
+        (has_uint64 && (has_negative || has_float64))) {
+        return column_type::json;
+    }
+    if (has_boolean) {
+        return column_type::boolean;
+    }
+    if (has_string) {
+        return column_type::string;
+    }
+    if (has_float64) {
+        return column_type::float64;
+    }
+    return has_uint64 ? column_type::uint64 : column_type::int64;
+}
+
+inline void fill_column(column& result,
+                        const std::vector<const value*>& cells) {
+    auto length{cells.size()};
+    auto bitmap_size{(length + 7) / 8};
+    result.length = length;
+    result.type = infer_column_type(cells);
+    std::vector<std::uint8_t> validity(bitmap_size);
+    switch (result.type) {
+    case column_type::boolean:
+        result.boolean_values.resize(bitmap_size);
+        break;
+    case column_type::int64:
+        result.int64_values.resize(length);
+        break;
+    case column_type::uint64:
+        result.uint64_values.resize(length);
+        break;
+    case column_type::float64:
+        result.float64_values.resize(length);
+        break;
+    case column_type::string:
+    case column_type::json:
+        result.offsets.reserve(length + 1);
+        result.offsets.push_back(0);
+        break;
+    default:
+        break;
+    }
+    std::ostringstream os{std::ios::binary};
+    for (size_t row{}; row < length; ++row) {
+        const auto* cell{cells[row]};
+        auto is_valid{cell && !cell->is_null()};
+        if (is_valid) {
+            set_bit(validity, row);
+        } else {
+            ++result.null_count;
+        }
+        switch (result.type) {
+        case column_type::boolean:
+            if (is_valid && cell->as_boolean()) {
+                set_bit(result.boolean_values, row);
+            }
+            break;
+        case column_type::int64:
+            if (is_valid) {
+                result.int64_values[row] = cell->as_int64();
+            }
+            break;
+        case column_type::uint64:
+            if (is_valid) {
+                result.uint64_values[row] = cell->as_uint64();
+            }
+            break;
+        case column_type::float64:
+            if (is_valid) {
+                result.float64_values[row] = cell->as_number();
+            }
+            break;
+        case column_type::string:
+            if (is_valid) {
+                const auto& s{cell->as_string()};
+                result.string_data.append(s.data(), s.size());
+            }
+            result.offsets.push_back(
+                static_cast<std::int64_t>(result.string_data.size()));
+            break;
+        case column_type::json:
+            if (is_valid) {
+                os.str({});
+                to_json(os, *cell);
+                result.string_data += os.str();
+            }
+            result.offsets.push_back(
+                static_cast<std::int64_t>(result.string_data.size()));
+            break;
+        default:
+            break;
+        }
+    }
+    if (result.null_count > 0) {
+        result.validity = std::move(validity);
+    }
+}
+
+} // namespace detail
+
+/**
+ * Converts an array of objects such as database rows into one column per
+ * member name. Columns are filled in parallel when there are enough cells to
+ * give each thread at least 8192, and on the calling thread otherwise.
+ *
+ * @param rows The array of objects.
+ * @param max_threads The maximum number of threads, or 0 for one per
+ * hardware thread.
+ * @return The columns in order of the first appearance of each member name.
+ * @throw bad_access if the value is not an array of objects.
+ */
+inline std::vector<column> to_columns(const value& rows,
+                                      size_t max_threads = 0) {
+    using namespace detail;
+    const auto& elements{rows.as_array()};
+    std::vector<std::string> names;
+    std::unordered_map<std::string, size_t> indices;
+    auto add_name = [&](string_ref name) {
+        if (indices.emplace(name.str(), names.size()).second) {
+            names.push_back(name.str());
+        }
+    };
+    const object_shape* last_shape{};
+    for (const auto& row : elements) {
+        if (!row.is_object()) {
+            throw bad_access{};
+        }
+        const auto& object{dynamic_cast<const object_impl&>(row.impl())};
+        if (const auto* shape{object.shape()}) {
+            if (shape != last_shape) {
+                last_shape = shape;
+                for (const auto& name : *shape) {
+                    add_name(name);
+                }
+            }
+            continue;
+        }
+        const auto& members{object.members()};
+        for (size_t i{}; i < members.size(); ++i) {
+            add_name(members.entry_at(i).first);
+        }
+    }
+    std::vector<column> result(names.size());
+    parallel_for(names.size(), elements.size(), max_threads, [&](size_t index) {
+        auto& target{result[index]};
+        target.name = names[index];
+        column_member_finder finder{target.name};
+        std::vector<const value*> cells;
+        cells.reserve(elements.size());
+        for (const auto& row : elements) {
+            cells.push_back(finder.find(row));
+        }
+        fill_column(target, cells);
+    });
+    return result;
+}
+
+LANGNES_JSON_CXX_NS_END
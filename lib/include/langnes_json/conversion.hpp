@@ -0,0 +1,439 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/type_traits.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "fields.hpp"
+#include "value.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+template<typename Value>
+using is_value = std::is_same<remove_cvref_t<Value>, value>;
+
+template<typename Value, typename T>
+using forwarded_t =
+    typename std::conditional<std::is_lvalue_reference<Value>::value,
+                              const T&, T&&>::type;
+
+// Casts part of a value to an rvalue unless the value is an lvalue, so that
+// contents are moved out of rvalues.
+template<typename Value, typename T>
+forwarded_t<Value, T> forward_like(T& v) noexcept {
+    return static_cast<forwarded_t<Value, T>>(v);
+}
+
+inline value make_array_value(size_t capacity) {
+    value result{make_unique<array_impl>()};
+    result.as_array().reserve(capacity);
+    return result;
+}
+
+inline value make_object_value(size_t capacity) {
+    value result{make_unique<object_impl>()};
+    result.as_object().reserve(capacity);
+    return result;
+}
+
+// Floating-point numbers are stored as a packed array.
+template<typename Container>
+value sequence_to_value(const Container& in, std::true_type /*packed*/) {
+    return value{make_unique<array_impl>(
+        array_impl::number_array_type(in.begin(), in.end()))};
+}
+
+template<typename Container>
+value sequence_to_value(const Container& in, std::false_type /*packed*/) {
+    auto result{make_array_value(in.size())};
+    auto& elements{result.as_array()};
+    for (const auto& element : in) {
+        elements.emplace_back(element);
+    }
+    return result;
+}
+
+template<typename T, typename Allocator>
+bool read_packed(const value& in, std::vector<T, Allocator>& out,
+                 std::true_type /*packable*/) {
+    if (!in.is_array()) {
+        return false;
+    }
+    const auto& array{dynamic_cast<const array_impl&>(in.impl())};
+    if (!array.is_packed()) {
+        return false;
+    }
+    out.assign(array.numbers().begin(), array.numbers().end());
+    return true;
+}
+
+template<typename T, typename Allocator>
+bool read_packed(const value& /*in*/, std::vector<T, Allocator>& /*out*/,
+                 std::false_type /*packable*/) {
+    return false;
+}
+
+template<typename Container>
+value map_to_value(const Container& in) {
+    auto result{make_object_value(in.size())};
+    auto& members{result.as_object()};
+    for (const auto& member : in) {
+        members.emplace(string_ref{member.first}, value{member.second});
+    }
+    return result;
+}
+
+template<typename Value, typename Container>
+void value_to_map(Value&& in, Container& out) {
+    using key_type = typename Container::key_type;
+    using mapped_type = typename Container::mapped_type;
+    out.clear();
+    for (auto&& member : in.as_object()) {
+        out.emplace(key_type(member.first.begin(), member.first.end()),
+                    forward_like<Value>(member.second)
+                        .template get<mapped_type>());
+    }
+}
+
+template<size_t I = 0, typename Tuple,
+         enable_if_t<I == std::tuple_size<Tuple>::value>* = nullptr>
+void tuple_to_elements(const Tuple& /*in*/, value::array_type& /*out*/) {}
+
+template<size_t I = 0, typename Tuple,
+         enable_if_t<(I < std::tuple_size<Tuple>::value)>* = nullptr>
+void tuple_to_elements(const Tuple& in, value::array_type& out) {
+    out.emplace_back(std::get<I>(in));
+    tuple_to_elements<I + 1>(in, out);
+}
+
+template<size_t I = 0, typename Value, typename Elements, typename Tuple,
+         enable_if_t<I == std::tuple_size<Tuple>::value>* = nullptr>
+void elements_to_tuple(Elements& /*in*/, Tuple& /*out*/) {}
+
+template<size_t I = 0, typename Value, typename Elements, typename Tuple,
+         enable_if_t<(I < std::tuple_size<Tuple>::value)>* = nullptr>
+void elements_to_tuple(Elements& in, Tuple& out) {
+    using element_type = typename std::tuple_element<I, Tuple>::type;
+    std::get<I>(out) =
+        forward_like<Value>(in[I]).template get<element_type>();
+    elements_to_tuple<I + 1, Value>(in, out);
+}
+
+template<typename Value, typename Tuple>
+void value_to_tuple(Value&& in, Tuple& out) {
+    auto&& elements{in.as_array()};
+    if (elements.size() != std::tuple_size<Tuple>::value) {
+        throw out_of_range{"Array length does not match"};
+    }
+    elements_to_tuple<0, Value>(elements, out);
+}
+
+struct field_counter {
+    template<size_t N, typename Field>
+    void operator()(const char (&/*name*/)[N],
+                    const Field& /*field*/) noexcept {
+        ++count;
+    }
+
+    size_t count{};
+};
+
+struct field_converter {
+    explicit field_converter(value::object_type& members) noexcept
+        : members{members} {}
+
+    template<size_t N, typename Field>
+    void operator()(const char (&name)[N], const Field& field) {
+        members.emplace(string_ref{name, N - 1}, value{field});
+    }
+
+    value::object_type& members;
+};
+
+template<typename Value>
+struct field_extractor {
+    using object_ref = typename std::remove_reference<Value>::type&;
+
+    explicit field_extractor(object_ref object) noexcept : object{object} {}
+
+    // Fields without a matching member keep their values.
+    template<size_t N, typename Field>
+    void operator()(const char (&name)[N], Field& field) {
+        if (auto* found{object.find_member(string_ref{name, N - 1})}) {
+            field = forward_like<Value>(*found).template get<Field>();
+        }
+    }
+
+    object_ref object;
+};
+
+} // namespace detail
+
+/**
+ * @name Conversions
+ *
+ * Overloads of the to_json() and from_json() customization points for
+ * standard types and structs registered with LANGNES_JSON_FIELDS. Other
+ * types can be converted by declaring these functions in the namespace of
+ * the type:
+ *
+ *     void to_json(value& out, const T& in);
+ *     void from_json(const value& in, T& out);
+ *
+ * @{
+ */
+
+inline void from_json(const value& in, bool& out) { out = in.as_boolean(); }
+
+template<typename T,
+         detail::enable_if_t<std::is_integral<T>::value &&
+                             std::is_signed<T>::value>* = nullptr>
+void from_json(const value& in, T& out) {
+    auto result{in.as_int64()};
+    if (result < std::numeric_limits<T>::min() ||
+        result > std::numeric_limits<T>::max()) {
+        throw out_of_range{"Number is out of range for the target type"};
+    }
+    out = static_cast<T>(result);
+}
+
+template<typename T,
+         detail::enable_if_t<std::is_integral<T>::value &&
+                             std::is_unsigned<T>::value &&
+                             !std::is_same<T, bool>::value>* = nullptr>
+void from_json(const value& in, T& out) {
+    auto result{in.as_uint64()};
+    if (result > std::numeric_limits<T>::max()) {
+        throw out_of_range{"Number is out of range for the target type"};
+    }
+    out = static_cast<T>(result);
+}
+
+template<typename T, detail::enable_if_t<
+                         std::is_floating_point<T>::value>* = nullptr>
+void from_json(const value& in, T& out) {
+    out = static_cast<T>(in.as_number());
+}
+
+template<typename Value,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, std::string& out) {
+    const auto& s{in.as_string()};
+    out.assign(s.data(), s.size());
+}
+
+template<typename Value,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, value::string_type& out) {
+    out = detail::forward_like<Value>(in.as_string());
+}
+
+template<typename Value,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, value& out) {
+    out = std::forward<Value>(in);
+}
+
+template<typename T, typename Allocator,
+         detail::enable_if_t<std::is_constructible<value, const T&>::value>* =
+             nullptr>
+void to_json(value& out, const std::vector<T, Allocator>& in) {
+    out = detail::sequence_to_value(in, std::is_floating_point<T>{});
+}
+
+template<typename Value, typename T, typename Allocator,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, std::vector<T, Allocator>& out) {
+    if (detail::read_packed(in, out, std::is_floating_point<T>{})) {
+        return;
+    }
+    auto&& elements{in.as_array()};
+    out.clear();
+    out.reserve(elements.size());
+    for (auto&& element : elements) {
+        out.push_back(
+            detail::forward_like<Value>(element).template get<T>());
+    }
+}
+
+template<typename T, size_t N,
+         detail::enable_if_t<std::is_constructible<value, const T&>::value>* =
+             nullptr>
+void to_json(value& out, const std::array<T, N>& in) {
+    out = detail::sequence_to_value(in, std::is_floating_point<T>{});
+}
+
+template<typename Value, typename T, size_t N,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, std::array<T, N>& out) {
+    auto&& elements{in.as_array()};
+    if (elements.size() != N) {
+        throw out_of_range{"Array length does not match"};
+    }
+    for (size_t i{}; i < N; ++i) {
+        out[i] = detail::forward_like<Value>(elements[i]).template get<T>();
+    }
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator,
+         detail::enable_if_t<
+             std::is_constructible<std::string, const Key&>::value &&
+             std::is_constructible<value, const T&>::value>* = nullptr>
+void to_json(value& out, const std::map<Key, T, Compare, Allocator>& in) {
+    out = detail::map_to_value(in);
+}
+
+template<typename Value, typename Key, typename T, typename Compare,
+         typename Allocator,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, std::map<Key, T, Compare, Allocator>& out) {
+    detail::value_to_map(std::forward<Value>(in), out);
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual,
+         typename Allocator,
+         detail::enable_if_t<
+             std::is_constructible<std::string, const Key&>::value &&
+             std::is_constructible<value, const T&>::value>* = nullptr>
+void to_json(value& out,
+             const std::unordered_map<Key, T, Hash, KeyEqual, Allocator>& in) {
+    out = detail::map_to_value(in);
+}
+
+template<typename Value, typename Key, typename T, typename Hash,
+         typename KeyEqual, typename Allocator,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in,
+               std::unordered_map<Key, T, Hash, KeyEqual, Allocator>& out) {
+    out.reserve(in.as_object().size());
+    detail::value_to_map(std::forward<Value>(in), out);
+}
+
+template<typename T1, typename T2,
+         detail::enable_if_t<
+             std::is_constructible<value, const T1&>::value &&
+             std::is_constructible<value, const T2&>::value>* = nullptr>
+void to_json(value& out, const std::pair<T1, T2>& in) {
+    out = detail::make_array_value(2);
+    detail::tuple_to_elements(in, out.as_array());
+}
+
+template<typename Value, typename T1, typename T2,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, std::pair<T1, T2>& out) {
+    detail::value_to_tuple(std::forward<Value>(in), out);
+}
+
+template<typename... Ts,
+         detail::enable_if_t<detail::all_true<
+             std::is_constructible<value, const Ts&>::value...>::value>* =
+             nullptr>
+void to_json(value& out, const std::tuple<Ts...>& in) {
+    out = detail::make_array_value(sizeof...(Ts));
+    detail::tuple_to_elements(in, out.as_array());
+}
+
+template<typename Value, typename... Ts,
+         detail::enable_if_t<detail::is_value<Value>::value>* = nullptr>
+void from_json(Value&& in, std::tuple<Ts...>& out) {
+    detail::value_to_tuple(std::forward<Value>(in), out);
+}
+
+template<typename T,
+         detail::enable_if_t<
+             detail::is_optional_like<T>::value &&
+             std::is_constructible<value,
+                                   const typename T::value_type&>::value>* =
+             nullptr>
+void to_json(value& out, const T& in) {
+    if (in.has_value()) {
+        out = value{*in};
+    } else {
+        out = nullptr;
+    }
+}
+
+template<typename Value, typename T,
+         detail::enable_if_t<detail::is_value<Value>::value &&
+                             detail::is_optional_like<T>::value>* = nullptr>
+void from_json(Value&& in, T& out) {
+    if (in.is_null()) {
+        out.reset();
+        return;
+    }
+    out.emplace();
+    *out = std::forward<Value>(in).template get<typename T::value_type>();
+}
+
+template<typename T,
+         detail::enable_if_t<detail::has_fields<T>::value>* = nullptr>
+void to_json(value& out, const T& in) {
+    detail::field_counter counter;
+    langnes_json_fields(in, counter);
+    out = detail::make_object_value(counter.count);
+    detail::field_converter converter{out.as_object()};
+    langnes_json_fields(in, converter);
+}
+
+template<typename Value, typename T,
+         detail::enable_if_t<detail::is_value<Value>::value &&
+                             detail::has_fields<T>::value>* = nullptr>
+void from_json(Value&& in, T& out) {
+    if (!in.is_object()) {
+        throw bad_access{};
+    }
+    detail::field_extractor<Value> extractor{in};
+    langnes_json_fields(out, extractor);
+}
+
+/// @}
+
+template<typename T, detail::enable_if_t<detail::has_to_json<T>::value>*>
+value::value(const T& from) : value{} {
+    to_json(*this, from);
+}
+
+template<typename T>
+T value::get() const& {
+    T result{};
+    from_json(*this, result);
+    return result;
+}
+
+template<typename T>
+T value::get() && {
+    T result{};
+    from_json(std::move(*this), result);
+    return result;
+}
+
+LANGNES_JSON_CXX_NS_END
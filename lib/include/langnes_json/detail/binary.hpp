@@ -0,0 +1,341 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "json.hpp"
+#include "macros.hpp"
+#include "memory.hpp"
+#include "parsing.hpp"
+#include "value_impl.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Reads a binary document in place.
+class byte_reader {
+public:
+    byte_reader(const std::uint8_t* data, size_t length) noexcept
+        : m_data{data},
+          m_length{length} {}
+
+    bool at_end() const noexcept { return m_position == m_length; }
+
+    std::uint8_t peek() const {
+        if (at_end()) {
+            throw parsing::reached_end{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return m_data[m_position];
+    }
+
+    std::uint8_t get() {
+        auto result{peek()};
+        ++m_position;
+        return result;
+    }
+
+    // Reads an unsigned integer stored in big-endian byte order.
+    template<typename T>
+    T get_big_endian() {
+        static_assert(std::is_unsigned<T>::value, "T must be unsigned");
+        const auto* bytes{get_bytes(sizeof(T))};
+        T result{};
+        for (size_t i{}; i < sizeof(T); ++i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            result = static_cast<T>((result << 8U) | bytes[i]);
+        }
+        return result;
+    }
+
+    const std::uint8_t* get_bytes(size_t length) {
+        if (length > m_length - m_position) {
+            throw parsing::reached_end{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const auto* result{m_data + m_position};
+        m_position += length;
+        return result;
+    }
+
+    // Appends to a string straight from the input.
+    template<typename String>
+    void append_string(String& s, std::uint64_t length) {
+        if (length > m_length - m_position) {
+            throw parsing::reached_end{};
+        }
+        auto n{static_cast<size_t>(length)};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        s.append(reinterpret_cast<const char*>(get_bytes(n)), n);
+    }
+
+    // Gets how many items to reserve storage for given a count from a length
+    // header, which is bounded by the remaining input so that malformed
+    // headers cannot cause huge allocations.
+    size_t reservable(std::uint64_t count, size_t min_item_size = 1) const
+        noexcept {
+        return static_cast<size_t>(std::min<std::uint64_t>(
+            count, (m_length - m_position) / min_item_size));
+    }
+
+    size_t position() const noexcept { return m_position; }
+
+private:
+    const std::uint8_t* m_data;
+    size_t m_length;
+    size_t m_position{};
+};
+
+// Reads a binary document from a stream with the same interface as
+// byte_reader.
+class stream_byte_reader {
+public:
+    explicit stream_byte_reader(std::istream& is) noexcept : m_is{is} {}
+
+    std::uint8_t peek() const {
+        auto c{m_is.peek()};
+        if (std::istream::traits_type::eq_int_type(
+                c, std::istream::traits_type::eof())) {
+            throw parsing::reached_end{};
+        }
+        return static_cast<std::uint8_t>(c);
+    }
+
+    std::uint8_t get() {
+        auto result{peek()};
+        m_is.ignore();
+        return result;
+    }
+
+    template<typename T>
+    T get_big_endian() {
+        static_assert(std::is_unsigned<T>::value, "T must be unsigned");
+        T result{};
+        for (size_t i{}; i < sizeof(T); ++i) {
+            result = static_cast<T>((result << 8U) | get());
+        }
+        return result;
+    }
+
+    // Appends to a string in chunks so that a bogus length cannot cause a
+    // huge allocation before the input runs out.
+    template<typename String>
+    void append_string(String& s, std::uint64_t length) {
+        constexpr std::uint64_t chunk_size{64 * 1024};
+        while (length > 0) {
+            auto n{static_cast<size_t>(std::min(length, chunk_size))};
+            auto offset{s.size()};
+            s.resize(offset + n);
+            m_is.read(&s[offset], static_cast<std::streamsize>(n));
+            if (static_cast<size_t>(m_is.gcount()) != n) {
+                throw parsing::reached_end{};
+            }
+            length -= n;
+        }
+    }
+
+    // Gets how many items to reserve storage for given a count from a length
+    // header. The remaining input is unknown, so the count is capped.
+    size_t reservable(std::uint64_t count, size_t min_item_size = 1) const
+        noexcept {
+        constexpr std::uint64_t max_reservation{64 * 1024};
+        return static_cast<size_t>(
+            std::min<std::uint64_t>(count, max_reservation / min_item_size));
+    }
+
+private:
+    std::istream& m_is;
+};
+
+// Writes a binary document to a stream.
+class byte_writer {
+public:
+    explicit byte_writer(std::ostream& os) noexcept : m_os{os} {}
+
+    void put(std::uint8_t byte) { m_os.put(static_cast<char>(byte)); }
+
+    // Writes an unsigned integer in big-endian byte order.
+    template<typename T>
+    void put_big_endian(T v) {
+        static_assert(std::is_unsigned<T>::value, "T must be unsigned");
+        for (auto i{sizeof(T)}; i > 0; --i) {
+            put(static_cast<std::uint8_t>(v >> ((i - 1) * 8U)));
+        }
+    }
+
+    void write(const char* data, size_t length) {
+        m_os.write(data, static_cast<std::streamsize>(length));
+    }
+
+private:
+    std::ostream& m_os;
+};
+
+// Appends everything written to a vector of bytes.
+class vector_streambuf : public std::streambuf {
+public:
+    explicit vector_streambuf(std::vector<std::uint8_t>& bytes) noexcept
+        : m_bytes{bytes} {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            m_bytes.push_back(static_cast<std::uint8_t>(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        m_bytes.insert(m_bytes.end(), s, s + n);
+        return n;
+    }
+
+private:
+    std::vector<std::uint8_t>& m_bytes;
+};
+
+inline double double_from_bits(std::uint64_t bits) noexcept {
+    double result{};
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline float float_from_bits(std::uint32_t bits) noexcept {
+    float result{};
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline std::uint64_t bits_of(double v) noexcept {
+    std::uint64_t result{};
+    std::memcpy(&result, &v, sizeof(result));
+    return result;
+}
+
+inline std::uint32_t bits_of(float v) noexcept {
+    std::uint32_t result{};
+    std::memcpy(&result, &v, sizeof(result));
+    return result;
+}
+
+// Whether a double is written as an integer, as in write_number().
+inline bool is_integral_double(double v) noexcept {
+    return std::trunc(v) == v && std::fabs(v) < 9007199254740992.0 &&
+           !(v == 0 && std::signbit(v));
+}
+
+// Whether a double converts to float and back without loss.
+inline bool is_exact_float(double v) noexcept {
+    return std::isnan(v) || static_cast<double>(static_cast<float>(v)) == v;
+}
+
+// Encodes bytes as base64url without padding, which is how binary data is
+// represented in JSON (RFC 8949 section 6.1).
+inline std::string to_base64url(const std::uint8_t* data, size_t length) {
+    static constexpr const char* alphabet{
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"};
+    std::string result;
+    result.reserve((length * 4 + 2) / 3);
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (size_t i{}; i < length; i += 3) {
+        auto remaining{length - i};
+        std::uint32_t chunk{static_cast<std::uint32_t>(data[i]) << 16U};
+        if (remaining > 1) {
+            chunk |= static_cast<std::uint32_t>(data[i + 1]) << 8U;
+        }
+        if (remaining > 2) {
+            chunk |= data[i + 2];
+        }
+        auto chars{std::min<size_t>(remaining, 3) + 1};
+        for (size_t j{}; j < chars; ++j) {
+            result.push_back(alphabet[(chunk >> (18 - j * 6)) & 0x3fU]);
+        }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return result;
+}
+
+// Binary formats nest a container per byte, so their decoders limit the
+// depth even if the options do not, which keeps the recursion off the end of
+// the stack.
+constexpr size_t default_binary_max_depth{1000};
+
+inline parse_options with_binary_depth_limit(parse_options options) noexcept {
+    if (options.max_depth == 0) {
+        options.max_depth = default_binary_max_depth;
+    }
+    return options;
+}
+
+inline void check_string_length(const parse_context& ctx, std::uint64_t n) {
+    auto max_length{ctx.options.max_string_length};
+    if (max_length > 0 && n > max_length) {
+        throw out_of_range{"Maximum string length exceeded"};
+    }
+}
+
+// Adds a decoded member to an object, or to the shared stacks of the
+// context when object shapes are shared.
+inline void add_member(parse_context& ctx, object_impl& object,
+                       value::string_type&& name, value&& member_value) {
+    if (ctx.options.share_object_shapes) {
+        ctx.names.push_back(std::move(name));
+        ctx.elements.push_back(std::move(member_value));
+        return;
+    }
+    object.members().emplace(std::move(name), std::move(member_value));
+}
+
+// Completes an object whose members were added with add_member().
+inline value finish_object(parse_context& ctx, object_impl&& object,
+                           size_t first_name, size_t first) {
+    if (ctx.options.share_object_shapes) {
+        return value{
+            make_unique<object_impl>(pop_members(ctx, first_name, first))};
+    }
+    return value{make_unique<object_impl>(std::move(object))};
+}
+
+// Converts a decoded float to a value. JSON cannot represent infinity and
+// NaN, which become null (RFC 8949 section 6.1).
+inline value make_float_value(double v) {
+    if (!std::isfinite(v)) {
+        return value{make_unique<null_impl>()};
+    }
+    return value{make_unique<number_impl>(v)};
+}
+
+inline value make_array(value::array_type&& elements) {
+    auto result{make_unique<array_impl>()};
+    result->elements() = std::move(elements);
+    return value{std::move(result)};
+}
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
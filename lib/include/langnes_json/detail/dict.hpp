@@ -16,112 +16,443 @@
 
 #pragma once
 
+#include "../memory_resource.hpp"
+#include "../string_ref.hpp"
 #include "macros.hpp"
 
-#include <deque>
-#include <string>
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 LANGNES_JSON_CXX_NS_BEGIN
 namespace detail {
 
+// FNV-1a over the bytes of a string.
+inline std::uint64_t hash_bytes(string_ref s) noexcept {
+    std::uint64_t h{0xcbf29ce484222325U};
+    for (auto c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3U;
+    }
+    return h;
+}
+
+// Keys in order of insertion with an index for finding them. Small lists are
+// searched linearly and only larger ones get a hash table, which is open
+// addressing with linear probing over the positions of the keys.
+template<typename Key>
+class key_list {
+public:
+    static constexpr size_t npos{std::numeric_limits<size_t>::max()};
+
+    size_t size() const noexcept { return m_keys.size(); }
+    bool empty() const noexcept { return m_keys.empty(); }
+    const Key& operator[](size_t index) const noexcept {
+        return m_keys[index];
+    }
+    typename std::vector<Key, allocator<Key>>::const_iterator
+    begin() const noexcept {
+        return m_keys.begin();
+    }
+    typename std::vector<Key, allocator<Key>>::const_iterator
+    end() const noexcept {
+        return m_keys.end();
+    }
+
+    // Gets the position of the first occurrence of a key, or npos.
+    size_t find(string_ref key) const noexcept {
+        if (m_slots.empty()) {
+            for (size_t i{}; i < m_keys.size(); ++i) {
+                if (string_ref{m_keys[i]} == key) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+        auto mask{m_slots.size() - 1};
+        for (auto slot{hash_bytes(key) & mask};; slot = (slot + 1) & mask) {
+            auto position{m_slots[slot]};
+            if (position == 0) {
+                return npos;
+            }
+            if (string_ref{m_keys[position - 1]} == key) {
+                return position - 1;
+            }
+        }
+    }
+
+    // Appends a key. A key that is already in the list is only indexed at
+    // its first position.
+    void push_back(Key key) {
+        if (m_keys.size() >= std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error{"Too many keys"};
+        }
+        m_keys.push_back(std::move(key));
+        if (m_keys.size() > linear_size) {
+            if (m_slots.size() < m_keys.size() * 2) {
+                rebuild(m_keys.size() * 2);
+            } else {
+                index(m_keys.size() - 1);
+            }
+        }
+    }
+
+    // Removes the key at a position by moving the last key into its place,
+    // so that removal takes constant time.
+    void swap_remove(size_t position) noexcept {
+        auto last{m_keys.size() - 1};
+        if (!m_slots.empty()) {
+            unindex(position);
+            if (position != last) {
+                m_slots[slot_of(last)] =
+                    static_cast<std::uint32_t>(position + 1);
+            }
+        }
+        if (position != last) {
+            m_keys[position] = std::move(m_keys[last]);
+        }
+        m_keys.pop_back();
+    }
+
+    // Whether no key occurs more than once.
+    bool has_unique_keys() const noexcept {
+        for (size_t i{}; i < m_keys.size(); ++i) {
+            if (find(m_keys[i]) != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void reserve(size_t count) {
+        m_keys.reserve(count);
+        if (count > linear_size && m_slots.size() < count * 2) {
+            rebuild(count * 2);
+        }
+    }
+
+    void clear() noexcept {
+        m_keys.clear();
+        m_slots.clear();
+    }
+
+private:
+    static constexpr size_t linear_size{8};
+
+    void rebuild(size_t min_slots) {
+        size_t count{16};
+        while (count < min_slots) {
+            count *= 2;
+        }
+        m_slots.assign(count, 0);
+        for (size_t i{}; i < m_keys.size(); ++i) {
+            index(i);
+        }
+    }
+
+    void index(size_t position) noexcept {
+        auto mask{m_slots.size() - 1};
+        auto slot{hash_bytes(m_keys[position]) & mask};
+        while (m_slots[slot] != 0) {
+            if (string_ref{m_keys[m_slots[slot] - 1]} ==
+                string_ref{m_keys[position]}) {
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = static_cast<std::uint32_t>(position + 1);
+    }
+
+    // Gets the slot that refers to the key at a position.
+    size_t slot_of(size_t position) const noexcept {
+        auto mask{m_slots.size() - 1};
+        auto slot{hash_bytes(m_keys[position]) & mask};
+        while (m_slots[slot] != position + 1) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    // Empties the slot of the key at a position and shifts back the slots
+    // after it so that probing stays unbroken.
+    void unindex(size_t position) noexcept {
+        auto mask{m_slots.size() - 1};
+        auto hole{slot_of(position)};
+        for (auto slot{(hole + 1) & mask}; m_slots[slot] != 0;
+             slot = (slot + 1) & mask) {
+            auto home{hash_bytes(m_keys[m_slots[slot] - 1]) & mask};
+            // Move the slot into the hole unless its home lies cyclically
+            // after the hole.
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                m_slots[hole] = m_slots[slot];
+                hole = slot;
+            }
+        }
+        m_slots[hole] = 0;
+    }
+
+    std::vector<Key, allocator<Key>> m_keys;
+    // Positions of keys plus one, or zero for empty slots.
+    std::vector<std::uint32_t, allocator<std::uint32_t>> m_slots;
+};
+
+template<typename Key>
+constexpr size_t key_list<Key>::npos;
+
+template<typename Key>
+constexpr size_t key_list<Key>::linear_size;
+
+// Map that keeps its entries in order of insertion and looks up keys without
+// creating them. Erasing an entry moves the last entry into its place.
+//
+// The keys can be shared with other dicts that have the same keys. Adding or
+// removing entries then copies the keys first, while the values can be
+// modified in place.
 template<typename Key, typename Value>
 class dict {
-    using container = std::unordered_map<Key, Value>;
-    using const_iterator = typename container::const_iterator;
-    using iterator = typename container::iterator;
+    template<bool Const>
+    class basic_iterator;
+
+public:
     using key_type = Key;
     using mapped_type = Value;
-    using value_type = std::pair<const Key, Value>;
+    using value_type = std::pair<const Key&, Value&>;
+    using const_value_type = std::pair<const Key&, const Value&>;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using keys_type = key_list<Key>;
+    using values_type = std::vector<Value, allocator<Value>>;
 
-public:
-    const Value& at(const std::string& key) const { return m_data.at(key); }
-    Value& at(const std::string& key) { return m_data.at(key); }
+    dict() noexcept = default;
 
-    const Value& operator[](const std::string& key) const {
-        return m_data.at(key);
+    // Creates a dict with shared keys and a value for every key.
+    dict(std::shared_ptr<const keys_type> keys, values_type&& values) noexcept
+        : m_shared_keys{std::move(keys)},
+          m_values{std::move(values)} {}
+
+    // Null unless the keys are shared.
+    const keys_type* shared_keys() const noexcept {
+        return m_shared_keys.get();
     }
 
-    Value& operator[](const std::string& key) {
-        auto found{m_data.find(key)};
-        if (found != m_data.end()) {
-            return found->second;
+    // The values in order of insertion.
+    const values_type& values() const noexcept { return m_values; }
+
+    const Value& at(string_ref key) const {
+        auto position{keys().find(key)};
+        if (position == key_list<Key>::npos) {
+            throw std::out_of_range{"Key not found"};
         }
-        auto inserted{m_data.insert(std::make_pair(key, Value{})).first};
-        track_entry(inserted);
-        return inserted->second;
+        return m_values[position];
+    }
+
+    Value& at(string_ref key) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        return const_cast<Value&>(static_cast<const dict*>(this)->at(key));
+    }
+
+    const Value& operator[](string_ref key) const { return at(key); }
+
+    Value& operator[](string_ref key) {
+        auto position{keys().find(key)};
+        if (position != key_list<Key>::npos) {
+            return m_values[position];
+        }
+        return append(Key(key.data(), key.size()), Value{});
+    }
+
+    size_t size() const noexcept { return m_values.size(); }
+    bool empty() const noexcept { return m_values.empty(); }
+    iterator begin() noexcept { return {this, 0}; }
+    const_iterator begin() const noexcept { return {this, 0}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return {this, size()}; }
+    const_iterator end() const noexcept { return {this, size()}; }
+    const_iterator cend() const noexcept { return end(); }
+
+    void reserve(size_t count) {
+        own_keys().reserve(count);
+        m_values.reserve(count);
+    }
+
+    size_t count(string_ref key) const noexcept {
+        return keys().find(key) == key_list<Key>::npos ? 0 : 1;
     }
 
-    size_t size() const noexcept { return m_data.size(); }
-    iterator begin() noexcept { return m_data.begin(); }
-    const_iterator begin() const noexcept { return m_data.begin(); }
-    const_iterator cbegin() const noexcept { return m_data.cbegin(); }
-    iterator end() noexcept { return m_data.end(); }
-    const_iterator end() const noexcept { return m_data.end(); }
-    const_iterator cend() const noexcept { return m_data.cend(); }
-    bool empty() const noexcept { return m_data.empty(); }
-    size_t count(const Key& key) const { return m_data.count(key); }
+    iterator find(string_ref key) noexcept { return {this, position(key)}; }
+
+    const_iterator find(string_ref key) const noexcept {
+        return {this, position(key)};
+    }
 
     void clear() noexcept {
-        m_data.clear();
-        m_entries.clear();
-        m_value_types_to_entry_iterators.clear();
+        m_shared_keys.reset();
+        m_keys.clear();
+        m_values.clear();
     }
 
-    void erase(const key_type& key) noexcept {
-        auto found{m_data.find(key)};
-        if (found != m_data.end()) {
-            untrack_entry(found);
-            m_data.erase(found);
+    void erase(string_ref key) {
+        auto found{keys().find(key)};
+        if (found != key_list<Key>::npos) {
+            erase_at(found);
         }
     }
 
-    void erase(iterator it) noexcept {
-        untrack_entry(it);
-        m_data.erase(it);
+    void erase(const_iterator it) { erase_at(it.m_index); }
+
+    // Inserts an entry unless the key exists. Does not move from the
+    // arguments if it does.
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> emplace(K&& key, Args&&... args) {
+        auto found{position(key)};
+        if (found != size()) {
+            return {{this, found}, false};
+        }
+        append(make_key(std::forward<K>(key)),
+               Value(std::forward<Args>(args)...));
+        return {{this, size() - 1}, true};
     }
 
-    template<typename... Args>
-    std::pair<iterator, bool> emplace(Args&&... args) {
-        auto pair{m_data.emplace(std::forward<Args>(args)...)};
-        track_entry(pair.first);
-        return pair;
+    // Gets an entry by position in order of insertion.
+    const_value_type entry_at(size_t index) const {
+        return {keys()[check_index(index)], m_values[index]};
     }
 
-    iterator insert(const value_type& kv) {
-        return track_entry(m_data.insert(kv));
+    value_type entry_at(size_t index) {
+        return {keys()[check_index(index)], m_values[index]};
     }
 
-    iterator insert(value_type&& kv) {
-        return track_entry(m_data.insert(std::move(kv)));
+private:
+    const keys_type& keys() const noexcept {
+        return m_shared_keys ? *m_shared_keys : m_keys;
     }
 
-    const value_type& entry_at(size_t index) const {
-        return *m_entries.at(index);
+    // Gets the keys for modification, copying them if shared.
+    keys_type& own_keys() {
+        if (m_shared_keys) {
+            m_keys = *m_shared_keys;
+            m_shared_keys.reset();
+        }
+        return m_keys;
     }
 
-    value_type& entry_at(size_t index) { return *m_entries.at(index); }
+    size_t position(string_ref key) const noexcept {
+        auto found{keys().find(key)};
+        return found == key_list<Key>::npos ? size() : found;
+    }
 
-private:
-    iterator track_entry(iterator it) noexcept {
-        auto* entry_ptr{std::addressof(*it)};
-        auto entry_ptr_it{m_entries.insert(m_entries.end(), entry_ptr)};
-        m_value_types_to_entry_iterators.emplace(entry_ptr, entry_ptr_it);
-        return it;
+    size_t check_index(size_t index) const {
+        if (index >= size()) {
+            throw std::out_of_range{"Index out of range"};
+        }
+        return index;
+    }
+
+    static Key make_key(Key&& key) noexcept { return std::move(key); }
+    static Key make_key(const Key& key) { return key; }
+
+    template<typename K, typename std::enable_if<!std::is_same<
+                             typename std::decay<K>::type, Key>::value>::type* =
+                             nullptr>
+    static Key make_key(const K& key) {
+        string_ref ref{key};
+        return Key(ref.data(), ref.size());
     }
 
-    void untrack_entry(iterator it) noexcept {
-        auto found{m_value_types_to_entry_iterators.find(std::addressof(*it))};
-        if (found != m_value_types_to_entry_iterators.end()) {
-            m_entries.erase(*found);
-            m_value_types_to_entry_iterators.erase(found);
+    Value& append(Key&& key, Value&& value) {
+        auto& keys{own_keys()};
+        m_values.push_back(std::move(value));
+        try {
+            keys.push_back(std::move(key));
+        } catch (...) {
+            m_values.pop_back();
+            throw;
         }
+        return m_values.back();
     }
 
-    container m_data;
-    std::deque<value_type*> m_entries;
-    std::unordered_map<value_type*, typename decltype(m_entries)::iterator>
-        m_value_types_to_entry_iterators;
+    void erase_at(size_t index) {
+        own_keys().swap_remove(index);
+        if (index != m_values.size() - 1) {
+            m_values[index] = std::move(m_values.back());
+        }
+        m_values.pop_back();
+    }
+
+    keys_type m_keys;
+    std::shared_ptr<const keys_type> m_shared_keys;
+    values_type m_values;
+};
+
+template<typename Key, typename Value>
+template<bool Const>
+class dict<Key, Value>::basic_iterator {
+    using owner_type = typename std::conditional<Const, const dict, dict>::type;
+    using entry_type =
+        typename std::conditional<Const, const_value_type, value_type>::type;
+
+    // Lets operator-> return an entry that is created on the fly.
+    struct arrow_proxy {
+        entry_type entry;
+        const entry_type* operator->() const noexcept { return &entry; }
+    };
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using reference = entry_type;
+    using pointer = arrow_proxy;
+
+    basic_iterator() noexcept = default;
+
+    basic_iterator(owner_type* owner, size_t index) noexcept
+        : m_owner{owner},
+          m_index{index} {}
+
+    template<bool C = Const, typename std::enable_if<C>::type* = nullptr>
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    basic_iterator(const basic_iterator<false>& other) noexcept
+        : m_owner{other.m_owner},
+          m_index{other.m_index} {}
+
+    entry_type operator*() const noexcept {
+        return {m_owner->keys()[m_index], m_owner->m_values[m_index]};
+    }
+
+    arrow_proxy operator->() const noexcept { return {**this}; }
+
+    basic_iterator& operator++() noexcept {
+        ++m_index;
+        return *this;
+    }
+
+    basic_iterator operator++(int) noexcept {
+        auto result{*this};
+        ++m_index;
+        return result;
+    }
+
+    bool operator==(const basic_iterator& other) const noexcept {
+        return m_index == other.m_index;
+    }
+
+    bool operator!=(const basic_iterator& other) const noexcept {
+        return m_index != other.m_index;
+    }
+
+private:
+    friend class dict;
+    template<bool>
+    friend class basic_iterator;
+
+    owner_type* m_owner{};
+    size_t m_index{};
 };
 
 } // namespace detail
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "../errors.hpp"
+#include "../options.hpp"
 #include "../value.hpp"
 #include "macros.hpp"
 #include "memory.hpp"
@@ -26,15 +27,58 @@
 #include "utf8.hpp"
 #include "value_impl.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
-#include <sstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 LANGNES_JSON_CXX_NS_BEGIN
 namespace detail {
 
+// Escapes a single character if needed and returns the length of the escape
+// sequence, or 0 if the character needs no escaping.
+inline size_t escape_char(char c, std::array<char, 6>& out) noexcept {
+    using namespace token_rules;
+    if (json_special_char(c)) {
+        static constexpr std::array<char, 256> special_escape_table = {
+            0, 0, 0,   0, 0, 0, 0, 0, 'b', 't', 'n', 0, 'f', 'r', 0, 0,
+            0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
+            0, 0, '"', 0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
+            0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
+            0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
+            0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, '\\'};
+        out[0] = '\\';
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        out[1] = special_escape_table[static_cast<unsigned char>(c)];
+        return 2;
+    }
+    if (json_control_char(c)) {
+        // Escape as \u00xx
+        static constexpr std::array<char, 16> hex_alphabet = {
+            '0', '1', '2', '3', '4', '5', '6', '7',
+            '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+        auto uc = static_cast<unsigned int>(static_cast<unsigned char>(c));
+        auto h = (uc >> 4U) & 0x0fU;
+        auto l = uc & 0x0fU;
+        out = {'\\', 'u', '0', '0', 0, 0};
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+        out[4] = hex_alphabet[h];
+        out[5] = hex_alphabet[l];
+        // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+        return 6;
+    }
+    return 0;
+}
+
 inline std::string escape(const std::string& s, bool add_quotes = true) {
     using namespace token_rules;
     // Calculate the size of the resulting string.
@@ -60,33 +104,10 @@ inline std::string escape(const std::string& s, bool add_quotes = true) {
         result += '"';
     }
     // Copy string while escaping characters.
+    std::array<char, 6> escaped{};
     for (auto c : s) {
-        if (json_special_char(c)) {
-            static constexpr std::array<char, 256> special_escape_table = {
-                0, 0, 0,   0, 0, 0, 0, 0, 'b', 't', 'n', 0, 'f', 'r', 0, 0,
-                0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
-                0, 0, '"', 0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
-                0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
-                0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, 0,   0,   0, 0,
-                0, 0, 0,   0, 0, 0, 0, 0, 0,   0,   0,   0, '\\'};
-            result += '\\';
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-            result += special_escape_table[static_cast<unsigned char>(c)];
-            continue;
-        }
-        if (json_control_char(c)) {
-            // Escape as \u00xx
-            static constexpr std::array<char, 16> hex_alphabet = {
-                '0', '1', '2', '3', '4', '5', '6', '7',
-                '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-            auto uc = static_cast<unsigned int>(static_cast<unsigned char>(c));
-            auto h = (uc >> 4U) & 0x0fU;
-            auto l = uc & 0x0fU;
-            result += "\\u00";
-            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
-            result += hex_alphabet[h];
-            result += hex_alphabet[l];
-            // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+        if (auto length{escape_char(c, escaped)}) {
+            result.append(escaped.data(), length);
             continue;
         }
         result += c;
@@ -99,38 +120,163 @@ inline std::string escape(const std::string& s, bool add_quotes = true) {
     return result;
 }
 
-inline void unescape_one(std::istream& is, std::ostream& os) {
-    using namespace parsing;
-    using namespace token_rules;
-    static constexpr std::array<char, 19> escape_table = {
-        '\b', 0, 0, 0, '\f', 0, 0, 0, 0, 0, 0, 0, '\n', 0, 0, 0, '\r', 0, '\t'};
-    char c{};
-    if (!next(is, c, escape_start)) {
-        os.put(c);
+// Writes a quoted and escaped string without intermediate allocations.
+inline void write_escaped(std::ostream& os, const char* data, size_t length) {
+    os.put('"');
+    std::array<char, 6> escaped{};
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto* end{data + length};
+    const auto* run{data};
+    for (const auto* p{data}; p != end; ++p) {
+        if (auto escaped_length{escape_char(*p, escaped)}) {
+            os.write(run, static_cast<std::streamsize>(p - run));
+            os.write(escaped.data(),
+                     static_cast<std::streamsize>(escaped_length));
+            run = p + 1;
+        }
+    }
+    os.write(run, static_cast<std::streamsize>(end - run));
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    os.put('"');
+}
+
+// Writes the shortest representation that converts back to the same double.
+// Integers below 2^53 are written without an exponent.
+inline void write_number(std::ostream& os, double v) {
+    if (std::trunc(v) == v && std::fabs(v) < 9007199254740992.0 &&
+        !(v == 0 && std::signbit(v))) {
+        os << static_cast<std::int64_t>(v);
+        return;
+    }
+    // Search for the lowest precision that converts back, since higher
+    // precisions practically always do too. 17 digits always suffice.
+    std::array<char, 32> buffer{};
+    std::array<char, 32> shortest{};
+    int low{1};
+    int high{17};
+    std::snprintf(shortest.data(), shortest.size(), "%.17g", v);
+    while (low < high) {
+        auto precision{low + (high - low) / 2};
+        std::snprintf(buffer.data(), buffer.size(), "%.*g", precision, v);
+        if (std::strtod(buffer.data(), nullptr) == v) {
+            shortest = buffer;
+            high = precision;
+        } else {
+            low = precision + 1;
+        }
+    }
+    os << shortest.data();
+}
+
+inline void write_number(std::ostream& os, const number_impl& v) {
+    using k = number_impl::kind;
+    if (const auto* text{v.raw_text()}) {
+        os.write(text->data(), static_cast<std::streamsize>(text->size()));
         return;
     }
-    c = get_next(is);
+    std::int64_t i{};
+    std::uint64_t u{};
+    switch (v.get_kind()) {
+    case k::int64:
+        v.to_int64(i);
+        os << i;
+        break;
+    case k::uint64:
+        v.to_uint64(u);
+        os << u;
+        break;
+    default:
+        write_number(os, v.data());
+    }
+}
+
+// Values of hexadecimal digits indexed by character, with 0xff for other
+// characters.
+struct hex_digit_table {
+    hex_digit_table() noexcept {
+        values.fill(0xffU);
+        for (unsigned char i{}; i < 10; ++i) {
+            values['0' + i] = i;
+        }
+        for (unsigned char i{}; i < 6; ++i) {
+            values['a' + i] = static_cast<unsigned char>(10 + i);
+            values['A' + i] = static_cast<unsigned char>(10 + i);
+        }
+    }
+
+    std::array<unsigned char, 256> values{};
+};
+
+// Reads a fixed number of hexadecimal digits.
+inline size_t read_hex(std::istream& is, size_t count) {
+    static const hex_digit_table table;
+    size_t result{};
+    for (size_t i{}; i < count; ++i) {
+        auto c{static_cast<unsigned char>(parsing::get_next(is))};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        auto digit{table.values[c]};
+        if (digit > 0xfU) {
+            throw parsing::unexpected_token{};
+        }
+        result = result << 4U | digit;
+    }
+    return result;
+}
+
+// Gets the character for a single-character escape sequence.
+inline char unescape_char(char c) noexcept {
+    static constexpr std::array<char, 19> escape_table = {
+        '\b', 0, 0, 0, '\f', 0, 0, 0, 0, 0, 0, 0, '\n', 0, 0, 0, '\r', 0, '\t'};
     if (c >= 'b' && c <= 't') {
         // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
         auto unescaped_char{escape_table[c - 'b']};
         if (unescaped_char != '\0') {
-            os.put(unescaped_char);
-            return;
+            return unescaped_char;
         }
-    } else if (c == 'x' || c == 'u') {
-        const auto length{c == 'x' ? 2U : 4U};
-        std::string digits;
-        read_while(is, digits, hex_digit);
-        if (digits.size() != length) {
-            throw unexpected_token{};
+    }
+    return c;
+}
+
+// Decodes a run of directly adjacent escape sequences into a string, starting
+// after the first backslash. UTF-16 surrogate pairs are joined, while lone
+// surrogates are kept as they are.
+template<typename String>
+void unescape(std::istream& is, String& s) {
+    using namespace parsing;
+    using std_traits = std::istream::traits_type;
+    size_t high_surrogate{};
+    auto flush_high_surrogate = [&] {
+        if (high_surrogate != 0) {
+            append_utf8(s, high_surrogate);
+            high_surrogate = 0;
         }
-        auto code_point{std::stoul(digits, nullptr, 16)};
-        auto utf8_char{to_utf8_char(code_point)};
-        os.write(utf8_char.data(),
-                 static_cast<std::streamsize>(utf8_char.size()));
-        return;
+    };
+    while (true) {
+        auto c{get_next(is)};
+        if (c == 'u' || c == 'x') {
+            auto code_point{read_hex(is, c == 'u' ? 4U : 2U)};
+            if (high_surrogate != 0 && is_low_surrogate(code_point)) {
+                append_utf8(s, combine_surrogates(high_surrogate, code_point));
+                high_surrogate = 0;
+            } else {
+                flush_high_surrogate();
+                if (is_high_surrogate(code_point)) {
+                    high_surrogate = code_point;
+                } else {
+                    append_utf8(s, code_point);
+                }
+            }
+        } else {
+            flush_high_surrogate();
+            s.push_back(unescape_char(c));
+        }
+        if (!std_traits::eq_int_type(is.peek(),
+                                     std_traits::to_int_type('\\'))) {
+            break;
+        }
+        skip(is);
     }
-    os.put(c);
+    flush_high_surrogate();
 }
 
 inline void to_json(std::ostream& os, const value& v) {
@@ -139,13 +285,28 @@ inline void to_json(std::ostream& os, const value& v) {
     case t::object: {
         os.put('{');
         bool first{true};
-        for (const auto& kv : v.as_object()) {
+        const auto& object{dynamic_cast<const object_impl&>(v.impl())};
+        if (const auto* shape{object.shape()}) {
+            for (size_t i{}; i < shape->size(); ++i) {
+                if (i > 0) {
+                    os.put(',');
+                }
+                const auto& name{(*shape)[i]};
+                write_escaped(os, name.data(), name.size());
+                os.put(':');
+                to_json(os, object.values()[i]);
+            }
+            os.put('}');
+            break;
+        }
+        for (const auto& kv : object.members()) {
             if (first) {
                 first = false;
             } else {
                 os.put(',');
             }
-            os << "\"" << kv.first << "\":";
+            write_escaped(os, kv.first.data(), kv.first.size());
+            os.put(':');
             to_json(os, kv.second);
         }
         os.put('}');
@@ -154,7 +315,20 @@ inline void to_json(std::ostream& os, const value& v) {
     case t::array: {
         os.put('[');
         bool first{true};
-        for (const auto& element : v.as_array()) {
+        const auto& array{dynamic_cast<const array_impl&>(v.impl())};
+        if (array.is_packed()) {
+            for (auto number : array.numbers()) {
+                if (first) {
+                    first = false;
+                } else {
+                    os.put(',');
+                }
+                write_number(os, number);
+            }
+            os.put(']');
+            break;
+        }
+        for (const auto& element : array.elements()) {
             if (first) {
                 first = false;
             } else {
@@ -166,8 +340,8 @@ inline void to_json(std::ostream& os, const value& v) {
         break;
     }
     case t::string: {
-        auto s{escape(v.as_string())};
-        os.write(s.data(), static_cast<std::streamsize>(s.size()));
+        const auto& s{v.as_string()};
+        write_escaped(os, s.data(), s.size());
         break;
     }
     case t::boolean:
@@ -177,43 +351,194 @@ inline void to_json(std::ostream& os, const value& v) {
         os << "null";
         break;
     case t::number:
-        os << v.as_number();
+        write_number(os, dynamic_cast<const number_impl&>(v.impl()));
         break;
     default:
         throw invalid_state{"Unexpected value type"};
     }
 }
 
-value parse_value(std::istream& is);
+struct parse_context {
+    explicit parse_context(const parse_options& options) noexcept
+        : options{options} {}
+
+    parse_options options;
+    size_t depth{};
+    // Elements of the arrays being parsed, shared by all nesting levels so
+    // that each array can be allocated once with the exact capacity.
+    std::vector<value> elements;
+    // Numbers of the arrays being packed, shared in the same way.
+    std::vector<double> numbers;
+    // Member names of the objects being parsed, shared in the same way.
+    std::vector<value::string_type> names;
+    // Shapes by joined member names. Null until the names are seen twice.
+    std::unordered_map<std::string, std::shared_ptr<const object_shape>>
+        shapes;
+    std::shared_ptr<const object_shape> last_shape;
+};
+
+// Moves the values parsed since a position in the shared element stack into
+// a new vector with the exact capacity.
+inline value::array_type pop_values(parse_context& ctx, size_t first) {
+    value::array_type result;
+    result.reserve(ctx.elements.size() - first);
+    for (auto i{first}; i < ctx.elements.size(); ++i) {
+        result.push_back(std::move(ctx.elements[i]));
+    }
+    ctx.elements.erase(ctx.elements.begin() +
+                           static_cast<std::ptrdiff_t>(first),
+                       ctx.elements.end());
+    return result;
+}
+
+// Moves the elements parsed since a position in the shared element stack
+// into a new array.
+inline array_impl pop_elements(parse_context& ctx, size_t first) {
+    array_impl result;
+    result.elements() = pop_values(ctx, first);
+    return result;
+}
 
-inline optional<std::string> try_parse_string(std::istream& is) {
+// Gets the shared shape for the member names parsed since a position in the
+// shared name stack. Returns null for names seen for the first time so that
+// one-off objects keep using a dict.
+inline std::shared_ptr<const object_shape> find_shape(parse_context& ctx,
+                                                      size_t first) {
+    auto begin{ctx.names.begin() + static_cast<std::ptrdiff_t>(first)};
+    auto count{ctx.names.size() - first};
+    auto matches = [&](const object_shape& shape) {
+        if (shape.size() != count) {
+            return false;
+        }
+        for (size_t i{}; i < count; ++i) {
+            if (shape[i] != begin[static_cast<std::ptrdiff_t>(i)]) {
+                return false;
+            }
+        }
+        return true;
+    };
+    // Consecutive objects such as the rows of a table usually match.
+    if (ctx.last_shape && matches(*ctx.last_shape)) {
+        return ctx.last_shape;
+    }
+    std::string key;
+    for (auto it{begin}; it != ctx.names.end(); ++it) {
+        key.append(it->data(), it->size());
+        key.push_back('\0');
+    }
+    auto inserted{ctx.shapes.emplace(std::move(key), nullptr)};
+    if (inserted.second) {
+        return nullptr;
+    }
+    auto& shape{inserted.first->second};
+    if (!shape) {
+        object_shape names;
+        names.reserve(count);
+        for (auto it{begin}; it != ctx.names.end(); ++it) {
+            names.push_back(*it);
+        }
+        if (!names.has_unique_keys()) {
+            return nullptr;
+        }
+        auto created{std::allocate_shared<const object_shape>(
+            allocator<object_shape>{}, std::move(names))};
+        shape = std::move(created);
+    } else if (!matches(*shape)) {
+        // Names containing null characters may collide.
+        return nullptr;
+    }
+    ctx.last_shape = shape;
+    return shape;
+}
+
+// Moves the members parsed since positions in the shared name and element
+// stacks into a new object.
+inline object_impl pop_members(parse_context& ctx, size_t first_name,
+                               size_t first) {
+    auto shape{find_shape(ctx, first_name)};
+    auto names_begin{ctx.names.begin() +
+                     static_cast<std::ptrdiff_t>(first_name)};
+    if (shape) {
+        ctx.names.erase(names_begin, ctx.names.end());
+        return object_impl{std::move(shape), pop_values(ctx, first)};
+    }
+    object_impl result;
+    auto& members{result.members()};
+    members.reserve(ctx.names.size() - first_name);
+    for (size_t i{}; i < ctx.names.size() - first_name; ++i) {
+        members.emplace(std::move(ctx.names[first_name + i]),
+                        std::move(ctx.elements[first + i]));
+    }
+    ctx.names.erase(names_begin, ctx.names.end());
+    ctx.elements.erase(ctx.elements.begin() +
+                           static_cast<std::ptrdiff_t>(first),
+                       ctx.elements.end());
+    return result;
+}
+
+// Moves the numbers parsed since a position in the shared number stack into
+// a new packed array.
+inline array_impl pop_numbers(parse_context& ctx, size_t first) {
+    auto begin{ctx.numbers.begin() + static_cast<std::ptrdiff_t>(first)};
+    array_impl::number_array_type numbers(begin, ctx.numbers.end());
+    ctx.numbers.erase(begin, ctx.numbers.end());
+    return array_impl{std::move(numbers)};
+}
+
+// Moves the numbers parsed since a position in the shared number stack onto
+// the element stack once an array turns out not to be packable.
+inline void unpack_numbers(parse_context& ctx, size_t first) {
+    for (auto i{first}; i < ctx.numbers.size(); ++i) {
+        ctx.elements.emplace_back(ctx.numbers[i]);
+    }
+    ctx.numbers.erase(ctx.numbers.begin() + static_cast<std::ptrdiff_t>(first),
+                      ctx.numbers.end());
+}
+
+inline void enter_nesting(parse_context& ctx) {
+    auto max_depth{ctx.options.max_depth};
+    if (max_depth > 0 && ctx.depth >= max_depth) {
+        throw out_of_range{"Maximum nesting depth exceeded"};
+    }
+    ++ctx.depth;
+}
+
+inline void leave_nesting(parse_context& ctx) noexcept { --ctx.depth; }
+
+value parse_value(std::istream& is, parse_context& ctx);
+
+template<typename String = value::string_type>
+optional<String> try_parse_string(std::istream& is, const parse_context& ctx) {
     using namespace parsing;
     using namespace token_rules;
     if (!peek(is, dquote)) {
         return nullopt;
     }
     skip(is);
-    std::ostringstream os{std::ios::binary};
-    for (char c{get_next(is)};; c = get_next(is)) {
+    String result;
+    for (char c{get_next(is)}; !dquote(is, c); c = get_next(is)) {
         if (escape_start(is, c)) {
-            is.unget();
-            unescape_one(is, os);
-            continue;
+            unescape(is, result);
+        } else {
+            result.push_back(c);
         }
-        if (dquote(is, c)) {
-            is.unget();
-            break;
-        }
-        os.put(c);
     }
-    expect(is, dquote);
-    return {os.str()};
+    auto max_length{ctx.options.max_string_length};
+    if (max_length > 0 && result.size() > max_length) {
+        throw out_of_range{"Maximum string length exceeded"};
+    }
+    if (ctx.options.validate_utf8 &&
+        !is_valid_utf8(result.data(), result.size())) {
+        throw parse_error{"Invalid UTF-8"};
+    }
+    return {std::move(result)};
 }
 
-inline std::string parse_string(std::istream& is) {
+template<typename String = value::string_type>
+String parse_string(std::istream& is, const parse_context& ctx) {
     using namespace parsing;
-    if (auto s{try_parse_string(is)}) {
-        return *s;
+    if (auto s{try_parse_string<String>(is, ctx)}) {
+        return std::move(*s);
     }
     throw unexpected_token{};
 }
@@ -239,77 +564,54 @@ inline bool parse_boolean(std::istream& is) {
     throw unexpected_token{};
 }
 
+// Parses a number, or only validates it and keeps its text in raw mode.
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
-inline optional<double> try_parse_number(std::istream& is) {
+inline optional<number_impl> try_parse_number(std::istream& is,
+                                              const parse_context& ctx) {
     using namespace parsing;
     using namespace token_rules;
-    int number_sign{1};
+    std::string text;
     if (peek_next(is) == '-') {
-        skip(is);
-        number_sign = -1;
-    }
-    std::string number_digits;
-    std::string fraction_digits;
-    std::string exponent_digits;
-    int exponent_sign{1};
-    if (peek_next(is) == '0') {
-        number_digits.push_back(get_next(is));
-    } else {
-        char first_digit{};
-        if (!next(is, first_digit, digit_1_through_9)) {
+        text.push_back(get_next(is));
+    }
+    char first_digit{};
+    if (!next(is, first_digit, digit)) {
+        throw unexpected_token{};
+    }
+    text.push_back(first_digit);
+    if (first_digit != '0') {
+        read_while(is, text, digit);
+    }
+    if (!has_reached_end(is) && peek_next(is) == '.') {
+        text.push_back(get_next(is));
+        if (!next(is, first_digit, digit)) {
             throw unexpected_token{};
         }
-        number_digits.push_back(first_digit);
-        read_while(is, number_digits, digit);
+        text.push_back(first_digit);
+        read_while(is, text, digit);
     }
-    if (!has_reached_end(is)) {
-        if (peek_next(is) == '.') {
-            skip(is);
-            char first_digit{};
-            if (!next(is, first_digit, digit)) {
-                throw unexpected_token{};
-            }
-            fraction_digits.push_back(first_digit);
-            read_while(is, fraction_digits, digit);
-        }
+    if (!has_reached_end(is) &&
+        (peek_next(is) == 'e' || peek_next(is) == 'E')) {
+        text.push_back(get_next(is));
         auto c{peek_next(is)};
-        if (c == 'e' || c == 'E') {
-            skip(is);
-            c = peek_next(is);
-            if (c == '+' || c == '-') {
-                skip(is);
-                if (c == '-') {
-                    exponent_sign = -1;
-                }
-            }
-            char first_digit{};
-            if (!next(is, first_digit, digit)) {
-                throw unexpected_token{};
-            }
-            exponent_digits.push_back(first_digit);
-            read_while(is, exponent_digits, digit);
+        if (c == '+' || c == '-') {
+            text.push_back(get_next(is));
         }
-    }
-    double number{std::stod(number_digits)};
-    if (!fraction_digits.empty()) {
-        number += std::stod("0." + fraction_digits);
-    }
-    if (number_sign < 0) {
-        number = -number;
-    }
-    if (!exponent_digits.empty()) {
-        auto exponent{std::stod(exponent_digits)};
-        if (exponent_sign < 0) {
-            exponent = -exponent;
+        if (!next(is, first_digit, digit)) {
+            throw unexpected_token{};
         }
-        number *= std::pow(10, exponent);
+        text.push_back(first_digit);
+        read_while(is, text, digit);
     }
-    return number;
+    if (ctx.options.raw_numbers) {
+        return number_impl::from_raw_text(std::move(text));
+    }
+    return number_impl::from_text(text);
 }
 
-inline double parse_number(std::istream& is) {
+inline number_impl parse_number(std::istream& is, const parse_context& ctx) {
     using namespace parsing;
-    if (auto v{try_parse_number(is)}) {
+    if (auto v{try_parse_number(is, ctx)}) {
         return *v;
     }
     throw unexpected_token{};
@@ -324,29 +626,40 @@ inline bool try_parse_null(std::istream& is) {
     return false;
 }
 
-inline optional<object_impl> try_parse_object(std::istream& is) {
+inline optional<object_impl> try_parse_object(std::istream& is,
+                                              parse_context& ctx) {
     using namespace parsing;
     using namespace token_rules;
     if (!peek(is, object_open)) {
         return nullopt;
     }
+    enter_nesting(ctx);
     skip(is);
     skip_while(is, ws);
     object_impl result;
     if (peek(is, object_close)) {
         expect(is, object_close);
+        leave_nesting(ctx);
         return result;
     }
+    auto is_shared{ctx.options.share_object_shapes};
+    auto first{ctx.elements.size()};
+    auto first_name{ctx.names.size()};
     while (true) {
         if (!peek(is, dquote)) {
             throw unexpected_token{};
         }
-        auto member_name{parse_string(is)};
+        auto member_name{parse_string(is, ctx)};
         skip_while(is, ws);
         expect(is, member_separator);
-        auto member_value{parse_value(is)};
-        result.members().emplace(std::move(member_name),
-                                 std::move(member_value));
+        auto member_value{parse_value(is, ctx)};
+        if (is_shared) {
+            ctx.names.push_back(std::move(member_name));
+            ctx.elements.push_back(std::move(member_value));
+        } else {
+            result.members().emplace(std::move(member_name),
+                                     std::move(member_value));
+        }
         if (peek(is, value_separator)) {
             skip(is);
             skip_while(is, ws);
@@ -356,25 +669,53 @@ inline optional<object_impl> try_parse_object(std::istream& is) {
     }
     skip_while(is, ws);
     expect(is, object_close);
+    leave_nesting(ctx);
+    if (is_shared) {
+        return pop_members(ctx, first_name, first);
+    }
     return result;
 }
 
-inline optional<array_impl> try_parse_array(std::istream& is) {
+inline optional<array_impl> try_parse_array(std::istream& is,
+                                            parse_context& ctx) {
     using namespace parsing;
     using namespace token_rules;
     if (!peek(is, array_open)) {
         return nullopt;
     }
+    enter_nesting(ctx);
     skip(is);
     skip_while(is, ws);
-    array_impl result;
     if (peek(is, array_close)) {
         expect(is, array_close);
-        return result;
+        leave_nesting(ctx);
+        return array_impl{};
     }
+    auto first{ctx.elements.size()};
+    auto first_number{ctx.numbers.size()};
+    auto is_packed{ctx.options.pack_numeric_arrays && !ctx.options.raw_numbers};
     while (true) {
-        auto element_value{parse_value(is)};
-        result.elements().push_back(std::move(element_value));
+        if (is_packed) {
+            skip_while(is, ws);
+            auto c{peek_next(is)};
+            if (c == '-' || digit(is, c)) {
+                auto number{parse_number(is, ctx)};
+                if (number.is_exact_double()) {
+                    ctx.numbers.push_back(number.data());
+                } else {
+                    unpack_numbers(ctx, first_number);
+                    is_packed = false;
+                    ctx.elements.emplace_back(
+                        make_unique<number_impl>(std::move(number)));
+                }
+            } else {
+                unpack_numbers(ctx, first_number);
+                is_packed = false;
+                ctx.elements.push_back(parse_value(is, ctx));
+            }
+        } else {
+            ctx.elements.push_back(parse_value(is, ctx));
+        }
         if (peek(is, value_separator)) {
             skip(is);
             skip_while(is, ws);
@@ -384,20 +725,22 @@ inline optional<array_impl> try_parse_array(std::istream& is) {
     }
     skip_while(is, ws);
     expect(is, array_close);
-    return result;
+    leave_nesting(ctx);
+    return is_packed ? pop_numbers(ctx, first_number)
+                     : pop_elements(ctx, first);
 }
 
-inline value parse_value(std::istream& is) {
+inline value parse_value(std::istream& is, parse_context& ctx) {
     using namespace parsing;
     using namespace token_rules;
     skip_while(is, ws);
-    if (auto v{try_parse_string(is)}) {
+    if (auto v{try_parse_string(is, ctx)}) {
         return value{make_unique<string_impl>(std::move(*v))};
     }
-    if (auto v{try_parse_object(is)}) {
+    if (auto v{try_parse_object(is, ctx)}) {
         return value{make_unique<object_impl>(std::move(*v))};
     }
-    if (auto v{try_parse_array(is)}) {
+    if (auto v{try_parse_array(is, ctx)}) {
         return value{make_unique<array_impl>(std::move(*v))};
     }
     if (auto v{try_parse_boolean(is)}) {
@@ -406,15 +749,69 @@ inline value parse_value(std::istream& is) {
     if (try_parse_null(is)) {
         return value{make_unique<null_impl>()};
     }
-    if (auto v{try_parse_number(is)}) {
-        return value{make_unique<number_impl>(*v)};
+    if (auto v{try_parse_number(is, ctx)}) {
+        return value{make_unique<number_impl>(std::move(*v))};
     }
     throw unexpected_token{};
 }
 
-inline value fully_parse_value(std::istream& is) {
+inline void skip_string(std::istream& is) {
+    using namespace parsing;
+    using namespace token_rules;
+    expect(is, dquote);
+    for (char c{get_next(is)}; !dquote(is, c); c = get_next(is)) {
+        if (escape_start(is, c)) {
+            skip(is);
+        }
+    }
+}
+
+// Skips a value without building it. Arrays and objects are bracket-matched
+// rather than parsed, so their contents are not validated.
+inline void skip_value(std::istream& is) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    auto c{peek_next(is)};
+    if (dquote(is, c)) {
+        skip_string(is);
+        return;
+    }
+    if (object_open(is, c) || array_open(is, c)) {
+        size_t depth{};
+        do {
+            c = peek_next(is);
+            if (dquote(is, c)) {
+                skip_string(is);
+                continue;
+            }
+            skip(is);
+            if (object_open(is, c) || array_open(is, c)) {
+                ++depth;
+            } else if (object_close(is, c) || array_close(is, c)) {
+                --depth;
+            }
+        } while (depth > 0);
+        return;
+    }
+    // Literals and numbers
+    auto scalar_char{[](std::istream& is_, char c_) {
+        return !ws(is_, c_) && !value_separator(is_, c_) &&
+               !member_separator(is_, c_) && !object_close(is_, c_) &&
+               !array_close(is_, c_);
+    }};
+    if (!scalar_char(is, c)) {
+        throw unexpected_token{};
+    }
+    skip_while(is, scalar_char);
+}
+
+inline value fully_parse_value(std::istream& is,
+                               const parse_options& options = {}) {
     using namespace parsing;
-    auto value{parse_value(is)};
+    scoped_resource scope{options.resource};
+    parse_context ctx{options};
+    auto value{parse_value(is, ctx)};
     expect_fully_consumed(is);
     return value;
 }
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "macros.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Read-only memory mapping of a whole file.
+class mapped_file {
+public:
+    mapped_file() noexcept = default;
+
+    explicit mapped_file(const std::string& path) { map(path); }
+
+    mapped_file(const mapped_file&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept
+        : m_data{other.m_data},
+          m_size{other.m_size} {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+        }
+        return *this;
+    }
+
+    ~mapped_file() { unmap(); }
+
+    const std::uint8_t* data() const noexcept { return m_data; }
+    size_t size() const noexcept { return m_size; }
+
+private:
+#ifdef _WIN32
+    void map(const std::string& path) {
+        auto* file{CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                               nullptr)};
+        if (file == INVALID_HANDLE_VALUE) {
+            throw_last_error("Failed to open file");
+        }
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw_last_error("Failed to get file size");
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size == 0) {
+            CloseHandle(file);
+            return;
+        }
+        auto* mapping{
+            CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+        CloseHandle(file);
+        if (!mapping) {
+            throw_last_error("Failed to map file");
+        }
+        m_data = static_cast<const std::uint8_t*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping);
+        if (!m_data) {
+            throw_last_error("Failed to map file");
+        }
+    }
+
+    void unmap() noexcept {
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+    }
+
+    [[noreturn]] static void throw_last_error(const char* message) {
+        throw std::system_error{static_cast<int>(GetLastError()),
+                                std::system_category(), message};
+    }
+#else
+    void map(const std::string& path) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        auto fd{::open(path.c_str(), O_RDONLY)};
+        if (fd < 0) {
+            throw_errno("Failed to open file");
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw_errno("Failed to get file size");
+        }
+        m_size = static_cast<size_t>(info.st_size);
+        if (m_size == 0) {
+            ::close(fd);
+            return;
+        }
+        auto* p{::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            throw_errno("Failed to map file");
+        }
+        m_data = static_cast<const std::uint8_t*>(p);
+    }
+
+    void unmap() noexcept {
+        if (m_data) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+            ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+        }
+    }
+
+    [[noreturn]] static void throw_errno(const char* message) {
+        throw std::system_error{errno, std::generic_category(), message};
+    }
+#endif
+
+    const std::uint8_t* m_data{};
+    size_t m_size{};
+};
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "macros.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Units of work, such as values visited, that a thread must be given to
+// make up for the tens of microseconds that it takes to start it.
+constexpr size_t parallel_work_per_thread{8192};
+
+// Calls a function for each index in [0, count) on up to max_threads
+// threads including the calling thread, or on one thread per hardware thread
+// if max_threads is 0. Each index is item_cost units of work, and threads are
+// only started for at least parallel_work_per_thread units each, so small
+// workloads stay on the calling thread. The first exception thrown is
+// rethrown.
+template<typename Fn>
+void parallel_for(size_t count, size_t item_cost, size_t max_threads, Fn fn) {
+    if (max_threads == 0) {
+        max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    auto items_per_thread{std::max<size_t>(count, 1)};
+    if (item_cost != 0) {
+        items_per_thread =
+            (parallel_work_per_thread + item_cost - 1) / item_cost;
+    }
+    max_threads = std::min(max_threads,
+                           std::max<size_t>(count / items_per_thread, 1));
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&] {
+        for (auto i{next++}; i < count; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock{error_mutex};
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    auto thread_count{std::min(count, max_threads)};
+    for (size_t i{1}; i < thread_count; ++i) {
+        try {
+            threads.emplace_back(work);
+        } catch (const std::system_error&) {
+            // Continue with the threads that could be started.
+            break;
+        }
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
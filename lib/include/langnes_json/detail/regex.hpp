@@ -0,0 +1,732 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../errors.hpp"
+#include "../string_ref.hpp"
+#include "macros.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Patterns that compile to more instructions, such as through large
+// repetition counts, or that nest groups more deeply are rejected.
+constexpr size_t max_regex_instructions{1U << 16U};
+constexpr size_t max_regex_nesting{256};
+
+constexpr std::uint32_t max_code_point{0x10ffffU};
+// Stands for the lack of a code point before the start or after the end.
+constexpr std::uint32_t no_code_point{0xffffffffU};
+
+// Sorted and disjoint ranges of code points, both ends included.
+using code_point_ranges = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+inline void normalize_ranges(code_point_ranges& ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    code_point_ranges merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    ranges = std::move(merged);
+}
+
+inline code_point_ranges complement_ranges(code_point_ranges ranges) {
+    normalize_ranges(ranges);
+    code_point_ranges result;
+    std::uint32_t next{};
+    for (const auto& range : ranges) {
+        if (range.first > next) {
+            result.emplace_back(next, range.first - 1);
+        }
+        next = range.second + 1;
+    }
+    if (next <= max_code_point) {
+        result.emplace_back(next, max_code_point);
+    }
+    return result;
+}
+
+inline bool contains_code_point(const code_point_ranges& ranges,
+                                std::uint32_t c) noexcept {
+    auto it{std::upper_bound(
+        ranges.begin(), ranges.end(), c,
+        [](std::uint32_t lhs, const std::pair<std::uint32_t, std::uint32_t>&
+                                  rhs) { return lhs < rhs.first; })};
+    return it != ranges.begin() && c <= (it - 1)->second;
+}
+
+inline bool is_word_code_point(std::uint32_t c) noexcept {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+           (c >= 'a' && c <= 'z') || c == '_';
+}
+
+// Decodes the code point at an offset and advances past it. Bytes that are
+// not valid UTF-8 are taken as code points of their own.
+inline std::uint32_t next_code_point(string_ref s, size_t& offset) noexcept {
+    auto length{utf8_sequence_length(s.data(), s.size(), offset)};
+    auto lead{static_cast<unsigned char>(s[offset])};
+    if (length <= 1) {
+        ++offset;
+        return lead;
+    }
+    std::uint32_t c{lead & (0xffU >> (length + 1))};
+    for (size_t i{1}; i < length; ++i) {
+        c = (c << 6U) | (static_cast<unsigned char>(s[offset + i]) & 0x3fU);
+    }
+    offset += length;
+    return c;
+}
+
+// Regular expression of a JSON Schema pattern in the ECMAScript syntax,
+// without backreferences and lookarounds. Every path through the pattern is
+// followed at once, so searching takes time linear in the length of the
+// text times the size of the pattern and never recurses. Patterns are
+// matched against code points rather than bytes.
+class regex {
+public:
+    // Throws invalid_argument if the pattern is malformed, unsupported or
+    // beyond the limits above.
+    explicit regex(const std::string& source) {
+        compiler{source, *this}.compile();
+    }
+
+    // Checks whether the pattern matches anywhere in a text.
+    bool search(string_ref text) const {
+        search_state state;
+        state.marks.assign(m_code.size(), 0);
+        size_t end{};
+        auto previous{no_code_point};
+        auto current{text.empty() ? no_code_point
+                                  : next_code_point(text, end)};
+        for (size_t position{};; ++position) {
+            // A match may start at every position.
+            if (add_thread(state, state.threads, 0, position, previous,
+                           current)) {
+                return true;
+            }
+            if (current == no_code_point) {
+                return false;
+            }
+            auto following_end{end};
+            auto following{end < text.size()
+                               ? next_code_point(text, following_end)
+                               : no_code_point};
+            state.next.clear();
+            for (auto index : state.threads) {
+                if (consumes(m_code[index], current) &&
+                    add_thread(state, state.next, index + 1, position + 1,
+                               current, following)) {
+                    return true;
+                }
+            }
+            state.threads.swap(state.next);
+            previous = current;
+            current = following;
+            end = following_end;
+        }
+    }
+
+private:
+    enum class op : std::uint8_t {
+        character,
+        set,
+        assertion,
+        split,
+        jump,
+        match
+    };
+
+    enum assertion_kind : std::uint32_t {
+        line_start,
+        line_end,
+        word_boundary,
+        not_word_boundary
+    };
+
+    // Splits continue at both x and y, and jumps at x.
+    struct instruction {
+        op code;
+        std::uint32_t x;
+        std::uint32_t y;
+    };
+
+    struct search_state {
+        std::vector<std::uint32_t> threads;
+        std::vector<std::uint32_t> next;
+        std::vector<std::uint32_t> stack;
+        // One more than the position at which each instruction was last
+        // added.
+        std::vector<size_t> marks;
+    };
+
+    // Follows splits, jumps and assertions from an instruction and adds the
+    // instructions that consume code points. Returns whether a match was
+    // reached.
+    bool add_thread(search_state& state, std::vector<std::uint32_t>& threads,
+                    std::uint32_t index, size_t position,
+                    std::uint32_t previous, std::uint32_t current) const {
+        state.stack.push_back(index);
+        while (!state.stack.empty()) {
+            auto i{state.stack.back()};
+            state.stack.pop_back();
+            if (state.marks[i] == position + 1) {
+                continue;
+            }
+            state.marks[i] = position + 1;
+            const auto& ins{m_code[i]};
+            switch (ins.code) {
+            case op::jump:
+                state.stack.push_back(ins.x);
+                break;
+            case op::split:
+                state.stack.push_back(ins.y);
+                state.stack.push_back(ins.x);
+                break;
+            case op::assertion:
+                if (holds(ins.x, previous, current)) {
+                    state.stack.push_back(i + 1);
+                }
+                break;
+            case op::match:
+                state.stack.clear();
+                return true;
+            default:
+                threads.push_back(i);
+                break;
+            }
+        }
+        return false;
+    }
+
+    static bool holds(std::uint32_t kind, std::uint32_t previous,
+                      std::uint32_t current) noexcept {
+        switch (kind) {
+        case line_start:
+            return previous == no_code_point;
+        case line_end:
+            return current == no_code_point;
+        default:
+            return (is_word_code_point(previous) ==
+                    is_word_code_point(current)) == (kind == not_word_boundary);
+        }
+    }
+
+    bool consumes(const instruction& ins, std::uint32_t c) const noexcept {
+        if (ins.code == op::character) {
+            return ins.x == c;
+        }
+        return contains_code_point(m_sets[ins.x], c);
+    }
+
+    // Parses a pattern into a tree and then emits the instructions of the
+    // tree, repeating the instructions of repeated subpatterns.
+    class compiler {
+    public:
+        compiler(const std::string& source, regex& result)
+            : m_source{source},
+              m_result{result} {}
+
+        void compile() {
+            auto root{parse_disjunction(0)};
+            if (m_offset != m_source.size()) {
+                throw invalid_argument{};
+            }
+            emit(root);
+            push(op::match);
+        }
+
+    private:
+        enum class kind : std::uint8_t {
+            character,
+            set,
+            assertion,
+            sequence,
+            alternation,
+            repetition
+        };
+
+        static constexpr size_t unbounded{std::numeric_limits<size_t>::max()};
+
+        struct node {
+            kind type;
+            // Code point, set or assertion.
+            std::uint32_t value;
+            std::vector<size_t> children;
+            size_t min;
+            size_t max;
+        };
+
+        size_t add_node(kind type, std::uint32_t value = 0,
+                        std::vector<size_t> children = {}, size_t min = 0,
+                        size_t max = 0) {
+            m_nodes.push_back({type, value, std::move(children), min, max});
+            return m_nodes.size() - 1;
+        }
+
+        size_t add_set(code_point_ranges ranges) {
+            normalize_ranges(ranges);
+            m_result.m_sets.push_back(std::move(ranges));
+            return add_node(kind::set, static_cast<std::uint32_t>(
+                                           m_result.m_sets.size() - 1));
+        }
+
+        bool at_end() const noexcept { return m_offset >= m_source.size(); }
+
+        char peek() const noexcept { return m_source[m_offset]; }
+
+        bool accept(char c) noexcept {
+            if (!at_end() && peek() == c) {
+                ++m_offset;
+                return true;
+            }
+            return false;
+        }
+
+        char next() {
+            if (at_end()) {
+                throw invalid_argument{};
+            }
+            return m_source[m_offset++];
+        }
+
+        size_t parse_disjunction(size_t depth) {
+            if (depth > max_regex_nesting) {
+                throw invalid_argument{};
+            }
+            std::vector<size_t> alternatives{parse_alternative(depth)};
+            while (accept('|')) {
+                alternatives.push_back(parse_alternative(depth));
+            }
+            if (alternatives.size() == 1) {
+                return alternatives.front();
+            }
+            return add_node(kind::alternation, 0, std::move(alternatives));
+        }
+
+        size_t parse_alternative(size_t depth) {
+            std::vector<size_t> terms;
+            while (!at_end() && peek() != '|' && peek() != ')') {
+                terms.push_back(parse_term(depth));
+            }
+            return add_node(kind::sequence, 0, std::move(terms));
+        }
+
+        size_t parse_term(size_t depth) {
+            std::uint32_t assertion{};
+            if (accept('^')) {
+                assertion = line_start;
+            } else if (accept('$')) {
+                assertion = line_end;
+            } else if (m_source.compare(m_offset, 2, "\\b") == 0) {
+                assertion = word_boundary;
+            } else if (m_source.compare(m_offset, 2, "\\B") == 0) {
+                assertion = not_word_boundary;
+            } else {
+                return parse_quantifier(parse_atom(depth));
+            }
+            if (assertion == word_boundary ||
+                assertion == not_word_boundary) {
+                m_offset += 2;
+            }
+            auto result{add_node(kind::assertion, assertion)};
+            // Assertions cannot be repeated.
+            if (parse_quantifier(result) != result) {
+                throw invalid_argument{};
+            }
+            return result;
+        }
+
+        size_t parse_atom(size_t depth) {
+            auto c{peek()};
+            switch (c) {
+            case '(':
+                return parse_group(depth);
+            case '.':
+                ++m_offset;
+                // Any code point except line terminators.
+                return add_set(complement_ranges(
+                    {{'\n', '\n'}, {'\r', '\r'}, {0x2028U, 0x2029U}}));
+            case '[':
+                ++m_offset;
+                return parse_class();
+            case '\\':
+                ++m_offset;
+                return parse_atom_escape();
+            case '*':
+            case '+':
+            case '?':
+                throw invalid_argument{};
+            case '{': {
+                // Braces are literal unless they form a quantifier.
+                size_t min{};
+                size_t max{};
+                if (parse_braces(min, max)) {
+                    throw invalid_argument{};
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            return add_node(kind::character,
+                            next_code_point(m_source, m_offset));
+        }
+
+        size_t parse_group(size_t depth) {
+            ++m_offset;
+            // Named groups are plain groups since nothing is captured, and
+            // lookarounds are not supported.
+            if (accept('?') && !accept(':')) {
+                if (!accept('<') || at_end() || peek() == '=' ||
+                    peek() == '!') {
+                    throw invalid_argument{};
+                }
+                auto close{m_source.find('>', m_offset)};
+                if (close == std::string::npos) {
+                    throw invalid_argument{};
+                }
+                m_offset = close + 1;
+            }
+            auto result{parse_disjunction(depth + 1)};
+            if (!accept(')')) {
+                throw invalid_argument{};
+            }
+            return result;
+        }
+
+        size_t parse_quantifier(size_t atom) {
+            size_t min{};
+            size_t max{unbounded};
+            if (accept('*')) {
+            } else if (accept('+')) {
+                min = 1;
+            } else if (accept('?')) {
+                max = 1;
+            } else if (!parse_braces(min, max)) {
+                return atom;
+            }
+            // Lazy quantifiers match the same texts.
+            accept('?');
+            if (min > max) {
+                throw invalid_argument{};
+            }
+            return add_node(kind::repetition, 0, {atom}, min, max);
+        }
+
+        // Parses {n}, {n,} or {n,m}, or leaves the offset unchanged if there
+        // is no such quantifier.
+        bool parse_braces(size_t& min, size_t& max) {
+            auto start{m_offset};
+            if (!accept('{') || !parse_count(min)) {
+                m_offset = start;
+                return false;
+            }
+            max = min;
+            if (accept(',')) {
+                max = unbounded;
+                parse_count(max);
+            }
+            if (!accept('}')) {
+                m_offset = start;
+                return false;
+            }
+            return true;
+        }
+
+        // Counts beyond the instruction limit are capped, as they are
+        // rejected anyway.
+        bool parse_count(size_t& result) {
+            if (at_end() || peek() < '0' || peek() > '9') {
+                return false;
+            }
+            result = 0;
+            while (!at_end() && peek() >= '0' && peek() <= '9') {
+                result = std::min(result * 10 + static_cast<size_t>(
+                                                    next() - '0'),
+                                  max_regex_instructions + 1);
+            }
+            return true;
+        }
+
+        size_t parse_atom_escape() {
+            code_point_ranges ranges;
+            if (parse_class_escape(ranges)) {
+                return add_set(std::move(ranges));
+            }
+            return add_node(kind::character, parse_character_escape());
+        }
+
+        // Parses \d, \D, \w, \W, \s and \S after the backslash.
+        bool parse_class_escape(code_point_ranges& ranges) {
+            if (at_end()) {
+                throw invalid_argument{};
+            }
+            code_point_ranges result;
+            auto c{peek()};
+            switch (c) {
+            case 'd':
+            case 'D':
+                result = {{'0', '9'}};
+                break;
+            case 'w':
+            case 'W':
+                result = {{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}};
+                break;
+            case 's':
+            case 'S':
+                result = {{'\t', '\r'},       {' ', ' '},
+                          {0xa0U, 0xa0U},     {0x1680U, 0x1680U},
+                          {0x2000U, 0x200aU}, {0x2028U, 0x2029U},
+                          {0x202fU, 0x202fU}, {0x205fU, 0x205fU},
+                          {0x3000U, 0x3000U}, {0xfeffU, 0xfeffU}};
+                break;
+            default:
+                return false;
+            }
+            ++m_offset;
+            if (c == 'D' || c == 'W' || c == 'S') {
+                result = complement_ranges(std::move(result));
+            }
+            ranges.insert(ranges.end(), result.begin(), result.end());
+            return true;
+        }
+
+        // Parses an escaped code point after the backslash.
+        std::uint32_t parse_character_escape() {
+            auto c{next()};
+            switch (c) {
+            case 't':
+                return '\t';
+            case 'n':
+                return '\n';
+            case 'v':
+                return '\v';
+            case 'f':
+                return '\f';
+            case 'r':
+                return '\r';
+            case '0':
+                if (!at_end() && peek() >= '0' && peek() <= '9') {
+                    throw invalid_argument{};
+                }
+                return 0;
+            case 'x':
+                return parse_hex(2);
+            case 'u': {
+                auto result{parse_hex(4)};
+                if (is_high_surrogate(result) &&
+                    m_source.compare(m_offset, 2, "\\u") == 0) {
+                    auto start{m_offset};
+                    m_offset += 2;
+                    auto low{parse_hex(4)};
+                    if (is_low_surrogate(low)) {
+                        return static_cast<std::uint32_t>(
+                            combine_surrogates(result, low));
+                    }
+                    m_offset = start;
+                }
+                return result;
+            }
+            case 'c': {
+                auto letter{next()};
+                if (!std::isalpha(static_cast<unsigned char>(letter))) {
+                    throw invalid_argument{};
+                }
+                return static_cast<std::uint32_t>(letter) % 32U;
+            }
+            default:
+                break;
+            }
+            // Backreferences, property escapes and unknown letters would
+            // silently match something else.
+            if (std::isalnum(static_cast<unsigned char>(c))) {
+                throw invalid_argument{};
+            }
+            --m_offset;
+            return next_code_point(m_source, m_offset);
+        }
+
+        std::uint32_t parse_hex(size_t digits) {
+            std::uint32_t result{};
+            for (size_t i{}; i < digits; ++i) {
+                auto c{next()};
+                std::uint32_t digit{};
+                if (c >= '0' && c <= '9') {
+                    digit = static_cast<std::uint32_t>(c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    digit = static_cast<std::uint32_t>(c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    digit = static_cast<std::uint32_t>(c - 'A' + 10);
+                } else {
+                    throw invalid_argument{};
+                }
+                result = result * 16 + digit;
+            }
+            return result;
+        }
+
+        // Parses a character class after the opening bracket.
+        size_t parse_class() {
+            auto negate{accept('^')};
+            code_point_ranges ranges;
+            while (!accept(']')) {
+                std::uint32_t first{};
+                if (!parse_class_atom(ranges, first)) {
+                    continue;
+                }
+                auto last{first};
+                if (m_offset + 1 < m_source.size() && peek() == '-' &&
+                    m_source[m_offset + 1] != ']') {
+                    ++m_offset;
+                    if (!parse_class_atom(ranges, last) || last < first) {
+                        throw invalid_argument{};
+                    }
+                }
+                ranges.emplace_back(first, last);
+            }
+            if (negate) {
+                ranges = complement_ranges(std::move(ranges));
+            }
+            return add_set(std::move(ranges));
+        }
+
+        // Parses a code point of a character class, or adds the ranges of a
+        // class escape and returns false.
+        bool parse_class_atom(code_point_ranges& ranges,
+                              std::uint32_t& result) {
+            if (at_end()) {
+                throw invalid_argument{};
+            }
+            if (!accept('\\')) {
+                result = next_code_point(m_source, m_offset);
+                return true;
+            }
+            if (parse_class_escape(ranges)) {
+                return false;
+            }
+            if (accept('b')) {
+                result = '\b';
+            } else if (accept('-')) {
+                result = '-';
+            } else {
+                result = parse_character_escape();
+            }
+            return true;
+        }
+
+        size_t push(op code, std::uint32_t x = 0) {
+            auto& program{m_result.m_code};
+            if (program.size() >= max_regex_instructions) {
+                throw invalid_argument{};
+            }
+            program.push_back({code, x, 0});
+            return program.size() - 1;
+        }
+
+        std::uint32_t here() const noexcept {
+            return static_cast<std::uint32_t>(m_result.m_code.size());
+        }
+
+        void emit(size_t index) {
+            const auto& n{m_nodes[index]};
+            auto& program{m_result.m_code};
+            switch (n.type) {
+            case kind::character:
+                push(op::character, n.value);
+                break;
+            case kind::set:
+                push(op::set, n.value);
+                break;
+            case kind::assertion:
+                push(op::assertion, n.value);
+                break;
+            case kind::sequence:
+                for (auto child : n.children) {
+                    emit(child);
+                }
+                break;
+            case kind::alternation: {
+                std::vector<size_t> jumps;
+                for (size_t i{}; i + 1 < n.children.size(); ++i) {
+                    auto split{push(op::split)};
+                    program[split].x = here();
+                    emit(n.children[i]);
+                    jumps.push_back(push(op::jump));
+                    program[split].y = here();
+                }
+                emit(n.children.back());
+                for (auto jump : jumps) {
+                    program[jump].x = here();
+                }
+                break;
+            }
+            case kind::repetition:
+                emit_repetition(n);
+                break;
+            }
+        }
+
+        void emit_repetition(const node& n) {
+            auto& program{m_result.m_code};
+            auto child{n.children.front()};
+            for (size_t i{}; i < n.min; ++i) {
+                emit(child);
+            }
+            if (n.max == unbounded) {
+                auto split{push(op::split)};
+                program[split].x = here();
+                emit(child);
+                push(op::jump, static_cast<std::uint32_t>(split));
+                program[split].y = here();
+                return;
+            }
+            std::vector<size_t> splits;
+            for (auto i{n.min}; i < n.max; ++i) {
+                splits.push_back(push(op::split));
+                program[splits.back()].x = here();
+                emit(child);
+            }
+            for (auto split : splits) {
+                program[split].y = here();
+            }
+        }
+
+        const std::string& m_source;
+        regex& m_result;
+        size_t m_offset{};
+        std::vector<node> m_nodes;
+    };
+
+    std::vector<instruction> m_code;
+    std::vector<code_point_ranges> m_sets;
+};
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
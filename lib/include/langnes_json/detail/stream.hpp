@@ -19,6 +19,7 @@
 #include "macros.hpp"
 
 #include <istream>
+#include <ostream>
 #include <streambuf>
 #include <string>
 
@@ -43,6 +44,27 @@ public:
     string_streambuf& operator=(const string_streambuf&) = delete;
     string_streambuf& operator=(string_streambuf&&) = delete;
     ~string_streambuf() override = default;
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override {
+        if ((which & std::ios_base::in) == 0) {
+            return pos_type(off_type(-1));
+        }
+        auto* base{dir == std::ios_base::beg   ? eback()
+                   : dir == std::ios_base::cur ? gptr()
+                                               : egptr()};
+        if (off < eback() - base || off > egptr() - base) {
+            return pos_type(off_type(-1));
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        setg(eback(), base + off, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
 };
 
 class string_istream_data {
@@ -107,5 +129,41 @@ inline string_istream make_istream(Container&& data) noexcept {
     return string_istream{std::forward<Container>(data)};
 }
 
+// Gets the read position of a stream without affecting its state.
+inline size_t get_read_position(std::istream& is) {
+    return static_cast<size_t>(
+        is.rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::in));
+}
+
+// Writes into a fixed-size buffer and keeps counting once the buffer is full.
+class buffer_streambuf : public std::streambuf {
+public:
+    buffer_streambuf(char* data, size_t length) noexcept {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        setp(data, data + length);
+    }
+
+    buffer_streambuf(const buffer_streambuf&) = delete;
+    buffer_streambuf(buffer_streambuf&&) = delete;
+    buffer_streambuf& operator=(const buffer_streambuf&) = delete;
+    buffer_streambuf& operator=(buffer_streambuf&&) = delete;
+    ~buffer_streambuf() override = default;
+
+    size_t required_length() const noexcept {
+        return static_cast<size_t>(pptr() - pbase()) + m_overflow_length;
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            ++m_overflow_length;
+        }
+        return traits_type::not_eof(c);
+    }
+
+private:
+    size_t m_overflow_length{};
+};
+
 } // namespace detail
 LANGNES_JSON_CXX_NS_END
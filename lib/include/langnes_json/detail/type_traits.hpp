@@ -35,5 +35,21 @@ using remove_cvref_t = typename remove_cvref<T>::type;
 template<bool Condition, typename T = void>
 using enable_if_t = typename std::enable_if<Condition, T>::type;
 
+template<typename...>
+struct make_void {
+    using type = void;
+};
+
+template<typename... Ts>
+using void_t = typename make_void<Ts...>::type;
+
+template<bool...>
+struct bool_pack;
+
+// Whether all conditions are true.
+template<bool... Conditions>
+using all_true = std::is_same<bool_pack<true, Conditions...>,
+                              bool_pack<Conditions..., true>>;
+
 } // namespace detail
 LANGNES_JSON_CXX_NS_END
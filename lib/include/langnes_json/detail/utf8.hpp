@@ -19,31 +19,136 @@
 #include "../errors.hpp"
 #include "macros.hpp"
 
+#include <cstdint>
+#include <cstring>
 #include <string>
 
 LANGNES_JSON_CXX_NS_BEGIN
 namespace detail {
 
+// Encodes a code point as UTF-8 into a buffer of at least 4 bytes and
+// returns the number of bytes written.
+inline size_t encode_utf8(size_t c, char* out) {
+    if (c <= 0x7fU) {
+        out[0] = static_cast<char>(c);
+        return 1;
+    }
+    if (c <= 0x7ffU) {
+        out[0] = static_cast<char>(0xc0U | (c >> 6U));
+        out[1] = static_cast<char>(0x80U | (c & 0x3fU));
+        return 2;
+    }
+    if (c <= 0xffffU) {
+        out[0] = static_cast<char>(0xe0U | (c >> 12U));
+        out[1] = static_cast<char>(0x80U | ((c >> 6U) & 0x3fU));
+        out[2] = static_cast<char>(0x80U | (c & 0x3fU));
+        return 3;
+    }
+    if (c <= 0x10ffffU) {
+        out[0] = static_cast<char>(0xf0U | (c >> 18U));
+        out[1] = static_cast<char>(0x80U | ((c >> 12U) & 0x3fU));
+        out[2] = static_cast<char>(0x80U | ((c >> 6U) & 0x3fU));
+        out[3] = static_cast<char>(0x80U | (c & 0x3fU));
+        return 4;
+    }
+    throw out_of_range{"Invalid code point"};
+}
+
+template<typename String>
+void append_utf8(String& s, size_t c) {
+    char buffer[4];
+    s.append(buffer, encode_utf8(c, buffer));
+}
+
 inline std::string to_utf8_char(size_t c) {
     std::string s;
-    if (c <= 0x7fU) {
-        s.push_back(static_cast<char>(c));
-    } else if (c <= 0x7ffU) {
-        s.push_back(static_cast<char>(0xc0U | (c >> 6U)));
-        s.push_back(static_cast<char>(0x80U | (c & 0x3fU)));
-    } else if (c <= 0xffffU) {
-        s.push_back(static_cast<char>(0xe0U | (c >> 12U)));
-        s.push_back(static_cast<char>(0x80U | ((c >> 6U) & 0x3fU)));
-        s.push_back(static_cast<char>(0x80U | (c & 0x3fU)));
-    } else if (c <= 0x10ffffU) {
-        s.push_back(static_cast<char>(0xf0U | (c >> 18U)));
-        s.push_back(static_cast<char>(0x80U | ((c >> 12U) & 0x3fU)));
-        s.push_back(static_cast<char>(0x80U | ((c >> 6U) & 0x3fU)));
-        s.push_back(static_cast<char>(0x80U | (c & 0x3fU)));
+    append_utf8(s, c);
+    return s;
+}
+
+constexpr bool is_high_surrogate(size_t c) noexcept {
+    return c >= 0xd800U && c <= 0xdbffU;
+}
+
+constexpr bool is_low_surrogate(size_t c) noexcept {
+    return c >= 0xdc00U && c <= 0xdfffU;
+}
+
+// Joins a UTF-16 surrogate pair into the code point it represents.
+constexpr size_t combine_surrogates(size_t high, size_t low) noexcept {
+    return 0x10000U + ((high - 0xd800U) << 10U) + (low - 0xdc00U);
+}
+
+// Every byte of a word at once, as long as bytes are ASCII.
+namespace word_bits {
+constexpr std::uint64_t ones{0x0101010101010101U};
+constexpr std::uint64_t highs{0x8080808080808080U};
+} // namespace word_bits
+
+inline std::uint64_t load_word(const char* data) noexcept {
+    std::uint64_t result{};
+    std::memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+// Gets the length of the UTF-8 sequence at an offset, or 0 if it is
+// invalid. Overlong encodings, surrogates and code points beyond U+10FFFF
+// are invalid.
+inline size_t utf8_sequence_length(const char* data, size_t length,
+                                   size_t offset) noexcept {
+    auto byte = [&](size_t i) {
+        return static_cast<unsigned char>(data[offset + i]);
+    };
+    auto lead{byte(0)};
+    if (lead < 0x80U) {
+        return 1;
+    }
+    size_t size{};
+    // Bounds of the second byte, which rule out the invalid code points.
+    unsigned char low{0x80U};
+    unsigned char high{0xbfU};
+    if (lead >= 0xc2U && lead <= 0xdfU) {
+        size = 2;
+    } else if (lead >= 0xe0U && lead <= 0xefU) {
+        size = 3;
+        low = lead == 0xe0U ? 0xa0U : low;
+        high = lead == 0xedU ? 0x9fU : high;
+    } else if (lead >= 0xf0U && lead <= 0xf4U) {
+        size = 4;
+        low = lead == 0xf0U ? 0x90U : low;
+        high = lead == 0xf4U ? 0x8fU : high;
     } else {
-        throw out_of_range{"Invalid code point"};
+        return 0;
     }
-    return s;
+    if (length - offset < size || byte(1) < low || byte(1) > high) {
+        return 0;
+    }
+    for (size_t i{2}; i < size; ++i) {
+        if ((byte(i) & 0xc0U) != 0x80U) {
+            return 0;
+        }
+    }
+    return size;
+}
+
+// Checks whether text is valid UTF-8, skipping ASCII a word at a time.
+inline bool is_valid_utf8(const char* data, size_t length) noexcept {
+    size_t i{};
+    while (i < length) {
+        while (length - i >= sizeof(std::uint64_t) &&
+               (load_word(data + i) & word_bits::highs) == 0) {
+            i += sizeof(std::uint64_t);
+        }
+        if (i == length) {
+            break;
+        }
+        auto size{utf8_sequence_length(data, length, i)};
+        if (size == 0) {
+            return false;
+        }
+        i += size;
+    }
+    return true;
 }
 
 } // namespace detail
@@ -18,15 +18,22 @@
 
 #include "../errors.hpp"
 #include "../value.hpp"
+#include "../memory_resource.hpp"
 #include "dict.hpp"
 #include "macros.hpp"
 #include "memory.hpp"
 #include "type_traits.hpp"
 
-#include <deque>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 LANGNES_JSON_CXX_NS_BEGIN
 namespace detail {
@@ -38,6 +45,14 @@ public:
     value::type get_type() const noexcept { return m_type; }
     bool is_type(value::type type) const noexcept { return m_type == type; }
 
+    // Allocate from the default memory resource.
+    static void* operator new(size_t size) { return resource_new(size); }
+    static void* operator new(size_t /*size*/, void* p) noexcept { return p; }
+    static void operator delete(void* p, size_t size) noexcept {
+        resource_delete(p, size);
+    }
+    static void operator delete(void* /*p*/, void* /*place*/) noexcept {}
+
 protected:
     explicit value_impl_base(value::type type) noexcept : m_type{type} {}
     value_impl_base() = default;
@@ -50,11 +65,98 @@ private:
     value::type m_type{};
 };
 
+// Hashes of objects and arrays are cached by const code and are only valid
+// in the epoch in which they were cached. Mutable access to any value ends
+// the epoch if a hash has been cached in it. This also discards the hashes
+// of the enclosing values, which cannot be reached from a nested value that
+// is modified through a reference.
+class hash_epoch {
+public:
+    static std::uint64_t current() noexcept {
+        return counter().load(std::memory_order_relaxed);
+    }
+
+    // Gets the epoch to cache a hash in.
+    static std::uint64_t begin_caching() noexcept {
+        auto epoch{current()};
+        auto cached{last_cached().load(std::memory_order_relaxed)};
+        while (cached < epoch &&
+               !last_cached().compare_exchange_weak(
+                   cached, epoch, std::memory_order_relaxed)) {
+        }
+        return epoch;
+    }
+
+    static void on_write() noexcept {
+        auto epoch{current()};
+        if (last_cached().load(std::memory_order_relaxed) >= epoch) {
+            counter().compare_exchange_strong(epoch, epoch + 1,
+                                              std::memory_order_relaxed);
+        }
+    }
+
+private:
+    // Starts at one so that zero never refers to a valid epoch.
+    static std::atomic<std::uint64_t>& counter() noexcept {
+        static std::atomic<std::uint64_t> instance{1};
+        return instance;
+    }
+
+    static std::atomic<std::uint64_t>& last_cached() noexcept {
+        static std::atomic<std::uint64_t> instance{0};
+        return instance;
+    }
+};
+
+// The hash of an object or array, which may be cached by several threads at
+// once. They all cache the same hash since the value cannot change during
+// const access.
+class hash_cache {
+public:
+    hash_cache() noexcept = default;
+
+    hash_cache(const hash_cache& other) noexcept
+        : m_hash{other.m_hash.load(std::memory_order_relaxed)},
+          m_epoch{other.m_epoch.load(std::memory_order_relaxed)} {}
+
+    hash_cache& operator=(const hash_cache& other) noexcept {
+        m_hash.store(other.m_hash.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+        m_epoch.store(other.m_epoch.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+        return *this;
+    }
+
+    ~hash_cache() = default;
+
+    // Zero unless a hash has been cached in the current epoch.
+    std::uint64_t get() const noexcept {
+        if (m_epoch.load(std::memory_order_acquire) != hash_epoch::current()) {
+            return 0;
+        }
+        return m_hash.load(std::memory_order_relaxed);
+    }
+
+    void set(std::uint64_t hash) const noexcept {
+        auto epoch{hash_epoch::begin_caching()};
+        m_hash.store(hash, std::memory_order_relaxed);
+        m_epoch.store(epoch, std::memory_order_release);
+    }
+
+private:
+    mutable std::atomic<std::uint64_t> m_hash{};
+    mutable std::atomic<std::uint64_t> m_epoch{};
+};
+
 struct string_impl : public value_impl_base {
     string_impl() noexcept : value_impl_base{value::type::string} {}
 
+    explicit string_impl(string_ref data) noexcept
+        : value_impl_base{value::type::string},
+          m_data(data.data(), data.size()) {}
+
     template<typename T,
-             enable_if_t<std::is_convertible<T, std::string>::value>* = nullptr>
+             enable_if_t<std::is_same<T, value::string_type>::value>* = nullptr>
     explicit string_impl(T&& data) noexcept
         : value_impl_base{value::type::string},
           m_data{std::forward<T>(data)} {}
@@ -63,35 +165,238 @@ struct string_impl : public value_impl_base {
         return make_unique<string_impl>(*this);
     }
 
-    const std::string& data() const noexcept { return m_data; }
-    std::string& data() noexcept { return m_data; }
+    const value::string_type& data() const noexcept { return m_data; }
+    value::string_type& data() noexcept {
+        hash_epoch::on_write();
+        return m_data;
+    }
 
 private:
-    std::string m_data;
+    value::string_type m_data;
+};
+
+// Source text of a number loaded in raw mode and the double it converts to.
+struct raw_number {
+    raw_number(const std::string& text, double converted)
+        : text(text.data(), text.size()),
+          converted{converted} {}
+
+    // Allocate from the default memory resource.
+    static void* operator new(size_t size) { return resource_new(size); }
+    static void operator delete(void* p, size_t size) noexcept {
+        resource_delete(p, size);
+    }
+
+    value::string_type text;
+    double converted;
 };
 
 struct number_impl : public value_impl_base {
+    // How the number is stored. Non-negative integers are stored as int64
+    // unless they only fit in uint64.
+    enum class kind : unsigned char { int64, uint64, floating };
+
     number_impl() noexcept : value_impl_base{value::type::number} {}
 
-    template<typename T, enable_if_t<std::is_integral<T>::value>* = nullptr>
+    template<typename T,
+             enable_if_t<std::is_integral<T>::value &&
+                         std::is_signed<T>::value>* = nullptr>
     explicit number_impl(T data) noexcept
-        : number_impl{static_cast<double>(data)} {}
+        : value_impl_base{value::type::number},
+          m_kind{kind::int64} {
+        m_integer = static_cast<std::uint64_t>(data);
+    }
 
     template<typename T,
-             enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+             enable_if_t<std::is_integral<T>::value &&
+                         std::is_unsigned<T>::value>* = nullptr>
     explicit number_impl(T data) noexcept
         : value_impl_base{value::type::number},
-          m_data{data} {}
+          m_kind{data <= static_cast<std::uint64_t>(
+                             std::numeric_limits<std::int64_t>::max())
+                     ? kind::int64
+                     : kind::uint64} {
+        m_integer = data;
+    }
+
+    template<typename T,
+             enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+    explicit number_impl(T data) noexcept
+        : value_impl_base{value::type::number} {
+        m_double = static_cast<double>(data);
+    }
+
+    number_impl(const number_impl& other)
+        : value_impl_base{other},
+          m_kind{other.m_kind},
+          m_raw{other.m_raw ? make_unique<raw_number>(*other.m_raw)
+                            : nullptr} {
+        if (m_kind == kind::floating) {
+            m_double = other.m_double;
+        } else {
+            m_integer = other.m_integer;
+        }
+    }
+
+    number_impl(number_impl&&) noexcept = default;
+    number_impl& operator=(const number_impl&) = delete;
+    number_impl& operator=(number_impl&&) noexcept = default;
+    ~number_impl() override = default;
+
+    // Converts the text of a valid JSON number. Integers that fit in 64 bits
+    // are converted exactly without going through floating point.
+    static number_impl from_text(const std::string& text) noexcept {
+        if (text.find_first_of(".eE") != std::string::npos) {
+            return number_impl{std::strtod(text.c_str(), nullptr)};
+        }
+        auto is_negative{text[0] == '-'};
+        std::uint64_t magnitude{};
+        for (size_t i{is_negative ? 1U : 0U}; i < text.size(); ++i) {
+            auto digit{static_cast<std::uint64_t>(text[i] - '0')};
+            if (magnitude >
+                (std::numeric_limits<std::uint64_t>::max() - digit) / 10) {
+                return number_impl{std::strtod(text.c_str(), nullptr)};
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+        if (!is_negative) {
+            return number_impl{magnitude};
+        }
+        if (magnitude == 0) {
+            // Keep the sign of negative zero.
+            return number_impl{-0.0};
+        }
+        // The magnitude of the lowest value is 2^63.
+        constexpr auto max_negative_magnitude{
+            static_cast<std::uint64_t>(
+                std::numeric_limits<std::int64_t>::max()) +
+            1};
+        if (magnitude > max_negative_magnitude) {
+            return number_impl{std::strtod(text.c_str(), nullptr)};
+        }
+        if (magnitude == max_negative_magnitude) {
+            return number_impl{std::numeric_limits<std::int64_t>::min()};
+        }
+        return number_impl{-static_cast<std::int64_t>(magnitude)};
+    }
+
+    // Converts the text of a valid JSON number and keeps the text out of
+    // line so that numbers without it stay small.
+    static number_impl from_raw_text(const std::string& text) {
+        auto result{from_text(text)};
+        result.m_raw = make_unique<raw_number>(text, result.data());
+        return result;
+    }
 
     std::unique_ptr<value_impl_base> clone() const noexcept override {
         return make_unique<number_impl>(*this);
     }
 
-    double data() const noexcept { return m_data; }
-    double& data() noexcept { return m_data; }
+    kind get_kind() const noexcept { return m_kind; }
+
+    // Gets the source text if the number was loaded in raw mode and has not
+    // been modified since.
+    const value::string_type* raw_text() const noexcept {
+        if (!m_raw || data() != m_raw->converted) {
+            return nullptr;
+        }
+        return &m_raw->text;
+    }
+
+    double data() const noexcept {
+        switch (m_kind) {
+        case kind::int64:
+            return static_cast<double>(int64());
+        case kind::uint64:
+            return static_cast<double>(m_integer);
+        default:
+            return m_double;
+        }
+    }
+
+    // The number becomes a double since it may be modified through the
+    // reference.
+    double& data() noexcept {
+        hash_epoch::on_write();
+        if (m_kind != kind::floating) {
+            m_double = static_cast<const number_impl&>(*this).data();
+            m_kind = kind::floating;
+        }
+        return m_double;
+    }
+
+    bool to_int64(std::int64_t& result) const noexcept {
+        switch (m_kind) {
+        case kind::int64:
+            result = int64();
+            return true;
+        case kind::uint64:
+            return false;
+        default:
+            // The range is [-2^63, 2^63).
+            if (!(m_double >= -9223372036854775808.0 &&
+                  m_double < 9223372036854775808.0) ||
+                std::trunc(m_double) != m_double) {
+                return false;
+            }
+            result = static_cast<std::int64_t>(m_double);
+            return true;
+        }
+    }
+
+    // Whether the number can be stored as a double without losing anything,
+    // i.e. it is not an integer beyond 2^53 or raw text.
+    bool is_exact_double() const noexcept {
+        if (raw_text()) {
+            return false;
+        }
+        // Integers in the range [-2^53, 2^53] are exact.
+        constexpr std::uint64_t max_magnitude{std::uint64_t{1} << 53};
+        switch (m_kind) {
+        case kind::int64:
+            return int64() >= -static_cast<std::int64_t>(max_magnitude) &&
+                   int64() <= static_cast<std::int64_t>(max_magnitude);
+        case kind::uint64:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    bool to_uint64(std::uint64_t& result) const noexcept {
+        switch (m_kind) {
+        case kind::int64:
+            if (int64() < 0) {
+                return false;
+            }
+            result = m_integer;
+            return true;
+        case kind::uint64:
+            result = m_integer;
+            return true;
+        default:
+            // The range is [0, 2^64).
+            if (!(m_double >= 0 && m_double < 18446744073709551616.0) ||
+                std::trunc(m_double) != m_double) {
+                return false;
+            }
+            result = static_cast<std::uint64_t>(m_double);
+            return true;
+        }
+    }
 
 private:
-    double m_data{};
+    std::int64_t int64() const noexcept {
+        return static_cast<std::int64_t>(m_integer);
+    }
+
+    kind m_kind{kind::floating};
+    // Integers keep their exact value and other numbers a double.
+    union {
+        std::uint64_t m_integer;
+        double m_double{};
+    };
+    std::unique_ptr<raw_number> m_raw;
 };
 
 struct boolean_impl : public value_impl_base {
@@ -106,7 +411,10 @@ struct boolean_impl : public value_impl_base {
     }
 
     bool data() const noexcept { return m_data; }
-    bool& data() noexcept { return m_data; }
+    bool& data() noexcept {
+        hash_epoch::on_write();
+        return m_data;
+    }
 
 private:
     bool m_data{};
@@ -120,39 +428,273 @@ struct null_impl : public value_impl_base {
     }
 };
 
+// Value derived from const member functions on first use without changing
+// what it is derived from. Concurrent first uses may each create the value,
+// but only one of them is kept. Copies start out empty.
+template<typename T>
+class lazy_cache {
+public:
+    lazy_cache() noexcept = default;
+    lazy_cache(const lazy_cache& /*other*/) noexcept {}
+    lazy_cache(lazy_cache&& other) noexcept
+        : m_value{other.m_value.exchange(nullptr)} {}
+    ~lazy_cache() { reset(); }
+
+    lazy_cache& operator=(const lazy_cache& other) noexcept {
+        if (this != &other) {
+            reset();
+        }
+        return *this;
+    }
+
+    lazy_cache& operator=(lazy_cache&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_value = other.m_value.exchange(nullptr);
+        }
+        return *this;
+    }
+
+    template<typename Factory>
+    const T& get(Factory create) const {
+        auto* current{m_value.load(std::memory_order_acquire)};
+        if (current) {
+            return *current;
+        }
+        auto* storage{resource_new(sizeof(T))};
+        T* created{};
+        try {
+            created = new (storage) T(create());
+        } catch (...) {
+            resource_delete(storage, sizeof(T));
+            throw;
+        }
+        if (m_value.compare_exchange_strong(current, created,
+                                            std::memory_order_acq_rel)) {
+            return *created;
+        }
+        destroy(created);
+        return *current;
+    }
+
+    // Gets the value, or null if not created.
+    T* peek() const noexcept { return m_value.load(std::memory_order_acquire); }
+
+    // Takes the value, if created.
+    T* release() noexcept { return m_value.exchange(nullptr); }
+
+    void reset() noexcept { destroy(release()); }
+
+    static void destroy(T* p) noexcept {
+        if (p) {
+            p->~T();
+            resource_delete(p, sizeof(T));
+        }
+    }
+
+private:
+    mutable std::atomic<T*> m_value{};
+};
+
+// Ordered member names shared by objects that have the same members.
+using object_shape = value::object_type::keys_type;
+
+// Objects can share a shape and only store their member values in the order
+// of the shape. The members are a dict with shared keys either way, so const
+// and mutable access to them never copies the values. Adding or removing a
+// member copies the names into a private list.
 struct object_impl : public value_impl_base {
     object_impl() noexcept : value_impl_base{value::type::object} {}
 
+    object_impl(std::shared_ptr<const object_shape> shape,
+                value::array_type&& values) noexcept
+        : value_impl_base{value::type::object},
+          m_members{std::move(shape), std::move(values)} {}
+
     std::unique_ptr<value_impl_base> clone() const noexcept override {
         return make_unique<object_impl>(*this);
     }
 
-    const dict<std::string, value>& members() const noexcept {
+    const value::object_type& members() const noexcept { return m_members; }
+
+    value::object_type& members() noexcept {
+        hash_epoch::on_write();
         return m_members;
     }
-    dict<std::string, value>& members() noexcept { return m_members; }
+
+    // Null unless the object has a shared shape.
+    const object_shape* shape() const noexcept {
+        return m_members.shared_keys();
+    }
+
+    // The member values in order, which is the order of the shape if any.
+    const value::array_type& values() const noexcept {
+        return m_members.values();
+    }
+
+    size_t size() const noexcept { return m_members.size(); }
+
+    // Calls a function for every member in order until it returns false.
+    template<typename Fn>
+    bool all_members(Fn fn) const {
+        for (const auto& kv : m_members) {
+            if (!fn(kv.first, kv.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Gets a member by position.
+    std::pair<const value::string_type*, const value*>
+    member_at(size_t index) const {
+        const auto& entry{m_members.entry_at(index)};
+        return {&entry.first, &entry.second};
+    }
+
+    std::pair<const value::string_type*, value*> member_at(size_t index) {
+        auto entry{members().entry_at(index)};
+        return {&entry.first, &entry.second};
+    }
+
+    const value* find(string_ref name) const noexcept {
+        auto found{m_members.find(name)};
+        return found == m_members.end() ? nullptr : &found->second;
+    }
+
+    // A member value may be modified through the result.
+    value* find(string_ref name) noexcept {
+        auto found{members().find(name)};
+        return found == m_members.end() ? nullptr : &found->second;
+    }
+
+    // Zero unless a valid hash has been cached.
+    std::uint64_t cached_hash() const noexcept { return m_hash.get(); }
+    void cache_hash(std::uint64_t hash) const noexcept { m_hash.set(hash); }
 
 private:
-    dict<std::string, value> m_members;
+    value::object_type m_members;
+    hash_cache m_hash;
 };
 
+// Arrays of numbers can be stored packed as doubles instead of as separate
+// values. Reading never changes the layout: const access to the elements of
+// a packed array is served from a copy created on first use. Mutable access
+// to the elements switches to the generic layout for good, and that copy
+// becomes the elements so that references to it stay valid.
 struct array_impl : public value_impl_base {
+    using number_array_type = std::vector<double, allocator<double>>;
+
     array_impl() noexcept : value_impl_base{value::type::array} {}
 
+    explicit array_impl(number_array_type&& numbers) noexcept
+        : value_impl_base{value::type::array},
+          m_numbers{std::move(numbers)},
+          m_is_packed{true} {}
+
+    array_impl(const array_impl& other)
+        : value_impl_base{other},
+          m_elements{other.m_is_packed ? value::array_type{}
+                                       : other.generic_elements()},
+          m_numbers{other.m_numbers},
+          m_is_packed{other.m_is_packed},
+          m_hash{other.m_hash} {}
+
+    array_impl(array_impl&& other) noexcept
+        : value_impl_base{std::move(other)},
+          m_elements{std::move(other.generic_elements())},
+          m_numbers{std::move(other.m_numbers)},
+          m_is_packed{other.m_is_packed},
+          m_hash{other.m_hash} {}
+
+    array_impl& operator=(const array_impl&) = delete;
+    array_impl& operator=(array_impl&&) = delete;
+    ~array_impl() override = default;
+
     std::unique_ptr<value_impl_base> clone() const noexcept override {
         return make_unique<array_impl>(*this);
     }
 
-    const std::deque<value>& elements() const noexcept { return m_elements; }
-    std::deque<value>& elements() noexcept { return m_elements; }
+    const value::array_type& elements() const {
+        if (!m_is_packed) {
+            return generic_elements();
+        }
+        return m_unpacked.get([this] {
+            value::array_type elements;
+            elements.reserve(m_numbers.size());
+            for (auto number : m_numbers) {
+                elements.emplace_back(number);
+            }
+            return elements;
+        });
+    }
+
+    value::array_type& elements() {
+        hash_epoch::on_write();
+        unpack();
+        return generic_elements();
+    }
+
+    bool is_packed() const noexcept { return m_is_packed; }
+
+    size_t size() const noexcept {
+        return m_is_packed ? m_numbers.size() : generic_elements().size();
+    }
+
+    // Only valid while packed. Mutable access switches to the generic layout
+    // instead if the elements have been handed out by const access, since
+    // they could not reflect changes to the numbers, leaving no numbers.
+    const number_array_type& numbers() const noexcept { return m_numbers; }
+    number_array_type& numbers() noexcept {
+        if (m_is_packed && m_unpacked.peek()) {
+            m_numbers = number_array_type{};
+            m_is_packed = false;
+        }
+        hash_epoch::on_write();
+        return m_numbers;
+    }
+
+    // Zero unless a valid hash has been cached.
+    std::uint64_t cached_hash() const noexcept { return m_hash.get(); }
+    void cache_hash(std::uint64_t hash) const noexcept { m_hash.set(hash); }
 
 private:
-    std::deque<value> m_elements;
+    // The elements in the generic layout, which are the copy created by const
+    // access if the array was packed at the time.
+    const value::array_type& generic_elements() const noexcept {
+        const auto* unpacked{m_unpacked.peek()};
+        return unpacked ? *unpacked : m_elements;
+    }
+
+    value::array_type& generic_elements() noexcept {
+        auto* unpacked{m_unpacked.peek()};
+        return unpacked ? *unpacked : m_elements;
+    }
+
+    void unpack() {
+        if (!m_is_packed) {
+            return;
+        }
+        if (!m_unpacked.peek()) {
+            m_elements.reserve(m_numbers.size());
+            for (auto number : m_numbers) {
+                m_elements.emplace_back(number);
+            }
+        }
+        m_numbers = number_array_type{};
+        m_is_packed = false;
+    }
+
+    value::array_type m_elements;
+    number_array_type m_numbers;
+    bool m_is_packed{};
+    lazy_cache<value::array_type> m_unpacked;
+    hash_cache m_hash;
 };
 
 } // namespace detail
 
-inline const std::string& value::as_string() const {
+inline const value::string_type& value::as_string() const {
     using namespace detail;
     if (!m_impl->is_type(value::type::string)) {
         throw bad_access{};
@@ -168,6 +710,30 @@ inline double value::as_number() const {
     return dynamic_cast<const number_impl*>(m_impl.get())->data();
 }
 
+inline std::int64_t value::as_int64() const {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::number)) {
+        throw bad_access{};
+    }
+    std::int64_t result{};
+    if (!dynamic_cast<const number_impl*>(m_impl.get())->to_int64(result)) {
+        throw out_of_range{"Number is not representable as int64"};
+    }
+    return result;
+}
+
+inline std::uint64_t value::as_uint64() const {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::number)) {
+        throw bad_access{};
+    }
+    std::uint64_t result{};
+    if (!dynamic_cast<const number_impl*>(m_impl.get())->to_uint64(result)) {
+        throw out_of_range{"Number is not representable as uint64"};
+    }
+    return result;
+}
+
 inline bool value::as_boolean() const {
     using namespace detail;
     if (!m_impl->is_type(value::type::boolean)) {
@@ -176,7 +742,7 @@ inline bool value::as_boolean() const {
     return dynamic_cast<const boolean_impl*>(m_impl.get())->data();
 }
 
-inline const detail::dict<std::string, value>& value::as_object() const {
+inline const value::object_type& value::as_object() const {
     using namespace detail;
     if (!m_impl->is_type(value::type::object)) {
         throw bad_access{};
@@ -184,7 +750,7 @@ inline const detail::dict<std::string, value>& value::as_object() const {
     return dynamic_cast<const object_impl*>(m_impl.get())->members();
 }
 
-inline const std::deque<value>& value::as_array() const {
+inline const value::array_type& value::as_array() const {
     using namespace detail;
     if (!m_impl->is_type(value::type::array)) {
         throw bad_access{};
@@ -192,7 +758,28 @@ inline const std::deque<value>& value::as_array() const {
     return dynamic_cast<const array_impl*>(m_impl.get())->elements();
 }
 
-inline std::string& value::as_string() {
+inline span<const double> value::as_number_span() const {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::array)) {
+        throw bad_access{};
+    }
+    const auto* array{dynamic_cast<const array_impl*>(m_impl.get())};
+    if (!array->is_packed()) {
+        return {};
+    }
+    const auto& numbers{array->numbers()};
+    return {numbers.data(), numbers.size()};
+}
+
+inline const value* value::find_member(string_ref name) const {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::object)) {
+        throw bad_access{};
+    }
+    return dynamic_cast<const object_impl*>(m_impl.get())->find(name);
+}
+
+inline value::string_type& value::as_string() {
     if (!m_impl->is_type(value::type::string)) {
         using namespace detail;
         throw bad_access{};
@@ -216,7 +803,7 @@ inline bool& value::as_boolean() {
     return dynamic_cast<boolean_impl*>(m_impl.get())->data();
 }
 
-inline detail::dict<std::string, value>& value::as_object() {
+inline value::object_type& value::as_object() {
     using namespace detail;
     if (!m_impl->is_type(value::type::object)) {
         throw bad_access{};
@@ -224,7 +811,7 @@ inline detail::dict<std::string, value>& value::as_object() {
     return dynamic_cast<object_impl*>(m_impl.get())->members();
 }
 
-inline std::deque<value>& value::as_array() {
+inline value::array_type& value::as_array() {
     using namespace detail;
     if (!m_impl->is_type(value::type::array)) {
         throw bad_access{};
@@ -232,6 +819,40 @@ inline std::deque<value>& value::as_array() {
     return dynamic_cast<array_impl*>(m_impl.get())->elements();
 }
 
+inline span<double> value::as_number_span() {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::array)) {
+        throw bad_access{};
+    }
+    auto* array{dynamic_cast<array_impl*>(m_impl.get())};
+    if (!array->is_packed()) {
+        return {};
+    }
+    auto& numbers{array->numbers()};
+    return {numbers.data(), numbers.size()};
+}
+
+inline value* value::find_member(string_ref name) {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::object)) {
+        throw bad_access{};
+    }
+    return dynamic_cast<object_impl*>(m_impl.get())->find(name);
+}
+
+template<typename Fn>
+void value::for_each_member(Fn fn) const {
+    using namespace detail;
+    if (!m_impl->is_type(value::type::object)) {
+        throw bad_access{};
+    }
+    dynamic_cast<const object_impl*>(m_impl.get())
+        ->all_members([&](const string_type& name, const value& member) {
+            fn(name, member);
+            return true;
+        });
+}
+
 inline bool value::is_type(value::type type) const noexcept {
     return m_impl->is_type(type);
 }
@@ -267,7 +888,9 @@ inline value::value(const value& rhs) noexcept {
     this->m_impl = rhs.m_impl->clone();
 }
 
-inline value::value(value&& rhs) noexcept : m_impl{std::move(rhs.m_impl)} {}
+inline value::value(value&& rhs) noexcept : m_impl{std::move(rhs.m_impl)} {
+    detail::hash_epoch::on_write();
+}
 
 inline value::value(std::unique_ptr<detail::value_impl_base>&& impl) noexcept
     : m_impl{std::move(impl)} {}
@@ -278,7 +901,10 @@ inline value::value(const char* data) noexcept
 inline value::value(const std::string& data) noexcept
     : m_impl{detail::make_unique<detail::string_impl>(data)} {}
 
-inline value::value(std::string&& data) noexcept
+inline value::value(const string_type& data) noexcept
+    : m_impl{detail::make_unique<detail::string_impl>(data)} {}
+
+inline value::value(string_type&& data) noexcept
     : m_impl{detail::make_unique<detail::string_impl>(std::move(data))} {}
 
 inline value::value(std::nullptr_t) noexcept
@@ -304,6 +930,7 @@ template<typename T,
               !std::is_same<detail::remove_cvref_t<T>, bool>::value) ||
              std::is_floating_point<T>::value>*>
 value& value::operator=(T from) noexcept {
+    detail::hash_epoch::on_write();
     m_impl = detail::make_unique<detail::number_impl>(std::forward<T>(from));
     return *this;
 }
@@ -311,11 +938,13 @@ value& value::operator=(T from) noexcept {
 template<typename T, detail::enable_if_t<
                          std::is_same<detail::remove_cvref_t<T>, bool>::value>*>
 value& value::operator=(T from) noexcept {
+    detail::hash_epoch::on_write();
     m_impl = detail::make_unique<detail::boolean_impl>(std::forward<T>(from));
     return *this;
 }
 
 inline value& value::operator=(const value& rhs) noexcept {
+    detail::hash_epoch::on_write();
     if (this == &rhs) {
         return *this;
     }
@@ -324,29 +953,41 @@ inline value& value::operator=(const value& rhs) noexcept {
 }
 
 inline value& value::operator=(value&& rhs) noexcept {
+    detail::hash_epoch::on_write();
     m_impl = std::move(rhs.m_impl);
     return *this;
 }
 
 inline value& value::operator=(const char* rhs) noexcept {
+    detail::hash_epoch::on_write();
     using namespace detail;
     m_impl = make_unique<string_impl>(rhs);
     return *this;
 }
 
 inline value& value::operator=(const std::string& rhs) noexcept {
+    detail::hash_epoch::on_write();
+    using namespace detail;
+    m_impl = make_unique<string_impl>(rhs);
+    return *this;
+}
+
+inline value& value::operator=(const string_type& rhs) noexcept {
+    detail::hash_epoch::on_write();
     using namespace detail;
     m_impl = make_unique<string_impl>(rhs);
     return *this;
 }
 
-inline value& value::operator=(std::string&& rhs) noexcept {
+inline value& value::operator=(string_type&& rhs) noexcept {
+    detail::hash_epoch::on_write();
     using namespace detail;
     m_impl = make_unique<string_impl>(std::move(rhs));
     return *this;
 }
 
 inline value& value::operator=(std::nullptr_t) noexcept {
+    detail::hash_epoch::on_write();
     using namespace detail;
     m_impl = make_unique<null_impl>();
     return *this;
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "detail/macros.hpp"
+#include "detail/value_impl.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Seeds that keep values of different types apart.
+namespace hash_seed {
+constexpr std::uint64_t object{0x6f626a6563740000U};
+constexpr std::uint64_t array{0x6172726179000000U};
+constexpr std::uint64_t string{0x737472696e670000U};
+constexpr std::uint64_t integer{0x696e746567657200U};
+constexpr std::uint64_t floating{0x666c6f6174000000U};
+constexpr std::uint64_t boolean{0x626f6f6c65616e00U};
+constexpr std::uint64_t null{0x6e756c6c00000000U};
+} // namespace hash_seed
+
+// Finalizer of SplitMix64.
+inline std::uint64_t mix_hash(std::uint64_t h) noexcept {
+    h ^= h >> 30U;
+    h *= 0xbf58476d1ce4e5b9U;
+    h ^= h >> 27U;
+    h *= 0x94d049bb133111ebU;
+    h ^= h >> 31U;
+    return h;
+}
+
+inline std::uint64_t combine_hash(std::uint64_t seed,
+                                  std::uint64_t h) noexcept {
+    return mix_hash(seed ^ (h + 0x9e3779b97f4a7c15U + (seed << 6U) +
+                            (seed >> 2U)));
+}
+
+inline std::uint64_t hash_string(string_ref s) noexcept {
+    return combine_hash(hash_seed::string, hash_bytes(s));
+}
+
+// Numbers are equal when their values are, regardless of how they are
+// stored, so integral values hash as integers.
+inline std::uint64_t hash_number(const number_impl& number) noexcept {
+    std::int64_t signed_integer{};
+    if (number.to_int64(signed_integer)) {
+        return combine_hash(hash_seed::integer,
+                            static_cast<std::uint64_t>(signed_integer));
+    }
+    std::uint64_t unsigned_integer{};
+    if (number.to_uint64(unsigned_integer)) {
+        return combine_hash(hash_seed::integer, unsigned_integer);
+    }
+    auto d{number.data()};
+    std::uint64_t bits{};
+    std::memcpy(&bits, &d, sizeof(bits));
+    return combine_hash(hash_seed::floating, bits);
+}
+
+inline bool numbers_equal(const number_impl& lhs,
+                          const number_impl& rhs) noexcept {
+    std::int64_t lhs_signed{};
+    std::int64_t rhs_signed{};
+    auto lhs_is_signed{lhs.to_int64(lhs_signed)};
+    auto rhs_is_signed{rhs.to_int64(rhs_signed)};
+    if (lhs_is_signed || rhs_is_signed) {
+        return lhs_is_signed && rhs_is_signed && lhs_signed == rhs_signed;
+    }
+    std::uint64_t lhs_unsigned{};
+    std::uint64_t rhs_unsigned{};
+    auto lhs_is_unsigned{lhs.to_uint64(lhs_unsigned)};
+    auto rhs_is_unsigned{rhs.to_uint64(rhs_unsigned)};
+    if (lhs_is_unsigned || rhs_is_unsigned) {
+        return lhs_is_unsigned && rhs_is_unsigned &&
+               lhs_unsigned == rhs_unsigned;
+    }
+    return lhs.data() == rhs.data();
+}
+
+// Hashes of objects and arrays by address, for hashing every subtree of a
+// document once without caching the hashes in the values themselves.
+using hash_memo = std::unordered_map<const value*, std::uint64_t>;
+
+inline std::uint64_t hash_value(const value& v, bool cache,
+                                hash_memo* memo = nullptr) {
+    using t = value::type;
+    switch (v.get_type()) {
+    case t::object: {
+        const auto& object{dynamic_cast<const object_impl&>(v.impl())};
+        if (auto h{object.cached_hash()}) {
+            return h;
+        }
+        if (memo) {
+            auto found{memo->find(&v)};
+            if (found != memo->end()) {
+                return found->second;
+            }
+        }
+        // Summing makes the result independent of the member order.
+        std::uint64_t sum{};
+        object.all_members([&](string_ref name, const value& member) {
+            sum += combine_hash(hash_string(name),
+                                hash_value(member, cache, memo));
+            return true;
+        });
+        auto h{combine_hash(combine_hash(hash_seed::object, object.size()),
+                            sum)};
+        // Zero means that nothing is cached.
+        h = h == 0 ? 1 : h;
+        if (cache) {
+            object.cache_hash(h);
+        }
+        if (memo) {
+            memo->emplace(&v, h);
+        }
+        return h;
+    }
+    case t::array: {
+        const auto& array{dynamic_cast<const array_impl&>(v.impl())};
+        if (auto h{array.cached_hash()}) {
+            return h;
+        }
+        if (memo) {
+            auto found{memo->find(&v)};
+            if (found != memo->end()) {
+                return found->second;
+            }
+        }
+        auto h{combine_hash(hash_seed::array, array.size())};
+        if (array.is_packed()) {
+            for (auto number : array.numbers()) {
+                h = combine_hash(h, hash_number(number_impl{number}));
+            }
+        } else {
+            for (const auto& element : array.elements()) {
+                h = combine_hash(h, hash_value(element, cache, memo));
+            }
+        }
+        h = h == 0 ? 1 : h;
+        if (cache) {
+            array.cache_hash(h);
+        }
+        if (memo) {
+            memo->emplace(&v, h);
+        }
+        return h;
+    }
+    case t::string:
+        return hash_string(v.as_string());
+    case t::number:
+        return hash_number(dynamic_cast<const number_impl&>(v.impl()));
+    case t::boolean:
+        return combine_hash(hash_seed::boolean, v.as_boolean() ? 1U : 0U);
+    default:
+        return hash_seed::null;
+    }
+}
+
+// Hashes only tell values apart when both are cached.
+inline bool hashes_differ(std::uint64_t lhs, std::uint64_t rhs) noexcept {
+    return lhs != 0 && rhs != 0 && lhs != rhs;
+}
+
+inline bool values_equal(const value& lhs, const value& rhs);
+
+inline bool objects_equal(const object_impl& lhs, const object_impl& rhs) {
+    if (lhs.size() != rhs.size() ||
+        hashes_differ(lhs.cached_hash(), rhs.cached_hash())) {
+        return false;
+    }
+    if (lhs.shape() && lhs.shape() == rhs.shape()) {
+        for (size_t i{}; i < lhs.size(); ++i) {
+            if (!values_equal(lhs.values()[i], rhs.values()[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return lhs.all_members([&](string_ref name, const value& member) {
+        const auto* other{rhs.find(name)};
+        return other && values_equal(member, *other);
+    });
+}
+
+inline bool number_equals_value(double number, const value& v) {
+    return v.is_number() &&
+           numbers_equal(number_impl{number},
+                         dynamic_cast<const number_impl&>(v.impl()));
+}
+
+inline bool arrays_equal(const array_impl& lhs, const array_impl& rhs) {
+    if (lhs.size() != rhs.size() ||
+        hashes_differ(lhs.cached_hash(), rhs.cached_hash())) {
+        return false;
+    }
+    if (lhs.is_packed() && rhs.is_packed()) {
+        return lhs.numbers() == rhs.numbers();
+    }
+    if (lhs.is_packed() || rhs.is_packed()) {
+        const auto& packed{lhs.is_packed() ? lhs : rhs};
+        const auto& other{lhs.is_packed() ? rhs : lhs};
+        for (size_t i{}; i < packed.size(); ++i) {
+            if (!number_equals_value(packed.numbers()[i],
+                                     other.elements()[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (size_t i{}; i < lhs.size(); ++i) {
+        if (!values_equal(lhs.elements()[i], rhs.elements()[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool values_equal(const value& lhs, const value& rhs) {
+    using t = value::type;
+    if (&lhs == &rhs) {
+        return true;
+    }
+    if (lhs.get_type() != rhs.get_type()) {
+        return false;
+    }
+    switch (lhs.get_type()) {
+    case t::object:
+        return objects_equal(dynamic_cast<const object_impl&>(lhs.impl()),
+                             dynamic_cast<const object_impl&>(rhs.impl()));
+    case t::array:
+        return arrays_equal(dynamic_cast<const array_impl&>(lhs.impl()),
+                            dynamic_cast<const array_impl&>(rhs.impl()));
+    case t::string:
+        return lhs.as_string() == rhs.as_string();
+    case t::number:
+        return numbers_equal(dynamic_cast<const number_impl&>(lhs.impl()),
+                             dynamic_cast<const number_impl&>(rhs.impl()));
+    case t::boolean:
+        return lhs.as_boolean() == rhs.as_boolean();
+    default:
+        return true;
+    }
+}
+
+} // namespace detail
+
+inline std::uint64_t value::hash(bool cache) const {
+    return detail::hash_value(*this, cache);
+}
+
+/**
+ * Compares JSON values deeply. Object members are compared regardless of
+ * their order, and numbers are compared by value regardless of how they are
+ * stored.
+ *
+ * @param lhs The first JSON value.
+ * @param rhs The second JSON value.
+ * @return Whether the values are equal.
+ */
+inline bool operator==(const value& lhs, const value& rhs) {
+    return detail::values_equal(lhs, rhs);
+}
+
+/// @copydoc operator==(const value&, const value&)
+inline bool operator!=(const value& lhs, const value& rhs) {
+    return !detail::values_equal(lhs, rhs);
+}
+
+LANGNES_JSON_CXX_NS_END
+
+namespace std {
+
+/// Hashes JSON values with value::hash().
+template<>
+struct hash<LANGNES_JSON_CXX_NS::value> {
+    size_t operator()(const LANGNES_JSON_CXX_NS::value& v) const {
+        return static_cast<size_t>(v.hash());
+    }
+};
+
+} // namespace std
@@ -27,6 +27,10 @@ typedef int langnes_json_error_code_t;
 extern "C" {
 #endif
 
+/// @see error_code::validation_error
+LANGNES_JSON_API const langnes_json_error_code_t
+    langnes_json_error_validation_error;
+
 /// @see error_code::parse_error
 LANGNES_JSON_API const langnes_json_error_code_t langnes_json_error_parse_error;
 
@@ -27,6 +27,7 @@ LANGNES_JSON_CXX_NS_BEGIN
  * Error code.
  */
 enum class error_code {
+    validation_error = -7,
     parse_error = -6,
     out_of_range = -5,
     bad_access = -4,
@@ -159,4 +160,41 @@ public:
         : error{error_code::out_of_range, "Out of range: " + message} {}
 };
 
+/**
+ * Validation error.
+ */
+class validation_error : public error {
+public:
+    /**
+     * Construct a new validation error.
+     *
+     * @param pointer JSON pointer to the value that is invalid.
+     * @param keyword The schema keyword that the value does not satisfy.
+     */
+    validation_error(const std::string& pointer, const std::string& keyword)
+        : error{error_code::validation_error,
+                "Validation error: Value at \"" + pointer +
+                    "\" does not satisfy \"" + keyword + "\""},
+          m_pointer{pointer},
+          m_keyword{keyword} {}
+
+    /**
+     * Get the JSON pointer to the value that is invalid.
+     *
+     * @return The JSON pointer.
+     */
+    const std::string& pointer() const noexcept { return m_pointer; }
+
+    /**
+     * Get the schema keyword that the value does not satisfy.
+     *
+     * @return The keyword.
+     */
+    const std::string& keyword() const noexcept { return m_keyword; }
+
+private:
+    std::string m_pointer;
+    std::string m_keyword;
+};
+
 LANGNES_JSON_CXX_NS_END
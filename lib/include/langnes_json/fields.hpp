@@ -0,0 +1,482 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/parsing.hpp"
+#include "detail/token_rules.hpp"
+#include "detail/type_traits.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "value.hpp"
+#include "writer.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @cond
+#define LANGNES_JSON_DETAIL_EXPAND(x) x
+#define LANGNES_JSON_DETAIL_FOR_EACH_1(m, x) m(x)
+#define LANGNES_JSON_DETAIL_FOR_EACH_2(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_1(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_3(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_2(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_4(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_3(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_5(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_4(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_6(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_5(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_7(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_6(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_8(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_7(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_9(m, x, ...)                              \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_8(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_10(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_9(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_11(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_10(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_12(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_11(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_13(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_12(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_14(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_13(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_15(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_14(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_16(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_15(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_17(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_16(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_18(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_17(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_19(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_18(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_20(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_19(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_21(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_20(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_22(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_21(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_23(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_22(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_24(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_23(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_25(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_24(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_26(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_25(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_27(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_26(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_28(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_27(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_29(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_28(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_30(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_29(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_31(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_30(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_FOR_EACH_32(m, x, ...)                             \
+    m(x) LANGNES_JSON_DETAIL_EXPAND(                                           \
+        LANGNES_JSON_DETAIL_FOR_EACH_31(m, __VA_ARGS__))
+// Selects the macro for the number of arguments. A trailing argument is
+// always passed so that the variadic part is never empty.
+#define LANGNES_JSON_DETAIL_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10,    \
+    _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24,      \
+    _25, _26, _27, _28, _29, _30, _31, _32, name, ...)                         \
+    name
+#define LANGNES_JSON_DETAIL_FOR_EACH(m, ...)                                   \
+    LANGNES_JSON_DETAIL_EXPAND(LANGNES_JSON_DETAIL_SELECT(                     \
+        __VA_ARGS__, LANGNES_JSON_DETAIL_FOR_EACH_32,                          \
+        LANGNES_JSON_DETAIL_FOR_EACH_31, LANGNES_JSON_DETAIL_FOR_EACH_30,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_29, LANGNES_JSON_DETAIL_FOR_EACH_28,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_27, LANGNES_JSON_DETAIL_FOR_EACH_26,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_25, LANGNES_JSON_DETAIL_FOR_EACH_24,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_23, LANGNES_JSON_DETAIL_FOR_EACH_22,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_21, LANGNES_JSON_DETAIL_FOR_EACH_20,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_19, LANGNES_JSON_DETAIL_FOR_EACH_18,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_17, LANGNES_JSON_DETAIL_FOR_EACH_16,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_15, LANGNES_JSON_DETAIL_FOR_EACH_14,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_13, LANGNES_JSON_DETAIL_FOR_EACH_12,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_11, LANGNES_JSON_DETAIL_FOR_EACH_10,      \
+        LANGNES_JSON_DETAIL_FOR_EACH_9, LANGNES_JSON_DETAIL_FOR_EACH_8,        \
+        LANGNES_JSON_DETAIL_FOR_EACH_7, LANGNES_JSON_DETAIL_FOR_EACH_6,        \
+        LANGNES_JSON_DETAIL_FOR_EACH_5, LANGNES_JSON_DETAIL_FOR_EACH_4,        \
+        LANGNES_JSON_DETAIL_FOR_EACH_3, LANGNES_JSON_DETAIL_FOR_EACH_2,        \
+        LANGNES_JSON_DETAIL_FOR_EACH_1, unused)(m, __VA_ARGS__))
+#define LANGNES_JSON_DETAIL_VISIT_FIELD(field) visitor(#field, object.field);
+/// @endcond
+
+/**
+ * Registers the public data members of a struct for loading and saving
+ * without a value tree in between, e.g.
+ * LANGNES_JSON_FIELDS(user, id, name, tags).
+ *
+ * Use the macro in the namespace of the struct. Members may be booleans,
+ * numbers, strings, values, std::vector, optional types such as
+ * std::optional and other registered structs. Member names are used as
+ * JSON member names.
+ *
+ * @param type The struct type.
+ * @param ... The names of the data members.
+ */
+#define LANGNES_JSON_FIELDS(type, ...)                                         \
+    template<typename Visitor>                                                 \
+    inline void langnes_json_fields(type& object, Visitor& visitor) {          \
+        LANGNES_JSON_DETAIL_FOR_EACH(LANGNES_JSON_DETAIL_VISIT_FIELD,          \
+                                     __VA_ARGS__)                              \
+    }                                                                          \
+    template<typename Visitor>                                                 \
+    inline void langnes_json_fields(const type& object, Visitor& visitor) {    \
+        LANGNES_JSON_DETAIL_FOR_EACH(LANGNES_JSON_DETAIL_VISIT_FIELD,          \
+                                     __VA_ARGS__)                              \
+    }
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+struct fields_probe {
+    template<size_t N, typename Field>
+    void operator()(const char (&/*name*/)[N], Field& /*field*/) {}
+};
+
+// Whether a type was registered with LANGNES_JSON_FIELDS.
+template<typename T, typename = void>
+struct has_fields : std::false_type {};
+
+template<typename T>
+struct has_fields<T, void_t<decltype(langnes_json_fields(
+                         std::declval<T&>(), std::declval<fields_probe&>()))>>
+    : std::true_type {};
+
+// Whether a type behaves like std::optional.
+template<typename T, typename = void>
+struct is_optional_like : std::false_type {};
+
+template<typename T>
+struct is_optional_like<
+    T, void_t<typename T::value_type, decltype(std::declval<T&>().has_value()),
+              decltype(std::declval<T&>().reset()),
+              decltype(std::declval<T&>().emplace())>> : std::true_type {};
+
+inline void read_field(std::istream& is, parse_context& ctx, bool& out);
+inline void read_field(std::istream& is, parse_context& ctx, std::string& out);
+inline void read_field(std::istream& is, parse_context& ctx, value& out);
+
+template<typename T,
+         enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value>* =
+             nullptr>
+void read_field(std::istream& is, parse_context& ctx, T& out);
+
+template<typename T,
+         enable_if_t<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                     !std::is_same<T, bool>::value>* = nullptr>
+void read_field(std::istream& is, parse_context& ctx, T& out);
+
+template<typename T,
+         enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+void read_field(std::istream& is, parse_context& ctx, T& out);
+
+template<typename T, typename Allocator>
+void read_field(std::istream& is, parse_context& ctx,
+                std::vector<T, Allocator>& out);
+
+template<typename T, enable_if_t<is_optional_like<T>::value>* = nullptr>
+void read_field(std::istream& is, parse_context& ctx, T& out);
+
+template<typename T, enable_if_t<has_fields<T>::value>* = nullptr>
+void read_field(std::istream& is, parse_context& ctx, T& out);
+
+// Reads the value of a member into the field with a matching name. Names
+// have a length known at compile time, so most fields are rejected without
+// comparing any characters.
+struct field_reader {
+    field_reader(std::istream& is, parse_context& ctx,
+                 const std::string& name) noexcept
+        : is{is},
+          ctx{ctx},
+          name{name} {}
+
+    template<size_t N, typename Field>
+    void operator()(const char (&field_name)[N], Field& field) {
+        if (found || name.size() != N - 1 ||
+            std::memcmp(name.data(), field_name, N - 1) != 0) {
+            return;
+        }
+        found = true;
+        read_field(is, ctx, field);
+    }
+
+    std::istream& is;
+    parse_context& ctx;
+    const std::string& name;
+    bool found{};
+};
+
+inline void read_field(std::istream& is, parse_context& /*ctx*/, bool& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    out = parse_boolean(is);
+}
+
+inline void read_field(std::istream& is, parse_context& ctx,
+                       std::string& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    out = parse_string<std::string>(is, ctx);
+}
+
+inline void read_field(std::istream& is, parse_context& ctx, value& out) {
+    out = parse_value(is, ctx);
+}
+
+template<typename T,
+         enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value>*>
+void read_field(std::istream& is, parse_context& ctx, T& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    std::int64_t result{};
+    if (!parse_number(is, ctx).to_int64(result) ||
+        result < std::numeric_limits<T>::min() ||
+        result > std::numeric_limits<T>::max()) {
+        throw out_of_range{"Number is out of range for the field"};
+    }
+    out = static_cast<T>(result);
+}
+
+template<typename T,
+         enable_if_t<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                     !std::is_same<T, bool>::value>*>
+void read_field(std::istream& is, parse_context& ctx, T& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    std::uint64_t result{};
+    if (!parse_number(is, ctx).to_uint64(result) ||
+        result > std::numeric_limits<T>::max()) {
+        throw out_of_range{"Number is out of range for the field"};
+    }
+    out = static_cast<T>(result);
+}
+
+template<typename T, enable_if_t<std::is_floating_point<T>::value>*>
+void read_field(std::istream& is, parse_context& ctx, T& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    out = static_cast<T>(parse_number(is, ctx).data());
+}
+
+template<typename T, typename Allocator>
+void read_field(std::istream& is, parse_context& ctx,
+                std::vector<T, Allocator>& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    expect(is, array_open);
+    enter_nesting(ctx);
+    skip_while(is, ws);
+    out.clear();
+    if (!peek(is, array_close)) {
+        while (true) {
+            // Read into a separate element since std::vector<bool> has no
+            // references to its elements.
+            T element{};
+            read_field(is, ctx, element);
+            out.push_back(std::move(element));
+            skip_while(is, ws);
+            if (peek(is, value_separator)) {
+                skip(is);
+                continue;
+            }
+            break;
+        }
+    }
+    expect(is, array_close);
+    leave_nesting(ctx);
+}
+
+template<typename T, enable_if_t<is_optional_like<T>::value>*>
+void read_field(std::istream& is, parse_context& ctx, T& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    if (try_parse_null(is)) {
+        out.reset();
+        return;
+    }
+    out.emplace();
+    read_field(is, ctx, *out);
+}
+
+// Members without a matching field are skipped, and fields without a
+// matching member keep their values.
+template<typename T, enable_if_t<has_fields<T>::value>*>
+void read_field(std::istream& is, parse_context& ctx, T& out) {
+    using namespace parsing;
+    using namespace token_rules;
+    skip_while(is, ws);
+    expect(is, object_open);
+    enter_nesting(ctx);
+    skip_while(is, ws);
+    if (!peek(is, object_close)) {
+        while (true) {
+            if (!peek(is, dquote)) {
+                throw unexpected_token{};
+            }
+            auto name{parse_string<std::string>(is, ctx)};
+            skip_while(is, ws);
+            expect(is, member_separator);
+            field_reader reader{is, ctx, name};
+            langnes_json_fields(out, reader);
+            if (!reader.found) {
+                skip_value(is);
+            }
+            skip_while(is, ws);
+            if (peek(is, value_separator)) {
+                skip(is);
+                skip_while(is, ws);
+                continue;
+            }
+            break;
+        }
+    }
+    expect(is, object_close);
+    leave_nesting(ctx);
+}
+
+template<typename T>
+T fully_parse_fields(std::istream& is, const parse_options& options) {
+    using namespace parsing;
+    using namespace token_rules;
+    scoped_resource scope{options.resource};
+    parse_context ctx{options};
+    T result{};
+    read_field(is, ctx, result);
+    skip_while(is, ws);
+    expect_fully_consumed(is);
+    return result;
+}
+
+inline void write_field(writer& w, bool v) { w.boolean(v); }
+inline void write_field(writer& w, const std::string& v) { w.string(v); }
+inline void write_field(writer& w, const value& v) { w.write(v); }
+
+template<typename T,
+         enable_if_t<std::is_integral<T>::value &&
+                     !std::is_same<T, bool>::value>* = nullptr>
+void write_field(writer& w, T v) {
+    w.number(v);
+}
+
+template<typename T,
+         enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+void write_field(writer& w, T v) {
+    w.number(static_cast<double>(v));
+}
+
+template<typename T, typename Allocator>
+void write_field(writer& w, const std::vector<T, Allocator>& v);
+
+template<typename T, enable_if_t<is_optional_like<T>::value>* = nullptr>
+void write_field(writer& w, const T& v);
+
+template<typename T, enable_if_t<has_fields<T>::value>* = nullptr>
+void write_field(writer& w, const T& v);
+
+struct field_writer {
+    explicit field_writer(writer& w) noexcept : w{w} {}
+
+    template<size_t N, typename Field>
+    void operator()(const char (&name)[N], const Field& field) {
+        w.key(name, N - 1);
+        write_field(w, field);
+    }
+
+    writer& w;
+};
+
+template<typename T, typename Allocator>
+void write_field(writer& w, const std::vector<T, Allocator>& v) {
+    w.begin_array();
+    for (const auto& element : v) {
+        write_field(w, element);
+    }
+    w.end_array();
+}
+
+template<typename T, enable_if_t<is_optional_like<T>::value>*>
+void write_field(writer& w, const T& v) {
+    if (v.has_value()) {
+        write_field(w, *v);
+    } else {
+        w.null();
+    }
+}
+
+template<typename T, enable_if_t<has_fields<T>::value>*>
+void write_field(writer& w, const T& v) {
+    w.begin_object();
+    field_writer fw{w};
+    langnes_json_fields(v, fw);
+    w.end_object();
+}
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
@@ -21,14 +21,23 @@
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstdint>
 #else
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #endif
 
 // NOLINTBEGIN(modernize-use-using)
 typedef struct langnes_json_value_t langnes_json_value_t;
 typedef struct langnes_json_string_t langnes_json_string_t;
+typedef struct langnes_json_writer_t langnes_json_writer_t;
+typedef struct langnes_json_columns_t langnes_json_columns_t;
+typedef struct langnes_json_msgpack_decoder_t langnes_json_msgpack_decoder_t;
+typedef struct langnes_json_snapshot_t langnes_json_snapshot_t;
+typedef struct langnes_json_schema_t langnes_json_schema_t;
+typedef struct langnes_json_query_t langnes_json_query_t;
+typedef struct langnes_json_query_results_t langnes_json_query_results_t;
 
 typedef enum {
     langnes_json_value_type_object,
@@ -38,6 +47,14 @@ typedef enum {
     langnes_json_value_type_boolean,
     langnes_json_value_type_null
 } langnes_json_value_type_t;
+
+/// Allocates memory aligned for any type. Returns NULL on failure.
+typedef void* (*langnes_json_malloc_fn_t)(size_t size, void* ctx);
+/// Frees memory previously allocated.
+typedef void (*langnes_json_free_fn_t)(void* p, void* ctx);
+/// Receives a chunk of output.
+typedef void (*langnes_json_write_fn_t)(const char* data, size_t length,
+                                        void* ctx);
 // NOLINTEND(modernize-use-using)
 
 #ifdef __cplusplus
@@ -72,11 +89,113 @@ LANGNES_JSON_API bool langnes_json_succeeded(langnes_json_error_code_t ec);
  */
 LANGNES_JSON_API bool langnes_json_failed(langnes_json_error_code_t ec);
 
+/**
+ * Sets the functions used to allocate JSON values, their containers, strings
+ * and member names, and the strings returned by the save functions.
+ *
+ * Values allocated before a change keep being freed with the functions that
+ * allocated them. Pass NULL for all functions to restore the default.
+ *
+ * @param malloc_fn Allocates memory.
+ * @param free_fn Frees memory.
+ * @param ctx User data passed to the functions.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_set_allocator(langnes_json_malloc_fn_t malloc_fn,
+                           langnes_json_free_fn_t free_fn, void* ctx);
+
+/**
+ * Options for loading JSON.
+ *
+ * Zero-initialize for the default behavior.
+ */
+struct langnes_json_parse_options_t {
+    /// Maximum nesting depth of arrays and objects, or 0 for no limit.
+    size_t max_depth;
+    /// Maximum length of strings in bytes after unescaping, or 0 for no limit.
+    size_t max_string_length;
+    /**
+     * Whether to keep the text of numbers alongside their converted value.
+     * Numbers that are not modified are saved verbatim.
+     */
+    bool raw_numbers;
+    /**
+     * Whether to store arrays of numbers packed as doubles rather than as
+     * separate values. See langnes_json_value_array_get_numbers().
+     */
+    bool pack_numeric_arrays;
+    /**
+     * Whether objects with the same member names share one list of names
+     * and only store their values. Adding or removing members gives an
+     * object its own list of names.
+     */
+    bool share_object_shapes;
+    /**
+     * Whether to reject strings and member names that are not valid UTF-8
+     * after unescaping.
+     */
+    bool validate_utf8;
+};
+
+// NOLINTNEXTLINE(modernize-use-using)
+typedef struct langnes_json_parse_options_t langnes_json_parse_options_t;
+
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_load_from_cstring(const char* data, langnes_json_value_t** result);
+
+/**
+ * Loads JSON from a character array with a fixed length.
+ *
+ * The character array is read in place and need not be null-terminated,
+ * which allows loading a slice of a larger buffer.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param options Options for loading, or NULL for the defaults.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code. @c langnes_json_error_out_of_range if a limit in
+ * @p options was exceeded.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_load_from_buffer(
+    const char* data, size_t length,
+    const langnes_json_parse_options_t* options, langnes_json_value_t** result);
+
+/**
+ * Checks whether a character array is a JSON document (RFC 8259) with
+ * strings in valid UTF-8, without building a value tree. As when loading
+ * with UTF-8 validation, escaped UTF-16 surrogates must form pairs.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param result Output parameter of whether the document is valid.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_validate(const char* data, size_t length, bool* result);
+LANGNES_JSON_API bool langnes_json_validate_s(const char* data, size_t length);
+
 LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_to_string(
     langnes_json_value_t* json_value, langnes_json_string_t** result);
 
+/**
+ * Saves a JSON value into a caller-provided buffer.
+ *
+ * The output is not null-terminated. Pass a NULL buffer with a size of zero
+ * to only query the required size.
+ *
+ * @param json_value The JSON value.
+ * @param buffer The output buffer.
+ * @param buffer_size The size of the output buffer in bytes.
+ * @param required_size Output parameter of the length of the saved JSON
+ * document in bytes.
+ * @return Error code. @c langnes_json_error_out_of_range if the buffer is too
+ * small, in which case the buffer contents are unspecified.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_to_buffer(
+    langnes_json_value_t* json_value, char* buffer, size_t buffer_size,
+    size_t* required_size);
+
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_value_free(langnes_json_value_t* json_value);
 LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_replace(
@@ -90,6 +209,70 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_clone(
 LANGNES_JSON_API langnes_json_value_t*
 langnes_json_value_clone_s(langnes_json_value_t* json_value);
 
+/**
+ * Compares JSON values deeply regardless of the order of object members.
+ *
+ * @param lhs The first JSON value.
+ * @param rhs The second JSON value.
+ * @param result Output parameter of whether the values are equal.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_equals(langnes_json_value_t* lhs, langnes_json_value_t* rhs,
+                          bool* result);
+LANGNES_JSON_API bool langnes_json_value_equals_s(langnes_json_value_t* lhs,
+                                                  langnes_json_value_t* rhs);
+
+/**
+ * Computes a hash of a JSON value that is stable across runs and independent
+ * of the order of object members.
+ *
+ * @param json_value The JSON value.
+ * @param cache Whether to cache the hashes of objects and arrays for later
+ * calls. Modifying any value discards all cached hashes, and equality
+ * comparisons use cached hashes to tell values apart.
+ * @param result Output parameter of the hash.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_hash(
+    langnes_json_value_t* json_value, bool cache, uint64_t* result);
+LANGNES_JSON_API uint64_t
+langnes_json_value_hash_s(langnes_json_value_t* json_value, bool cache);
+
+/**
+ * Gets a value within a JSON document using a JSON Pointer (RFC 6901).
+ *
+ * The resulting value is owned by the document.
+ *
+ * @param json_value The JSON document.
+ * @param pointer The JSON pointer, e.g. "/a/b/0".
+ * @param result Output parameter of the found JSON value.
+ * @return Error code. @c langnes_json_error_out_of_range if the pointer does
+ * not refer to a value.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_get_by_pointer(
+    langnes_json_value_t* json_value, const char* pointer,
+    langnes_json_value_t** result);
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_value_get_by_pointer_s(langnes_json_value_t* json_value,
+                                    const char* pointer);
+
+/**
+ * Applies a JSON Merge Patch (RFC 7396) to a JSON value in place and takes
+ * ownership of the patch.
+ *
+ * Members of the patch are moved into the target, and null members remove
+ * the corresponding members of the target.
+ *
+ * @param target The JSON value to modify.
+ * @param patch The JSON Merge Patch, which must not contain the target or be
+ * contained in it.
+ * @return Error code. @c langnes_json_error_invalid_argument if the patch
+ * contains the target or is contained in it.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_merge_patch(
+    langnes_json_value_t* target, langnes_json_value_t* patch);
+
 //
 // String
 //
@@ -153,6 +336,60 @@ langnes_json_value_get_number_s(langnes_json_value_t* json_value);
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_value_set_number(langnes_json_value_t* json_value, double value);
 
+/**
+ * Creates a JSON number value that keeps an int64_t exactly.
+ *
+ * @param value The number.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_number_new_int64(
+    int64_t value, langnes_json_value_t** result);
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_value_number_new_int64_s(int64_t value);
+
+/**
+ * Gets a JSON number value as int64_t.
+ *
+ * @param json_value The JSON value.
+ * @param result Output parameter of the number.
+ * @return Error code. @c langnes_json_error_out_of_range if the number is not
+ * an integer representable as int64_t.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_get_int64(
+    langnes_json_value_t* json_value, int64_t* result);
+LANGNES_JSON_API int64_t
+langnes_json_value_get_int64_s(langnes_json_value_t* json_value);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_set_int64(langnes_json_value_t* json_value, int64_t value);
+
+/**
+ * Creates a JSON number value that keeps an uint64_t exactly.
+ *
+ * @param value The number.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_number_new_uint64(
+    uint64_t value, langnes_json_value_t** result);
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_value_number_new_uint64_s(uint64_t value);
+
+/**
+ * Gets a JSON number value as uint64_t.
+ *
+ * @param json_value The JSON value.
+ * @param result Output parameter of the number.
+ * @return Error code. @c langnes_json_error_out_of_range if the number is not
+ * an integer representable as uint64_t.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_get_uint64(
+    langnes_json_value_t* json_value, uint64_t* result);
+LANGNES_JSON_API uint64_t
+langnes_json_value_get_uint64_s(langnes_json_value_t* json_value);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_set_uint64(langnes_json_value_t* json_value, uint64_t value);
+
 //
 // JSON boolean
 //
@@ -250,6 +487,25 @@ langnes_json_value_object_clear(langnes_json_value_t* json_object);
 // JSON array
 //
 
+/**
+ * Contiguous view of the elements of a JSON array.
+ *
+ * The element at index @c i is located at <tt>(langnes_json_value_t*)((char*)
+ * data + i * stride)</tt>. The view is invalidated when the array is
+ * modified.
+ */
+struct langnes_json_array_view_t {
+    /// The first element, or NULL if the array is empty.
+    langnes_json_value_t* data;
+    /// The distance between elements in bytes.
+    size_t stride;
+    /// The number of elements.
+    size_t length;
+};
+
+// NOLINTNEXTLINE(modernize-use-using)
+typedef struct langnes_json_array_view_t langnes_json_array_view_t;
+
 /**
  * Creates an empty JSON array value.
  *
@@ -276,12 +532,76 @@ LANGNES_JSON_API size_t
 langnes_json_value_array_get_length_s(langnes_json_value_t* json_array);
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_value_array_clear(langnes_json_value_t* json_array);
+
+/**
+ * Reserves storage for array elements.
+ *
+ * Elements are stored contiguously, so adding elements beyond the reserved
+ * capacity invalidates pointers to existing elements.
+ *
+ * @param json_array The JSON array.
+ * @param capacity The number of elements to reserve storage for.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_reserve(
+    langnes_json_value_t* json_array, size_t capacity);
+
+/**
+ * Adds an element to the end of an array and takes ownership of it.
+ *
+ * Pointers to existing elements are invalidated unless enough capacity was
+ * reserved.
+ *
+ * @param json_array The JSON array.
+ * @param json_array_element The element to add.
+ * @return Error code.
+ */
 LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_push(
     langnes_json_value_t* json_array, langnes_json_value_t* json_array_element);
+/**
+ * Gets an element of an array.
+ *
+ * An array stored packed as numbers is switched to separate values first,
+ * after which langnes_json_value_array_get_numbers() yields no numbers.
+ *
+ * @param value The JSON array.
+ * @param index The index of the element.
+ * @param result Output parameter of the element, owned by the array.
+ * @return Error code.
+ */
 LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_get_item(
     langnes_json_value_t* value, size_t index, langnes_json_value_t** result);
 LANGNES_JSON_API langnes_json_value_t*
 langnes_json_value_array_get_item_s(langnes_json_value_t* value, size_t index);
+
+/**
+ * Gets a contiguous view of the elements of an array.
+ *
+ * An array stored packed as numbers is switched to separate values first,
+ * as with langnes_json_value_array_get_item().
+ *
+ * @param json_array The JSON array.
+ * @param result Output parameter of the view.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_get_view(
+    langnes_json_value_t* json_array, langnes_json_array_view_t* result);
+
+/**
+ * Gets the elements of an array stored packed as contiguous doubles, which
+ * arrays of numbers loaded with @c pack_numeric_arrays are.
+ *
+ * Other arrays yield no numbers. The pointer is invalidated when the array
+ * is switched to separate values by accessing or adding its elements.
+ *
+ * @param json_array The JSON array.
+ * @param data Output parameter of the pointer to the first number, or NULL
+ * if there are none.
+ * @param length Output parameter of the number of packed elements.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_get_numbers(
+    langnes_json_value_t* json_array, const double** data, size_t* length);
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_value_set_array(langnes_json_value_t* json_array);
 LANGNES_JSON_API langnes_json_error_code_t
@@ -289,6 +609,549 @@ langnes_json_value_set_array_with_elements(langnes_json_value_t* json_array,
                                            langnes_json_value_t** values,
                                            size_t length);
 
+//
+// Writer
+//
+
+/**
+ * Creates a writer that writes a JSON document piece by piece without
+ * building a value tree.
+ *
+ * Output is passed to @p write_fn in chunks and at the latest when
+ * langnes_json_writer_flush() or langnes_json_writer_free() is called. If
+ * @p write_fn is NULL then output is collected and can be retrieved with
+ * langnes_json_writer_get_output().
+ *
+ * @param write_fn Function that receives output, or NULL.
+ * @param ctx Context passed to @p write_fn.
+ * @param validate_nesting Whether to validate the order of calls, in which
+ * case invalid calls fail with @c langnes_json_error_invalid_state.
+ * @param result Output parameter of the resulting writer.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_new(langnes_json_write_fn_t write_fn, void* ctx,
+                        bool validate_nesting, langnes_json_writer_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_free(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_flush(langnes_json_writer_t* writer);
+
+/**
+ * Gets the output collected by a writer created without a write function.
+ *
+ * The output is not null-terminated and remains owned by the writer.
+ *
+ * @param writer The writer.
+ * @param data Output parameter of the output data.
+ * @param length Output parameter of the length of the output in bytes.
+ * @return Error code. @c langnes_json_error_invalid_state if the writer was
+ * created with a write function.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_writer_get_output(
+    langnes_json_writer_t* writer, const char** data, size_t* length);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_is_complete(langnes_json_writer_t* writer, bool* result);
+LANGNES_JSON_API bool
+langnes_json_writer_is_complete_s(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_begin_object(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_end_object(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_begin_array(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_end_array(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_key(langnes_json_writer_t* writer, const char* key);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_string(langnes_json_writer_t* writer, const char* data);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_number(langnes_json_writer_t* writer, double number);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_int64(langnes_json_writer_t* writer, int64_t number);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_uint64(langnes_json_writer_t* writer, uint64_t number);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_boolean(langnes_json_writer_t* writer, bool boolean);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_null(langnes_json_writer_t* writer);
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_writer_value(
+    langnes_json_writer_t* writer, langnes_json_value_t* json_value);
+
+
+//
+// Columns
+//
+
+// NOLINTBEGIN(modernize-use-using)
+/**
+ * Type of the values in a column.
+ */
+typedef enum {
+    /// Every value is null or missing.
+    langnes_json_column_type_null,
+    /// Booleans, bit-packed in @c values.
+    langnes_json_column_type_boolean,
+    /// @c int64_t values.
+    langnes_json_column_type_int64,
+    /// @c double values.
+    langnes_json_column_type_float64,
+    /// UTF-8 strings in @c values delimited by @c offsets.
+    langnes_json_column_type_string,
+    /// JSON text of objects, arrays and values of mixed types, stored like
+    /// strings. Also used for integers beyond the range of @c int64_t mixed
+    /// with negative or fractional numbers.
+    langnes_json_column_type_json,
+    /// @c uint64_t values, used if some are beyond the range of @c int64_t.
+    langnes_json_column_type_uint64
+} langnes_json_column_type_t;
+// NOLINTEND(modernize-use-using)
+
+/**
+ * Values of one object member across an array of objects, laid out like an
+ * Apache Arrow array.
+ *
+ * Bitmaps have one bit per row, least significant bit first. The buffers
+ * remain owned by the columns.
+ */
+struct langnes_json_column_t {
+    /// Member name.
+    const char* name;
+    /// Type of the values.
+    langnes_json_column_type_t type;
+    /// Number of rows.
+    size_t length;
+    /// Number of null or missing values.
+    size_t null_count;
+    /// Validity bitmap, or NULL if there are no null values.
+    const uint8_t* validity;
+    /// Values, or NULL for columns of nulls.
+    const void* values;
+    /// Offsets of strings in @c values with @c length + 1 entries, or NULL
+    /// unless the column holds strings.
+    const int64_t* offsets;
+};
+
+// NOLINTNEXTLINE(modernize-use-using)
+typedef struct langnes_json_column_t langnes_json_column_t;
+
+/**
+ * Converts an array of objects such as database rows into one column per
+ * member name. Columns are filled in parallel when there are enough cells to
+ * give each thread at least 8192, and on the calling thread otherwise.
+ *
+ * @param json_array The JSON array of objects.
+ * @param max_threads The maximum number of threads, or 0 for one per
+ * hardware thread.
+ * @param result Output parameter of the resulting columns.
+ * @return Error code. @c langnes_json_error_bad_access unless the value is
+ * an array of objects.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_to_columns(langnes_json_value_t* json_array,
+                              size_t max_threads,
+                              langnes_json_columns_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_columns_free(langnes_json_columns_t* columns);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_columns_get_length(langnes_json_columns_t* columns,
+                                size_t* result);
+LANGNES_JSON_API size_t
+langnes_json_columns_get_length_s(langnes_json_columns_t* columns);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_columns_get_column(langnes_json_columns_t* columns, size_t index,
+                                langnes_json_column_t* result);
+LANGNES_JSON_API langnes_json_column_t
+langnes_json_columns_get_column_s(langnes_json_columns_t* columns,
+                                  size_t index);
+
+//
+// CBOR
+//
+
+/**
+ * Loads a JSON value from CBOR (RFC 8949).
+ *
+ * Tags are ignored, byte strings become base64url strings, and infinity,
+ * NaN and simple values other than booleans become null. Text strings must
+ * be valid UTF-8.
+ *
+ * @param data The CBOR data.
+ * @param length The length of the data in bytes.
+ * @param options Options for loading, or NULL for the defaults. The limits
+ * and @c share_object_shapes apply. The nesting depth is limited to 1000
+ * unless another limit is set.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_load_cbor(const uint8_t* data, size_t length,
+                       const langnes_json_parse_options_t* options,
+                       langnes_json_value_t** result);
+
+/**
+ * Saves a JSON value as CBOR (RFC 8949) into a new string object.
+ *
+ * The CBOR data may contain null characters, so use
+ * langnes_json_string_get_length() to get its length.
+ *
+ * @param json_value The JSON value.
+ * @param result Output parameter of the resulting string object.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_cbor_to_string(
+    langnes_json_value_t* json_value, langnes_json_string_t** result);
+
+/**
+ * Saves a JSON value as CBOR (RFC 8949) into a caller-provided buffer.
+ *
+ * Pass a NULL buffer with a size of zero to only query the required size.
+ *
+ * @param json_value The JSON value.
+ * @param buffer The output buffer.
+ * @param buffer_size The size of the output buffer in bytes.
+ * @param required_size Output parameter of the length of the CBOR data in
+ * bytes.
+ * @return Error code. @c langnes_json_error_out_of_range if the buffer is too
+ * small, in which case the buffer contents are unspecified.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_cbor_to_buffer(langnes_json_value_t* json_value,
+                                 uint8_t* buffer, size_t buffer_size,
+                                 size_t* required_size);
+
+//
+// MessagePack
+//
+
+/**
+ * Loads a JSON value from MessagePack.
+ *
+ * Binary and extension data become base64url strings and infinity and NaN
+ * become null.
+ *
+ * @param data The MessagePack data.
+ * @param length The length of the data in bytes.
+ * @param options Options for loading, or NULL for the defaults. The limits
+ * and @c share_object_shapes apply. The nesting depth is limited to 1000
+ * unless another limit is set.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_load_msgpack(const uint8_t* data, size_t length,
+                          const langnes_json_parse_options_t* options,
+                          langnes_json_value_t** result);
+
+/**
+ * Saves a JSON value as MessagePack into a new string object.
+ *
+ * The MessagePack data may contain null characters, so use
+ * langnes_json_string_get_length() to get its length.
+ *
+ * @param json_value The JSON value.
+ * @param result Output parameter of the resulting string object.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_msgpack_to_string(langnes_json_value_t* json_value,
+                                    langnes_json_string_t** result);
+
+/**
+ * Saves a JSON value as MessagePack into a caller-provided buffer.
+ *
+ * Pass a NULL buffer with a size of zero to only query the required size.
+ *
+ * @param json_value The JSON value.
+ * @param buffer The output buffer.
+ * @param buffer_size The size of the output buffer in bytes.
+ * @param required_size Output parameter of the length of the MessagePack
+ * data in bytes.
+ * @return Error code. @c langnes_json_error_out_of_range if the buffer is too
+ * small, in which case the buffer contents are unspecified.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_msgpack_to_buffer(langnes_json_value_t* json_value,
+                                    uint8_t* buffer, size_t buffer_size,
+                                    size_t* required_size);
+
+/**
+ * Creates a decoder of a sequence of MessagePack values that arrive in
+ * chunks.
+ *
+ * @param options Options for loading, or NULL for the defaults. The nesting
+ * depth is limited to 1000 unless another limit is set.
+ * @param result Output parameter of the resulting decoder.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_new(const langnes_json_parse_options_t* options,
+                                 langnes_json_msgpack_decoder_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_free(langnes_json_msgpack_decoder_t* decoder);
+
+/**
+ * Appends data to the buffer of a decoder.
+ *
+ * @param decoder The decoder.
+ * @param data The data.
+ * @param length The length of the data in bytes.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_feed(langnes_json_msgpack_decoder_t* decoder,
+                                  const uint8_t* data, size_t length);
+
+/**
+ * Decodes the next value if it has been fed completely.
+ *
+ * @param decoder The decoder.
+ * @param result Output parameter of the decoded JSON value, or NULL if more
+ * data is needed.
+ * @return Error code. Malformed data is discarded.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_next(langnes_json_msgpack_decoder_t* decoder,
+                                  langnes_json_value_t** result);
+
+//
+// Snapshot
+//
+
+/**
+ * Read-only view of a JSON value within a snapshot.
+ *
+ * Views are small and passed by value. They remain valid until the snapshot
+ * is freed.
+ */
+struct langnes_json_element_t {
+    /// Internal use only.
+    const void* image;
+    /// Internal use only.
+    size_t index;
+};
+
+// NOLINTNEXTLINE(modernize-use-using)
+typedef struct langnes_json_element_t langnes_json_element_t;
+
+/**
+ * Saves a JSON value as a snapshot file, which can be opened without
+ * parsing with langnes_json_snapshot_open().
+ *
+ * @param json_value The JSON value.
+ * @param path The path of the file to create or replace.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_snapshot_to_file(
+    langnes_json_value_t* json_value, const char* path);
+
+/**
+ * Saves a JSON value as a snapshot image into a new string object.
+ *
+ * @param json_value The JSON value.
+ * @param result Output parameter of the resulting string object.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_snapshot_to_string(langnes_json_value_t* json_value,
+                                     langnes_json_string_t** result);
+
+/**
+ * Opens a snapshot file by mapping it into memory.
+ *
+ * @param path The path of the snapshot file.
+ * @param result Output parameter of the resulting snapshot.
+ * @return Error code. @c langnes_json_error_parse_error if the file is not a
+ * snapshot.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_snapshot_open(const char* path, langnes_json_snapshot_t** result);
+
+/**
+ * Opens a snapshot image in memory without copying it.
+ *
+ * @param data The snapshot image, which must outlive the snapshot.
+ * @param length The length of the image in bytes.
+ * @param result Output parameter of the resulting snapshot.
+ * @return Error code. @c langnes_json_error_parse_error if the data is not a
+ * snapshot.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_snapshot_open_buffer(const uint8_t* data, size_t length,
+                                  langnes_json_snapshot_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_snapshot_free(langnes_json_snapshot_t* snapshot);
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_snapshot_get_root(
+    langnes_json_snapshot_t* snapshot, langnes_json_element_t* result);
+LANGNES_JSON_API langnes_json_element_t
+langnes_json_snapshot_get_root_s(langnes_json_snapshot_t* snapshot);
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_type(
+    langnes_json_element_t element, langnes_json_value_type_t* result);
+LANGNES_JSON_API langnes_json_value_type_t
+langnes_json_element_get_type_s(langnes_json_element_t element);
+
+/**
+ * Gets the data of a string within a snapshot.
+ *
+ * @param element The string element.
+ * @param data Output parameter of the string data, which is not
+ * null-terminated.
+ * @param length Output parameter of the length of the string in bytes.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_string(
+    langnes_json_element_t element, const char** data, size_t* length);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_get_number(langnes_json_element_t element, double* result);
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_int64(
+    langnes_json_element_t element, int64_t* result);
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_uint64(
+    langnes_json_element_t element, uint64_t* result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_get_boolean(langnes_json_element_t element, bool* result);
+
+/**
+ * Gets the number of members or elements of an object or array.
+ *
+ * @param element The object or array element.
+ * @param result Output parameter of the number of members or elements.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_length(
+    langnes_json_element_t element, size_t* result);
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_array_get_item(
+    langnes_json_element_t element, size_t index,
+    langnes_json_element_t* result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_object_get_value(langnes_json_element_t element,
+                                      const char* member_name,
+                                      langnes_json_element_t* result);
+
+/**
+ * Gets an object member by index.
+ *
+ * @param element The object element.
+ * @param index The member index.
+ * @param name Output parameter of the member name, which is not
+ * null-terminated.
+ * @param name_length Output parameter of the length of the member name.
+ * @param result Output parameter of the member value.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_object_get_member(langnes_json_element_t element,
+                                       size_t index, const char** name,
+                                       size_t* name_length,
+                                       langnes_json_element_t* result);
+
+/**
+ * Copies an element into a new JSON value.
+ *
+ * @param element The element.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_materialize(
+    langnes_json_element_t element, langnes_json_value_t** result);
+
+//
+// Schema
+//
+
+/**
+ * Compiles a JSON Schema so that it can be used to validate many documents.
+ *
+ * @param schema The JSON Schema document, which need not outlive the
+ * compiled schema.
+ * @param result Output parameter of the resulting compiled schema.
+ * @return Error code. @c langnes_json_error_invalid_argument if the schema is
+ * malformed or uses a reference that cannot be resolved.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_schema_compile(
+    langnes_json_value_t* schema, langnes_json_schema_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_schema_free(langnes_json_schema_t* schema);
+
+/**
+ * Checks whether a JSON value is valid. Stops at the first failure.
+ *
+ * @param schema The compiled schema.
+ * @param json_value The JSON value.
+ * @param result Output parameter of whether the value is valid.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_schema_validate(langnes_json_schema_t* schema,
+                             langnes_json_value_t* json_value, bool* result);
+LANGNES_JSON_API bool
+langnes_json_schema_validate_s(langnes_json_schema_t* schema,
+                               langnes_json_value_t* json_value);
+
+/**
+ * Loads JSON from a character array with a fixed length while validating it
+ * against a compiled schema. Loading stops at the first invalid member.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param schema The compiled schema.
+ * @param options Options for loading, or NULL for the defaults.
+ * @param result Output parameter of the resulting JSON value.
+ * @return Error code. @c langnes_json_error_validation_error if the document
+ * is invalid.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_load_validated(
+    const char* data, size_t length, langnes_json_schema_t* schema,
+    const langnes_json_parse_options_t* options, langnes_json_value_t** result);
+
+//
+// Query
+//
+
+/**
+ * Compiles a JSONPath query (RFC 9535) so that it can be evaluated against
+ * many documents.
+ *
+ * @param expression The query, e.g. "$.orders[?@.total > 100].id".
+ * @param result Output parameter of the resulting compiled query.
+ * @return Error code. @c langnes_json_error_invalid_argument if the query is
+ * malformed.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_query_compile(
+    const char* expression, langnes_json_query_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_free(langnes_json_query_t* query);
+
+/**
+ * Selects values within a JSON document. Large arrays and objects are split
+ * between threads.
+ *
+ * @param query The compiled query.
+ * @param json_value The JSON document.
+ * @param max_threads The maximum number of threads, or 0 for one per
+ * hardware thread.
+ * @param result Output parameter of the resulting list of selected values,
+ * which are owned by the document.
+ * @return Error code.
+ */
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_query_evaluate(
+    langnes_json_query_t* query, langnes_json_value_t* json_value,
+    size_t max_threads, langnes_json_query_results_t** result);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_results_free(langnes_json_query_results_t* results);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_results_get_length(langnes_json_query_results_t* results,
+                                      size_t* result);
+LANGNES_JSON_API size_t
+langnes_json_query_results_get_length_s(langnes_json_query_results_t* results);
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_results_get_item(langnes_json_query_results_t* results,
+                                    size_t index,
+                                    langnes_json_value_t** result);
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_query_results_get_item_s(langnes_json_query_results_t* results,
+                                      size_t index);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -16,12 +16,30 @@
 
 #pragma once
 
+#include "canonical.hpp"
+#include "cbor.hpp"
+#include "columns.hpp"
+#include "conversion.hpp"
 #include "detail/json.hpp"
 #include "detail/macros.hpp"
 #include "detail/memory.hpp"
 #include "detail/stream.hpp"
 #include "detail/type_traits.hpp"
+#include "equality.hpp"
+#include "fields.hpp"
+#include "lazy.hpp"
+#include "memory_resource.hpp"
+#include "msgpack.hpp"
+#include "options.hpp"
+#include "patch.hpp"
+#include "pointer.hpp"
+#include "projection.hpp"
+#include "query.hpp"
+#include "schema.hpp"
+#include "snapshot.hpp"
+#include "validate.hpp"
 #include "value.hpp"
+#include "writer.hpp"
 
 #include <cstring>
 #include <memory>
@@ -61,26 +79,68 @@ constexpr const char* build_metadata{""};
  * Loads JSON from a stream.
  *
  * @param is The input stream.
+ * @param options Options for loading.
  * @return The JSON value.
  */
 template<typename Stream,
          detail::enable_if_t<std::is_base_of<std::istream, Stream>::value>* =
              nullptr>
-inline value load(Stream&& is) {
+inline value load(Stream&& is, const parse_options& options) {
     // Satisfy clang-tidy rule cppcoreguidelines-missing-std-forward
     auto&& is_{std::forward<Stream>(is)};
-    return detail::fully_parse_value(is_);
+    return detail::fully_parse_value(is_, options);
+}
+
+/**
+ * Loads JSON from a stream.
+ *
+ * @param is The input stream.
+ * @return The JSON value.
+ */
+template<typename Stream,
+         detail::enable_if_t<std::is_base_of<std::istream, Stream>::value>* =
+             nullptr>
+inline value load(Stream&& is) {
+    return load(std::forward<Stream>(is), parse_options{});
 }
 
 /**
  * Loads JSON from a character array with a fixed length.
  *
+ * The character array is read in place and need not be null-terminated.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param options Options for loading.
+ * @return The JSON value.
+ */
+inline value load(const char* data, size_t length,
+                  const parse_options& options) {
+    return load(detail::make_istream(data, length), options);
+}
+
+/**
+ * Loads JSON from a character array with a fixed length.
+ *
+ * The character array is read in place and need not be null-terminated.
+ *
  * @param data The JSON document data.
  * @param length The length of the JSON document in bytes.
  * @return The JSON value.
  */
 inline value load(const char* data, size_t length) {
-    return load(detail::make_istream(data, length));
+    return load(data, length, parse_options{});
+}
+
+/**
+ * Loads JSON from a null-terminated character array.
+ *
+ * @param data The JSON document data.
+ * @param options Options for loading.
+ * @return The JSON value.
+ */
+inline value load(const char* data, const parse_options& options) {
+    return load(data, std::strlen(data), options);
 }
 
 /**
@@ -90,7 +150,21 @@ inline value load(const char* data, size_t length) {
  * @return The JSON value.
  */
 inline value load(const char* data) {
-    return load(detail::make_istream(data, std::strlen(data)));
+    return load(data, std::strlen(data), parse_options{});
+}
+
+/**
+ * Loads JSON from a container such as std::string.
+ *
+ * @param input The input container.
+ * @param options Options for loading.
+ * @return The JSON value.
+ */
+template<typename Container, detail::enable_if_t<!std::is_base_of<
+                                 std::istream, Container>::value>* = nullptr>
+inline value load(Container&& input, const parse_options& options) {
+    return load(detail::make_istream(std::forward<Container>(input)),
+                options);
 }
 
 /**
@@ -102,7 +176,257 @@ inline value load(const char* data) {
 template<typename Container, detail::enable_if_t<!std::is_base_of<
                                  std::istream, Container>::value>* = nullptr>
 inline value load(Container&& input) {
-    return load(detail::make_istream(std::forward<Container>(input)));
+    return load(std::forward<Container>(input), parse_options{});
+}
+
+/**
+ * Loads only the parts of a JSON document selected by a projection from a
+ * stream. Everything else is skipped without being stored.
+ *
+ * Objects and arrays along the selected paths are kept. Skipped array
+ * elements that precede a selected element are loaded as null so that
+ * indices stay intact.
+ *
+ * @param is The input stream.
+ * @param paths The JSON pointers to load, e.g. {"/user/id", "/tags"}.
+ * @param options Options for loading.
+ * @return The JSON value.
+ */
+template<typename Stream,
+         detail::enable_if_t<std::is_base_of<std::istream, Stream>::value>* =
+             nullptr>
+inline value load_projected(Stream&& is, const projection& paths,
+                            const parse_options& options = {}) {
+    // Satisfy clang-tidy rule cppcoreguidelines-missing-std-forward
+    auto&& is_{std::forward<Stream>(is)};
+    return detail::fully_parse_projected_value(is_, paths, options);
+}
+
+/**
+ * Loads only the parts of a JSON document selected by a projection from a
+ * character array with a fixed length.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param paths The JSON pointers to load.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @see load_projected(Stream&&, const projection&, const parse_options&)
+ */
+inline value load_projected(const char* data, size_t length,
+                            const projection& paths,
+                            const parse_options& options = {}) {
+    return load_projected(detail::make_istream(data, length), paths, options);
+}
+
+/**
+ * Loads only the parts of a JSON document selected by a projection from a
+ * null-terminated character array.
+ *
+ * @param data The JSON document data.
+ * @param paths The JSON pointers to load.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @see load_projected(Stream&&, const projection&, const parse_options&)
+ */
+inline value load_projected(const char* data, const projection& paths,
+                            const parse_options& options = {}) {
+    return load_projected(data, std::strlen(data), paths, options);
+}
+
+/**
+ * Loads only the parts of a JSON document selected by a projection from a
+ * container such as std::string.
+ *
+ * @param input The input container.
+ * @param paths The JSON pointers to load.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @see load_projected(Stream&&, const projection&, const parse_options&)
+ */
+template<typename Container,
+         detail::enable_if_t<
+             !std::is_base_of<std::istream, Container>::value &&
+             !std::is_convertible<Container, const char*>::value>* = nullptr>
+inline value load_projected(Container&& input, const projection& paths,
+                            const parse_options& options = {}) {
+    return load_projected(detail::make_istream(std::forward<Container>(input)),
+                          paths, options);
+}
+
+/**
+ * Loads JSON from a stream while validating it against a JSON Schema.
+ *
+ * Objects and arrays are validated member by member as they are parsed, so
+ * that loading stops at the first invalid member without building the rest
+ * of the document. Values checked by enum, const, uniqueItems, contains or
+ * a combination of subschemas are validated once parsed.
+ *
+ * @param is The input stream.
+ * @param schema The compiled JSON Schema.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @throw validation_error if the document is invalid.
+ */
+template<typename Stream,
+         detail::enable_if_t<std::is_base_of<std::istream, Stream>::value>* =
+             nullptr>
+inline value load_validated(Stream&& is, const compiled_schema& schema,
+                            const parse_options& options = {}) {
+    // Satisfy clang-tidy rule cppcoreguidelines-missing-std-forward
+    auto&& is_{std::forward<Stream>(is)};
+    return detail::fully_parse_validated_value(is_, schema, options);
+}
+
+/**
+ * Loads JSON from a character array with a fixed length while validating it
+ * against a JSON Schema.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param schema The compiled JSON Schema.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @see load_validated(Stream&&, const compiled_schema&, const parse_options&)
+ */
+inline value load_validated(const char* data, size_t length,
+                            const compiled_schema& schema,
+                            const parse_options& options = {}) {
+    return load_validated(detail::make_istream(data, length), schema, options);
+}
+
+/**
+ * Loads JSON from a null-terminated character array while validating it
+ * against a JSON Schema.
+ *
+ * @param data The JSON document data.
+ * @param schema The compiled JSON Schema.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @see load_validated(Stream&&, const compiled_schema&, const parse_options&)
+ */
+inline value load_validated(const char* data, const compiled_schema& schema,
+                            const parse_options& options = {}) {
+    return load_validated(data, std::strlen(data), schema, options);
+}
+
+/**
+ * Loads JSON from a container such as std::string while validating it
+ * against a JSON Schema.
+ *
+ * @param input The input container.
+ * @param schema The compiled JSON Schema.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @see load_validated(Stream&&, const compiled_schema&, const parse_options&)
+ */
+template<typename Container,
+         detail::enable_if_t<
+             !std::is_base_of<std::istream, Container>::value &&
+             !std::is_convertible<Container, const char*>::value>* = nullptr>
+inline value load_validated(Container&& input, const compiled_schema& schema,
+                            const parse_options& options = {}) {
+    return load_validated(detail::make_istream(std::forward<Container>(input)),
+                          schema, options);
+}
+
+/**
+ * Loads JSON from a stream directly into an object of a struct registered
+ * with LANGNES_JSON_FIELDS, or of any other supported field type such as
+ * std::vector, without building a value tree.
+ *
+ * @tparam T The type to load.
+ * @param is The input stream.
+ * @param options Options for loading.
+ * @return The loaded object.
+ * @throw out_of_range if a number does not fit its field.
+ */
+template<typename T, typename Stream,
+         detail::enable_if_t<std::is_base_of<std::istream, Stream>::value>* =
+             nullptr>
+inline T load_as(Stream&& is, const parse_options& options = {}) {
+    // Satisfy clang-tidy rule cppcoreguidelines-missing-std-forward
+    auto&& is_{std::forward<Stream>(is)};
+    return detail::fully_parse_fields<T>(is_, options);
+}
+
+/**
+ * Loads JSON from a character array with a fixed length directly into an
+ * object.
+ *
+ * @tparam T The type to load.
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @param options Options for loading.
+ * @return The loaded object.
+ * @see load_as(Stream&&, const parse_options&)
+ */
+template<typename T>
+inline T load_as(const char* data, size_t length,
+                 const parse_options& options = {}) {
+    return load_as<T>(detail::make_istream(data, length), options);
+}
+
+/**
+ * Loads JSON from a null-terminated character array directly into an
+ * object.
+ *
+ * @tparam T The type to load.
+ * @param data The JSON document data.
+ * @param options Options for loading.
+ * @return The loaded object.
+ * @see load_as(Stream&&, const parse_options&)
+ */
+template<typename T>
+inline T load_as(const char* data, const parse_options& options = {}) {
+    return load_as<T>(data, std::strlen(data), options);
+}
+
+/**
+ * Loads JSON from a container such as std::string directly into an object.
+ *
+ * @tparam T The type to load.
+ * @param input The input container.
+ * @param options Options for loading.
+ * @return The loaded object.
+ * @see load_as(Stream&&, const parse_options&)
+ */
+template<typename T, typename Container,
+         detail::enable_if_t<
+             !std::is_base_of<std::istream, Container>::value &&
+             !std::is_convertible<Container, const char*>::value>* = nullptr>
+inline T load_as(Container&& input, const parse_options& options = {}) {
+    return load_as<T>(detail::make_istream(std::forward<Container>(input)),
+                      options);
+}
+
+/**
+ * Saves an object of a struct registered with LANGNES_JSON_FIELDS to a
+ * stream without building a value tree.
+ *
+ * @param os The output stream.
+ * @param v The object.
+ */
+template<typename T,
+         detail::enable_if_t<detail::has_fields<T>::value>* = nullptr>
+inline void save(std::ostream& os, const T& v) {
+    writer w{os, false};
+    detail::write_field(w, v);
+}
+
+/**
+ * Saves an object of a struct registered with LANGNES_JSON_FIELDS to a new
+ * string without building a value tree.
+ *
+ * @param v The object.
+ * @return The saved JSON document.
+ */
+template<typename T,
+         detail::enable_if_t<detail::has_fields<T>::value>* = nullptr>
+inline std::string save(const T& v) {
+    std::ostringstream os{std::ios::binary};
+    save(os, v);
+    return os.str();
 }
 
 /**
@@ -125,6 +449,24 @@ inline std::string save(const value& v) {
     return os.str();
 }
 
+/**
+ * Saves a JSON value into a character array with a fixed length.
+ *
+ * The output is not null-terminated. If the saved JSON document is longer
+ * than the character array then the output is truncated.
+ *
+ * @param v The JSON value.
+ * @param data The output character array. May be null if @p length is zero.
+ * @param length The length of the output character array in bytes.
+ * @return The length of the saved JSON document in bytes.
+ */
+inline size_t save(const value& v, char* data, size_t length) {
+    detail::buffer_streambuf buf{data, length};
+    std::ostream os{&buf};
+    save(os, v);
+    return buf.required_length();
+}
+
 /**
  * Creates a JSON object value.
  *
@@ -151,6 +493,7 @@ inline value make_object(
 template<typename... Args>
 inline value make_array(Args&&... elements) noexcept {
     auto impl{detail::make_unique<detail::array_impl>()};
+    impl->elements().reserve(sizeof...(Args));
     detail::put_array(impl->elements(), std::forward<Args>(elements)...);
     return value{std::move(impl)};
 }
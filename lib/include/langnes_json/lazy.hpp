@@ -0,0 +1,465 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/parsing.hpp"
+#include "detail/stream.hpp"
+#include "detail/token_rules.hpp"
+#include "detail/type_traits.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+class lazy_iterator;
+
+/**
+ * Read-only view of a JSON value within a lazily loaded document.
+ *
+ * Nothing is parsed until it is accessed. Looking up members and elements
+ * scans the document only as far as needed and skips over other values by
+ * matching brackets, so malformed input is only detected when scanned.
+ *
+ * The view refers to the document data, which must outlive it.
+ */
+class lazy_value {
+public:
+    /**
+     * Constructs a view of the value at an offset within a document.
+     *
+     * @param data The JSON document data.
+     * @param length The length of the JSON document in bytes.
+     * @param offset The offset of the first character of the value.
+     */
+    lazy_value(const char* data, size_t length, size_t offset) noexcept
+        : m_data{data},
+          m_length{length},
+          m_offset{offset} {}
+
+    value::type get_type() const {
+        using namespace detail::token_rules;
+        using t = value::type;
+        auto is{stream()};
+        auto c{detail::parsing::peek_next(is)};
+        if (object_open(is, c)) {
+            return t::object;
+        }
+        if (array_open(is, c)) {
+            return t::array;
+        }
+        if (dquote(is, c)) {
+            return t::string;
+        }
+        if (c == 't' || c == 'f') {
+            return t::boolean;
+        }
+        if (c == 'n') {
+            return t::null;
+        }
+        return t::number;
+    }
+
+    bool is_type(value::type type) const { return get_type() == type; }
+    bool is_string() const { return is_type(value::type::string); }
+    bool is_number() const { return is_type(value::type::number); }
+    bool is_boolean() const { return is_type(value::type::boolean); }
+    bool is_object() const { return is_type(value::type::object); }
+    bool is_array() const { return is_type(value::type::array); }
+    bool is_null() const { return is_type(value::type::null); }
+
+    std::string as_string() const {
+        ensure_type(value::type::string);
+        auto is{stream()};
+        detail::parse_context ctx{parse_options{}};
+        return detail::parse_string<std::string>(is, ctx);
+    }
+
+    double as_number() const { return number().data(); }
+
+    std::int64_t as_int64() const {
+        std::int64_t result{};
+        if (!number().to_int64(result)) {
+            throw out_of_range{"Number is not representable as int64"};
+        }
+        return result;
+    }
+
+    std::uint64_t as_uint64() const {
+        std::uint64_t result{};
+        if (!number().to_uint64(result)) {
+            throw out_of_range{"Number is not representable as uint64"};
+        }
+        return result;
+    }
+
+    bool as_boolean() const {
+        ensure_type(value::type::boolean);
+        auto is{stream()};
+        return detail::parse_boolean(is);
+    }
+
+    /**
+     * Parses the value into a JSON value tree.
+     *
+     * @param options Options for loading.
+     * @return The JSON value.
+     */
+    value materialize(const parse_options& options = {}) const {
+        auto is{stream()};
+        scoped_resource scope{options.resource};
+        detail::parse_context ctx{options};
+        return detail::parse_value(is, ctx);
+    }
+
+    /**
+     * Gets the number of members or elements of an object or array.
+     *
+     * @return The number of members or elements.
+     */
+    size_t size() const;
+
+    /**
+     * Gets an iterator to the first member or element of an object or array.
+     *
+     * @return The iterator.
+     */
+    lazy_iterator begin() const;
+
+    /**
+     * Gets an iterator past the last member or element of an object or
+     * array.
+     *
+     * @return The iterator.
+     */
+    lazy_iterator end() const;
+
+    /**
+     * Finds an object member by name.
+     *
+     * @param name The member name.
+     * @return Iterator to the member, or end() if not found.
+     */
+    lazy_iterator find(const std::string& name) const;
+
+    /**
+     * Gets an object member by name.
+     *
+     * @param name The member name.
+     * @return The member value.
+     * @throw out_of_range if the member does not exist.
+     */
+    lazy_value operator[](const std::string& name) const;
+
+    /**
+     * Gets an array element by index.
+     *
+     * @param index The element index.
+     * @return The element value.
+     * @throw out_of_range if the index is out of range.
+     */
+    lazy_value operator[](size_t index) const;
+
+private:
+    friend class lazy_iterator;
+
+    detail::string_istream stream() const {
+        auto is{detail::make_istream(m_data, m_length)};
+        is.rdbuf()->pubseekpos(static_cast<std::streamoff>(m_offset),
+                               std::ios_base::in);
+        return is;
+    }
+
+    detail::number_impl number() const {
+        ensure_type(value::type::number);
+        auto is{stream()};
+        detail::parse_context ctx{parse_options{}};
+        return detail::parse_number(is, ctx);
+    }
+
+    void ensure_type(value::type type) const {
+        if (!is_type(type)) {
+            throw bad_access{};
+        }
+    }
+
+    const char* m_data;
+    size_t m_length;
+    size_t m_offset;
+};
+
+/**
+ * Iterator over the members of an object or the elements of an array within
+ * a lazily loaded document.
+ */
+class lazy_iterator {
+public:
+    /**
+     * Gets the current member or element value.
+     *
+     * @return The value.
+     */
+    lazy_value operator*() const {
+        return lazy_value{m_data, m_length, m_offset};
+    }
+
+    /**
+     * Gets the name of the current object member.
+     *
+     * @return The member name, or an empty string for array elements.
+     */
+    const std::string& key() const noexcept { return m_key; }
+
+    lazy_iterator& operator++() {
+        using namespace detail;
+        using namespace detail::parsing;
+        using namespace detail::token_rules;
+        auto is{lazy_value{m_data, m_length, m_offset}.stream()};
+        skip_value(is);
+        skip_while(is, ws);
+        if (peek(is, value_separator)) {
+            skip(is);
+            read_next(is);
+            return *this;
+        }
+        expect(is, m_is_object ? object_close : array_close);
+        m_offset = npos;
+        m_key.clear();
+        return *this;
+    }
+
+    bool operator==(const lazy_iterator& other) const noexcept {
+        return m_data == other.m_data && m_offset == other.m_offset;
+    }
+
+    bool operator!=(const lazy_iterator& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    friend class lazy_value;
+
+    static constexpr size_t npos{std::numeric_limits<size_t>::max()};
+
+    lazy_iterator(const char* data, size_t length, bool is_object) noexcept
+        : m_data{data},
+          m_length{length},
+          m_is_object{is_object} {}
+
+    // Reads the member name if any and moves to the start of the next value.
+    void read_next(std::istream& is) {
+        using namespace detail;
+        using namespace detail::parsing;
+        using namespace detail::token_rules;
+        skip_while(is, ws);
+        if (m_is_object) {
+            m_key =
+                parse_string<std::string>(is, parse_context{parse_options{}});
+            skip_while(is, ws);
+            expect(is, member_separator);
+            skip_while(is, ws);
+        }
+        peek_next(is);
+        m_offset = get_read_position(is);
+    }
+
+    const char* m_data;
+    size_t m_length;
+    size_t m_offset{npos};
+    bool m_is_object;
+    std::string m_key;
+};
+
+inline lazy_iterator lazy_value::begin() const {
+    using namespace detail;
+    using namespace detail::parsing;
+    using namespace detail::token_rules;
+    auto type{get_type()};
+    if (type != value::type::object && type != value::type::array) {
+        throw bad_access{};
+    }
+    auto is_object{type == value::type::object};
+    lazy_iterator it{m_data, m_length, is_object};
+    auto is{stream()};
+    skip(is);
+    skip_while(is, ws);
+    if (peek(is, is_object ? object_close : array_close)) {
+        return it;
+    }
+    it.read_next(is);
+    return it;
+}
+
+inline lazy_iterator lazy_value::end() const {
+    return lazy_iterator{m_data, m_length, is_object()};
+}
+
+inline size_t lazy_value::size() const {
+    size_t count{};
+    for (auto it{begin()}, last{end()}; it != last; ++it) {
+        ++count;
+    }
+    return count;
+}
+
+inline lazy_iterator lazy_value::find(const std::string& name) const {
+    ensure_type(value::type::object);
+    auto it{begin()};
+    for (auto last{end()}; it != last; ++it) {
+        if (it.key() == name) {
+            break;
+        }
+    }
+    return it;
+}
+
+inline lazy_value lazy_value::operator[](const std::string& name) const {
+    auto found{find(name)};
+    if (found == end()) {
+        throw out_of_range{"Member not found"};
+    }
+    return *found;
+}
+
+inline lazy_value lazy_value::operator[](size_t index) const {
+    ensure_type(value::type::array);
+    size_t i{};
+    for (auto it{begin()}, last{end()}; it != last; ++it, ++i) {
+        if (i == index) {
+            return *it;
+        }
+    }
+    throw out_of_range{"Index out of range"};
+}
+
+namespace detail {
+
+class lazy_document_data {
+public:
+    lazy_document_data(const char* data, size_t length) noexcept
+        : m_data{data},
+          m_length{length} {}
+
+    explicit lazy_document_data(const std::string& s) noexcept
+        : lazy_document_data{s.data(), s.size()} {}
+
+    explicit lazy_document_data(std::string&& s)
+        : m_owned_data{make_unique<std::string>(std::move(s))},
+          m_data{m_owned_data->data()},
+          m_length{m_owned_data->size()} {}
+
+    const char* data() const noexcept { return m_data; }
+    size_t length() const noexcept { return m_length; }
+
+    // Finds the offset of the root value.
+    size_t root_offset() const {
+        using namespace parsing;
+        using namespace token_rules;
+        auto is{make_istream(m_data, m_length)};
+        skip_while(is, ws);
+        peek_next(is);
+        return get_read_position(is);
+    }
+
+private:
+    std::unique_ptr<std::string> m_owned_data;
+    const char* m_data;
+    size_t m_length;
+};
+
+} // namespace detail
+
+/**
+ * Lazily loaded JSON document that is itself a view of the root value.
+ *
+ * The document keeps referring to character arrays and containers passed by
+ * lvalue reference, while containers passed by rvalue reference are owned.
+ */
+class lazy_document : private detail::lazy_document_data, public lazy_value {
+public:
+    /**
+     * Constructs a lazy document that refers to a character array.
+     *
+     * @param data The JSON document data.
+     * @param length The length of the JSON document in bytes.
+     */
+    lazy_document(const char* data, size_t length)
+        : detail::lazy_document_data{data, length},
+          lazy_value{this->data(), this->length(), root_offset()} {}
+
+    /**
+     * Constructs a lazy document that refers to a string.
+     *
+     * @param s The JSON document.
+     */
+    explicit lazy_document(const std::string& s)
+        : lazy_document{s.data(), s.size()} {}
+
+    /**
+     * Constructs a lazy document that owns a string.
+     *
+     * @param s The JSON document.
+     */
+    explicit lazy_document(std::string&& s)
+        : detail::lazy_document_data{std::move(s)},
+          lazy_value{data(), length(), root_offset()} {}
+};
+
+/**
+ * Lazily loads JSON from a character array with a fixed length.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @return The lazy document.
+ */
+inline lazy_document load_lazy(const char* data, size_t length) {
+    return lazy_document{data, length};
+}
+
+/**
+ * Lazily loads JSON from a null-terminated character array.
+ *
+ * @param data The JSON document data.
+ * @return The lazy document.
+ */
+inline lazy_document load_lazy(const char* data) {
+    return lazy_document{data, std::strlen(data)};
+}
+
+/**
+ * Lazily loads JSON from a container such as std::string.
+ *
+ * @param input The input container.
+ * @return The lazy document.
+ */
+template<typename Container,
+         detail::enable_if_t<
+             !std::is_convertible<Container, const char*>::value>* = nullptr>
+inline lazy_document load_lazy(Container&& input) {
+    return lazy_document{std::forward<Container>(input)};
+}
+
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/macros.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+/**
+ * Interface for memory resources used to allocate JSON values, their
+ * containers, strings and object member names, modeled after
+ * @c std::pmr::memory_resource.
+ */
+class memory_resource {
+public:
+    /// Default constructor.
+    memory_resource() = default;
+    memory_resource(const memory_resource&) = default;
+    memory_resource(memory_resource&&) = default;
+    memory_resource& operator=(const memory_resource&) = default;
+    memory_resource& operator=(memory_resource&&) = default;
+    virtual ~memory_resource() = default;
+
+    /**
+     * Allocates memory.
+     *
+     * @param bytes The size of the memory in bytes.
+     * @param alignment The alignment of the memory.
+     * @return Pointer to the allocated memory.
+     */
+    void* allocate(size_t bytes,
+                   size_t alignment = alignof(std::max_align_t)) {
+        return do_allocate(bytes, alignment);
+    }
+
+    /**
+     * Deallocates memory previously allocated with allocate().
+     *
+     * @param p Pointer to the memory.
+     * @param bytes The size of the memory in bytes.
+     * @param alignment The alignment of the memory.
+     */
+    void deallocate(void* p, size_t bytes,
+                    size_t alignment = alignof(std::max_align_t)) noexcept {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    /**
+     * Checks whether memory allocated from this resource can be deallocated
+     * by another resource and vice versa.
+     *
+     * @param other The other resource.
+     * @return Whether the resources are interchangeable.
+     */
+    bool is_equal(const memory_resource& other) const noexcept {
+        return do_is_equal(other);
+    }
+
+protected:
+    /// @see allocate
+    virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+    /// @see deallocate
+    virtual void do_deallocate(void* p, size_t bytes,
+                               size_t alignment) noexcept = 0;
+    /// @see is_equal
+    virtual bool do_is_equal(const memory_resource& other) const noexcept {
+        return this == &other;
+    }
+};
+
+namespace detail {
+
+class new_delete_resource_impl : public memory_resource {
+protected:
+    void* do_allocate(size_t bytes, size_t /*alignment*/) override {
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void* p, size_t /*bytes*/,
+                       size_t /*alignment*/) noexcept override {
+        ::operator delete(p);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return dynamic_cast<const new_delete_resource_impl*>(&other) !=
+               nullptr;
+    }
+};
+
+} // namespace detail
+
+/**
+ * Gets a memory resource that uses the global @c operator @c new and
+ * @c operator @c delete.
+ *
+ * @return The memory resource.
+ */
+inline memory_resource* new_delete_resource() noexcept {
+    static detail::new_delete_resource_impl instance;
+    return &instance;
+}
+
+namespace detail {
+
+inline std::atomic<memory_resource*>& default_resource_storage() noexcept {
+    static std::atomic<memory_resource*> instance{new_delete_resource()};
+    return instance;
+}
+
+// Resource of the innermost scoped_resource of the calling thread, if any.
+inline memory_resource*& scoped_resource_storage() noexcept {
+    static thread_local memory_resource* instance{};
+    return instance;
+}
+
+} // namespace detail
+
+/**
+ * Gets the memory resource used for new JSON values, containers and
+ * strings: the resource of the innermost scoped_resource of the calling
+ * thread, or else the resource set with set_default_resource().
+ *
+ * @return The memory resource.
+ */
+inline memory_resource* get_default_resource() noexcept {
+    if (auto* scoped{detail::scoped_resource_storage()}) {
+        return scoped;
+    }
+    return detail::default_resource_storage().load(std::memory_order_acquire);
+}
+
+/**
+ * Sets the memory resource used for new JSON values, containers and strings
+ * by all threads outside of a scoped_resource.
+ *
+ * Values, containers and strings remember the resource they were allocated
+ * from, so the resource must outlive them.
+ *
+ * @param resource The memory resource, or null for new_delete_resource().
+ * @return The previous memory resource.
+ */
+inline memory_resource*
+set_default_resource(memory_resource* resource) noexcept {
+    if (!resource) {
+        resource = new_delete_resource();
+    }
+    return detail::default_resource_storage().exchange(
+        resource, std::memory_order_acq_rel);
+}
+
+/**
+ * Makes the calling thread allocate new JSON values, containers and strings
+ * from a memory resource until the end of the scope, without affecting other
+ * threads. Scopes can be nested.
+ *
+ * Loading with parse_options::resource set uses such a scope.
+ */
+class scoped_resource {
+public:
+    /**
+     * Starts a scope.
+     *
+     * @param resource The memory resource, or null to keep using the current
+     * resource.
+     */
+    explicit scoped_resource(memory_resource* resource) noexcept
+        : m_previous{detail::scoped_resource_storage()} {
+        if (resource) {
+            detail::scoped_resource_storage() = resource;
+        }
+    }
+
+    scoped_resource(const scoped_resource&) = delete;
+    scoped_resource(scoped_resource&&) = delete;
+    scoped_resource& operator=(const scoped_resource&) = delete;
+    scoped_resource& operator=(scoped_resource&&) = delete;
+
+    /// Ends the scope.
+    ~scoped_resource() { detail::scoped_resource_storage() = m_previous; }
+
+private:
+    memory_resource* m_previous;
+};
+
+/**
+ * Allocator that allocates from a memory_resource, modeled after
+ * @c std::pmr::polymorphic_allocator.
+ *
+ * Containers copy the current default resource when copied and keep their
+ * resource when moved.
+ */
+template<typename T>
+class allocator {
+public:
+    /// Allocated type.
+    using value_type = T;
+    /// @cond
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    /// @endcond
+
+    /// Constructs an allocator using the default resource.
+    allocator() noexcept : m_resource{get_default_resource()} {}
+
+    /**
+     * Constructs an allocator using the given resource.
+     *
+     * @param resource The memory resource.
+     */
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    allocator(memory_resource* resource) noexcept : m_resource{resource} {}
+
+    /**
+     * Constructs an allocator using the resource of another allocator.
+     *
+     * @param other The other allocator.
+     */
+    template<typename U>
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    allocator(const allocator<U>& other) noexcept
+        : m_resource{other.resource()} {}
+
+    /**
+     * Allocates memory for objects.
+     *
+     * @param n The number of objects.
+     * @return Pointer to the allocated memory.
+     */
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc{};
+        }
+        return static_cast<T*>(
+            m_resource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Deallocates memory previously allocated with allocate().
+     *
+     * @param p Pointer to the memory.
+     * @param n The number of objects.
+     */
+    void deallocate(T* p, size_t n) noexcept {
+        m_resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    /// @cond
+    allocator select_on_container_copy_construction() const noexcept {
+        return allocator{};
+    }
+    /// @endcond
+
+    /**
+     * Gets the memory resource.
+     *
+     * @return The memory resource.
+     */
+    memory_resource* resource() const noexcept { return m_resource; }
+
+private:
+    memory_resource* m_resource;
+};
+
+/// @cond
+template<typename T, typename U>
+bool operator==(const allocator<T>& a, const allocator<U>& b) noexcept {
+    return a.resource() == b.resource() ||
+           a.resource()->is_equal(*b.resource());
+}
+
+template<typename T, typename U>
+bool operator!=(const allocator<T>& a, const allocator<U>& b) noexcept {
+    return !(a == b);
+}
+/// @endcond
+
+namespace detail {
+
+// Header that precedes objects allocated with resource_new() in order to
+// remember which resource to deallocate from. Keeps the maximum alignment.
+union resource_header {
+    memory_resource* resource;
+    std::max_align_t alignment;
+};
+
+// Allocates memory for an object from the default resource.
+inline void* resource_new(size_t size) {
+    auto* resource{get_default_resource()};
+    auto* p{static_cast<resource_header*>(
+        resource->allocate(sizeof(resource_header) + size))};
+    p->resource = resource;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return p + 1;
+}
+
+// Deallocates memory previously allocated with resource_new().
+inline void resource_delete(void* p, size_t size) noexcept {
+    if (!p) {
+        return;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto* header{static_cast<resource_header*>(p) - 1};
+    header->resource->deallocate(header, sizeof(resource_header) + size);
+}
+
+} // namespace detail
+
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,736 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/binary.hpp"
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/parsing.hpp"
+#include "detail/stream.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+namespace msgpack {
+
+constexpr std::uint8_t nil{0xc0};
+constexpr std::uint8_t false_value{0xc2};
+constexpr std::uint8_t true_value{0xc3};
+constexpr std::uint8_t bin8{0xc4};
+constexpr std::uint8_t ext8{0xc7};
+constexpr std::uint8_t float32{0xca};
+constexpr std::uint8_t float64{0xcb};
+constexpr std::uint8_t uint8{0xcc};
+constexpr std::uint8_t uint16{0xcd};
+constexpr std::uint8_t uint32{0xce};
+constexpr std::uint8_t uint64{0xcf};
+constexpr std::uint8_t int8{0xd0};
+constexpr std::uint8_t int16{0xd1};
+constexpr std::uint8_t int32{0xd2};
+constexpr std::uint8_t int64{0xd3};
+constexpr std::uint8_t fixext1{0xd4};
+constexpr std::uint8_t str8{0xd9};
+constexpr std::uint8_t str16{0xda};
+constexpr std::uint8_t str32{0xdb};
+constexpr std::uint8_t array16{0xdc};
+constexpr std::uint8_t array32{0xdd};
+constexpr std::uint8_t map16{0xde};
+constexpr std::uint8_t map32{0xdf};
+
+} // namespace msgpack
+
+// Reads a 1, 2 or 4 byte length depending on the offset of a type byte from
+// the first of its family, e.g. str8.
+template<typename Reader>
+std::uint32_t read_msgpack_length(Reader& reader, unsigned size_index) {
+    switch (size_index) {
+    case 0:
+        return reader.get();
+    case 1:
+        return reader.template get_big_endian<std::uint16_t>();
+    default:
+        return reader.template get_big_endian<std::uint32_t>();
+    }
+}
+
+// Reads the length of a string following its type byte, or returns false if
+// the type is not a string.
+template<typename Reader>
+bool read_msgpack_string_length(Reader& reader, std::uint8_t type,
+                                std::uint32_t& result) {
+    if ((type & 0xe0U) == 0xa0U) {
+        result = type & 0x1fU;
+        return true;
+    }
+    if (type >= msgpack::str8 && type <= msgpack::str32) {
+        result = read_msgpack_length(
+            reader, static_cast<unsigned>(type - msgpack::str8));
+        return true;
+    }
+    return false;
+}
+
+template<typename Reader>
+value::string_type read_msgpack_bytes(Reader& reader, const parse_context& ctx,
+                                      std::uint32_t length) {
+    check_string_length(ctx, length);
+    value::string_type result;
+    reader.append_string(result, length);
+    return result;
+}
+
+template<typename Reader>
+value decode_msgpack(Reader& reader, parse_context& ctx);
+
+template<typename Reader>
+value decode_msgpack_array(Reader& reader, parse_context& ctx,
+                           std::uint32_t length) {
+    enter_nesting(ctx);
+    value::array_type elements;
+    elements.reserve(reader.reservable(length));
+    for (std::uint32_t i{}; i < length; ++i) {
+        elements.push_back(decode_msgpack(reader, ctx));
+    }
+    leave_nesting(ctx);
+    return make_array(std::move(elements));
+}
+
+template<typename Reader>
+value decode_msgpack_map(Reader& reader, parse_context& ctx,
+                         std::uint32_t length) {
+    enter_nesting(ctx);
+    object_impl object;
+    auto first{ctx.elements.size()};
+    auto first_name{ctx.names.size()};
+    if (!ctx.options.share_object_shapes) {
+        // Every member takes at least two bytes.
+        object.members().reserve(reader.reservable(length, 2));
+    }
+    for (std::uint32_t i{}; i < length; ++i) {
+        std::uint32_t name_length{};
+        if (!read_msgpack_string_length(reader, reader.get(), name_length)) {
+            throw parsing::unexpected_token{};
+        }
+        auto name{read_msgpack_bytes(reader, ctx, name_length)};
+        auto member_value{decode_msgpack(reader, ctx)};
+        add_member(ctx, object, std::move(name), std::move(member_value));
+    }
+    leave_nesting(ctx);
+    return finish_object(ctx, std::move(object), first_name, first);
+}
+
+// Converts binary data to a base64url string like CBOR byte strings.
+inline value make_msgpack_binary(string_ref bytes) {
+    return value{make_unique<string_impl>(to_base64url(
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size()))};
+}
+
+template<typename Reader>
+value decode_msgpack(Reader& reader, parse_context& ctx) {
+    auto type{reader.get()};
+    if (type <= 0x7fU) {
+        return value{make_unique<number_impl>(static_cast<int>(type))};
+    }
+    if (type >= 0xe0U) {
+        return value{make_unique<number_impl>(
+            static_cast<int>(static_cast<std::int8_t>(type)))};
+    }
+    std::uint32_t length{};
+    if (read_msgpack_string_length(reader, type, length)) {
+        return value{make_unique<string_impl>(
+            read_msgpack_bytes(reader, ctx, length))};
+    }
+    if ((type & 0xf0U) == 0x80U) {
+        return decode_msgpack_map(reader, ctx, type & 0x0fU);
+    }
+    if ((type & 0xf0U) == 0x90U) {
+        return decode_msgpack_array(reader, ctx, type & 0x0fU);
+    }
+    switch (type) {
+    case msgpack::nil:
+        return value{make_unique<null_impl>()};
+    case msgpack::false_value:
+        return value{make_unique<boolean_impl>(false)};
+    case msgpack::true_value:
+        return value{make_unique<boolean_impl>(true)};
+    case msgpack::bin8:
+    case msgpack::bin8 + 1:
+    case msgpack::bin8 + 2:
+        length = read_msgpack_length(
+            reader, static_cast<unsigned>(type - msgpack::bin8));
+        return make_msgpack_binary(read_msgpack_bytes(reader, ctx, length));
+    case msgpack::ext8:
+    case msgpack::ext8 + 1:
+    case msgpack::ext8 + 2:
+        // Extension types have no JSON equivalent and keep only their data.
+        length = read_msgpack_length(
+            reader, static_cast<unsigned>(type - msgpack::ext8));
+        reader.get();
+        return make_msgpack_binary(read_msgpack_bytes(reader, ctx, length));
+    case msgpack::fixext1:
+    case msgpack::fixext1 + 1:
+    case msgpack::fixext1 + 2:
+    case msgpack::fixext1 + 3:
+    case msgpack::fixext1 + 4:
+        reader.get();
+        return make_msgpack_binary(read_msgpack_bytes(
+            reader, ctx, 1U << static_cast<unsigned>(type - msgpack::fixext1)));
+    case msgpack::float32:
+        return make_float_value(float_from_bits(
+            reader.template get_big_endian<std::uint32_t>()));
+    case msgpack::float64:
+        return make_float_value(double_from_bits(
+            reader.template get_big_endian<std::uint64_t>()));
+    case msgpack::uint8:
+        return value{make_unique<number_impl>(reader.get())};
+    case msgpack::uint16:
+        return value{make_unique<number_impl>(
+            reader.template get_big_endian<std::uint16_t>())};
+    case msgpack::uint32:
+        return value{make_unique<number_impl>(
+            reader.template get_big_endian<std::uint32_t>())};
+    case msgpack::uint64:
+        return value{make_unique<number_impl>(
+            reader.template get_big_endian<std::uint64_t>())};
+    case msgpack::int8:
+        return value{make_unique<number_impl>(
+            static_cast<std::int8_t>(reader.get()))};
+    case msgpack::int16:
+        return value{make_unique<number_impl>(static_cast<std::int16_t>(
+            reader.template get_big_endian<std::uint16_t>()))};
+    case msgpack::int32:
+        return value{make_unique<number_impl>(static_cast<std::int32_t>(
+            reader.template get_big_endian<std::uint32_t>()))};
+    case msgpack::int64:
+        return value{make_unique<number_impl>(static_cast<std::int64_t>(
+            reader.template get_big_endian<std::uint64_t>()))};
+    case msgpack::array16:
+    case msgpack::array32:
+        return decode_msgpack_array(
+            reader, ctx,
+            read_msgpack_length(
+                reader, static_cast<unsigned>(type - msgpack::array16 + 1)));
+    case msgpack::map16:
+    case msgpack::map32:
+        return decode_msgpack_map(
+            reader, ctx,
+            read_msgpack_length(
+                reader, static_cast<unsigned>(type - msgpack::map16 + 1)));
+    default:
+        throw parsing::unexpected_token{};
+    }
+}
+
+// Writes a type byte followed by a big-endian length in the smallest of the
+// 1, 2 and 4 byte variants that starts at first_type.
+inline void write_msgpack_length(byte_writer& writer, std::uint8_t first_type,
+                                 size_t length) {
+    if (length <= 0xffU) {
+        writer.put(first_type);
+        writer.put(static_cast<std::uint8_t>(length));
+    } else if (length <= 0xffffU) {
+        writer.put(static_cast<std::uint8_t>(first_type + 1));
+        writer.put_big_endian(static_cast<std::uint16_t>(length));
+    } else if (length <= 0xffffffffU) {
+        writer.put(static_cast<std::uint8_t>(first_type + 2));
+        writer.put_big_endian(static_cast<std::uint32_t>(length));
+    } else {
+        throw out_of_range{"Length exceeds the MessagePack limit"};
+    }
+}
+
+// Writes the header of an array or map, which has no 1 byte length variant.
+inline void write_msgpack_container(byte_writer& writer,
+                                    std::uint8_t fix_type,
+                                    std::uint8_t first_type, size_t length) {
+    if (length < 16) {
+        writer.put(static_cast<std::uint8_t>(fix_type | length));
+    } else if (length <= 0xffffU) {
+        writer.put(first_type);
+        writer.put_big_endian(static_cast<std::uint16_t>(length));
+    } else if (length <= 0xffffffffU) {
+        writer.put(static_cast<std::uint8_t>(first_type + 1));
+        writer.put_big_endian(static_cast<std::uint32_t>(length));
+    } else {
+        throw out_of_range{"Length exceeds the MessagePack limit"};
+    }
+}
+
+inline void write_msgpack_unsigned(byte_writer& writer, std::uint64_t v) {
+    if (v <= 0x7fU) {
+        writer.put(static_cast<std::uint8_t>(v));
+    } else if (v <= 0xffU) {
+        writer.put(msgpack::uint8);
+        writer.put(static_cast<std::uint8_t>(v));
+    } else if (v <= 0xffffU) {
+        writer.put(msgpack::uint16);
+        writer.put_big_endian(static_cast<std::uint16_t>(v));
+    } else if (v <= 0xffffffffU) {
+        writer.put(msgpack::uint32);
+        writer.put_big_endian(static_cast<std::uint32_t>(v));
+    } else {
+        writer.put(msgpack::uint64);
+        writer.put_big_endian(v);
+    }
+}
+
+inline void write_msgpack_integer(byte_writer& writer, std::int64_t v) {
+    if (v >= 0) {
+        write_msgpack_unsigned(writer, static_cast<std::uint64_t>(v));
+    } else if (v >= -32) {
+        writer.put(static_cast<std::uint8_t>(v));
+    } else if (v >= std::numeric_limits<std::int8_t>::min()) {
+        writer.put(msgpack::int8);
+        writer.put(static_cast<std::uint8_t>(v));
+    } else if (v >= std::numeric_limits<std::int16_t>::min()) {
+        writer.put(msgpack::int16);
+        writer.put_big_endian(static_cast<std::uint16_t>(v));
+    } else if (v >= std::numeric_limits<std::int32_t>::min()) {
+        writer.put(msgpack::int32);
+        writer.put_big_endian(static_cast<std::uint32_t>(v));
+    } else {
+        writer.put(msgpack::int64);
+        writer.put_big_endian(static_cast<std::uint64_t>(v));
+    }
+}
+
+// Writes integers like write_number() and other numbers as float32 if that
+// holds them exactly.
+inline void write_msgpack_number(byte_writer& writer, double v) {
+    if (is_integral_double(v)) {
+        write_msgpack_integer(writer, static_cast<std::int64_t>(v));
+    } else if (is_exact_float(v)) {
+        writer.put(msgpack::float32);
+        writer.put_big_endian(bits_of(static_cast<float>(v)));
+    } else {
+        writer.put(msgpack::float64);
+        writer.put_big_endian(bits_of(v));
+    }
+}
+
+inline void write_msgpack_number(byte_writer& writer, const number_impl& v) {
+    std::int64_t i{};
+    std::uint64_t u{};
+    switch (v.get_kind()) {
+    case number_impl::kind::int64:
+        v.to_int64(i);
+        write_msgpack_integer(writer, i);
+        break;
+    case number_impl::kind::uint64:
+        v.to_uint64(u);
+        write_msgpack_unsigned(writer, u);
+        break;
+    default:
+        write_msgpack_number(writer, v.data());
+    }
+}
+
+inline void write_msgpack_string(byte_writer& writer, string_ref s) {
+    if (s.size() < 32) {
+        writer.put(static_cast<std::uint8_t>(0xa0U | s.size()));
+    } else {
+        write_msgpack_length(writer, msgpack::str8, s.size());
+    }
+    writer.write(s.data(), s.size());
+}
+
+inline void to_msgpack(byte_writer& writer, const value& v) {
+    using t = value::type;
+    switch (v.get_type()) {
+    case t::object: {
+        const auto& object{dynamic_cast<const object_impl&>(v.impl())};
+        write_msgpack_container(writer, 0x80, msgpack::map16, object.size());
+        if (const auto* shape{object.shape()}) {
+            for (size_t i{}; i < shape->size(); ++i) {
+                write_msgpack_string(writer, (*shape)[i]);
+                to_msgpack(writer, object.values()[i]);
+            }
+            break;
+        }
+        // Members are written in insertion order.
+        const auto& members{object.members()};
+        for (size_t i{}; i < members.size(); ++i) {
+            const auto& member{members.entry_at(i)};
+            write_msgpack_string(writer, member.first);
+            to_msgpack(writer, member.second);
+        }
+        break;
+    }
+    case t::array: {
+        const auto& array{dynamic_cast<const array_impl&>(v.impl())};
+        if (array.is_packed()) {
+            write_msgpack_container(writer, 0x90, msgpack::array16,
+                                    array.numbers().size());
+            for (auto number : array.numbers()) {
+                write_msgpack_number(writer, number);
+            }
+            break;
+        }
+        write_msgpack_container(writer, 0x90, msgpack::array16,
+                                array.elements().size());
+        for (const auto& element : array.elements()) {
+            to_msgpack(writer, element);
+        }
+        break;
+    }
+    case t::string:
+        write_msgpack_string(writer, v.as_string());
+        break;
+    case t::boolean:
+        writer.put(v.as_boolean() ? msgpack::true_value
+                                  : msgpack::false_value);
+        break;
+    case t::null:
+        writer.put(msgpack::nil);
+        break;
+    case t::number:
+        write_msgpack_number(writer,
+                             dynamic_cast<const number_impl&>(v.impl()));
+        break;
+    default:
+        throw invalid_state{"Unexpected value type"};
+    }
+}
+
+// Finds the end of a MessagePack value in a buffer that grows in chunks.
+// Only the headers are read, and scanning resumes where it stopped, so each
+// byte is scanned once however the value is split. Malformed data is left
+// for the decoder to reject.
+class msgpack_scanner {
+public:
+    // Scans a buffer that starts with the value and returns whether the
+    // value is complete. The buffer may have grown since the last call.
+    bool scan(const std::uint8_t* data, size_t size) noexcept {
+        while (m_pending > 0) {
+            std::uint64_t item_size{};
+            std::uint64_t children{};
+            if (!read_header(data + m_end, size - m_end, item_size,
+                             children) ||
+                item_size > size - m_end) {
+                return false;
+            }
+            m_end += static_cast<size_t>(item_size);
+            m_pending += children;
+            --m_pending;
+        }
+        return true;
+    }
+
+    // Length of the value once complete.
+    size_t end() const noexcept { return m_end; }
+
+    void reset() noexcept {
+        m_end = 0;
+        m_pending = 1;
+    }
+
+private:
+    // Gets the size of an item excluding nested items, and the number of
+    // nested items, or returns false if the header is incomplete.
+    static bool read_header(const std::uint8_t* p, size_t available,
+                            std::uint64_t& size,
+                            std::uint64_t& children) noexcept {
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (available == 0) {
+            return false;
+        }
+        auto type{p[0]};
+        // Reads a big-endian length of 1, 2 or 4 bytes after the type.
+        auto length = [&](unsigned bytes, std::uint64_t& result) {
+            if (available < 1 + bytes) {
+                return false;
+            }
+            result = 0;
+            for (unsigned i{1}; i <= bytes; ++i) {
+                result = (result << 8U) | p[i];
+            }
+            return true;
+        };
+        std::uint64_t n{};
+        size = 1;
+        children = 0;
+        if ((type & 0xf0U) == 0x80U) {
+            children = 2 * (type & 0x0fU);
+        } else if ((type & 0xf0U) == 0x90U) {
+            children = type & 0x0fU;
+        } else if ((type & 0xe0U) == 0xa0U) {
+            size += type & 0x1fU;
+        } else if (type >= msgpack::bin8 && type <= msgpack::bin8 + 2) {
+            auto bytes{1U << static_cast<unsigned>(type - msgpack::bin8)};
+            if (!length(bytes, n)) {
+                return false;
+            }
+            size += bytes + n;
+        } else if (type >= msgpack::ext8 && type <= msgpack::ext8 + 2) {
+            auto bytes{1U << static_cast<unsigned>(type - msgpack::ext8)};
+            if (!length(bytes, n)) {
+                return false;
+            }
+            size += bytes + 1 + n;
+        } else if (type >= msgpack::float32 && type <= msgpack::int64) {
+            // Numbers of 4, 8, 1, 2, 4, 8, 1, 2, 4 and 8 bytes.
+            constexpr std::uint8_t sizes[]{4, 8, 1, 2, 4, 8, 1, 2, 4, 8};
+            size += sizes[type - msgpack::float32];
+        } else if (type >= msgpack::fixext1 && type < msgpack::str8) {
+            size += 1 + (1U << static_cast<unsigned>(type - msgpack::fixext1));
+        } else if (type >= msgpack::str8 && type <= msgpack::str32) {
+            auto bytes{1U << static_cast<unsigned>(type - msgpack::str8)};
+            if (!length(bytes, n)) {
+                return false;
+            }
+            size += bytes + n;
+        } else if (type == msgpack::array16 || type == msgpack::array32) {
+            auto bytes{type == msgpack::array16 ? 2U : 4U};
+            if (!length(bytes, children)) {
+                return false;
+            }
+            size += bytes;
+        } else if (type == msgpack::map16 || type == msgpack::map32) {
+            auto bytes{type == msgpack::map16 ? 2U : 4U};
+            if (!length(bytes, n)) {
+                return false;
+            }
+            size += bytes;
+            children = 2 * n;
+        }
+        return true;
+        // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+
+    size_t m_end{};
+    std::uint64_t m_pending{1};
+};
+
+} // namespace detail
+
+/**
+ * Incrementally decodes a sequence of MessagePack values from data that
+ * arrives in chunks, such as from a socket.
+ *
+ * Object shapes are shared across all values decoded by the same decoder
+ * if enabled in the options.
+ */
+class msgpack_decoder {
+public:
+    /**
+     * Constructs a decoder.
+     *
+     * @param options Options for loading. The limits, object shape sharing
+     * and memory resource apply. The nesting depth is limited to 1000 unless
+     * another limit is set.
+     */
+    explicit msgpack_decoder(const parse_options& options = {})
+        : m_ctx{detail::with_binary_depth_limit(options)} {}
+
+    /**
+     * Appends data to the buffer of the decoder.
+     *
+     * @param data The data.
+     * @param length The length of the data in bytes.
+     */
+    void feed(const std::uint8_t* data, size_t length) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        m_buffer.insert(m_buffer.end(), data, data + length);
+    }
+
+    /**
+     * Decodes the next value if it has been fed completely.
+     *
+     * The data of an incomplete value is only scanned for its length, and
+     * scanning resumes on the next call, so the value is decoded once when
+     * complete. Malformed data is discarded before the error is thrown.
+     *
+     * @param result Output parameter of the decoded value.
+     * @return Whether a value was decoded.
+     * @throw parse_error if the data is malformed.
+     */
+    bool next(value& result) {
+        const auto* data{m_buffer.data() + m_offset};
+        if (!m_scanner.scan(data, m_buffer.size() - m_offset)) {
+            return false;
+        }
+        scoped_resource scope{m_ctx.options.resource};
+        detail::byte_reader reader{data, m_scanner.end()};
+        try {
+            result = detail::decode_msgpack(reader, m_ctx);
+        } catch (...) {
+            discard();
+            throw;
+        }
+        m_scanner.reset();
+        m_offset += reader.position();
+        // Drop consumed data once it makes up most of the buffer.
+        if (m_offset > m_buffer.size() / 2) {
+            m_buffer.erase(m_buffer.begin(),
+                           m_buffer.begin() +
+                               static_cast<std::ptrdiff_t>(m_offset));
+            m_offset = 0;
+        }
+        return true;
+    }
+
+    /**
+     * Gets the length of the data that has been fed but not decoded.
+     *
+     * @return The length in bytes.
+     */
+    size_t buffered_length() const noexcept {
+        return m_buffer.size() - m_offset;
+    }
+
+private:
+    // Drops the buffered data and what a partially decoded value left on
+    // the shared stacks.
+    void discard() noexcept {
+        m_ctx.depth = 0;
+        m_ctx.elements.clear();
+        m_ctx.names.clear();
+        m_scanner.reset();
+        m_buffer.clear();
+        m_offset = 0;
+    }
+
+    detail::parse_context m_ctx;
+    detail::msgpack_scanner m_scanner;
+    std::vector<std::uint8_t> m_buffer;
+    size_t m_offset{};
+};
+
+/**
+ * Loads a JSON value from MessagePack.
+ *
+ * Binary and extension data become base64url strings and infinity and NaN
+ * become null. Map keys must be strings. Containers are allocated once
+ * using the length in their header.
+ *
+ * @param data The MessagePack data.
+ * @param length The length of the data in bytes.
+ * @param options Options for loading. The limits, object shape sharing
+ * and memory resource apply. The nesting depth is limited to 1000 unless
+ * another limit is set.
+ * @return The JSON value.
+ * @throw parse_error if the data is malformed or has trailing bytes.
+ */
+inline value load_msgpack(const std::uint8_t* data, size_t length,
+                          const parse_options& options = {}) {
+    detail::byte_reader reader{data, length};
+    scoped_resource scope{options.resource};
+    detail::parse_context ctx{detail::with_binary_depth_limit(options)};
+    auto result{detail::decode_msgpack(reader, ctx)};
+    if (!reader.at_end()) {
+        throw detail::parsing::unexpected_token{};
+    }
+    return result;
+}
+
+/**
+ * Loads a JSON value from MessagePack.
+ *
+ * @param data The MessagePack data.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @throw parse_error if the data is malformed or has trailing bytes.
+ * @see load_msgpack(const std::uint8_t*, size_t, const parse_options&)
+ */
+inline value load_msgpack(const std::vector<std::uint8_t>& data,
+                          const parse_options& options = {}) {
+    return load_msgpack(data.data(), data.size(), options);
+}
+
+/**
+ * Loads the next JSON value from a stream of MessagePack values.
+ *
+ * Only the bytes of one value are read, so consecutive values can be
+ * loaded by calling this repeatedly.
+ *
+ * @param is The input stream.
+ * @param options Options for loading.
+ * @return The JSON value.
+ * @throw parse_error if the data is malformed or ends early.
+ */
+inline value load_msgpack(std::istream& is, const parse_options& options = {}) {
+    detail::stream_byte_reader reader{is};
+    scoped_resource scope{options.resource};
+    detail::parse_context ctx{detail::with_binary_depth_limit(options)};
+    return detail::decode_msgpack(reader, ctx);
+}
+
+/**
+ * Saves a JSON value as MessagePack to a stream.
+ *
+ * Integers use the shortest encoding and other numbers use float32 if that
+ * holds them exactly.
+ *
+ * @param os The output stream.
+ * @param v The JSON value.
+ * @throw out_of_range if a string or container is too long for MessagePack.
+ */
+inline void save_msgpack(std::ostream& os, const value& v) {
+    detail::byte_writer writer{os};
+    detail::to_msgpack(writer, v);
+}
+
+/**
+ * Saves a JSON value as MessagePack.
+ *
+ * @param v The JSON value.
+ * @return The MessagePack data.
+ * @throw out_of_range if a string or container is too long for MessagePack.
+ */
+inline std::vector<std::uint8_t> save_msgpack(const value& v) {
+    std::vector<std::uint8_t> result;
+    detail::vector_streambuf buf{result};
+    std::ostream os{&buf};
+    save_msgpack(os, v);
+    return result;
+}
+
+/**
+ * Saves a JSON value as MessagePack into a byte array with a fixed length.
+ *
+ * If the MessagePack data is longer than the byte array then the output is
+ * truncated.
+ *
+ * @param v The JSON value.
+ * @param data The output byte array. May be null if @p length is zero.
+ * @param length The length of the output byte array in bytes.
+ * @return The length of the MessagePack data in bytes.
+ * @throw out_of_range if a string or container is too long for MessagePack.
+ */
+inline size_t save_msgpack(const value& v, std::uint8_t* data, size_t length) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    detail::buffer_streambuf buf{reinterpret_cast<char*>(data), length};
+    std::ostream os{&buf};
+    save_msgpack(os, v);
+    return buf.required_length();
+}
+
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/macros.hpp"
+#include "memory_resource.hpp"
+
+#include <cstddef>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+/**
+ * Options for loading JSON.
+ *
+ * A default-constructed instance yields the default behavior.
+ */
+struct parse_options {
+    /// Maximum nesting depth of arrays and objects, or 0 for no limit. CBOR
+    /// and MessagePack are limited to a depth of 1000 instead of none.
+    size_t max_depth{};
+    /// Maximum length of strings in bytes after unescaping, or 0 for no limit.
+    size_t max_string_length{};
+    /**
+     * Whether to keep the text of numbers alongside their converted value.
+     * Numbers that are not modified are saved verbatim, so numbers with more
+     * precision than a double survive loading and saving.
+     *
+     * Numbers are still converted once while loading, and the text is
+     * stored separately so that other numbers do not grow.
+     */
+    bool raw_numbers{};
+    /**
+     * Whether to store arrays of numbers packed as doubles rather than as
+     * separate values, which saves memory and gives access to the numbers
+     * with value::as_number_span(). Integers beyond 2^53 keep an array from
+     * being packed.
+     *
+     * The const value::as_array() keeps an array packed and creates a copy
+     * of the elements on first use, which is safe from multiple threads.
+     * The non-const value::as_array() switches an array to separate values
+     * for good.
+     */
+    bool pack_numeric_arrays{};
+    /**
+     * Whether objects with the same member names, such as the rows of a
+     * table, share one list of names and only store their values.
+     *
+     * The members are still a dict that can be read and modified in place
+     * through value::as_object(). Adding or removing members gives an
+     * object its own list of names.
+     */
+    bool share_object_shapes{};
+    /**
+     * Whether to reject strings and member names that are not valid UTF-8
+     * after unescaping.
+     */
+    bool validate_utf8{};
+    /**
+     * Memory resource to allocate the loaded values, containers and strings
+     * from, or null for the default resource. Only the loading thread is
+     * affected; the resource must outlive the loaded value.
+     */
+    memory_resource* resource{};
+};
+
+LANGNES_JSON_CXX_NS_END
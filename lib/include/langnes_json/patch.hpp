@@ -0,0 +1,512 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/value_impl.hpp"
+#include "equality.hpp"
+#include "errors.hpp"
+#include "pointer.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Finds the object or array that contains the value a pointer refers to.
+inline value& find_patch_parent(value& root, const compiled_pointer& path) {
+    const auto& tokens{path.tokens()};
+    auto* current{&root};
+    for (size_t i{}; i + 1 < tokens.size(); ++i) {
+        const auto& token{tokens[i]};
+        value* child{};
+        if (current->is_object()) {
+            child = current->find_member(token.name());
+        } else if (current->is_array()) {
+            auto& elements{current->as_array()};
+            if (token.index() < elements.size()) {
+                child = &elements[token.index()];
+            }
+        }
+        if (!child) {
+            throw out_of_range{"JSON pointer does not refer to a value"};
+        }
+        current = child;
+    }
+    return *current;
+}
+
+inline void patch_add(value& root, const compiled_pointer& path,
+                      value&& v) {
+    if (path.tokens().empty()) {
+        root = std::move(v);
+        return;
+    }
+    auto& parent{find_patch_parent(root, path)};
+    const auto& token{path.tokens().back()};
+    if (parent.is_object()) {
+        parent.as_object()[token.name()] = std::move(v);
+        return;
+    }
+    if (!parent.is_array()) {
+        throw out_of_range{"JSON pointer does not refer to a value"};
+    }
+    auto& elements{parent.as_array()};
+    if (token.is_end_index()) {
+        elements.push_back(std::move(v));
+        return;
+    }
+    if (token.index() > elements.size()) {
+        throw out_of_range{"Index out of range"};
+    }
+    elements.insert(elements.begin() +
+                        static_cast<std::ptrdiff_t>(token.index()),
+                    std::move(v));
+}
+
+// Removes the value that a pointer refers to and returns it.
+inline value patch_remove(value& root, const compiled_pointer& path) {
+    if (path.tokens().empty()) {
+        throw invalid_argument{};
+    }
+    auto& parent{find_patch_parent(root, path)};
+    const auto& token{path.tokens().back()};
+    if (parent.is_object()) {
+        auto& members{parent.as_object()};
+        auto found{members.find(token.name())};
+        if (found == members.end()) {
+            throw out_of_range{"JSON pointer does not refer to a value"};
+        }
+        auto result{std::move(found->second)};
+        members.erase(found);
+        return result;
+    }
+    if (!parent.is_array()) {
+        throw out_of_range{"JSON pointer does not refer to a value"};
+    }
+    auto& elements{parent.as_array()};
+    if (token.index() >= elements.size()) {
+        throw out_of_range{"Index out of range"};
+    }
+    auto it{elements.begin() + static_cast<std::ptrdiff_t>(token.index())};
+    auto result{std::move(*it)};
+    elements.erase(it);
+    return result;
+}
+
+inline const value& patch_member(const value& operation, const char* name) {
+    const auto* found{operation.find_member(name)};
+    if (!found) {
+        throw invalid_argument{};
+    }
+    return *found;
+}
+
+// The value of an operation is copied from a borrowed patch and moved out of
+// an owned one.
+inline value patch_operand(const value& operation) {
+    return value{patch_member(operation, "value")};
+}
+
+inline value patch_operand(value& operation) {
+    auto* found{operation.find_member("value")};
+    if (!found) {
+        throw invalid_argument{};
+    }
+    return std::move(*found);
+}
+
+inline compiled_pointer patch_pointer(const value& operation,
+                                      const char* name) {
+    const auto& pointer{patch_member(operation, name)};
+    if (!pointer.is_string()) {
+        throw invalid_argument{};
+    }
+    return compiled_pointer{pointer.as_string()};
+}
+
+// Whether a pointer refers to a value within the value that another pointer
+// refers to.
+inline bool is_proper_prefix(const compiled_pointer& prefix,
+                             const compiled_pointer& path) noexcept {
+    const auto& a{prefix.tokens()};
+    const auto& b{path.tokens()};
+    if (a.size() >= b.size()) {
+        return false;
+    }
+    for (size_t i{}; i < a.size(); ++i) {
+        if (a[i].name() != b[i].name()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Values of operations are moved out of the patch when it is owned, which is
+// when the operation is not const.
+template<typename Operation>
+void apply_operation(value& target, Operation& operation) {
+    if (!operation.is_object()) {
+        throw invalid_argument{};
+    }
+    const auto& op_value{patch_member(operation, "op")};
+    if (!op_value.is_string()) {
+        throw invalid_argument{};
+    }
+    const auto& op{op_value.as_string()};
+    auto path{patch_pointer(operation, "path")};
+    auto operand = [&] { return patch_operand(operation); };
+    if (op == "add") {
+        patch_add(target, path, operand());
+    } else if (op == "remove") {
+        patch_remove(target, path);
+    } else if (op == "replace") {
+        auto& existing{target.at_pointer(path)};
+        existing = operand();
+    } else if (op == "move") {
+        auto from{patch_pointer(operation, "from")};
+        if (is_proper_prefix(from, path)) {
+            throw invalid_argument{};
+        }
+        patch_add(target, path, patch_remove(target, from));
+    } else if (op == "copy") {
+        auto from{patch_pointer(operation, "from")};
+        patch_add(target, path, value{target.at_pointer(from)});
+    } else if (op == "test") {
+        if (target.at_pointer(path) != patch_member(operation, "value")) {
+            throw invalid_state{"Test operation failed"};
+        }
+    } else {
+        throw invalid_argument{};
+    }
+}
+
+class patch_builder {
+public:
+    void add(const std::string& path, const value& v) {
+        push("add", path, &v);
+    }
+
+    void remove(const std::string& path) { push("remove", path, nullptr); }
+
+    void replace(const std::string& path, const value& v) {
+        push("replace", path, &v);
+    }
+
+    void diff(const std::string& path, const value& a, const value& b) {
+        if (a.get_type() != b.get_type()) {
+            replace(path, b);
+            return;
+        }
+        // Equal hashes confirmed by a comparison skip unchanged subtrees
+        // without descending into them.
+        if ((a.is_object() || a.is_array()) && hash_of(a) == hash_of(b) &&
+            a == b) {
+            return;
+        }
+        if (a.is_object()) {
+            diff_objects(path, a, b);
+        } else if (a.is_array()) {
+            diff_arrays(path, a, b);
+        } else if (a != b) {
+            replace(path, b);
+        }
+    }
+
+    value::array_type&& release() noexcept { return std::move(m_operations); }
+
+private:
+    void push(const char* op, const std::string& path, const value* v) {
+        auto operation{make_unique<object_impl>()};
+        auto& members{operation->members()};
+        members.emplace("op", value{op});
+        members.emplace("path", value{path});
+        if (v) {
+            members.emplace("value", *v);
+        }
+        m_operations.emplace_back(std::move(operation));
+    }
+
+    // Members are visited in place so that the hashes of shared object
+    // shapes are looked up by the same addresses that they were stored by.
+    void diff_objects(const std::string& path, const value& a,
+                      const value& b) {
+        a.for_each_member([&](string_ref name, const value& member) {
+            auto member_path{path + '/' + escape_pointer_token(name)};
+            if (const auto* other{b.find_member(name)}) {
+                diff(member_path, member, *other);
+            } else {
+                remove(member_path);
+            }
+        });
+        b.for_each_member([&](string_ref name, const value& member) {
+            if (!a.find_member(name)) {
+                add(path + '/' + escape_pointer_token(name), member);
+            }
+        });
+    }
+
+    // Elements are matched by their hashes. A common prefix and suffix are
+    // skipped, and a longest common subsequence aligns the remaining
+    // elements unless there are too many of them.
+    void diff_arrays(const std::string& path, const value& a,
+                     const value& b) {
+        const auto& x{a.as_array()};
+        const auto& y{b.as_array()};
+        std::vector<std::uint64_t> x_hashes;
+        std::vector<std::uint64_t> y_hashes;
+        x_hashes.reserve(x.size());
+        y_hashes.reserve(y.size());
+        for (const auto& element : x) {
+            x_hashes.push_back(hash_of(element));
+        }
+        for (const auto& element : y) {
+            y_hashes.push_back(hash_of(element));
+        }
+        size_t prefix{};
+        while (prefix < x.size() && prefix < y.size() &&
+               x_hashes[prefix] == y_hashes[prefix] &&
+               x[prefix] == y[prefix]) {
+            ++prefix;
+        }
+        size_t suffix{};
+        while (suffix < x.size() - prefix && suffix < y.size() - prefix &&
+               x_hashes[x.size() - 1 - suffix] ==
+                   y_hashes[y.size() - 1 - suffix] &&
+               x[x.size() - 1 - suffix] == y[y.size() - 1 - suffix]) {
+            ++suffix;
+        }
+        auto n{x.size() - prefix - suffix};
+        auto m{y.size() - prefix - suffix};
+        std::vector<edit> edits;
+        constexpr size_t max_table_size{1U << 20U};
+        if (n > 0 && m > 0 && n <= max_table_size / m) {
+            edits = align(x_hashes, y_hashes, prefix, n, m);
+        } else {
+            edits.assign(n < m ? n : m, edit::keep);
+            edits.insert(edits.end(), n > m ? n - m : 0, edit::remove);
+            edits.insert(edits.end(), m > n ? m - n : 0, edit::add);
+        }
+        emit(path, x, y, prefix, edits);
+    }
+
+    enum class edit : std::uint8_t { keep, remove, add };
+
+    // Computes a shortest edit script with a longest common subsequence.
+    static std::vector<edit> align(const std::vector<std::uint64_t>& x,
+                                   const std::vector<std::uint64_t>& y,
+                                   size_t offset, size_t n, size_t m) {
+        // lengths[i * (m + 1) + j] is the length of the longest common
+        // subsequence of the suffixes starting at i and j.
+        std::vector<std::uint32_t> lengths((n + 1) * (m + 1));
+        for (auto i{n}; i-- > 0;) {
+            for (auto j{m}; j-- > 0;) {
+                auto& cell{lengths[i * (m + 1) + j]};
+                if (x[offset + i] == y[offset + j]) {
+                    cell = lengths[(i + 1) * (m + 1) + j + 1] + 1;
+                } else {
+                    auto down{lengths[(i + 1) * (m + 1) + j]};
+                    auto right{lengths[i * (m + 1) + j + 1]};
+                    cell = down > right ? down : right;
+                }
+            }
+        }
+        std::vector<edit> result;
+        size_t i{};
+        size_t j{};
+        while (i < n && j < m) {
+            if (x[offset + i] == y[offset + j]) {
+                result.push_back(edit::keep);
+                ++i;
+                ++j;
+            } else if (lengths[(i + 1) * (m + 1) + j] >=
+                       lengths[i * (m + 1) + j + 1]) {
+                result.push_back(edit::remove);
+                ++i;
+            } else {
+                result.push_back(edit::add);
+                ++j;
+            }
+        }
+        result.insert(result.end(), n - i, edit::remove);
+        result.insert(result.end(), m - j, edit::add);
+        return result;
+    }
+
+    // Adjacent removals and additions are paired up and diffed in place.
+    // Kept elements have equal hashes and are only diffed if they differ.
+    void emit(const std::string& path, const value::array_type& x,
+              const value::array_type& y, size_t prefix,
+              const std::vector<edit>& edits) {
+        auto i{prefix};
+        auto j{prefix};
+        for (size_t k{}; k < edits.size();) {
+            if (edits[k] == edit::keep) {
+                if (x[i] != y[j]) {
+                    diff(path + '/' + std::to_string(j), x[i], y[j]);
+                }
+                ++i;
+                ++j;
+                ++k;
+                continue;
+            }
+            size_t removals{};
+            size_t additions{};
+            for (; k < edits.size() && edits[k] != edit::keep; ++k) {
+                ++(edits[k] == edit::remove ? removals : additions);
+            }
+            auto paired{removals < additions ? removals : additions};
+            for (size_t p{}; p < paired; ++p) {
+                diff(path + '/' + std::to_string(j), x[i], y[j]);
+                ++i;
+                ++j;
+            }
+            for (auto r{removals - paired}; r > 0; --r) {
+                remove(path + '/' + std::to_string(j));
+                ++i;
+            }
+            for (auto a{additions - paired}; a > 0; --a) {
+                add(path + '/' + std::to_string(j), y[j]);
+                ++j;
+            }
+        }
+    }
+
+    // Every subtree is hashed once per diff.
+    std::uint64_t hash_of(const value& v) {
+        return hash_value(v, false, &m_hashes);
+    }
+
+    value::array_type m_operations;
+    hash_memo m_hashes;
+};
+
+} // namespace detail
+
+/**
+ * Applies a JSON Patch (RFC 6902) to a JSON value in place.
+ *
+ * Values are moved within the target by "move" operations and copied from
+ * the patch by "add", "replace" and "copy" operations. Operations are
+ * applied in order to a copy of the target, which replaces the target once
+ * every operation has succeeded, so a failing patch leaves the target
+ * unchanged.
+ *
+ * @param target The JSON value to modify.
+ * @param patch The JSON Patch, an array of operations.
+ * @throw invalid_argument if the patch is malformed.
+ * @throw out_of_range if a path does not refer to a value.
+ * @throw invalid_state if a "test" operation fails.
+ */
+inline void apply_patch(value& target, const value& patch) {
+    if (!patch.is_array()) {
+        throw invalid_argument{};
+    }
+    value result{target};
+    for (const auto& operation : patch.as_array()) {
+        detail::apply_operation(result, operation);
+    }
+    target = std::move(result);
+}
+
+/**
+ * Applies a JSON Patch (RFC 6902) to a JSON value in place and moves the
+ * values of the operations into the target instead of copying them.
+ *
+ * @copydetails apply_patch(value&, const value&)
+ */
+inline void apply_patch(value& target, value&& patch) {
+    if (!patch.is_array()) {
+        throw invalid_argument{};
+    }
+    value result{target};
+    for (auto& operation : patch.as_array()) {
+        detail::apply_operation(result, operation);
+    }
+    target = std::move(result);
+}
+
+/**
+ * Generates a JSON Patch (RFC 6902) that turns one JSON value into another.
+ *
+ * Unchanged subtrees produce no operations. Every subtree is hashed once,
+ * and subtrees with equal hashes are compared instead of diffed. Array
+ * elements are aligned by their hashes so that insertions and removals in
+ * the middle of an array do not turn into replacements of every following
+ * element.
+ *
+ * @param from The original JSON value.
+ * @param to The modified JSON value.
+ * @return The JSON Patch, an array of "add", "remove" and "replace"
+ * operations.
+ */
+inline value diff(const value& from, const value& to) {
+    detail::patch_builder builder;
+    builder.diff("", from, to);
+    auto result{detail::make_unique<detail::array_impl>()};
+    result->elements() = builder.release();
+    return value{std::move(result)};
+}
+
+/**
+ * Applies a JSON Merge Patch (RFC 7396) to a JSON value in place.
+ *
+ * Members of the patch are moved into the target, and null members remove
+ * the corresponding members of the target. A patch that is not an object
+ * replaces the target.
+ *
+ * @param target The JSON value to modify.
+ * @param patch The JSON Merge Patch, which is left in a valid but
+ * unspecified state.
+ */
+inline void merge_patch(value& target, value&& patch) {
+    if (!patch.is_object()) {
+        target = std::move(patch);
+        return;
+    }
+    if (!target.is_object()) {
+        target = value{detail::make_unique<detail::object_impl>()};
+    }
+    auto& members{target.as_object()};
+    auto& patch_members{patch.as_object()};
+    for (size_t i{}; i < patch_members.size(); ++i) {
+        auto member{patch_members.entry_at(i)};
+        if (member.second.is_null()) {
+            members.erase(member.first);
+            continue;
+        }
+        auto found{members.find(member.first)};
+        if (found != members.end()) {
+            merge_patch(found->second, std::move(member.second));
+        } else if (member.second.is_object()) {
+            // Null members of a new object are dropped as well.
+            auto inserted{members.emplace(member.first, value{}).first};
+            merge_patch(inserted->second, std::move(member.second));
+        } else {
+            members.emplace(member.first, std::move(member.second));
+        }
+    }
+}
+
+LANGNES_JSON_CXX_NS_END
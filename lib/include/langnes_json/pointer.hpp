@@ -0,0 +1,278 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/macros.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Escapes an object member name for use as a JSON pointer reference token.
+inline std::string escape_pointer_token(string_ref name) {
+    std::string result;
+    result.reserve(name.size());
+    for (auto c : name) {
+        if (c == '~') {
+            result += "~0";
+        } else if (c == '/') {
+            result += "~1";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+} // namespace detail
+
+/**
+ * JSON Pointer (RFC 6901) that has been parsed once so that it can be
+ * resolved repeatedly without allocating memory.
+ */
+class compiled_pointer {
+public:
+    /// Reference token of a JSON pointer.
+    class token {
+    public:
+        /// Value of index() when the token is not a valid array index.
+        static constexpr size_t npos{std::numeric_limits<size_t>::max()};
+
+        /**
+         * Constructs a reference token.
+         *
+         * @param name The unescaped reference token.
+         */
+        explicit token(std::string name) noexcept
+            : m_name{std::move(name)},
+              m_index{parse_index(m_name)} {}
+
+        /**
+         * Gets the unescaped reference token used as an object member name.
+         *
+         * @return The member name.
+         */
+        const std::string& name() const noexcept { return m_name; }
+
+        /**
+         * Gets the reference token as an array index.
+         *
+         * @return The array index, or @c npos if the token is not an index.
+         */
+        size_t index() const noexcept { return m_index; }
+
+        /**
+         * Checks whether the token refers to the position after the last
+         * array element ("-").
+         *
+         * @return Whether the token is "-".
+         */
+        bool is_end_index() const noexcept { return m_name == "-"; }
+
+    private:
+        static size_t parse_index(const std::string& s) noexcept {
+            if (s.empty() || (s.size() > 1 && s[0] == '0')) {
+                return npos;
+            }
+            size_t index{};
+            for (auto c : s) {
+                if (c < '0' || c > '9') {
+                    return npos;
+                }
+                auto digit{static_cast<size_t>(c - '0')};
+                if (index > (npos - 1 - digit) / 10) {
+                    return npos;
+                }
+                index = index * 10 + digit;
+            }
+            return index;
+        }
+
+        std::string m_name;
+        size_t m_index;
+    };
+
+    /// Constructs a pointer that refers to the whole document.
+    compiled_pointer() = default;
+
+    /**
+     * Parses a JSON pointer.
+     *
+     * @param pointer The JSON pointer, e.g. "/a/b/0".
+     * @throw invalid_argument if the pointer is malformed.
+     */
+    explicit compiled_pointer(string_ref pointer) {
+        if (pointer.empty()) {
+            return;
+        }
+        if (pointer[0] != '/') {
+            throw invalid_argument{};
+        }
+        std::string name;
+        for (size_t i{1}; i <= pointer.size(); ++i) {
+            if (i == pointer.size() || pointer[i] == '/') {
+                m_tokens.emplace_back(std::move(name));
+                name.clear();
+                continue;
+            }
+            auto c{pointer[i]};
+            if (c == '~') {
+                auto next{i + 1 < pointer.size() ? pointer[i + 1] : '\0'};
+                if (next == '0') {
+                    c = '~';
+                } else if (next == '1') {
+                    c = '/';
+                } else {
+                    throw invalid_argument{};
+                }
+                ++i;
+            }
+            name += c;
+        }
+    }
+
+    /**
+     * Gets the reference tokens.
+     *
+     * @return The reference tokens.
+     */
+    const std::vector<token>& tokens() const noexcept { return m_tokens; }
+
+    /**
+     * Finds the value that the pointer refers to.
+     *
+     * @param root The document to search.
+     * @return Pointer to the value, or null if not found.
+     */
+    const value* find(const value& root) const noexcept {
+        const auto* current{&root};
+        for (const auto& token : m_tokens) {
+            current = find_child(*current, token);
+            if (!current) {
+                return nullptr;
+            }
+        }
+        return current;
+    }
+
+    /**
+     * Finds the value that the pointer refers to for modification.
+     *
+     * Every value along the way is accessed mutably, which discards their
+     * cached hashes and switches packed arrays to separate values.
+     *
+     * @param root The document to search.
+     * @return Pointer to the value, or null if not found.
+     */
+    value* find(value& root) const {
+        auto* current{&root};
+        for (const auto& token : m_tokens) {
+            current = find_child(*current, token);
+            if (!current) {
+                return nullptr;
+            }
+        }
+        return current;
+    }
+
+    /**
+     * Finds the value that a reference token refers to within a value.
+     *
+     * @param parent The object or array to search.
+     * @param ref The reference token.
+     * @return Pointer to the value, or null if not found.
+     */
+    static const value* find_child(const value& parent,
+                                   const token& ref) noexcept {
+        if (parent.is_object()) {
+            return parent.find_member(ref.name());
+        }
+        if (parent.is_array()) {
+            const auto& elements{parent.as_array()};
+            if (ref.index() >= elements.size()) {
+                return nullptr;
+            }
+            return &elements[ref.index()];
+        }
+        return nullptr;
+    }
+
+    /// @copydoc find_child(const value&, const token&)
+    static value* find_child(value& parent, const token& ref) {
+        if (parent.is_object()) {
+            return parent.find_member(ref.name());
+        }
+        if (parent.is_array()) {
+            auto& elements{parent.as_array()};
+            if (ref.index() >= elements.size()) {
+                return nullptr;
+            }
+            return &elements[ref.index()];
+        }
+        return nullptr;
+    }
+
+private:
+    std::vector<token> m_tokens;
+};
+
+inline const value* value::find_pointer(const std::string& pointer) const {
+    return compiled_pointer{pointer}.find(*this);
+}
+
+inline value* value::find_pointer(const std::string& pointer) {
+    return compiled_pointer{pointer}.find(*this);
+}
+
+inline const value*
+value::find_pointer(const compiled_pointer& pointer) const noexcept {
+    return pointer.find(*this);
+}
+
+inline value* value::find_pointer(const compiled_pointer& pointer) {
+    return pointer.find(*this);
+}
+
+inline const value& value::at_pointer(const std::string& pointer) const {
+    return at_pointer(compiled_pointer{pointer});
+}
+
+inline value& value::at_pointer(const std::string& pointer) {
+    return at_pointer(compiled_pointer{pointer});
+}
+
+inline const value& value::at_pointer(const compiled_pointer& pointer) const {
+    if (const auto* found{pointer.find(*this)}) {
+        return *found;
+    }
+    throw out_of_range{"JSON pointer does not refer to a value"};
+}
+
+inline value& value::at_pointer(const compiled_pointer& pointer) {
+    if (auto* found{pointer.find(*this)}) {
+        return *found;
+    }
+    throw out_of_range{"JSON pointer does not refer to a value"};
+}
+
+LANGNES_JSON_CXX_NS_END
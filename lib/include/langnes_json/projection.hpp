@@ -0,0 +1,306 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/optional.hpp"
+#include "detail/parsing.hpp"
+#include "detail/token_rules.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "pointer.hpp"
+#include "value.hpp"
+
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+struct projection_node {
+    static constexpr size_t npos{std::numeric_limits<size_t>::max()};
+
+    // Finds the child node for an object member.
+    size_t find_member(string_ref name) const noexcept {
+        for (const auto& child : children) {
+            if (child.first.name() == name) {
+                return child.second;
+            }
+        }
+        return wildcard;
+    }
+
+    // Finds the child node for an array element.
+    size_t find_element(size_t index) const noexcept {
+        for (const auto& child : children) {
+            if (child.first.index() == index) {
+                return child.second;
+            }
+        }
+        return wildcard;
+    }
+
+    // Whether the whole value is selected.
+    bool is_leaf{};
+    size_t wildcard{npos};
+    std::vector<std::pair<compiled_pointer::token, size_t>> children;
+};
+
+} // namespace detail
+
+/**
+ * Set of JSON pointers that selects the parts of a document to load with
+ * load_projected().
+ *
+ * The reference token "*" matches every member of an object and every
+ * element of an array.
+ */
+class projection {
+public:
+    /**
+     * Constructs a projection.
+     *
+     * @param pointers The JSON pointers, e.g. "/user/id".
+     * @throw invalid_argument if a pointer is malformed.
+     */
+    projection(std::initializer_list<std::string> pointers)
+        : projection{pointers.begin(), pointers.end()} {}
+
+    /**
+     * Constructs a projection.
+     *
+     * @param first Iterator to the first JSON pointer.
+     * @param last Iterator past the last JSON pointer.
+     * @throw invalid_argument if a pointer is malformed.
+     */
+    template<typename InputIt>
+    projection(InputIt first, InputIt last) : m_nodes(1) {
+        for (; first != last; ++first) {
+            add(compiled_pointer{*first});
+        }
+        merge_wildcards(0);
+    }
+
+    /// @cond
+    const std::vector<detail::projection_node>& nodes() const noexcept {
+        return m_nodes;
+    }
+    /// @endcond
+
+private:
+    void add(const compiled_pointer& pointer) {
+        size_t current{};
+        for (const auto& token : pointer.tokens()) {
+            if (m_nodes[current].is_leaf) {
+                return;
+            }
+            current = token.name() == "*" ? wildcard_child(current)
+                                          : named_child(current, token);
+        }
+        m_nodes[current].is_leaf = true;
+    }
+
+    size_t named_child(size_t parent, const compiled_pointer::token& token) {
+        for (const auto& child : m_nodes[parent].children) {
+            if (child.first.name() == token.name()) {
+                return child.second;
+            }
+        }
+        auto index{m_nodes.size()};
+        m_nodes.emplace_back();
+        m_nodes[parent].children.emplace_back(token, index);
+        return index;
+    }
+
+    size_t wildcard_child(size_t parent) {
+        if (m_nodes[parent].wildcard == detail::projection_node::npos) {
+            m_nodes[parent].wildcard = m_nodes.size();
+            m_nodes.emplace_back();
+        }
+        return m_nodes[parent].wildcard;
+    }
+
+    // Copies the selection of one node into another.
+    void merge(size_t target, size_t source) {
+        if (m_nodes[target].is_leaf) {
+            return;
+        }
+        if (m_nodes[source].is_leaf) {
+            m_nodes[target].is_leaf = true;
+            return;
+        }
+        // Indices stay valid while nodes are appended.
+        for (size_t i{}; i < m_nodes[source].children.size(); ++i) {
+            auto token{m_nodes[source].children[i].first};
+            auto child{m_nodes[source].children[i].second};
+            merge(named_child(target, token), child);
+        }
+        if (m_nodes[source].wildcard != detail::projection_node::npos) {
+            merge(wildcard_child(target), m_nodes[source].wildcard);
+        }
+    }
+
+    // Named children also select whatever a sibling wildcard selects, so
+    // that a single child lookup is enough while parsing.
+    void merge_wildcards(size_t index) {
+        auto wildcard{m_nodes[index].wildcard};
+        for (size_t i{}; i < m_nodes[index].children.size(); ++i) {
+            auto child{m_nodes[index].children[i].second};
+            if (wildcard != detail::projection_node::npos) {
+                merge(child, wildcard);
+            }
+            merge_wildcards(child);
+        }
+        if (wildcard != detail::projection_node::npos) {
+            merge_wildcards(wildcard);
+        }
+    }
+
+    std::vector<detail::projection_node> m_nodes;
+};
+
+namespace detail {
+
+inline optional<value>
+parse_projected_value(std::istream& is, parse_context& ctx,
+                      const std::vector<projection_node>& nodes, size_t index);
+
+inline value parse_projected_object(std::istream& is, parse_context& ctx,
+                                    const std::vector<projection_node>& nodes,
+                                    const projection_node& node) {
+    using namespace parsing;
+    using namespace token_rules;
+    enter_nesting(ctx);
+    skip(is);
+    skip_while(is, ws);
+    object_impl result;
+    if (!peek(is, object_close)) {
+        while (true) {
+            if (!peek(is, dquote)) {
+                throw unexpected_token{};
+            }
+            auto member_name{parse_string(is, ctx)};
+            skip_while(is, ws);
+            expect(is, member_separator);
+            auto child{node.find_member(member_name)};
+            if (child == projection_node::npos) {
+                skip_value(is);
+            } else if (auto v{parse_projected_value(is, ctx, nodes, child)}) {
+                result.members().emplace(std::move(member_name),
+                                         std::move(*v));
+            }
+            skip_while(is, ws);
+            if (peek(is, value_separator)) {
+                skip(is);
+                skip_while(is, ws);
+                continue;
+            }
+            break;
+        }
+    }
+    expect(is, object_close);
+    leave_nesting(ctx);
+    return value{make_unique<object_impl>(std::move(result))};
+}
+
+inline value parse_projected_array(std::istream& is, parse_context& ctx,
+                                   const std::vector<projection_node>& nodes,
+                                   const projection_node& node) {
+    using namespace parsing;
+    using namespace token_rules;
+    enter_nesting(ctx);
+    skip(is);
+    skip_while(is, ws);
+    auto first{ctx.elements.size()};
+    // Skipped elements become null when followed by a selected element in
+    // order to keep indices intact.
+    size_t skipped{};
+    if (!peek(is, array_close)) {
+        for (size_t i{};; ++i) {
+            optional<value> element_value;
+            auto child{node.find_element(i)};
+            if (child == projection_node::npos) {
+                skip_value(is);
+            } else {
+                element_value = parse_projected_value(is, ctx, nodes, child);
+            }
+            if (element_value) {
+                for (; skipped > 0; --skipped) {
+                    ctx.elements.emplace_back();
+                }
+                ctx.elements.push_back(std::move(*element_value));
+            } else {
+                ++skipped;
+            }
+            skip_while(is, ws);
+            if (peek(is, value_separator)) {
+                skip(is);
+                skip_while(is, ws);
+                continue;
+            }
+            break;
+        }
+    }
+    expect(is, array_close);
+    leave_nesting(ctx);
+    return value{make_unique<array_impl>(pop_elements(ctx, first))};
+}
+
+// Parses the parts of a value selected by a projection node and skips the
+// rest. Returns nothing for scalars that are not selected.
+inline optional<value>
+parse_projected_value(std::istream& is, parse_context& ctx,
+                      const std::vector<projection_node>& nodes,
+                      size_t index) {
+    using namespace parsing;
+    using namespace token_rules;
+    const auto& node{nodes[index]};
+    if (node.is_leaf) {
+        return parse_value(is, ctx);
+    }
+    skip_while(is, ws);
+    if (peek(is, object_open)) {
+        return parse_projected_object(is, ctx, nodes, node);
+    }
+    if (peek(is, array_open)) {
+        return parse_projected_array(is, ctx, nodes, node);
+    }
+    skip_value(is);
+    return nullopt;
+}
+
+inline value fully_parse_projected_value(std::istream& is,
+                                         const projection& paths,
+                                         const parse_options& options) {
+    using namespace parsing;
+    using namespace token_rules;
+    scoped_resource scope{options.resource};
+    parse_context ctx{options};
+    auto result{parse_projected_value(is, ctx, paths.nodes(), 0)};
+    skip_while(is, ws);
+    expect_fully_consumed(is);
+    return result ? std::move(*result) : value{};
+}
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,952 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/parallel.hpp"
+#include "detail/stream.hpp"
+#include "detail/utf8.hpp"
+#include "detail/value_impl.hpp"
+#include "equality.hpp"
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+enum class query_selector_kind { name, wildcard, index, slice, filter };
+
+struct query_selector {
+    query_selector_kind kind{};
+    std::string name;
+    // The index, or the start of a slice.
+    std::int64_t start{};
+    std::int64_t end{};
+    std::int64_t step{1};
+    bool has_start{};
+    bool has_end{};
+    size_t filter{};
+};
+
+struct query_segment {
+    bool is_descendant{};
+    std::vector<query_selector> selectors;
+};
+
+struct query_path {
+    // Whether the path starts at the root rather than at the current node
+    // of a filter.
+    bool is_absolute{};
+    // Whether the path selects at most one node.
+    bool is_singular{true};
+    std::vector<query_segment> segments;
+};
+
+enum class filter_op {
+    logical_or,
+    logical_and,
+    logical_not,
+    exists,
+    equal,
+    not_equal,
+    less,
+    less_equal,
+    greater,
+    greater_equal
+};
+
+// Logical operators refer to other filter nodes, existence tests to a path
+// and comparisons to operands.
+struct filter_node {
+    filter_op op;
+    size_t lhs;
+    size_t rhs;
+};
+
+struct filter_operand {
+    static constexpr size_t no_path{std::numeric_limits<size_t>::max()};
+
+    // The literal is used unless there is a path.
+    size_t path{no_path};
+    value literal;
+};
+
+struct query_plan {
+    // The first path is the query itself, followed by the paths within
+    // filters.
+    std::vector<query_path> paths;
+    std::vector<filter_node> filters;
+    std::vector<filter_operand> operands;
+};
+
+class query_parser {
+public:
+    query_parser(const std::string& text, query_plan& plan) noexcept
+        : m_text{text},
+          m_plan{plan} {}
+
+    void parse() {
+        expect('$');
+        parse_path(true);
+        if (m_pos != m_text.size()) {
+            throw invalid_argument{};
+        }
+    }
+
+private:
+    // Integers are limited to the range that doubles represent exactly.
+    static constexpr std::int64_t max_integer{(std::int64_t{1} << 53) - 1};
+
+    char peek() const noexcept {
+        return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+    }
+
+    bool consume(char c) noexcept {
+        if (peek() != c) {
+            return false;
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool consume(const char* s) noexcept {
+        auto length{std::char_traits<char>::length(s)};
+        if (m_text.compare(m_pos, length, s) != 0) {
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            throw invalid_argument{};
+        }
+    }
+
+    void skip_blank() noexcept {
+        while (m_pos < m_text.size() &&
+               (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' ||
+                m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+            ++m_pos;
+        }
+    }
+
+    static bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+    static bool is_name_char(char c, bool is_first) noexcept {
+        auto u{static_cast<unsigned char>(c)};
+        return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || u == '_' ||
+               u >= 0x80U || (!is_first && is_digit(c));
+    }
+
+    // Parses the segments that follow "$" or "@".
+    size_t parse_path(bool is_absolute) {
+        // Reserve the index first so that the query itself comes first.
+        auto index{m_plan.paths.size()};
+        m_plan.paths.emplace_back();
+        query_path path;
+        path.is_absolute = is_absolute;
+        while (true) {
+            auto start{m_pos};
+            skip_blank();
+            query_segment segment;
+            if (consume("..")) {
+                segment.is_descendant = true;
+                if (peek() == '[') {
+                    parse_bracketed(segment);
+                } else {
+                    segment.selectors.push_back(parse_shorthand());
+                }
+            } else if (consume('.')) {
+                segment.selectors.push_back(parse_shorthand());
+            } else if (peek() == '[') {
+                parse_bracketed(segment);
+            } else {
+                m_pos = start;
+                break;
+            }
+            path.is_singular =
+                path.is_singular && !segment.is_descendant &&
+                segment.selectors.size() == 1 &&
+                (segment.selectors[0].kind == query_selector_kind::name ||
+                 segment.selectors[0].kind == query_selector_kind::index);
+            path.segments.push_back(std::move(segment));
+        }
+        m_plan.paths[index] = std::move(path);
+        return index;
+    }
+
+    query_selector parse_shorthand() {
+        query_selector selector;
+        if (consume('*')) {
+            selector.kind = query_selector_kind::wildcard;
+            return selector;
+        }
+        auto begin{m_pos};
+        while (m_pos < m_text.size() &&
+               is_name_char(m_text[m_pos], m_pos == begin)) {
+            ++m_pos;
+        }
+        if (m_pos == begin) {
+            throw invalid_argument{};
+        }
+        selector.kind = query_selector_kind::name;
+        selector.name = m_text.substr(begin, m_pos - begin);
+        return selector;
+    }
+
+    void parse_bracketed(query_segment& segment) {
+        expect('[');
+        do {
+            skip_blank();
+            segment.selectors.push_back(parse_selector());
+            skip_blank();
+        } while (consume(','));
+        expect(']');
+    }
+
+    query_selector parse_selector() {
+        query_selector selector;
+        auto c{peek()};
+        if (c == '\'' || c == '"') {
+            selector.kind = query_selector_kind::name;
+            selector.name = parse_string_literal();
+            return selector;
+        }
+        if (consume('*')) {
+            selector.kind = query_selector_kind::wildcard;
+            return selector;
+        }
+        if (consume('?')) {
+            selector.kind = query_selector_kind::filter;
+            selector.filter = parse_or();
+            return selector;
+        }
+        selector.kind = query_selector_kind::index;
+        if (c == '-' || is_digit(c)) {
+            selector.start = parse_integer();
+            selector.has_start = true;
+        }
+        skip_blank();
+        if (!consume(':')) {
+            if (!selector.has_start) {
+                throw invalid_argument{};
+            }
+            return selector;
+        }
+        selector.kind = query_selector_kind::slice;
+        skip_blank();
+        c = peek();
+        if (c == '-' || is_digit(c)) {
+            selector.end = parse_integer();
+            selector.has_end = true;
+            skip_blank();
+        }
+        if (consume(':')) {
+            skip_blank();
+            c = peek();
+            if (c == '-' || is_digit(c)) {
+                selector.step = parse_integer();
+            }
+        }
+        return selector;
+    }
+
+    std::int64_t parse_integer() {
+        auto is_negative{consume('-')};
+        auto begin{m_pos};
+        std::int64_t result{};
+        for (; is_digit(peek()); ++m_pos) {
+            result = result * 10 + (m_text[m_pos] - '0');
+            if (result > max_integer) {
+                throw invalid_argument{};
+            }
+        }
+        // Integers have no leading zeros, and zero has no sign.
+        if (m_pos == begin ||
+            (m_text[begin] == '0' && (m_pos - begin > 1 || is_negative))) {
+            throw invalid_argument{};
+        }
+        return is_negative ? -result : result;
+    }
+
+    size_t parse_hex4() {
+        size_t result{};
+        for (size_t i{}; i < 4; ++i) {
+            auto c{peek()};
+            size_t digit{};
+            if (is_digit(c)) {
+                digit = static_cast<size_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                digit = static_cast<size_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                digit = static_cast<size_t>(c - 'A' + 10);
+            } else {
+                throw invalid_argument{};
+            }
+            result = result * 16 + digit;
+            ++m_pos;
+        }
+        return result;
+    }
+
+    size_t parse_code_point() {
+        auto code_point{parse_hex4()};
+        if (is_low_surrogate(code_point)) {
+            throw invalid_argument{};
+        }
+        if (is_high_surrogate(code_point)) {
+            if (!consume("\\u")) {
+                throw invalid_argument{};
+            }
+            auto low{parse_hex4()};
+            if (!is_low_surrogate(low)) {
+                throw invalid_argument{};
+            }
+            code_point = combine_surrogates(code_point, low);
+        }
+        return code_point;
+    }
+
+    // Parses a string in single or double quotes.
+    std::string parse_string_literal() {
+        auto quote{m_text[m_pos++]};
+        std::string result;
+        while (true) {
+            if (m_pos >= m_text.size()) {
+                throw invalid_argument{};
+            }
+            auto c{m_text[m_pos++]};
+            if (c == quote) {
+                return result;
+            }
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            c = peek();
+            ++m_pos;
+            switch (c) {
+            case 'b':
+                result += '\b';
+                break;
+            case 'f':
+                result += '\f';
+                break;
+            case 'n':
+                result += '\n';
+                break;
+            case 'r':
+                result += '\r';
+                break;
+            case 't':
+                result += '\t';
+                break;
+            case 'u':
+                append_utf8(result, parse_code_point());
+                break;
+            case '\\':
+            case '/':
+            case '\'':
+            case '"':
+                result += c;
+                break;
+            default:
+                throw invalid_argument{};
+            }
+        }
+    }
+
+    size_t add_filter(filter_op op, size_t lhs, size_t rhs) {
+        m_plan.filters.push_back(filter_node{op, lhs, rhs});
+        return m_plan.filters.size() - 1;
+    }
+
+    size_t parse_or() {
+        auto lhs{parse_and()};
+        while (true) {
+            skip_blank();
+            if (!consume("||")) {
+                return lhs;
+            }
+            lhs = add_filter(filter_op::logical_or, lhs, parse_and());
+        }
+    }
+
+    size_t parse_and() {
+        auto lhs{parse_basic()};
+        while (true) {
+            skip_blank();
+            if (!consume("&&")) {
+                return lhs;
+            }
+            lhs = add_filter(filter_op::logical_and, lhs, parse_basic());
+        }
+    }
+
+    size_t parse_filter_path() {
+        auto c{peek()};
+        if (!consume('@') && !consume('$')) {
+            throw invalid_argument{};
+        }
+        return parse_path(c == '$');
+    }
+
+    size_t parse_basic() {
+        skip_blank();
+        if (consume('!')) {
+            skip_blank();
+            auto operand{peek() == '('
+                             ? parse_basic()
+                             : add_filter(filter_op::exists,
+                                          parse_filter_path(), 0)};
+            return add_filter(filter_op::logical_not, operand, 0);
+        }
+        if (consume('(')) {
+            auto result{parse_or()};
+            skip_blank();
+            expect(')');
+            return result;
+        }
+        size_t lhs{};
+        auto c{peek()};
+        if (c == '@' || c == '$') {
+            auto path{parse_filter_path()};
+            skip_blank();
+            auto op{parse_comparison_op()};
+            if (op == filter_op::exists) {
+                return add_filter(filter_op::exists, path, 0);
+            }
+            lhs = add_path_operand(path);
+            skip_blank();
+            return add_filter(op, lhs, parse_comparable());
+        }
+        lhs = parse_comparable();
+        skip_blank();
+        auto op{parse_comparison_op()};
+        if (op == filter_op::exists) {
+            throw invalid_argument{};
+        }
+        skip_blank();
+        return add_filter(op, lhs, parse_comparable());
+    }
+
+    // Returns exists if there is no comparison operator.
+    filter_op parse_comparison_op() {
+        if (consume("==")) {
+            return filter_op::equal;
+        }
+        if (consume("!=")) {
+            return filter_op::not_equal;
+        }
+        if (consume("<=")) {
+            return filter_op::less_equal;
+        }
+        if (consume(">=")) {
+            return filter_op::greater_equal;
+        }
+        if (consume('<')) {
+            return filter_op::less;
+        }
+        if (consume('>')) {
+            return filter_op::greater;
+        }
+        return filter_op::exists;
+    }
+
+    size_t add_path_operand(size_t path) {
+        // Only paths that select at most one node can be compared.
+        if (!m_plan.paths[path].is_singular) {
+            throw invalid_argument{};
+        }
+        filter_operand operand;
+        operand.path = path;
+        m_plan.operands.push_back(std::move(operand));
+        return m_plan.operands.size() - 1;
+    }
+
+    size_t parse_comparable() {
+        auto c{peek()};
+        if (c == '@' || c == '$') {
+            return add_path_operand(parse_filter_path());
+        }
+        filter_operand operand;
+        if (c == '\'' || c == '"') {
+            operand.literal = parse_string_literal();
+        } else {
+            auto begin{m_pos};
+            while (m_pos < m_text.size() &&
+                   (is_name_char(m_text[m_pos], false) ||
+                    m_text[m_pos] == '-' || m_text[m_pos] == '+' ||
+                    m_text[m_pos] == '.')) {
+                ++m_pos;
+            }
+            // Numbers, true, false and null are parsed as JSON.
+            try {
+                auto is{make_istream(m_text.data() + begin, m_pos - begin)};
+                operand.literal = fully_parse_value(is);
+            } catch (const parse_error&) {
+                throw invalid_argument{};
+            }
+        }
+        m_plan.operands.push_back(std::move(operand));
+        return m_plan.operands.size() - 1;
+    }
+
+    const std::string& m_text;
+    query_plan& m_plan;
+    size_t m_pos{};
+};
+
+// The members of an object or the elements of an array by index.
+class query_children {
+public:
+    explicit query_children(const value& v) {
+        if (v.is_array()) {
+            m_elements = &v.as_array();
+        } else if (v.is_object()) {
+            m_object = &dynamic_cast<const object_impl&>(v.impl());
+        }
+    }
+
+    bool is_array() const noexcept { return m_elements != nullptr; }
+
+    size_t size() const noexcept {
+        if (m_elements) {
+            return m_elements->size();
+        }
+        return m_object ? m_object->size() : 0;
+    }
+
+    const value& operator[](size_t index) const {
+        if (m_elements) {
+            return (*m_elements)[index];
+        }
+        if (m_object->shape()) {
+            return m_object->values()[index];
+        }
+        return m_object->members().entry_at(index).second;
+    }
+
+private:
+    const value::array_type* m_elements{};
+    const object_impl* m_object{};
+};
+
+// Normalizes a negative index relative to the end of an array.
+inline bool normalize_query_index(std::int64_t index, size_t size,
+                                  size_t& result) noexcept {
+    auto length{static_cast<std::int64_t>(size)};
+    auto normalized{index < 0 ? length + index : index};
+    if (normalized < 0 || normalized >= length) {
+        return false;
+    }
+    result = static_cast<size_t>(normalized);
+    return true;
+}
+
+// The indices selected by a slice are first + k * step for k in
+// [0, count).
+struct query_slice {
+    std::int64_t first{};
+    std::int64_t step{};
+    size_t count{};
+};
+
+inline query_slice get_query_slice(const query_selector& selector,
+                                   size_t size) noexcept {
+    auto length{static_cast<std::int64_t>(size)};
+    auto normalize = [&](std::int64_t i) { return i < 0 ? length + i : i; };
+    auto clamp = [](std::int64_t i, std::int64_t low, std::int64_t high) {
+        return std::min(std::max(i, low), high);
+    };
+    query_slice result;
+    result.step = selector.step;
+    if (selector.step > 0) {
+        auto lower{clamp(selector.has_start ? normalize(selector.start) : 0,
+                         0, length)};
+        auto upper{clamp(selector.has_end ? normalize(selector.end) : length,
+                         0, length)};
+        result.first = lower;
+        if (upper > lower) {
+            result.count =
+                static_cast<size_t>((upper - lower - 1) / selector.step + 1);
+        }
+    } else if (selector.step < 0) {
+        auto upper{clamp(selector.has_start ? normalize(selector.start)
+                                            : length - 1,
+                         -1, length - 1)};
+        auto lower{clamp(selector.has_end ? normalize(selector.end)
+                                          : -length - 1,
+                         -1, length - 1)};
+        result.first = upper;
+        if (upper > lower) {
+            result.count =
+                static_cast<size_t>((upper - lower - 1) / -selector.step + 1);
+        }
+    }
+    return result;
+}
+
+inline void add_query_descendants(const value& v,
+                                  std::vector<const value*>& result) {
+    result.push_back(&v);
+    query_children children{v};
+    for (size_t i{}; i < children.size(); ++i) {
+        add_query_descendants(children[i], result);
+    }
+}
+
+// Follows a path that selects at most one node without building a list.
+inline const value* find_singular(const query_path& path, const value& start) {
+    const auto* current{&start};
+    for (const auto& segment : path.segments) {
+        const auto& selector{segment.selectors.front()};
+        if (selector.kind == query_selector_kind::name) {
+            if (!current->is_object()) {
+                return nullptr;
+            }
+            current = current->find_member(selector.name);
+            if (!current) {
+                return nullptr;
+            }
+            continue;
+        }
+        if (!current->is_array()) {
+            return nullptr;
+        }
+        const auto& elements{current->as_array()};
+        size_t index{};
+        if (!normalize_query_index(selector.start, elements.size(), index)) {
+            return nullptr;
+        }
+        current = &elements[index];
+    }
+    return current;
+}
+
+inline bool query_less(const value& lhs, const value& rhs) {
+    if (lhs.is_number() && rhs.is_number()) {
+        const auto& lhs_number{dynamic_cast<const number_impl&>(lhs.impl())};
+        const auto& rhs_number{dynamic_cast<const number_impl&>(rhs.impl())};
+        std::int64_t lhs_integer{};
+        std::int64_t rhs_integer{};
+        if (lhs_number.to_int64(lhs_integer) &&
+            rhs_number.to_int64(rhs_integer)) {
+            return lhs_integer < rhs_integer;
+        }
+        return lhs_number.data() < rhs_number.data();
+    }
+    // Byte order of UTF-8 is code point order.
+    if (lhs.is_string() && rhs.is_string()) {
+        return lhs.as_string() < rhs.as_string();
+    }
+    return false;
+}
+
+// Compares nodes, where null stands for an empty node list.
+inline bool query_compare(filter_op op, const value* lhs, const value* rhs) {
+    auto equal = [&] { return lhs && rhs ? *lhs == *rhs : lhs == rhs; };
+    auto less = [](const value* a, const value* b) {
+        return a && b && query_less(*a, *b);
+    };
+    switch (op) {
+    case filter_op::equal:
+        return equal();
+    case filter_op::not_equal:
+        return !equal();
+    case filter_op::less:
+        return less(lhs, rhs);
+    case filter_op::less_equal:
+        return less(lhs, rhs) || equal();
+    case filter_op::greater:
+        return less(rhs, lhs);
+    case filter_op::greater_equal:
+        return less(rhs, lhs) || equal();
+    default:
+        return false;
+    }
+}
+
+// Segments with at least this many candidate nodes are evaluated in
+// parallel, in chunks of half as many.
+constexpr size_t parallel_query_threshold{parallel_work_per_thread};
+
+class query_evaluator {
+public:
+    query_evaluator(const query_plan& plan, const value& root,
+                    size_t max_threads)
+        : m_plan{plan},
+          m_max_threads{max_threads},
+          m_absolute(plan.paths.size()) {
+        // Absolute paths within filters select the same nodes for every
+        // candidate, so they are evaluated once and then only read by all
+        // threads. Nested paths come later.
+        for (auto i{plan.paths.size()}; i-- > 1;) {
+            if (plan.paths[i].is_absolute) {
+                m_absolute[i] = select(i, root, true);
+            }
+        }
+    }
+
+    std::vector<const value*> select(size_t path, const value& start,
+                                     bool allow_parallel) const {
+        std::vector<const value*> nodes{&start};
+        for (const auto& segment : m_plan.paths[path].segments) {
+            if (segment.is_descendant) {
+                std::vector<const value*> descendants;
+                for (const auto* node : nodes) {
+                    add_query_descendants(*node, descendants);
+                }
+                nodes = std::move(descendants);
+                // Threads must not share subtrees, and descendants do.
+                allow_parallel = false;
+            }
+            nodes = apply(segment, nodes, allow_parallel);
+        }
+        return nodes;
+    }
+
+private:
+    struct work_item {
+        const value* node;
+        const query_selector* selector;
+        size_t begin;
+        size_t end;
+    };
+
+    // Gets the number of children that a selector may select.
+    static size_t count_candidates(const value& node,
+                                   const query_selector& selector) {
+        switch (selector.kind) {
+        case query_selector_kind::name:
+            return node.is_object() ? 1 : 0;
+        case query_selector_kind::index:
+            return node.is_array() ? 1 : 0;
+        case query_selector_kind::slice: {
+            query_children children{node};
+            return children.is_array()
+                       ? get_query_slice(selector, children.size()).count
+                       : 0;
+        }
+        default:
+            return query_children{node}.size();
+        }
+    }
+
+    static bool has_duplicates(std::vector<const value*> nodes) {
+        std::sort(nodes.begin(), nodes.end());
+        return std::adjacent_find(nodes.begin(), nodes.end()) != nodes.end();
+    }
+
+    std::vector<const value*> apply(const query_segment& segment,
+                                    const std::vector<const value*>& nodes,
+                                    bool allow_parallel) const {
+        std::vector<work_item> work;
+        size_t total{};
+        constexpr size_t chunk_size{parallel_query_threshold / 2};
+        for (const auto* node : nodes) {
+            for (const auto& selector : segment.selectors) {
+                auto count{count_candidates(*node, selector)};
+                total += count;
+                for (size_t begin{}; begin < count; begin += chunk_size) {
+                    work.push_back(work_item{node, &selector, begin,
+                                             std::min(begin + chunk_size,
+                                                      count)});
+                }
+            }
+        }
+        std::vector<const value*> result;
+        if (!allow_parallel || total < parallel_query_threshold ||
+            has_duplicates(nodes)) {
+            result.reserve(total);
+            for (const auto& item : work) {
+                select(item, result);
+            }
+            return result;
+        }
+        std::vector<std::vector<const value*>> results(work.size());
+        parallel_for(work.size(), chunk_size, m_max_threads, [&](size_t index) {
+            select(work[index], results[index]);
+        });
+        result.reserve(total);
+        for (const auto& part : results) {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        return result;
+    }
+
+    void select(const work_item& item,
+                std::vector<const value*>& result) const {
+        const auto& selector{*item.selector};
+        switch (selector.kind) {
+        case query_selector_kind::name:
+            if (const auto* member{item.node->find_member(selector.name)}) {
+                result.push_back(member);
+            }
+            break;
+        case query_selector_kind::index: {
+            const auto& elements{item.node->as_array()};
+            size_t index{};
+            if (normalize_query_index(selector.start, elements.size(),
+                                      index)) {
+                result.push_back(&elements[index]);
+            }
+            break;
+        }
+        case query_selector_kind::slice: {
+            query_children children{*item.node};
+            auto slice{get_query_slice(selector, children.size())};
+            for (auto k{item.begin}; k < item.end; ++k) {
+                auto index{slice.first +
+                           static_cast<std::int64_t>(k) * slice.step};
+                result.push_back(&children[static_cast<size_t>(index)]);
+            }
+            break;
+        }
+        case query_selector_kind::wildcard: {
+            query_children children{*item.node};
+            for (auto i{item.begin}; i < item.end; ++i) {
+                result.push_back(&children[i]);
+            }
+            break;
+        }
+        case query_selector_kind::filter: {
+            query_children children{*item.node};
+            for (auto i{item.begin}; i < item.end; ++i) {
+                if (test(selector.filter, children[i])) {
+                    result.push_back(&children[i]);
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    bool test(size_t filter, const value& current) const {
+        const auto& node{m_plan.filters[filter]};
+        switch (node.op) {
+        case filter_op::logical_or:
+            return test(node.lhs, current) || test(node.rhs, current);
+        case filter_op::logical_and:
+            return test(node.lhs, current) && test(node.rhs, current);
+        case filter_op::logical_not:
+            return !test(node.lhs, current);
+        case filter_op::exists: {
+            const auto& path{m_plan.paths[node.lhs]};
+            if (path.is_absolute) {
+                return !m_absolute[node.lhs].empty();
+            }
+            if (path.is_singular) {
+                return find_singular(path, current) != nullptr;
+            }
+            return !select(node.lhs, current, false).empty();
+        }
+        default:
+            return query_compare(node.op, get_operand(node.lhs, current),
+                                 get_operand(node.rhs, current));
+        }
+    }
+
+    const value* get_operand(size_t index, const value& current) const {
+        const auto& operand{m_plan.operands[index]};
+        if (operand.path == filter_operand::no_path) {
+            return &operand.literal;
+        }
+        const auto& path{m_plan.paths[operand.path]};
+        if (path.is_absolute) {
+            const auto& nodes{m_absolute[operand.path]};
+            return nodes.size() == 1 ? nodes.front() : nullptr;
+        }
+        return find_singular(path, current);
+    }
+
+    const query_plan& m_plan;
+    size_t m_max_threads;
+    std::vector<std::vector<const value*>> m_absolute;
+};
+
+} // namespace detail
+
+/**
+ * JSONPath query (RFC 9535) that has been parsed once so that it can be
+ * evaluated against many documents.
+ *
+ * Filters support comparisons, the logical operators &&, || and !,
+ * parentheses and existence tests, but no function extensions.
+ */
+class compiled_query {
+public:
+    /**
+     * Compiles a JSONPath query.
+     *
+     * @param expression The query, e.g. "$.orders[?@.total > 100].id".
+     * @throw invalid_argument if the query is malformed.
+     */
+    explicit compiled_query(const std::string& expression) {
+        detail::query_parser{expression, m_plan}.parse();
+    }
+
+    /**
+     * Selects values within a JSON document.
+     *
+     * Segments with at least 8192 candidate nodes are split between
+     * threads, each of which is given at least 8192 candidates since the
+     * threads are started for each such segment of each call and joined
+     * before it continues. Smaller segments are evaluated on the calling
+     * thread. The document is only
+     * read, so other threads may read it at the same time but must not
+     * modify it.
+     *
+     * @param root The JSON document.
+     * @param max_threads The maximum number of threads, or 0 for one per
+     * hardware thread.
+     * @return The selected values, which are owned by the document, in the
+     * order in which they were selected.
+     */
+    std::vector<const value*> evaluate(const value& root,
+                                       size_t max_threads = 0) const {
+        return detail::query_evaluator{m_plan, root, max_threads}.select(
+            0, root, true);
+    }
+
+private:
+    detail::query_plan m_plan;
+};
+
+/**
+ * Compiles a JSONPath query (RFC 9535).
+ *
+ * @param expression The query, e.g. "$.orders[?@.total > 100].id".
+ * @return The compiled query.
+ * @throw invalid_argument if the query is malformed.
+ */
+inline compiled_query compile_query(const std::string& expression) {
+    return compiled_query{expression};
+}
+
+LANGNES_JSON_CXX_NS_END
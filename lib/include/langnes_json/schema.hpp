@@ -0,0 +1,1248 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/memory.hpp"
+#include "detail/parsing.hpp"
+#include "detail/regex.hpp"
+#include "detail/token_rules.hpp"
+#include "detail/value_impl.hpp"
+#include "equality.hpp"
+#include "errors.hpp"
+#include "options.hpp"
+#include "pointer.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+constexpr size_t no_schema{std::numeric_limits<size_t>::max()};
+
+// Bits of the types accepted by a schema. The other bits are those of
+// value::type.
+constexpr unsigned integer_type_bit{1U << 6U};
+
+inline unsigned type_bit(value::type type) noexcept {
+    return 1U << static_cast<unsigned>(type);
+}
+
+// Keywords are looked up once when compiling so that validating only
+// compares numbers and follows indices. Optional bounds are infinite or
+// maximal when absent, and subschemas are no_schema.
+struct schema_node {
+    // Whether this is the false schema.
+    bool reject{};
+    // Zero accepts any type.
+    unsigned types{};
+
+    double minimum{-std::numeric_limits<double>::infinity()};
+    double maximum{std::numeric_limits<double>::infinity()};
+    double exclusive_minimum{-std::numeric_limits<double>::infinity()};
+    double exclusive_maximum{std::numeric_limits<double>::infinity()};
+    // Zero if absent.
+    double multiple_of{};
+
+    size_t min_length{};
+    size_t max_length{no_schema};
+    size_t pattern{no_schema};
+
+    size_t min_items{};
+    size_t max_items{no_schema};
+    bool unique_items{};
+    std::vector<size_t> prefix_items;
+    size_t items{no_schema};
+    size_t contains{no_schema};
+    size_t min_contains{1};
+    size_t max_contains{no_schema};
+
+    dict<std::string, size_t> properties;
+    std::vector<std::string> required;
+    // Pairs of pattern and subschema.
+    std::vector<std::pair<size_t, size_t>> pattern_properties;
+    size_t additional_properties{no_schema};
+    size_t property_names{no_schema};
+    size_t min_properties{};
+    size_t max_properties{no_schema};
+    // Pairs of member name and the names that it requires.
+    std::vector<std::pair<std::string, std::vector<std::string>>>
+        dependent_required;
+    // Pairs of member name and the subschema that applies to the object if
+    // the member is present.
+    std::vector<std::pair<std::string, size_t>> dependent_schemas;
+    // Whether the dependencies come from the dependencies keyword of drafts
+    // 4 to 7.
+    bool legacy_dependencies{};
+
+    size_t ref{no_schema};
+    std::vector<size_t> all_of;
+    std::vector<size_t> any_of;
+    std::vector<size_t> one_of;
+    size_t not_schema{no_schema};
+    size_t if_schema{no_schema};
+    size_t then_schema{no_schema};
+    size_t else_schema{no_schema};
+
+    // Values of enum or const, and their hashes.
+    bool has_enum{};
+    bool is_const{};
+    value::array_type enum_values;
+    std::vector<std::uint64_t> enum_hashes;
+
+    // Whether the node only refers to another node.
+    bool ref_only{};
+    // Whether objects and arrays can be validated member by member while
+    // parsing, rather than as a whole once parsed.
+    bool is_streamable{true};
+};
+
+// Where and why validation failed. Reference tokens are added in reverse
+// order while returning from nested values.
+struct schema_failure {
+    std::string pointer() const {
+        std::string result;
+        for (auto it{tokens.rbegin()}; it != tokens.rend(); ++it) {
+            result += '/';
+            result += *it;
+        }
+        return result;
+    }
+
+    std::vector<std::string> tokens;
+    std::string keyword;
+};
+
+inline bool is_integer(const number_impl& number) noexcept {
+    std::int64_t signed_integer{};
+    std::uint64_t unsigned_integer{};
+    if (number.to_int64(signed_integer) ||
+        number.to_uint64(unsigned_integer)) {
+        return true;
+    }
+    auto d{number.data()};
+    return std::isfinite(d) && std::trunc(d) == d;
+}
+
+// Decodes the percent-encoded octets of a URI fragment.
+inline std::string percent_decode(string_ref s) {
+    static const hex_digit_table table;
+    std::string result;
+    result.reserve(s.size());
+    for (size_t i{}; i < s.size(); ++i) {
+        if (s[i] != '%') {
+            result.push_back(s[i]);
+            continue;
+        }
+        if (s.size() - i < 3) {
+            throw invalid_argument{};
+        }
+        auto high{table.values[static_cast<unsigned char>(s[i + 1])]};
+        auto low{table.values[static_cast<unsigned char>(s[i + 2])]};
+        if (high > 0xfU || low > 0xfU) {
+            throw invalid_argument{};
+        }
+        result.push_back(static_cast<char>(high << 4U | low));
+        i += 2;
+    }
+    return result;
+}
+
+// Counts the code points of UTF-8 text.
+inline size_t count_code_points(string_ref s) noexcept {
+    size_t count{};
+    for (auto c : s) {
+        if ((static_cast<unsigned char>(c) & 0xc0U) != 0x80U) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+inline bool is_multiple_of(const number_impl& number, double divisor) {
+    std::int64_t integer{};
+    if (number.to_int64(integer) && std::trunc(divisor) == divisor &&
+        std::abs(divisor) < 9223372036854775808.0) {
+        return integer % static_cast<std::int64_t>(divisor) == 0;
+    }
+    // Allow for the rounding of decimal fractions such as 0.1.
+    auto quotient{number.data() / divisor};
+    if (!std::isfinite(quotient)) {
+        return false;
+    }
+    return std::abs(quotient - std::round(quotient)) <=
+           std::abs(quotient) * 4 * std::numeric_limits<double>::epsilon();
+}
+
+// Checks that the members required by the members of an object are
+// present.
+inline bool has_dependent_members(const schema_node& node,
+                                  const object_impl& object) {
+    for (const auto& dependency : node.dependent_required) {
+        if (!object.find(dependency.first)) {
+            continue;
+        }
+        for (const auto& name : dependency.second) {
+            if (!object.find(name)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+class schema_program {
+public:
+    size_t add_node() {
+        m_nodes.emplace_back();
+        return m_nodes.size() - 1;
+    }
+
+    size_t add_pattern(string_ref pattern) {
+        m_patterns.emplace_back(pattern.str());
+        return m_patterns.size() - 1;
+    }
+
+    std::vector<schema_node>& nodes() noexcept { return m_nodes; }
+    const std::vector<schema_node>& nodes() const noexcept { return m_nodes; }
+
+    // Skips nodes that only refer to other nodes.
+    size_t resolve(size_t index) const noexcept {
+        while (m_nodes[index].ref_only) {
+            index = m_nodes[index].ref;
+        }
+        return index;
+    }
+
+    bool matches_pattern(size_t pattern, string_ref s) const {
+        return m_patterns[pattern].search(s);
+    }
+
+    // Checks a value against a node. Stops at the first failure, which is
+    // described only if requested.
+    bool check(size_t index, const value& v, schema_failure* failure) const {
+        const auto& node{m_nodes[index]};
+        if (node.reject) {
+            return fail(failure, "false");
+        }
+        if (!matches_type(node, v)) {
+            return fail(failure, "type");
+        }
+        if (node.has_enum && !matches_enum(node, v)) {
+            return fail(failure, node.is_const ? "const" : "enum");
+        }
+        switch (v.get_type()) {
+        case value::type::object:
+            if (!check_object(node, v, failure)) {
+                return false;
+            }
+            break;
+        case value::type::array:
+            if (!check_array(node, v, failure)) {
+                return false;
+            }
+            break;
+        case value::type::string:
+            if (!check_string(node, v, failure)) {
+                return false;
+            }
+            break;
+        case value::type::number:
+            if (!check_number(node, v, failure)) {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+        return check_applicators(node, v, failure);
+    }
+
+    // Checks a value against a node.
+    //
+    // Throws validation_error on failure.
+    void validate(size_t index, const value& v) const {
+        schema_failure failure;
+        if (!check(index, v, &failure)) {
+            throw validation_error{failure.pointer(), failure.keyword};
+        }
+    }
+
+private:
+    static bool matches_type(const schema_node& node, const value& v) {
+        if (node.types == 0 || (node.types & type_bit(v.get_type())) != 0) {
+            return true;
+        }
+        return (node.types & integer_type_bit) != 0 && v.is_number() &&
+               is_integer(dynamic_cast<const number_impl&>(v.impl()));
+    }
+
+    static bool matches_enum(const schema_node& node, const value& v) {
+        auto h{v.hash()};
+        for (size_t i{}; i < node.enum_values.size(); ++i) {
+            if (node.enum_hashes[i] == h && node.enum_values[i] == v) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Checks a nested value and records its reference token on failure.
+    bool check_child(size_t index, const value& v, schema_failure* failure,
+                     const std::string& token) const {
+        if (check(index, v, failure)) {
+            return true;
+        }
+        if (failure) {
+            failure->tokens.push_back(token);
+        }
+        return false;
+    }
+
+    static bool fail(schema_failure* failure, const char* keyword) {
+        if (failure) {
+            failure->keyword = keyword;
+        }
+        return false;
+    }
+
+    static bool check_number(const schema_node& node, const value& v,
+                             schema_failure* failure) {
+        const auto& number{dynamic_cast<const number_impl&>(v.impl())};
+        auto d{number.data()};
+        if (d < node.minimum) {
+            return fail(failure, "minimum");
+        }
+        if (d > node.maximum) {
+            return fail(failure, "maximum");
+        }
+        if (d <= node.exclusive_minimum) {
+            return fail(failure, "exclusiveMinimum");
+        }
+        if (d >= node.exclusive_maximum) {
+            return fail(failure, "exclusiveMaximum");
+        }
+        if (node.multiple_of > 0 && !is_multiple_of(number, node.multiple_of)) {
+            return fail(failure, "multipleOf");
+        }
+        return true;
+    }
+
+    bool check_string(const schema_node& node, const value& v,
+                      schema_failure* failure) const {
+        const auto& s{v.as_string()};
+        // Code points are never more than bytes.
+        if (node.min_length > 0 || s.size() > node.max_length) {
+            auto length{count_code_points(s)};
+            if (length < node.min_length) {
+                return fail(failure, "minLength");
+            }
+            if (length > node.max_length) {
+                return fail(failure, "maxLength");
+            }
+        }
+        if (node.pattern != no_schema && !matches_pattern(node.pattern, s)) {
+            return fail(failure, "pattern");
+        }
+        return true;
+    }
+
+    bool check_array(const schema_node& node, const value& v,
+                     schema_failure* failure) const {
+        const auto& elements{v.as_array()};
+        if (elements.size() < node.min_items) {
+            return fail(failure, "minItems");
+        }
+        if (elements.size() > node.max_items) {
+            return fail(failure, "maxItems");
+        }
+        for (size_t i{}; i < elements.size(); ++i) {
+            auto child{i < node.prefix_items.size() ? node.prefix_items[i]
+                                                    : node.items};
+            if (child == no_schema) {
+                continue;
+            }
+            if (!check_child(child, elements[i], failure, std::to_string(i))) {
+                return false;
+            }
+        }
+        if (node.contains != no_schema) {
+            size_t count{};
+            for (const auto& element : elements) {
+                if (check(node.contains, element, nullptr)) {
+                    ++count;
+                }
+            }
+            if (count < node.min_contains) {
+                return fail(failure, node.min_contains == 1 ? "contains"
+                                                            : "minContains");
+            }
+            if (count > node.max_contains) {
+                return fail(failure, "maxContains");
+            }
+        }
+        if (node.unique_items && !are_unique(elements)) {
+            return fail(failure, "uniqueItems");
+        }
+        return true;
+    }
+
+    // Sorts the hashes of the elements so that only neighbors need to be
+    // compared.
+    static bool are_unique(const value::array_type& elements) {
+        std::vector<std::pair<std::uint64_t, size_t>> hashes;
+        hashes.reserve(elements.size());
+        for (size_t i{}; i < elements.size(); ++i) {
+            hashes.emplace_back(elements[i].hash(), i);
+        }
+        std::sort(hashes.begin(), hashes.end());
+        for (size_t i{}; i < hashes.size(); ++i) {
+            for (auto j{i + 1};
+                 j < hashes.size() && hashes[j].first == hashes[i].first;
+                 ++j) {
+                if (elements[hashes[i].second] == elements[hashes[j].second]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool check_object(const schema_node& node, const value& v,
+                      schema_failure* failure) const {
+        const auto& object{dynamic_cast<const object_impl&>(v.impl())};
+        if (object.size() < node.min_properties) {
+            return fail(failure, "minProperties");
+        }
+        if (object.size() > node.max_properties) {
+            return fail(failure, "maxProperties");
+        }
+        for (const auto& name : node.required) {
+            if (!object.find(name)) {
+                return fail(failure, "required");
+            }
+        }
+        if (!has_dependent_members(node, object)) {
+            return fail(failure, node.legacy_dependencies
+                                     ? "dependencies"
+                                     : "dependentRequired");
+        }
+        for (const auto& dependency : node.dependent_schemas) {
+            if (object.find(dependency.first) &&
+                !check(dependency.second, v, failure)) {
+                return false;
+            }
+        }
+        return object.all_members([&](string_ref name, const value& member) {
+            return check_member(node, name, member, failure);
+        });
+    }
+
+    bool check_member(const schema_node& node, string_ref name,
+                      const value& member, schema_failure* failure) const {
+        auto token{[&] { return escape_pointer_token(name); }};
+        auto matched{false};
+        auto found{node.properties.find(name)};
+        if (found != node.properties.end()) {
+            matched = true;
+            if (!check_child(found->second, member, failure, token())) {
+                return false;
+            }
+        }
+        for (const auto& pattern : node.pattern_properties) {
+            if (!matches_pattern(pattern.first, name)) {
+                continue;
+            }
+            matched = true;
+            if (!check_child(pattern.second, member, failure, token())) {
+                return false;
+            }
+        }
+        if (!matched && node.additional_properties != no_schema &&
+            !check_child(node.additional_properties, member, failure,
+                         token())) {
+            return false;
+        }
+        if (node.property_names != no_schema &&
+            !check(node.property_names, value{name.str()}, nullptr)) {
+            if (failure) {
+                failure->tokens.push_back(token());
+            }
+            return fail(failure, "propertyNames");
+        }
+        return true;
+    }
+
+    bool check_applicators(const schema_node& node, const value& v,
+                           schema_failure* failure) const {
+        if (node.ref != no_schema && !check(node.ref, v, failure)) {
+            return false;
+        }
+        for (auto index : node.all_of) {
+            if (!check(index, v, failure)) {
+                return false;
+            }
+        }
+        if (!node.any_of.empty() &&
+            std::none_of(node.any_of.begin(), node.any_of.end(),
+                         [&](size_t index) {
+                             return check(index, v, nullptr);
+                         })) {
+            return fail(failure, "anyOf");
+        }
+        if (!node.one_of.empty()) {
+            size_t count{};
+            for (auto index : node.one_of) {
+                if (check(index, v, nullptr) && ++count > 1) {
+                    break;
+                }
+            }
+            if (count != 1) {
+                return fail(failure, "oneOf");
+            }
+        }
+        if (node.not_schema != no_schema &&
+            check(node.not_schema, v, nullptr)) {
+            return fail(failure, "not");
+        }
+        if (node.if_schema != no_schema) {
+            auto next{check(node.if_schema, v, nullptr) ? node.then_schema
+                                                        : node.else_schema};
+            if (next != no_schema && !check(next, v, failure)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<schema_node> m_nodes;
+    std::vector<regex> m_patterns;
+};
+
+// Compiles a schema document into a program. Subschemas are compiled once
+// per JSON pointer so that references may be recursive.
+class schema_compiler {
+public:
+    schema_compiler(const value& root, schema_program& program)
+        : m_root{root},
+          m_program{program} {}
+
+    void compile() {
+        compile(m_root, std::string{});
+        auto& nodes{m_program.nodes()};
+        std::vector<unsigned char> states(nodes.size());
+        for (size_t i{}; i < nodes.size(); ++i) {
+            ensure_descends(i, states);
+        }
+    }
+
+private:
+    size_t compile(const value& schema, const std::string& pointer) {
+        auto found{m_compiled.find(pointer)};
+        if (found != m_compiled.end()) {
+            return found->second;
+        }
+        // Reserve the index first for references back to this node.
+        auto index{m_program.add_node()};
+        m_compiled.emplace(pointer, index);
+        schema_node node;
+        if (schema.is_boolean()) {
+            node.reject = !schema.as_boolean();
+        } else if (schema.is_object()) {
+            compile_keywords(schema, pointer, node);
+        } else {
+            throw invalid_argument{};
+        }
+        m_program.nodes()[index] = std::move(node);
+        return index;
+    }
+
+    size_t compile_member(const value& member, const std::string& pointer,
+                          string_ref name) {
+        return compile(member, pointer + '/' + escape_pointer_token(name));
+    }
+
+    std::vector<size_t> compile_list(const value& list,
+                                     const std::string& pointer) {
+        if (!list.is_array()) {
+            throw invalid_argument{};
+        }
+        std::vector<size_t> result;
+        const auto& elements{list.as_array()};
+        for (size_t i{}; i < elements.size(); ++i) {
+            result.push_back(
+                compile(elements[i], pointer + '/' + std::to_string(i)));
+        }
+        return result;
+    }
+
+    size_t compile_ref(const value& ref) {
+        if (!ref.is_string()) {
+            throw invalid_argument{};
+        }
+        // Only references within the document are supported. The fragment
+        // is a percent-encoded JSON pointer.
+        const auto& uri{ref.as_string()};
+        if (uri.empty() || uri[0] != '#') {
+            throw invalid_argument{};
+        }
+        auto pointer{percent_decode({uri.data() + 1, uri.size() - 1})};
+        const auto* target{m_root.find_pointer(pointer)};
+        if (!target) {
+            throw invalid_argument{};
+        }
+        return compile(*target, pointer);
+    }
+
+    static size_t to_count(const value& v) {
+        std::uint64_t result{};
+        if (!v.is_number() ||
+            !dynamic_cast<const number_impl&>(v.impl()).to_uint64(result)) {
+            throw invalid_argument{};
+        }
+        return static_cast<size_t>(
+            std::min<std::uint64_t>(result, no_schema));
+    }
+
+    static double to_number(const value& v) {
+        if (!v.is_number()) {
+            throw invalid_argument{};
+        }
+        return v.as_number();
+    }
+
+    static unsigned to_type_bits(const value& v) {
+        if (v.is_array()) {
+            unsigned result{};
+            for (const auto& element : v.as_array()) {
+                result |= to_type_bits(element);
+            }
+            return result;
+        }
+        if (!v.is_string()) {
+            throw invalid_argument{};
+        }
+        const auto& name{v.as_string()};
+        if (name == "integer") {
+            return integer_type_bit;
+        }
+        static const char* const names[]{"object", "array",   "string",
+                                         "number", "boolean", "null"};
+        for (unsigned i{}; i < 6; ++i) {
+            if (name == names[i]) {
+                return 1U << i;
+            }
+        }
+        throw invalid_argument{};
+    }
+
+    void compile_keywords(const value& schema, const std::string& pointer,
+                          schema_node& node) {
+        // Assertions that are not supported would otherwise accept values
+        // that are invalid, unlike annotations such as format.
+        for (const auto* name : {"unevaluatedProperties", "unevaluatedItems",
+                                 "$dynamicRef", "$recursiveRef"}) {
+            if (schema.find_member(name)) {
+                throw invalid_argument{};
+            }
+        }
+        auto has_constraints{false};
+        auto keyword = [&](const char* name) {
+            const auto* result{schema.find_member(name)};
+            has_constraints = has_constraints || result;
+            return result;
+        };
+        if (const auto* v{keyword("type")}) {
+            node.types = to_type_bits(*v);
+        }
+        if (const auto* v{keyword("enum")}) {
+            if (!v->is_array()) {
+                throw invalid_argument{};
+            }
+            node.enum_values = v->as_array();
+            node.has_enum = true;
+        } else if (const auto* v{keyword("const")}) {
+            node.enum_values.push_back(*v);
+            node.has_enum = node.is_const = true;
+        }
+        for (const auto& v : node.enum_values) {
+            node.enum_hashes.push_back(v.hash());
+        }
+        compile_number_keywords(keyword, node);
+        compile_string_keywords(keyword, node);
+        compile_array_keywords(keyword, pointer, node);
+        compile_object_keywords(keyword, pointer, node);
+        if (const auto* v{keyword("allOf")}) {
+            node.all_of = compile_list(*v, pointer + "/allOf");
+        }
+        if (const auto* v{keyword("anyOf")}) {
+            node.any_of = compile_list(*v, pointer + "/anyOf");
+        }
+        if (const auto* v{keyword("oneOf")}) {
+            node.one_of = compile_list(*v, pointer + "/oneOf");
+        }
+        if (const auto* v{keyword("not")}) {
+            node.not_schema = compile_member(*v, pointer, "not");
+        }
+        if (const auto* v{keyword("if")}) {
+            node.if_schema = compile_member(*v, pointer, "if");
+            if (const auto* then_v{schema.find_member("then")}) {
+                node.then_schema = compile_member(*then_v, pointer, "then");
+            }
+            if (const auto* else_v{schema.find_member("else")}) {
+                node.else_schema = compile_member(*else_v, pointer, "else");
+            }
+        }
+        if (const auto* v{schema.find_member("$ref")}) {
+            node.ref = compile_ref(*v);
+            node.ref_only = !has_constraints;
+        }
+        node.is_streamable =
+            !node.has_enum && !node.unique_items &&
+            node.contains == no_schema && node.all_of.empty() &&
+            node.any_of.empty() && node.one_of.empty() &&
+            node.not_schema == no_schema && node.if_schema == no_schema &&
+            node.dependent_schemas.empty() &&
+            (node.ref == no_schema || node.ref_only);
+    }
+
+    template<typename Keyword>
+    static void compile_number_keywords(Keyword& keyword, schema_node& node) {
+        if (const auto* v{keyword("minimum")}) {
+            node.minimum = to_number(*v);
+        }
+        if (const auto* v{keyword("maximum")}) {
+            node.maximum = to_number(*v);
+        }
+        // Draft 4 made the bounds exclusive with booleans.
+        if (const auto* v{keyword("exclusiveMinimum")}) {
+            if (!v->is_boolean()) {
+                node.exclusive_minimum = to_number(*v);
+            } else if (v->as_boolean()) {
+                std::swap(node.exclusive_minimum, node.minimum);
+            }
+        }
+        if (const auto* v{keyword("exclusiveMaximum")}) {
+            if (!v->is_boolean()) {
+                node.exclusive_maximum = to_number(*v);
+            } else if (v->as_boolean()) {
+                std::swap(node.exclusive_maximum, node.maximum);
+            }
+        }
+        if (const auto* v{keyword("multipleOf")}) {
+            node.multiple_of = to_number(*v);
+            if (!(node.multiple_of > 0)) {
+                throw invalid_argument{};
+            }
+        }
+    }
+
+    template<typename Keyword>
+    void compile_string_keywords(Keyword& keyword, schema_node& node) {
+        if (const auto* v{keyword("minLength")}) {
+            node.min_length = to_count(*v);
+        }
+        if (const auto* v{keyword("maxLength")}) {
+            node.max_length = to_count(*v);
+        }
+        if (const auto* v{keyword("pattern")}) {
+            if (!v->is_string()) {
+                throw invalid_argument{};
+            }
+            node.pattern = m_program.add_pattern(v->as_string());
+        }
+    }
+
+    template<typename Keyword>
+    void compile_array_keywords(Keyword& keyword, const std::string& pointer,
+                                schema_node& node) {
+        if (const auto* v{keyword("minItems")}) {
+            node.min_items = to_count(*v);
+        }
+        if (const auto* v{keyword("maxItems")}) {
+            node.max_items = to_count(*v);
+        }
+        if (const auto* v{keyword("uniqueItems")}) {
+            if (!v->is_boolean()) {
+                throw invalid_argument{};
+            }
+            node.unique_items = v->as_boolean();
+        }
+        if (const auto* v{keyword("prefixItems")}) {
+            node.prefix_items = compile_list(*v, pointer + "/prefixItems");
+        }
+        if (const auto* v{keyword("items")}) {
+            if (v->is_array()) {
+                // Draft 7 form of prefixItems.
+                node.prefix_items = compile_list(*v, pointer + "/items");
+                if (const auto* rest{keyword("additionalItems")}) {
+                    node.items =
+                        compile_member(*rest, pointer, "additionalItems");
+                }
+            } else {
+                node.items = compile_member(*v, pointer, "items");
+            }
+        }
+        if (const auto* v{keyword("contains")}) {
+            node.contains = compile_member(*v, pointer, "contains");
+            if (const auto* min{keyword("minContains")}) {
+                node.min_contains = to_count(*min);
+            }
+            if (const auto* max{keyword("maxContains")}) {
+                node.max_contains = to_count(*max);
+            }
+        }
+    }
+
+    template<typename Keyword>
+    void compile_object_keywords(Keyword& keyword, const std::string& pointer,
+                                 schema_node& node) {
+        if (const auto* v{keyword("minProperties")}) {
+            node.min_properties = to_count(*v);
+        }
+        if (const auto* v{keyword("maxProperties")}) {
+            node.max_properties = to_count(*v);
+        }
+        if (const auto* v{keyword("required")}) {
+            node.required = to_names(*v);
+        }
+        if (const auto* v{keyword("properties")}) {
+            auto base{pointer + "/properties"};
+            for_each_member(*v, [&](string_ref name, const value& member) {
+                node.properties.emplace(name,
+                                        compile_member(member, base, name));
+            });
+        }
+        if (const auto* v{keyword("patternProperties")}) {
+            auto base{pointer + "/patternProperties"};
+            for_each_member(*v, [&](string_ref name, const value& member) {
+                auto pattern{m_program.add_pattern(name)};
+                node.pattern_properties.emplace_back(
+                    pattern, compile_member(member, base, name));
+            });
+        }
+        if (const auto* v{keyword("additionalProperties")}) {
+            node.additional_properties =
+                compile_member(*v, pointer, "additionalProperties");
+        }
+        if (const auto* v{keyword("propertyNames")}) {
+            node.property_names = compile_member(*v, pointer, "propertyNames");
+        }
+        if (const auto* v{keyword("dependentRequired")}) {
+            for_each_member(*v, [&](string_ref name, const value& member) {
+                node.dependent_required.emplace_back(name.str(),
+                                                     to_names(member));
+            });
+        }
+        if (const auto* v{keyword("dependentSchemas")}) {
+            auto base{pointer + "/dependentSchemas"};
+            for_each_member(*v, [&](string_ref name, const value& member) {
+                node.dependent_schemas.emplace_back(
+                    name.str(),
+                    compile_member(member, base, name));
+            });
+        }
+        // Drafts 4 to 7 combine both in one keyword.
+        if (const auto* v{keyword("dependencies")}) {
+            auto base{pointer + "/dependencies"};
+            for_each_member(*v, [&](string_ref name, const value& member) {
+                if (member.is_array()) {
+                    node.dependent_required.emplace_back(
+                        name.str(),
+                        to_names(member));
+                } else {
+                    node.dependent_schemas.emplace_back(
+                        name.str(), compile_member(member, base, name));
+                }
+            });
+            node.legacy_dependencies = true;
+        }
+    }
+
+    static std::vector<std::string> to_names(const value& v) {
+        if (!v.is_array()) {
+            throw invalid_argument{};
+        }
+        std::vector<std::string> result;
+        for (const auto& name : v.as_array()) {
+            if (!name.is_string()) {
+                throw invalid_argument{};
+            }
+            const auto& s{name.as_string()};
+            result.emplace_back(s.data(), s.size());
+        }
+        return result;
+    }
+
+    template<typename Fn>
+    static void for_each_member(const value& object, Fn fn) {
+        if (!object.is_object()) {
+            throw invalid_argument{};
+        }
+        object.for_each_member(fn);
+    }
+
+    // Rejects references and combinations that would lead back to the same
+    // node without descending into the value, as validation would never
+    // end.
+    void ensure_descends(size_t index, std::vector<unsigned char>& states) {
+        enum : unsigned char { unvisited, visiting, visited };
+        if (states[index] == visited) {
+            return;
+        }
+        if (states[index] == visiting) {
+            throw invalid_argument{};
+        }
+        states[index] = visiting;
+        // Subschemas that apply to the same value rather than a nested one.
+        const auto& node{m_program.nodes()[index]};
+        std::vector<size_t> next(node.all_of);
+        next.insert(next.end(), node.any_of.begin(), node.any_of.end());
+        next.insert(next.end(), node.one_of.begin(), node.one_of.end());
+        for (const auto& dependency : node.dependent_schemas) {
+            next.push_back(dependency.second);
+        }
+        for (auto i : {node.ref, node.not_schema, node.if_schema,
+                       node.then_schema, node.else_schema}) {
+            if (i != no_schema) {
+                next.push_back(i);
+            }
+        }
+        for (auto i : next) {
+            ensure_descends(i, states);
+        }
+        states[index] = visited;
+    }
+
+    const value& m_root;
+    schema_program& m_program;
+    std::unordered_map<std::string, size_t> m_compiled;
+};
+
+} // namespace detail
+
+/**
+ * JSON Schema that has been compiled once so that it can be used to validate
+ * many documents, either as value trees or while loading them with
+ * load_validated().
+ *
+ * Supported are the validation keywords of drafts 4 to 2020-12 for types,
+ * numbers, strings, arrays and objects, as well as enum, const,
+ * dependencies, dependentRequired, dependentSchemas, allOf, anyOf, oneOf,
+ * not, if, then, else and $ref with JSON pointers within the same document.
+ * Other keywords such as format are ignored as annotations.
+ *
+ * Patterns are ECMAScript regular expressions without backreferences and
+ * lookarounds that are matched against code points in time linear in the
+ * length of the string.
+ */
+class compiled_schema {
+public:
+    /**
+     * Compiles a JSON Schema.
+     *
+     * @param schema The JSON Schema document.
+     * @throw invalid_argument if the schema is malformed, uses a reference
+     * that cannot be resolved, uses unevaluatedProperties,
+     * unevaluatedItems, $dynamicRef or $recursiveRef, or has a pattern that
+     * is unsupported, nests groups more than 256 levels deep or compiles to
+     * more than 65536 instructions, such as through large repetition
+     * counts.
+     */
+    explicit compiled_schema(const value& schema) {
+        detail::schema_compiler{schema, m_program}.compile();
+    }
+
+    /**
+     * Checks whether a JSON value is valid. Stops at the first failure.
+     *
+     * @param v The JSON value.
+     * @return Whether the value is valid.
+     */
+    bool is_valid(const value& v) const {
+        return m_program.check(0, v, nullptr);
+    }
+
+    /**
+     * Validates a JSON value. Stops at the first failure.
+     *
+     * @param v The JSON value.
+     * @throw validation_error if the value is invalid.
+     */
+    void validate(const value& v) const { m_program.validate(0, v); }
+
+    /// @cond
+    const detail::schema_program& program() const noexcept {
+        return m_program;
+    }
+    /// @endcond
+
+private:
+    detail::schema_program m_program;
+};
+
+namespace detail {
+
+inline value parse_validated_value(std::istream& is, parse_context& ctx,
+                                   const schema_program& program,
+                                   size_t index);
+
+// Parses a nested value and adds its reference token to validation errors.
+inline value parse_validated_child(std::istream& is, parse_context& ctx,
+                                   const schema_program& program,
+                                   size_t index, const std::string& token) {
+    try {
+        return parse_validated_value(is, ctx, program, index);
+    } catch (const validation_error& e) {
+        throw validation_error{'/' + token + e.pointer(), e.keyword()};
+    }
+}
+
+// Checks a parsed object member against the subschemas that it was not
+// parsed with.
+inline void validate_member(const schema_program& program,
+                            const schema_node& node, string_ref name,
+                            const value& member) {
+    for (const auto& pattern : node.pattern_properties) {
+        if (!program.matches_pattern(pattern.first, name)) {
+            continue;
+        }
+        schema_failure failure;
+        if (!program.check(pattern.second, member, &failure)) {
+            throw validation_error{'/' + escape_pointer_token(name) +
+                                       failure.pointer(),
+                                   failure.keyword};
+        }
+    }
+    if (node.property_names != no_schema &&
+        !program.check(node.property_names, value{name.str()}, nullptr)) {
+        throw validation_error{'/' + escape_pointer_token(name),
+                               "propertyNames"};
+    }
+}
+
+inline value parse_validated_object(std::istream& is, parse_context& ctx,
+                                    const schema_program& program,
+                                    const schema_node& node) {
+    using namespace parsing;
+    using namespace token_rules;
+    enter_nesting(ctx);
+    skip(is);
+    skip_while(is, ws);
+    auto is_shared{ctx.options.share_object_shapes};
+    auto first{ctx.elements.size()};
+    auto first_name{ctx.names.size()};
+    object_impl result;
+    size_t count{};
+    // Only the first occurrence of a member name is kept, so later ones are
+    // neither counted nor validated. Shared shapes keep the names on the
+    // shared name stack, which larger objects index in a copy.
+    object_shape names;
+    constexpr size_t scanned_names{8};
+    auto is_repeated = [&](string_ref name) {
+        if (!is_shared) {
+            return result.find(name) != nullptr;
+        }
+        auto names_begin{ctx.names.begin() +
+                         static_cast<std::ptrdiff_t>(first_name)};
+        if (names.empty() && ctx.names.size() - first_name <= scanned_names) {
+            return std::any_of(names_begin, ctx.names.end(),
+                               [&](const value::string_type& other) {
+                                   return string_ref{other} == name;
+                               });
+        }
+        if (names.empty()) {
+            for (auto it{names_begin}; it != ctx.names.end(); ++it) {
+                names.push_back(*it);
+            }
+        }
+        return names.find(name) != object_shape::npos;
+    };
+    if (!peek(is, object_close)) {
+        while (true) {
+            if (!peek(is, dquote)) {
+                throw unexpected_token{};
+            }
+            auto member_name{parse_string(is, ctx)};
+            skip_while(is, ws);
+            expect(is, member_separator);
+            auto is_first{!is_repeated(member_name)};
+            if (is_first && ++count > node.max_properties) {
+                throw validation_error{"", "maxProperties"};
+            }
+            // Stream into the first applicable subschema and check the value
+            // against the others once parsed.
+            auto found{node.properties.find(member_name)};
+            auto child{found != node.properties.end() ? found->second
+                                                      : no_schema};
+            auto has_pattern{std::any_of(
+                node.pattern_properties.begin(), node.pattern_properties.end(),
+                [&](const std::pair<size_t, size_t>& pattern) {
+                    return program.matches_pattern(pattern.first,
+                                                   member_name);
+                })};
+            if (child == no_schema && !has_pattern) {
+                child = node.additional_properties;
+            }
+            auto member_value{
+                !is_first || child == no_schema
+                    ? parse_value(is, ctx)
+                    : parse_validated_child(is, ctx, program, child,
+                                            escape_pointer_token(member_name))};
+            if (is_first &&
+                (has_pattern || node.property_names != no_schema)) {
+                validate_member(program, node, member_name, member_value);
+            }
+            if (is_shared) {
+                if (!names.empty()) {
+                    names.push_back(member_name);
+                }
+                ctx.names.push_back(std::move(member_name));
+                ctx.elements.push_back(std::move(member_value));
+            } else {
+                result.members().emplace(std::move(member_name),
+                                         std::move(member_value));
+            }
+            skip_while(is, ws);
+            if (peek(is, value_separator)) {
+                skip(is);
+                skip_while(is, ws);
+                continue;
+            }
+            break;
+        }
+    }
+    expect(is, object_close);
+    leave_nesting(ctx);
+    if (is_shared && count > 0) {
+        result = pop_members(ctx, first_name, first);
+    }
+    if (result.size() < node.min_properties) {
+        throw validation_error{"", "minProperties"};
+    }
+    for (const auto& name : node.required) {
+        if (!result.find(name)) {
+            throw validation_error{"", "required"};
+        }
+    }
+    if (!has_dependent_members(node, result)) {
+        throw validation_error{"", node.legacy_dependencies
+                                       ? "dependencies"
+                                       : "dependentRequired"};
+    }
+    return value{make_unique<object_impl>(std::move(result))};
+}
+
+inline value parse_validated_array(std::istream& is, parse_context& ctx,
+                                   const schema_program& program,
+                                   const schema_node& node) {
+    using namespace parsing;
+    using namespace token_rules;
+    enter_nesting(ctx);
+    skip(is);
+    skip_while(is, ws);
+    auto first{ctx.elements.size()};
+    if (!peek(is, array_close)) {
+        for (size_t i{};; ++i) {
+            if (i >= node.max_items) {
+                throw validation_error{"", "maxItems"};
+            }
+            auto child{i < node.prefix_items.size() ? node.prefix_items[i]
+                                                    : node.items};
+            ctx.elements.push_back(
+                child == no_schema ? parse_value(is, ctx)
+                                   : parse_validated_child(
+                                         is, ctx, program, child,
+                                         std::to_string(i)));
+            skip_while(is, ws);
+            if (peek(is, value_separator)) {
+                skip(is);
+                skip_while(is, ws);
+                continue;
+            }
+            break;
+        }
+    }
+    expect(is, array_close);
+    leave_nesting(ctx);
+    if (ctx.elements.size() - first < node.min_items) {
+        throw validation_error{"", "minItems"};
+    }
+    return value{make_unique<array_impl>(pop_elements(ctx, first))};
+}
+
+// Parses a value while validating it. Objects and arrays are checked member
+// by member so that parsing stops at the first invalid member, while other
+// values are checked once parsed.
+inline value parse_validated_value(std::istream& is, parse_context& ctx,
+                                   const schema_program& program,
+                                   size_t index) {
+    using namespace parsing;
+    using namespace token_rules;
+    index = program.resolve(index);
+    const auto& node{program.nodes()[index]};
+    skip_while(is, ws);
+    if (node.is_streamable) {
+        auto c{peek_next(is)};
+        auto is_object{object_open(is, c)};
+        // Arrays without subschemas for elements are parsed as usual to
+        // keep packing numbers.
+        auto is_array{array_open(is, c) &&
+                      (node.items != no_schema || !node.prefix_items.empty() ||
+                       node.max_items != no_schema)};
+        if (is_object || is_array) {
+            if (node.reject) {
+                throw validation_error{"", "false"};
+            }
+            auto type{is_object ? value::type::object : value::type::array};
+            if (node.types != 0 && (node.types & type_bit(type)) == 0) {
+                throw validation_error{"", "type"};
+            }
+            return is_object ? parse_validated_object(is, ctx, program, node)
+                             : parse_validated_array(is, ctx, program, node);
+        }
+    }
+    auto result{parse_value(is, ctx)};
+    program.validate(index, result);
+    return result;
+}
+
+inline value fully_parse_validated_value(std::istream& is,
+                                         const compiled_schema& schema,
+                                         const parse_options& options) {
+    using namespace parsing;
+    using namespace token_rules;
+    scoped_resource scope{options.resource};
+    parse_context ctx{options};
+    auto result{parse_validated_value(is, ctx, schema.program(), 0)};
+    skip_while(is, ws);
+    expect_fully_consumed(is);
+    return result;
+}
+
+} // namespace detail
+LANGNES_JSON_CXX_NS_END
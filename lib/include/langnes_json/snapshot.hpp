@@ -0,0 +1,897 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/binary.hpp"
+#include "detail/dict.hpp"
+#include "detail/macros.hpp"
+#include "detail/mapped_file.hpp"
+#include "detail/memory.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "span.hpp"
+#include "string_ref.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// A snapshot image consists of a header, an array of fixed-size nodes and a
+// pool of string data. All integers are little-endian and all references are
+// indices or offsets, so the image can be used at any address.
+//
+// Each node holds a tag, a size and a payload. The children of an array or
+// object are allocated as a contiguous run of nodes after the container,
+// with alternating name and value nodes for objects.
+//
+// Objects with more than indexed_size members have an extra string node
+// before their children, holding the positions of the members as 32-bit
+// integers sorted by name so that members can be looked up by binary search.
+namespace snapshot_format {
+
+constexpr std::array<char, 8> magic{{'L', 'J', 'S', 'N', 'A', 'P', '0', '2'}};
+constexpr size_t header_size{32};
+constexpr size_t node_size{16};
+constexpr std::uint64_t max_size{std::numeric_limits<std::uint32_t>::max()};
+constexpr size_t indexed_size{8};
+constexpr size_t position_size{4};
+
+enum class tag : std::uint32_t {
+    null,
+    boolean,
+    int64,
+    uint64,
+    float64,
+    // The payload is the offset of the data in the string pool.
+    string,
+    // The payload is the index of the first child.
+    array,
+    object
+};
+
+} // namespace snapshot_format
+
+struct snapshot_node {
+    snapshot_format::tag tag;
+    std::uint32_t size;
+    std::uint64_t payload;
+};
+
+inline std::uint64_t load_little_endian(const std::uint8_t* p,
+                                        size_t size) noexcept {
+    std::uint64_t result{};
+    for (auto i{size}; i > 0; --i) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        result = (result << 8U) | p[i - 1];
+    }
+    return result;
+}
+
+inline void store_little_endian(std::uint8_t* p, std::uint64_t v,
+                                size_t size) noexcept {
+    for (size_t i{}; i < size; ++i) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        p[i] = static_cast<std::uint8_t>(v >> (i * 8U));
+    }
+}
+
+inline parse_error invalid_snapshot() {
+    return parse_error{"Invalid snapshot"};
+}
+
+// Sections of a snapshot image in memory. Only the header is validated up
+// front. References are validated on access.
+class snapshot_image {
+public:
+    snapshot_image(const std::uint8_t* data, size_t length) {
+        using namespace snapshot_format;
+        if (length < header_size ||
+            std::memcmp(data, magic.data(), magic.size()) != 0) {
+            throw invalid_snapshot();
+        }
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto node_count{load_little_endian(data + 8, 8)};
+        auto pool_size{load_little_endian(data + 16, 8)};
+        auto available{length - header_size};
+        if (node_count == 0 || node_count > available / node_size ||
+            pool_size != available - node_count * node_size) {
+            throw invalid_snapshot();
+        }
+        m_nodes = data + header_size;
+        m_node_count = static_cast<size_t>(node_count);
+        m_pool =
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<const char*>(m_nodes + node_count * node_size);
+        // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        m_pool_size = static_cast<size_t>(pool_size);
+    }
+
+    snapshot_node node(size_t index) const {
+        if (index >= m_node_count) {
+            throw invalid_snapshot();
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const auto* p{m_nodes + index * snapshot_format::node_size};
+        auto tag{static_cast<std::uint32_t>(load_little_endian(p, 4))};
+        if (tag > static_cast<std::uint32_t>(snapshot_format::tag::object)) {
+            throw invalid_snapshot();
+        }
+        return snapshot_node{
+            static_cast<snapshot_format::tag>(tag),
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            static_cast<std::uint32_t>(load_little_endian(p + 4, 4)),
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            load_little_endian(p + 8, 8)};
+    }
+
+    span<const char> string(const snapshot_node& n) const {
+        if (n.payload > m_pool_size || n.size > m_pool_size - n.payload) {
+            throw invalid_snapshot();
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return {m_pool + n.payload, n.size};
+    }
+
+    static bool is_indexed(const snapshot_node& n) noexcept {
+        return n.tag == snapshot_format::tag::object &&
+               n.size > snapshot_format::indexed_size;
+    }
+
+    // Gets the index of the first child of a container. Children always
+    // follow their parent, which rules out cycles.
+    size_t first_child(const snapshot_node& n, size_t index) const {
+        auto stride{n.tag == snapshot_format::tag::object ? 2U : 1U};
+        auto extra{is_indexed(n) ? 1U : 0U};
+        if (n.payload <= index || n.payload > m_node_count ||
+            std::uint64_t{n.size} * stride + extra >
+                m_node_count - n.payload) {
+            throw invalid_snapshot();
+        }
+        return static_cast<size_t>(n.payload) + extra;
+    }
+
+    // Gets the position of the member of an indexed object with the given
+    // rank in name order.
+    size_t member_position(const snapshot_node& n, size_t index,
+                           size_t rank) const {
+        using snapshot_format::position_size;
+        first_child(n, index);
+        auto order{node(static_cast<size_t>(n.payload))};
+        if (order.tag != snapshot_format::tag::string ||
+            order.size != std::uint64_t{n.size} * position_size) {
+            throw invalid_snapshot();
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        const auto* positions{reinterpret_cast<const std::uint8_t*>(
+            string(order).data())};
+        auto position{load_little_endian(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            positions + rank * position_size, position_size)};
+        if (position >= n.size) {
+            throw invalid_snapshot();
+        }
+        return static_cast<size_t>(position);
+    }
+
+private:
+    const std::uint8_t* m_nodes;
+    size_t m_node_count;
+    const char* m_pool;
+    size_t m_pool_size;
+};
+
+// Lays out a value tree as a snapshot image.
+class snapshot_writer {
+public:
+    void write(std::ostream& os, const value& root) {
+        using namespace snapshot_format;
+        m_nodes.resize(1);
+        fill(root, 0);
+        std::array<std::uint8_t, header_size> header{};
+        std::memcpy(header.data(), magic.data(), magic.size());
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        store_little_endian(header.data() + 8, m_nodes.size(), 8);
+        store_little_endian(header.data() + 16, m_pool.size(), 8);
+        // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        write_bytes(os, header.data(), header.size());
+        std::array<std::uint8_t, node_size> bytes{};
+        for (const auto& n : m_nodes) {
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            store_little_endian(bytes.data(),
+                                static_cast<std::uint32_t>(n.tag), 4);
+            store_little_endian(bytes.data() + 4, n.size, 4);
+            store_little_endian(bytes.data() + 8, n.payload, 8);
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            write_bytes(os, bytes.data(), bytes.size());
+        }
+        os.write(m_pool.data(), static_cast<std::streamsize>(m_pool.size()));
+    }
+
+private:
+    static void write_bytes(std::ostream& os, const std::uint8_t* data,
+                            size_t length) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        os.write(reinterpret_cast<const char*>(data),
+                 static_cast<std::streamsize>(length));
+    }
+
+    static std::uint32_t checked_size(size_t size) {
+        if (size > snapshot_format::max_size) {
+            throw out_of_range{"Size exceeds the snapshot limit"};
+        }
+        return static_cast<std::uint32_t>(size);
+    }
+
+    snapshot_node make_string(string_ref s) {
+        snapshot_node result{snapshot_format::tag::string,
+                             checked_size(s.size()), m_pool.size()};
+        m_pool.append(s.data(), s.size());
+        return result;
+    }
+
+    // Member names repeat across objects, so each is stored once.
+    snapshot_node make_name(string_ref name) {
+        auto found{m_names.find(name)};
+        if (found != m_names.end()) {
+            return found->second;
+        }
+        auto result{make_string(name)};
+        m_names.emplace(name, result);
+        return result;
+    }
+
+    static snapshot_node make_number(double v) {
+        std::uint64_t bits{};
+        std::memcpy(&bits, &v, sizeof(bits));
+        return {snapshot_format::tag::float64, 0, bits};
+    }
+
+    static snapshot_node make_number(const number_impl& v) {
+        using t = snapshot_format::tag;
+        std::int64_t i{};
+        std::uint64_t u{};
+        switch (v.get_kind()) {
+        case number_impl::kind::int64:
+            v.to_int64(i);
+            return {t::int64, 0, static_cast<std::uint64_t>(i)};
+        case number_impl::kind::uint64:
+            v.to_uint64(u);
+            return {t::uint64, 0, u};
+        default:
+            return make_number(v.data());
+        }
+    }
+
+    // Allocates a run of nodes for the children of a container.
+    size_t allocate(snapshot_format::tag tag, size_t index, size_t count) {
+        snapshot_node n{tag, checked_size(count), m_nodes.size()};
+        auto stride{tag == snapshot_format::tag::object ? 2U : 1U};
+        auto extra{snapshot_image::is_indexed(n) ? 1U : 0U};
+        m_nodes.resize(m_nodes.size() + extra + count * stride);
+        m_nodes[index] = n;
+        return static_cast<size_t>(n.payload) + extra;
+    }
+
+    string_ref pooled(const snapshot_node& n) const {
+        return {&m_pool[static_cast<size_t>(n.payload)], n.size};
+    }
+
+    // Stores the positions of the members of an object sorted by name.
+    // Members with the same name keep their order.
+    void index_members(size_t first, size_t count) {
+        using snapshot_format::position_size;
+        std::vector<std::uint32_t> positions(count);
+        for (size_t i{}; i < count; ++i) {
+            positions[i] = static_cast<std::uint32_t>(i);
+        }
+        std::stable_sort(positions.begin(), positions.end(),
+                         [&](std::uint32_t lhs, std::uint32_t rhs) {
+                             return pooled(m_nodes[first + lhs * 2]) <
+                                    pooled(m_nodes[first + rhs * 2]);
+                         });
+        m_nodes[first - 1] =
+            snapshot_node{snapshot_format::tag::string,
+                          checked_size(count * position_size), m_pool.size()};
+        std::array<std::uint8_t, position_size> bytes{};
+        for (auto position : positions) {
+            store_little_endian(bytes.data(), position, position_size);
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            m_pool.append(reinterpret_cast<const char*>(bytes.data()),
+                          bytes.size());
+        }
+    }
+
+    void fill(const value& v, size_t index) {
+        using t = snapshot_format::tag;
+        switch (v.get_type()) {
+        case value::type::object: {
+            const auto& object{dynamic_cast<const object_impl&>(v.impl())};
+            auto first{allocate(t::object, index, object.size())};
+            if (const auto* shape{object.shape()}) {
+                for (size_t i{}; i < shape->size(); ++i) {
+                    m_nodes[first + i * 2] = make_name((*shape)[i]);
+                    fill(object.values()[i], first + i * 2 + 1);
+                }
+            } else {
+                const auto& members{object.members()};
+                for (size_t i{}; i < members.size(); ++i) {
+                    const auto& member{members.entry_at(i)};
+                    m_nodes[first + i * 2] = make_name(member.first);
+                    fill(member.second, first + i * 2 + 1);
+                }
+            }
+            if (object.size() > snapshot_format::indexed_size) {
+                index_members(first, object.size());
+            }
+            break;
+        }
+        case value::type::array: {
+            const auto& array{dynamic_cast<const array_impl&>(v.impl())};
+            if (array.is_packed()) {
+                const auto& numbers{array.numbers()};
+                auto first{allocate(t::array, index, numbers.size())};
+                for (size_t i{}; i < numbers.size(); ++i) {
+                    m_nodes[first + i] = make_number(numbers[i]);
+                }
+                break;
+            }
+            const auto& elements{array.elements()};
+            auto first{allocate(t::array, index, elements.size())};
+            for (size_t i{}; i < elements.size(); ++i) {
+                fill(elements[i], first + i);
+            }
+            break;
+        }
+        case value::type::string:
+            m_nodes[index] = make_string(v.as_string());
+            break;
+        case value::type::number:
+            m_nodes[index] =
+                make_number(dynamic_cast<const number_impl&>(v.impl()));
+            break;
+        case value::type::boolean:
+            m_nodes[index] = snapshot_node{t::boolean, 0, v.as_boolean()};
+            break;
+        default:
+            m_nodes[index] = snapshot_node{t::null, 0, 0};
+        }
+    }
+
+    std::vector<snapshot_node> m_nodes;
+    std::string m_pool;
+    dict<std::string, snapshot_node> m_names;
+};
+
+} // namespace detail
+
+class element_iterator;
+
+/**
+ * Read-only view of a JSON value within a snapshot.
+ *
+ * Accessing a view reads the snapshot image in place without parsing or
+ * allocating, except for the functions that return a std::string or a
+ * value. Looking up a member of an object with more than eight members is a
+ * binary search, and smaller objects are searched linearly.
+ *
+ * The view refers to the snapshot, which must outlive it.
+ */
+class element {
+public:
+    /// @cond
+    element(const detail::snapshot_image* image, size_t index) noexcept
+        : m_image{image},
+          m_index{index} {}
+
+    const detail::snapshot_image* image() const noexcept { return m_image; }
+    size_t index() const noexcept { return m_index; }
+    /// @endcond
+
+    value::type get_type() const {
+        using t = detail::snapshot_format::tag;
+        switch (node().tag) {
+        case t::object:
+            return value::type::object;
+        case t::array:
+            return value::type::array;
+        case t::string:
+            return value::type::string;
+        case t::boolean:
+            return value::type::boolean;
+        case t::null:
+            return value::type::null;
+        default:
+            return value::type::number;
+        }
+    }
+
+    bool is_type(value::type type) const { return get_type() == type; }
+    bool is_string() const { return is_type(value::type::string); }
+    bool is_number() const { return is_type(value::type::number); }
+    bool is_boolean() const { return is_type(value::type::boolean); }
+    bool is_object() const { return is_type(value::type::object); }
+    bool is_array() const { return is_type(value::type::array); }
+    bool is_null() const { return is_type(value::type::null); }
+
+    /**
+     * Gets the data of a string within the snapshot.
+     *
+     * @return The string data, which is not null-terminated.
+     */
+    span<const char> as_string_span() const {
+        auto n{node()};
+        if (n.tag != detail::snapshot_format::tag::string) {
+            throw bad_access{};
+        }
+        return m_image->string(n);
+    }
+
+    std::string as_string() const {
+        auto s{as_string_span()};
+        return std::string(s.data(), s.size());
+    }
+
+    double as_number() const { return number().data(); }
+
+    std::int64_t as_int64() const {
+        std::int64_t result{};
+        if (!number().to_int64(result)) {
+            throw out_of_range{"Number is not representable as int64"};
+        }
+        return result;
+    }
+
+    std::uint64_t as_uint64() const {
+        std::uint64_t result{};
+        if (!number().to_uint64(result)) {
+            throw out_of_range{"Number is not representable as uint64"};
+        }
+        return result;
+    }
+
+    bool as_boolean() const {
+        auto n{node()};
+        if (n.tag != detail::snapshot_format::tag::boolean) {
+            throw bad_access{};
+        }
+        return n.payload != 0;
+    }
+
+    /**
+     * Gets the number of members or elements of an object or array.
+     *
+     * @return The number of members or elements.
+     */
+    size_t size() const { return container().size; }
+
+    /**
+     * Gets an iterator to the first member or element of an object or array.
+     *
+     * @return The iterator.
+     */
+    element_iterator begin() const;
+
+    /**
+     * Gets an iterator past the last member or element of an object or
+     * array.
+     *
+     * @return The iterator.
+     */
+    element_iterator end() const;
+
+    /**
+     * Finds an object member by name.
+     *
+     * @param name The member name.
+     * @return Iterator to the member, or end() if not found.
+     */
+    element_iterator find(string_ref name) const;
+
+    /**
+     * Gets an object member by name.
+     *
+     * @param name The member name.
+     * @return The member value.
+     * @throw out_of_range if the member does not exist.
+     */
+    element operator[](string_ref name) const;
+
+    /**
+     * Gets an array element by index.
+     *
+     * @param index The element index.
+     * @return The element value.
+     * @throw out_of_range if the index is out of range.
+     */
+    element operator[](size_t index) const {
+        auto n{node()};
+        if (n.tag != detail::snapshot_format::tag::array) {
+            throw bad_access{};
+        }
+        if (index >= n.size) {
+            throw out_of_range{"Index out of range"};
+        }
+        return element{m_image, m_image->first_child(n, m_index) + index};
+    }
+
+    /**
+     * Copies the value into a JSON value tree.
+     *
+     * @return The JSON value.
+     */
+    value materialize() const {
+        using namespace detail;
+        using t = snapshot_format::tag;
+        auto n{node()};
+        switch (n.tag) {
+        case t::object: {
+            auto impl{make_unique<object_impl>()};
+            auto& members{impl->members()};
+            members.reserve(n.size);
+            auto first{m_image->first_child(n, m_index)};
+            for (size_t i{}; i < n.size; ++i) {
+                auto name{element{m_image, first + i * 2}.as_string()};
+                members.emplace(
+                    std::move(name),
+                    element{m_image, first + i * 2 + 1}.materialize());
+            }
+            return value{std::move(impl)};
+        }
+        case t::array: {
+            value::array_type elements;
+            elements.reserve(n.size);
+            auto first{m_image->first_child(n, m_index)};
+            for (size_t i{}; i < n.size; ++i) {
+                elements.push_back(element{m_image, first + i}.materialize());
+            }
+            auto impl{make_unique<array_impl>()};
+            impl->elements() = std::move(elements);
+            return value{std::move(impl)};
+        }
+        case t::string:
+            return value{make_unique<string_impl>(as_string())};
+        case t::boolean:
+            return value{make_unique<boolean_impl>(n.payload != 0)};
+        case t::null:
+            return value{make_unique<null_impl>()};
+        default:
+            return value{make_unique<number_impl>(number())};
+        }
+    }
+
+private:
+    friend class element_iterator;
+
+    detail::snapshot_node node() const { return m_image->node(m_index); }
+
+    detail::snapshot_node container() const {
+        using t = detail::snapshot_format::tag;
+        auto n{node()};
+        if (n.tag != t::object && n.tag != t::array) {
+            throw bad_access{};
+        }
+        return n;
+    }
+
+    detail::number_impl number() const {
+        using t = detail::snapshot_format::tag;
+        auto n{node()};
+        switch (n.tag) {
+        case t::int64:
+            return detail::number_impl{static_cast<std::int64_t>(n.payload)};
+        case t::uint64:
+            return detail::number_impl{n.payload};
+        case t::float64: {
+            double result{};
+            std::memcpy(&result, &n.payload, sizeof(result));
+            return detail::number_impl{result};
+        }
+        default:
+            throw bad_access{};
+        }
+    }
+
+    const detail::snapshot_image* m_image;
+    size_t m_index;
+};
+
+/**
+ * Iterator over the members of an object or the elements of an array within
+ * a snapshot.
+ */
+class element_iterator {
+public:
+    /**
+     * Gets the current member or element value.
+     *
+     * @return The value.
+     */
+    element operator*() const {
+        return element{m_image, m_first + m_position * m_stride + m_stride - 1};
+    }
+
+    /**
+     * Gets the name of the current object member.
+     *
+     * @return The member name, or an empty span for array elements.
+     */
+    span<const char> key() const {
+        if (m_stride == 1) {
+            return {};
+        }
+        return element{m_image, m_first + m_position * 2}.as_string_span();
+    }
+
+    element_iterator& operator++() noexcept {
+        ++m_position;
+        return *this;
+    }
+
+    element_iterator& operator+=(size_t n) noexcept {
+        m_position += n;
+        return *this;
+    }
+
+    bool operator==(const element_iterator& other) const noexcept {
+        return m_image == other.m_image && m_first == other.m_first &&
+               m_position == other.m_position;
+    }
+
+    bool operator!=(const element_iterator& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    friend class element;
+
+    element_iterator(const element& container, bool at_end) {
+        auto n{container.container()};
+        m_image = container.m_image;
+        m_first = m_image->first_child(n, container.m_index);
+        m_stride = n.tag == detail::snapshot_format::tag::object ? 2 : 1;
+        m_position = at_end ? n.size : 0;
+    }
+
+    const detail::snapshot_image* m_image{};
+    size_t m_first{};
+    size_t m_stride{};
+    size_t m_position{};
+};
+
+inline element_iterator element::begin() const {
+    return element_iterator{*this, false};
+}
+
+inline element_iterator element::end() const {
+    return element_iterator{*this, true};
+}
+
+inline element_iterator element::find(string_ref name) const {
+    auto n{node()};
+    if (n.tag != detail::snapshot_format::tag::object) {
+        throw bad_access{};
+    }
+    auto it{begin()};
+    if (!detail::snapshot_image::is_indexed(n)) {
+        for (auto last{end()}; it != last; ++it) {
+            auto key{it.key()};
+            if (string_ref{key.data(), key.size()} == name) {
+                break;
+            }
+        }
+        return it;
+    }
+    auto key_at = [&](size_t position) {
+        auto key{element{m_image, it.m_first + position * 2}};
+        auto data{key.as_string_span()};
+        return string_ref{data.data(), data.size()};
+    };
+    // Finds the first member in name order that is not less than the name.
+    size_t low{};
+    size_t high{n.size};
+    while (low < high) {
+        auto middle{low + (high - low) / 2};
+        if (key_at(m_image->member_position(n, m_index, middle)) < name) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == n.size) {
+        return end();
+    }
+    auto position{m_image->member_position(n, m_index, low)};
+    if (key_at(position) != name) {
+        return end();
+    }
+    it += position;
+    return it;
+}
+
+inline element element::operator[](string_ref name) const {
+    auto found{find(name)};
+    if (found == end()) {
+        throw out_of_range{"Member not found"};
+    }
+    return *found;
+}
+
+namespace detail {
+
+class snapshot_data {
+public:
+    explicit snapshot_data(mapped_file&& file)
+        : m_storage{make_unique<storage>(std::move(file))} {}
+
+    explicit snapshot_data(std::vector<std::uint8_t>&& bytes)
+        : m_storage{make_unique<storage>(std::move(bytes))} {}
+
+    snapshot_data(const std::uint8_t* data, size_t length)
+        : m_storage{make_unique<storage>(data, length)} {}
+
+    const snapshot_image* get_image() const noexcept {
+        return &m_storage->image;
+    }
+
+private:
+    struct storage {
+        explicit storage(mapped_file&& f)
+            : file{std::move(f)},
+              image{file.data(), file.size()} {}
+
+        explicit storage(std::vector<std::uint8_t>&& b)
+            : bytes{std::move(b)},
+              image{bytes.data(), bytes.size()} {}
+
+        storage(const std::uint8_t* data, size_t length)
+            : image{data, length} {}
+
+        mapped_file file;
+        std::vector<std::uint8_t> bytes;
+        snapshot_image image;
+    };
+
+    std::unique_ptr<storage> m_storage;
+};
+
+} // namespace detail
+
+/**
+ * Snapshot of a JSON document that is itself a view of the root value.
+ *
+ * A snapshot is movable, and views remain valid when it is moved.
+ */
+class snapshot : private detail::snapshot_data, public element {
+public:
+    /// @cond
+    explicit snapshot(detail::mapped_file&& file)
+        : detail::snapshot_data{std::move(file)},
+          element{get_image(), 0} {}
+
+    explicit snapshot(std::vector<std::uint8_t>&& data)
+        : detail::snapshot_data{std::move(data)},
+          element{get_image(), 0} {}
+
+    snapshot(const std::uint8_t* data, size_t length)
+        : detail::snapshot_data{data, length},
+          element{get_image(), 0} {}
+    /// @endcond
+};
+
+/**
+ * Saves a JSON value as a snapshot to a stream.
+ *
+ * @param os The output stream.
+ * @param v The JSON value.
+ * @throw out_of_range if a string or container has 2^32 or more bytes or
+ * items.
+ */
+inline void save_snapshot(std::ostream& os, const value& v) {
+    detail::snapshot_writer{}.write(os, v);
+}
+
+/**
+ * Saves a JSON value as a snapshot.
+ *
+ * @param v The JSON value.
+ * @return The snapshot image.
+ * @throw out_of_range if a string or container has 2^32 or more bytes or
+ * items.
+ */
+inline std::vector<std::uint8_t> save_snapshot(const value& v) {
+    std::vector<std::uint8_t> result;
+    detail::vector_streambuf buf{result};
+    std::ostream os{&buf};
+    save_snapshot(os, v);
+    return result;
+}
+
+/**
+ * Saves a JSON value as a snapshot file.
+ *
+ * @param v The JSON value.
+ * @param path The path of the file to create or replace.
+ * @throw out_of_range if a string or container has 2^32 or more bytes or
+ * items.
+ * @throw std::system_error if the file cannot be written.
+ */
+inline void save_snapshot(const value& v, const std::string& path) {
+    std::ofstream os{path, std::ios::binary | std::ios::trunc};
+    if (os) {
+        save_snapshot(os, v);
+        os.close();
+    }
+    // Streams do not report the cause of a failure, and errno may be stale.
+    if (!os) {
+        throw std::system_error{std::make_error_code(std::errc::io_error),
+                                "Failed to write snapshot file"};
+    }
+}
+
+/**
+ * Opens a snapshot file by mapping it into memory.
+ *
+ * Only the header is read, so opening takes constant time. Pages of the file
+ * are loaded by the operating system as they are accessed.
+ *
+ * @param path The path of the snapshot file.
+ * @return The snapshot.
+ * @throw parse_error if the file is not a snapshot. Corruption elsewhere in
+ * the file is detected on access.
+ * @throw std::system_error if the file cannot be mapped.
+ */
+inline snapshot open_snapshot(const std::string& path) {
+    return snapshot{detail::mapped_file{path}};
+}
+
+/**
+ * Opens a snapshot image in memory without copying it.
+ *
+ * @param data The snapshot image, which must outlive the snapshot.
+ * @param length The length of the image in bytes.
+ * @return The snapshot.
+ * @throw parse_error if the data is not a snapshot.
+ */
+inline snapshot open_snapshot(const std::uint8_t* data, size_t length) {
+    return snapshot{data, length};
+}
+
+/**
+ * Opens a snapshot image in memory and takes ownership of it.
+ *
+ * @param data The snapshot image.
+ * @return The snapshot.
+ * @throw parse_error if the data is not a snapshot.
+ */
+inline snapshot open_snapshot(std::vector<std::uint8_t>&& data) {
+    return snapshot{std::move(data)};
+}
+
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/macros.hpp"
+
+#include <cstddef>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+/**
+ * Non-owning view of a contiguous sequence of objects.
+ *
+ * @tparam T The object type.
+ */
+template<typename T>
+class span {
+public:
+    span() noexcept = default;
+
+    /**
+     * Constructs a view.
+     *
+     * @param data Pointer to the first object.
+     * @param size The number of objects.
+     */
+    span(T* data, size_t size) noexcept : m_data{data}, m_size{size} {}
+
+    T* data() const noexcept { return m_data; }
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    T* begin() const noexcept { return m_data; }
+    T* end() const noexcept { return m_data + m_size; }
+    T& operator[](size_t index) const noexcept { return m_data[index]; }
+
+private:
+    T* m_data{};
+    size_t m_size{};
+};
+
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/macros.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+/**
+ * Non-owning view of a string with a length, used to look up object members
+ * without creating a string.
+ */
+class string_ref {
+public:
+    string_ref() noexcept = default;
+
+    /**
+     * Constructs a view.
+     *
+     * @param data Pointer to the first character.
+     * @param size The number of characters.
+     */
+    string_ref(const char* data, size_t size) noexcept
+        : m_data{data},
+          m_size{size} {}
+
+    /**
+     * Constructs a view of a null-terminated string.
+     *
+     * @param data The string.
+     */
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    string_ref(const char* data) noexcept
+        : m_data{data},
+          m_size{std::strlen(data)} {}
+
+    /**
+     * Constructs a view of a string.
+     *
+     * @param s The string.
+     */
+    template<typename Traits, typename Allocator>
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    string_ref(const std::basic_string<char, Traits, Allocator>& s) noexcept
+        : m_data{s.data()},
+          m_size{s.size()} {}
+
+    const char* data() const noexcept { return m_data; }
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    const char* begin() const noexcept { return m_data; }
+    const char* end() const noexcept { return m_data + m_size; }
+    char operator[](size_t index) const noexcept { return m_data[index]; }
+
+    /**
+     * Copies the characters into a string.
+     *
+     * @return The string.
+     */
+    std::string str() const { return {m_data, m_size}; }
+
+private:
+    const char* m_data{""};
+    size_t m_size{};
+};
+
+/// @cond
+inline bool operator==(string_ref lhs, string_ref rhs) noexcept {
+    return lhs.size() == rhs.size() &&
+           (lhs.empty() ||
+            std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+inline bool operator!=(string_ref lhs, string_ref rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+inline bool operator<(string_ref lhs, string_ref rhs) noexcept {
+    auto size{lhs.size() < rhs.size() ? lhs.size() : rhs.size()};
+    auto order{size == 0 ? 0 : std::memcmp(lhs.data(), rhs.data(), size)};
+    return order < 0 || (order == 0 && lhs.size() < rhs.size());
+}
+/// @endcond
+
+LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "detail/macros.hpp"
+#include "detail/type_traits.hpp"
+#include "detail/utf8.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+namespace detail {
+
+// Whether each enclosing container is an object, stored as bits. Only
+// nesting deeper than the inline bits allocates.
+class nesting_stack {
+public:
+    bool empty() const noexcept { return m_size == 0; }
+
+    bool is_object() const {
+        auto index{m_size - 1};
+        if (index >= inline_bits) {
+            return m_overflow.back();
+        }
+        return (m_bits[index / 64] >> (index % 64) & 1U) != 0;
+    }
+
+    void push(bool is_object) {
+        if (m_size >= inline_bits) {
+            m_overflow.push_back(is_object);
+        } else {
+            auto mask{std::uint64_t{1} << (m_size % 64)};
+            auto& word{m_bits[m_size / 64]};
+            word = is_object ? word | mask : word & ~mask;
+        }
+        ++m_size;
+    }
+
+    void pop() {
+        --m_size;
+        if (m_size >= inline_bits) {
+            m_overflow.pop_back();
+        }
+    }
+
+private:
+    static constexpr size_t inline_bits{4096};
+
+    std::array<std::uint64_t, inline_bits / 64> m_bits{};
+    std::vector<bool> m_overflow;
+    size_t m_size{};
+};
+
+// Checks the grammar of JSON (RFC 8259) and the encoding of strings in one
+// pass without building anything.
+class json_validator {
+public:
+    json_validator(const char* data, size_t length) noexcept
+        : m_data{data},
+          m_length{length} {}
+
+    bool validate() {
+        enum class expecting { value, member_name, separator };
+        auto state{expecting::value};
+        while (true) {
+            skip_ws();
+            if (m_pos == m_length) {
+                return false;
+            }
+            auto c{m_data[m_pos]};
+            switch (state) {
+            case expecting::value:
+                if (c == '{' || c == '[') {
+                    ++m_pos;
+                    skip_ws();
+                    if (consume(c == '{' ? '}' : ']')) {
+                        state = expecting::separator;
+                    } else {
+                        m_stack.push(c == '{');
+                        state = c == '{' ? expecting::member_name
+                                         : expecting::value;
+                    }
+                    break;
+                }
+                if (!skip_scalar(c)) {
+                    return false;
+                }
+                state = expecting::separator;
+                break;
+            case expecting::member_name:
+                if (c != '"' || !skip_string()) {
+                    return false;
+                }
+                skip_ws();
+                if (!consume(':')) {
+                    return false;
+                }
+                state = expecting::value;
+                break;
+            case expecting::separator:
+                if (c == ',') {
+                    ++m_pos;
+                    state = m_stack.is_object() ? expecting::member_name
+                                                : expecting::value;
+                } else if (c == (m_stack.is_object() ? '}' : ']')) {
+                    ++m_pos;
+                    m_stack.pop();
+                } else {
+                    return false;
+                }
+                break;
+            }
+            if (state == expecting::separator && m_stack.empty()) {
+                skip_ws();
+                return m_pos == m_length;
+            }
+        }
+    }
+
+private:
+    unsigned char at(size_t offset) const noexcept {
+        return static_cast<unsigned char>(m_data[offset]);
+    }
+
+    bool consume(char c) noexcept {
+        if (m_pos < m_length && m_data[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void skip_ws() noexcept {
+        while (m_pos < m_length) {
+            auto c{m_data[m_pos]};
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                return;
+            }
+            ++m_pos;
+        }
+    }
+
+    static bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+    static bool is_hex_digit(char c) noexcept {
+        return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    bool skip_digits() noexcept {
+        auto start{m_pos};
+        while (m_pos < m_length && is_digit(m_data[m_pos])) {
+            ++m_pos;
+        }
+        return m_pos > start;
+    }
+
+    bool skip_literal(const char* literal) noexcept {
+        auto length{std::strlen(literal)};
+        if (m_length - m_pos < length ||
+            std::memcmp(m_data + m_pos, literal, length) != 0) {
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+
+    bool skip_number() noexcept {
+        consume('-');
+        if (!consume('0') && !skip_digits()) {
+            return false;
+        }
+        if (consume('.') && !skip_digits()) {
+            return false;
+        }
+        if (consume('e') || consume('E')) {
+            if (!consume('+')) {
+                consume('-');
+            }
+            return skip_digits();
+        }
+        return true;
+    }
+
+    bool skip_scalar(char c) noexcept {
+        switch (c) {
+        case '"':
+            return skip_string();
+        case 't':
+            return skip_literal("true");
+        case 'f':
+            return skip_literal("false");
+        case 'n':
+            return skip_literal("null");
+        default:
+            return (c == '-' || is_digit(c)) && skip_number();
+        }
+    }
+
+    // Whether a word contains a quote, a backslash, a control character or
+    // a byte that is not ASCII.
+    static bool has_special_byte(std::uint64_t word) noexcept {
+        using namespace word_bits;
+        auto has_zero = [](std::uint64_t w) { return (w - ones) & ~w & highs; };
+        auto special{has_zero(word ^ (ones * '"')) |
+                     has_zero(word ^ (ones * '\\')) |
+                     ((word - ones * 0x20U) & ~word & highs) | (word & highs)};
+        return special != 0;
+    }
+
+    bool skip_escape() noexcept {
+        if (m_pos == m_length) {
+            return false;
+        }
+        switch (m_data[m_pos++]) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            return true;
+        case 'u': {
+            // Lone surrogates cannot be encoded in UTF-8, so only pairs are
+            // valid.
+            size_t unit{};
+            if (!skip_code_unit(unit) || is_low_surrogate(unit)) {
+                return false;
+            }
+            if (!is_high_surrogate(unit)) {
+                return true;
+            }
+            return skip_literal("\\u") && skip_code_unit(unit) &&
+                   is_low_surrogate(unit);
+        }
+        default:
+            return false;
+        }
+    }
+
+    // Skips the four hex digits of a UTF-16 code unit.
+    bool skip_code_unit(size_t& result) noexcept {
+        result = 0;
+        for (auto end{m_pos + 4}; m_pos < end; ++m_pos) {
+            if (m_pos == m_length || !is_hex_digit(m_data[m_pos])) {
+                return false;
+            }
+            auto c{m_data[m_pos]};
+            auto digit{is_digit(c) ? c - '0' : (c | 0x20) - 'a' + 10};
+            result = result * 16 + static_cast<size_t>(digit);
+        }
+        return true;
+    }
+
+    bool skip_string() noexcept {
+        ++m_pos;
+        while (true) {
+            while (m_length - m_pos >= sizeof(std::uint64_t) &&
+                   !has_special_byte(load_word(m_data + m_pos))) {
+                m_pos += sizeof(std::uint64_t);
+            }
+            if (m_pos == m_length) {
+                return false;
+            }
+            auto c{at(m_pos)};
+            if (c == '"') {
+                ++m_pos;
+                return true;
+            }
+            if (c == '\\') {
+                ++m_pos;
+                if (!skip_escape()) {
+                    return false;
+                }
+            } else if (c < 0x20U) {
+                return false;
+            } else {
+                auto size{utf8_sequence_length(m_data, m_length, m_pos)};
+                if (size == 0) {
+                    return false;
+                }
+                m_pos += size;
+            }
+        }
+    }
+
+    const char* m_data;
+    size_t m_length;
+    size_t m_pos{};
+    nesting_stack m_stack;
+};
+
+} // namespace detail
+
+/**
+ * Checks whether a character array is a JSON document (RFC 8259) with
+ * strings in valid UTF-8, without building a value tree. As when loading
+ * with UTF-8 validation, escaped UTF-16 surrogates must form pairs.
+ *
+ * The document is scanned once, and plain ASCII in strings a word at a time.
+ * Nothing is allocated unless arrays and objects are nested more than 4096
+ * levels deep.
+ *
+ * @param data The JSON document data.
+ * @param length The length of the JSON document in bytes.
+ * @return Whether the document is valid.
+ */
+inline bool validate(const char* data, size_t length) {
+    return detail::json_validator{data, length}.validate();
+}
+
+/**
+ * Checks whether a null-terminated character array is a JSON document.
+ *
+ * @param data The JSON document data.
+ * @return Whether the document is valid.
+ * @see validate(const char*, size_t)
+ */
+inline bool validate(const char* data) {
+    return validate(data, std::strlen(data));
+}
+
+/**
+ * Checks whether a container such as std::string holds a JSON document.
+ *
+ * @param input The input container.
+ * @return Whether the document is valid.
+ * @see validate(const char*, size_t)
+ */
+template<typename Container,
+         detail::enable_if_t<
+             !std::is_convertible<Container, const char*>::value>* = nullptr>
+inline bool validate(const Container& input) {
+    return validate(input.data(), input.size());
+}
+
+LANGNES_JSON_CXX_NS_END
@@ -20,11 +20,16 @@
 #include "detail/macros.hpp"
 #include "detail/type_traits.hpp"
 #include "detail/value_fwd.hpp"
+#include "memory_resource.hpp"
+#include "span.hpp"
+#include "string_ref.hpp"
 
-#include <deque>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 struct langnes_json_value_t {
     virtual ~langnes_json_value_t() = default;
@@ -32,9 +37,30 @@ struct langnes_json_value_t {
 
 LANGNES_JSON_CXX_NS_BEGIN
 
+class compiled_pointer;
+class value;
+
+namespace detail {
+
+// Whether a to_json() customization point is found for a type.
+template<typename T, typename = void>
+struct has_to_json : std::false_type {};
+
+template<typename T>
+struct has_to_json<T, void_t<decltype(to_json(std::declval<value&>(),
+                                              std::declval<const T&>()))>>
+    : std::true_type {};
+
+} // namespace detail
+
 class value : public langnes_json_value_t {
 public:
     enum class type { object, array, string, number, boolean, null };
+    // Strings and member names allocate from the default memory resource.
+    using string_type =
+        std::basic_string<char, std::char_traits<char>, allocator<char>>;
+    using object_type = detail::dict<string_type, value>;
+    using array_type = std::vector<value, allocator<value>>;
 
     value() noexcept;
     value(const value& rhs) noexcept;
@@ -42,7 +68,8 @@ public:
     explicit value(std::unique_ptr<detail::value_impl_base>&& impl) noexcept;
     explicit value(const char* data) noexcept;
     explicit value(const std::string& data) noexcept;
-    explicit value(std::string&& data) noexcept;
+    explicit value(const string_type& data) noexcept;
+    explicit value(string_type&& data) noexcept;
     explicit value(std::nullptr_t) noexcept;
     ~value() override = default;
 
@@ -58,17 +85,44 @@ public:
                  detail::remove_cvref_t<T>, bool>::value>::type* = nullptr>
     explicit value(T from) noexcept;
 
-    const std::string& as_string() const;
+    // Converts with a to_json(value&, const T&) function found through ADL.
+    template<typename T,
+             detail::enable_if_t<detail::has_to_json<T>::value>* = nullptr>
+    explicit value(const T& from);
+
+    // Converts with a from_json(const value&, T&) function found through
+    // ADL. Contents are moved out of rvalues where possible.
+    template<typename T>
+    T get() const&;
+    template<typename T>
+    T get() &&;
+
+    const string_type& as_string() const;
     double as_number() const;
+    std::int64_t as_int64() const;
+    std::uint64_t as_uint64() const;
     bool as_boolean() const;
-    const detail::dict<std::string, value>& as_object() const;
-    const std::deque<value>& as_array() const;
-
-    std::string& as_string();
+    const object_type& as_object() const;
+    const array_type& as_array() const;
+    // Gets the elements of an array stored packed as contiguous doubles, see
+    // parse_options::pack_numeric_arrays. Empty for other arrays.
+    span<const double> as_number_span() const;
+
+    string_type& as_string();
+    // Numbers stored as integers are converted to floating point.
     double& as_number();
     bool& as_boolean();
-    detail::dict<std::string, value>& as_object();
-    std::deque<value>& as_array();
+    object_type& as_object();
+    array_type& as_array();
+    span<double> as_number_span();
+
+    // Finds an object member, or returns null if not found.
+    const value* find_member(string_ref name) const;
+    value* find_member(string_ref name);
+    // Calls a function with the name and value of each object member in
+    // order.
+    template<typename Fn>
+    void for_each_member(Fn fn) const;
 
     bool is_type(value::type type) const noexcept;
     bool is_string() const noexcept;
@@ -94,14 +148,54 @@ public:
     value& operator=(value&& rhs) noexcept;
     value& operator=(const char* rhs) noexcept;
     value& operator=(const std::string& rhs) noexcept;
-    value& operator=(std::string&& rhs) noexcept;
+    value& operator=(const string_type& rhs) noexcept;
+    value& operator=(string_type&& rhs) noexcept;
     value& operator=(std::nullptr_t) noexcept;
 
     type get_type() const noexcept;
     value clone() const noexcept;
 
+    /**
+     * Computes a hash that is stable across runs and independent of the
+     * order of object members.
+     *
+     * @param cache Whether to cache the hashes of objects and arrays for
+     * later calls to hash(). Mutable access to any value discards all
+     * cached hashes, including those of the values enclosing it, and
+     * operator== uses cached hashes to tell values apart.
+     * @return The hash.
+     */
+    std::uint64_t hash(bool cache = false) const;
+
+    const value& at_pointer(const std::string& pointer) const;
+    value& at_pointer(const std::string& pointer);
+    const value& at_pointer(const compiled_pointer& pointer) const;
+    value& at_pointer(const compiled_pointer& pointer);
+    const value* find_pointer(const std::string& pointer) const;
+    value* find_pointer(const std::string& pointer);
+    const value* find_pointer(const compiled_pointer& pointer) const noexcept;
+    value* find_pointer(const compiled_pointer& pointer);
+
+    /// @cond
+    const detail::value_impl_base& impl() const noexcept { return *m_impl; }
+    detail::value_impl_base& impl() noexcept { return *m_impl; }
+    /// @endcond
+
+    // Allocate from the default memory resource.
+    static void* operator new(size_t size) {
+        return detail::resource_new(size);
+    }
+    static void* operator new(size_t /*size*/, void* p) noexcept { return p; }
+    static void operator delete(void* p, size_t size) noexcept {
+        detail::resource_delete(p, size);
+    }
+    static void operator delete(void* /*p*/, void* /*place*/) noexcept {}
+
 private:
     std::unique_ptr<detail::value_impl_base> m_impl;
 };
 
+bool operator==(const value& lhs, const value& rhs);
+bool operator!=(const value& lhs, const value& rhs);
+
 LANGNES_JSON_CXX_NS_END
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2024 Steffen André Langnes
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/json.hpp"
+#include "detail/macros.hpp"
+#include "detail/type_traits.hpp"
+#include "detail/value_impl.hpp"
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+LANGNES_JSON_CXX_NS_BEGIN
+
+/**
+ * Writes a JSON document piece by piece directly to a stream without
+ * building a value tree.
+ *
+ * Separators and escaping are handled by the writer. With nesting
+ * validation enabled, calls that would produce invalid JSON throw
+ * invalid_state instead of writing anything.
+ */
+class writer {
+public:
+    /**
+     * Constructs a writer.
+     *
+     * @param os The output stream, which must outlive the writer.
+     * @param validate_nesting Whether to validate the order of calls.
+     */
+    explicit writer(std::ostream& os, bool validate_nesting = true)
+        : m_os{os},
+          m_validate{validate_nesting} {}
+
+    /**
+     * Begins writing an object.
+     *
+     * @return The writer.
+     */
+    writer& begin_object() {
+        begin_value();
+        m_stack.push_back(frame{true, true});
+        m_os.put('{');
+        return *this;
+    }
+
+    /**
+     * Ends writing an object.
+     *
+     * @return The writer.
+     */
+    writer& end_object() {
+        end_container(true);
+        m_os.put('}');
+        return *this;
+    }
+
+    /**
+     * Begins writing an array.
+     *
+     * @return The writer.
+     */
+    writer& begin_array() {
+        begin_value();
+        m_stack.push_back(frame{false, true});
+        m_os.put('[');
+        return *this;
+    }
+
+    /**
+     * Ends writing an array.
+     *
+     * @return The writer.
+     */
+    writer& end_array() {
+        end_container(false);
+        m_os.put(']');
+        return *this;
+    }
+
+    /**
+     * Writes the name of the next object member.
+     *
+     * @param data The member name.
+     * @param length The length of the member name in bytes.
+     * @return The writer.
+     */
+    writer& key(const char* data, size_t length) {
+        auto in_object{!m_stack.empty() && m_stack.back().is_object};
+        if (m_validate && (!in_object || m_after_key)) {
+            throw invalid_state{"Unexpected object member name"};
+        }
+        put_separator();
+        detail::write_escaped(m_os, data, length);
+        m_os.put(':');
+        m_after_key = true;
+        return *this;
+    }
+
+    /// @copydoc key(const char*, size_t)
+    writer& key(const char* data) { return key(data, std::strlen(data)); }
+
+    /// @copydoc key(const char*, size_t)
+    writer& key(const std::string& data) {
+        return key(data.data(), data.size());
+    }
+
+    /**
+     * Writes a string.
+     *
+     * @param data The string.
+     * @param length The length of the string in bytes.
+     * @return The writer.
+     */
+    writer& string(const char* data, size_t length) {
+        begin_value();
+        detail::write_escaped(m_os, data, length);
+        return *this;
+    }
+
+    /// @copydoc string(const char*, size_t)
+    writer& string(const char* data) {
+        return string(data, std::strlen(data));
+    }
+
+    /// @copydoc string(const char*, size_t)
+    writer& string(const std::string& data) {
+        return string(data.data(), data.size());
+    }
+
+    /**
+     * Writes a number.
+     *
+     * @param v The number.
+     * @return The writer.
+     * @throw invalid_argument if the number is not finite.
+     */
+    writer& number(double v) {
+        if (!std::isfinite(v)) {
+            throw invalid_argument{};
+        }
+        begin_value();
+        detail::write_number(m_os, v);
+        return *this;
+    }
+
+    /**
+     * Writes an integer exactly.
+     *
+     * @param v The integer.
+     * @return The writer.
+     */
+    template<typename T,
+             detail::enable_if_t<
+                 std::is_integral<T>::value &&
+                 !std::is_same<detail::remove_cvref_t<T>, bool>::value>* =
+                 nullptr>
+    writer& number(T v) {
+        begin_value();
+        detail::write_number(m_os, detail::number_impl{v});
+        return *this;
+    }
+
+    /**
+     * Writes a boolean.
+     *
+     * @param v The boolean.
+     * @return The writer.
+     */
+    writer& boolean(bool v) {
+        begin_value();
+        m_os << (v ? "true" : "false");
+        return *this;
+    }
+
+    /**
+     * Writes null.
+     *
+     * @return The writer.
+     */
+    writer& null() {
+        begin_value();
+        m_os << "null";
+        return *this;
+    }
+
+    /**
+     * Writes an existing JSON value.
+     *
+     * @param v The JSON value.
+     * @return The writer.
+     */
+    writer& write(const value& v) {
+        begin_value();
+        detail::to_json(m_os, v);
+        return *this;
+    }
+
+    /**
+     * Checks whether a complete JSON document has been written.
+     *
+     * @return Whether a top-level value has been written and all objects and
+     * arrays have been ended.
+     */
+    bool is_complete() const noexcept {
+        return m_has_root && m_stack.empty();
+    }
+
+private:
+    struct frame {
+        bool is_object;
+        bool is_empty;
+    };
+
+    void put_separator() {
+        if (m_stack.empty()) {
+            return;
+        }
+        if (!m_stack.back().is_empty) {
+            m_os.put(',');
+        }
+        m_stack.back().is_empty = false;
+    }
+
+    void begin_value() {
+        if (m_stack.empty()) {
+            if (m_validate && m_has_root) {
+                throw invalid_state{"Only one top-level value is allowed"};
+            }
+            m_has_root = true;
+            return;
+        }
+        if (m_stack.back().is_object) {
+            if (m_validate && !m_after_key) {
+                throw invalid_state{"Expected an object member name"};
+            }
+            m_after_key = false;
+            return;
+        }
+        put_separator();
+    }
+
+    void end_container(bool is_object) {
+        if (m_validate && (m_stack.empty() || m_after_key ||
+                           m_stack.back().is_object != is_object)) {
+            throw invalid_state{is_object ? "Unexpected end of object"
+                                          : "Unexpected end of array"};
+        }
+        if (!m_stack.empty()) {
+            m_stack.pop_back();
+        }
+        m_after_key = false;
+    }
+
+    std::ostream& m_os;
+    bool m_validate;
+    bool m_has_root{};
+    bool m_after_key{};
+    std::vector<frame> m_stack;
+};
+
+LANGNES_JSON_CXX_NS_END
@@ -16,12 +16,25 @@
 #include "langnes_json/json.h"
 #include "langnes_json/json.hpp"
 
+#include <cstddef>
 #include <cstdlib>
+#include <deque>
 #include <exception>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <sstream>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
 #include <utility>
+#include <vector>
+
+LANGNES_JSON_API const langnes_json_error_code_t
+    langnes_json_error_validation_error =
+        static_cast<langnes_json_error_code_t>(
+            LANGNES_JSON_CXX_NS::error_code::validation_error);
 
 LANGNES_JSON_API const langnes_json_error_code_t
     langnes_json_error_parse_error = static_cast<langnes_json_error_code_t>(
@@ -76,6 +89,20 @@ langnes_json_error_code_t filter_error(WorkFn do_work) noexcept {
     }
 }
 
+parse_options
+to_parse_options(const langnes_json_parse_options_t* options) noexcept {
+    parse_options result;
+    if (options) {
+        result.max_depth = options->max_depth;
+        result.max_string_length = options->max_string_length;
+        result.raw_numbers = options->raw_numbers;
+        result.pack_numeric_arrays = options->pack_numeric_arrays;
+        result.share_object_shapes = options->share_object_shapes;
+        result.validate_utf8 = options->validate_utf8;
+    }
+    return result;
+}
+
 void free_object_members(langnes_json_object_member_t* members,
                          size_t length) noexcept {
     for (size_t i{}; i < length; ++i) {
@@ -91,6 +118,267 @@ void free_values(langnes_json_value_t** values, size_t length) noexcept {
     }
 }
 
+class c_memory_resource : public memory_resource {
+public:
+    c_memory_resource(langnes_json_malloc_fn_t malloc_fn,
+                      langnes_json_free_fn_t free_fn, void* ctx) noexcept
+        : m_malloc{malloc_fn},
+          m_free{free_fn},
+          m_ctx{ctx} {}
+
+    bool uses(langnes_json_malloc_fn_t malloc_fn,
+              langnes_json_free_fn_t free_fn, void* ctx) const noexcept {
+        return m_malloc == malloc_fn && m_free == free_fn && m_ctx == ctx;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (alignment > alignof(std::max_align_t)) {
+            throw std::bad_alloc{};
+        }
+        if (auto* p{m_malloc(bytes, m_ctx)}) {
+            return p;
+        }
+        throw std::bad_alloc{};
+    }
+
+    void do_deallocate(void* p, size_t /*bytes*/,
+                       size_t /*alignment*/) noexcept override {
+        m_free(p, m_ctx);
+    }
+
+private:
+    langnes_json_malloc_fn_t m_malloc;
+    langnes_json_free_fn_t m_free;
+    void* m_ctx;
+};
+
+// Passes output to a C write function in chunks, or collects it if there is
+// no write function.
+class c_writer_streambuf : public std::streambuf {
+public:
+    c_writer_streambuf(langnes_json_write_fn_t write_fn, void* ctx)
+        : m_write{write_fn},
+          m_ctx{ctx} {
+        if (m_write) {
+            m_buffer.resize(buffer_size);
+            setp(&m_buffer[0], &m_buffer[0] + m_buffer.size());
+        }
+    }
+
+    bool collects_output() const noexcept { return !m_write; }
+    const std::string& output() const noexcept { return m_output; }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (m_write) {
+            write_buffer();
+        }
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        if (m_write) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        } else {
+            m_output += traits_type::to_char_type(c);
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (m_write) {
+            return std::streambuf::xsputn(s, n);
+        }
+        m_output.append(s, static_cast<size_t>(n));
+        return n;
+    }
+
+    int sync() override {
+        if (m_write) {
+            write_buffer();
+        }
+        return 0;
+    }
+
+private:
+    static constexpr size_t buffer_size{4096};
+
+    void write_buffer() {
+        auto length{static_cast<size_t>(pptr() - pbase())};
+        if (length > 0) {
+            m_write(pbase(), length, m_ctx);
+        }
+        setp(pbase(), epptr());
+    }
+
+    langnes_json_write_fn_t m_write;
+    void* m_ctx;
+    std::string m_buffer;
+    std::string m_output;
+};
+
+class c_writer {
+public:
+    c_writer(langnes_json_write_fn_t write_fn, void* ctx,
+             bool validate_nesting)
+        : m_buf{write_fn, ctx},
+          m_os{&m_buf},
+          m_writer{m_os, validate_nesting} {}
+
+    c_writer(const c_writer&) = delete;
+    c_writer(c_writer&&) = delete;
+    c_writer& operator=(const c_writer&) = delete;
+    c_writer& operator=(c_writer&&) = delete;
+    ~c_writer() { m_os.flush(); }
+
+    writer& get() noexcept { return m_writer; }
+    c_writer_streambuf& buf() noexcept { return m_buf; }
+    void flush() { m_os.flush(); }
+
+private:
+    c_writer_streambuf m_buf;
+    std::ostream m_os;
+    writer m_writer;
+};
+
+template<typename WorkFn>
+langnes_json_error_code_t with_writer(langnes_json_writer_t* w,
+                                      WorkFn do_work) noexcept {
+    return filter_error([&] {
+        if (!w) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        do_work(*reinterpret_cast<c_writer*>(w));
+    });
+}
+
+template<typename WorkFn>
+langnes_json_error_code_t with_columns(langnes_json_columns_t* columns,
+                                       WorkFn do_work) noexcept {
+    return filter_error([&] {
+        if (!columns) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        do_work(*reinterpret_cast<std::vector<column>*>(columns));
+    });
+}
+
+template<typename WorkFn>
+langnes_json_error_code_t
+with_query_results(langnes_json_query_results_t* results,
+                   WorkFn do_work) noexcept {
+    return filter_error([&] {
+        if (!results) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        do_work(*reinterpret_cast<std::vector<const value*>*>(results));
+    });
+}
+
+template<typename WorkFn>
+langnes_json_error_code_t
+with_msgpack_decoder(langnes_json_msgpack_decoder_t* decoder,
+                     WorkFn do_work) noexcept {
+    return filter_error([&] {
+        if (!decoder) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        do_work(*reinterpret_cast<msgpack_decoder*>(decoder));
+    });
+}
+
+// Strings handed out through the C API have the type of string values, so
+// that the string of a value can be handed out in place.
+langnes_json_string_t* new_c_string(const std::string& s) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return reinterpret_cast<langnes_json_string_t*>(
+        new value::string_type(s.data(), s.size()));
+}
+
+element to_element(langnes_json_element_t e) {
+    if (!e.image) {
+        throw invalid_argument{};
+    }
+    return element{static_cast<const snapshot_image*>(e.image), e.index};
+}
+
+langnes_json_element_t to_c_element(const element& e) noexcept {
+    return langnes_json_element_t{e.image(), e.index()};
+}
+
+template<typename WorkFn>
+langnes_json_error_code_t with_element(langnes_json_element_t e,
+                                       WorkFn do_work) noexcept {
+    return filter_error([&] { do_work(to_element(e)); });
+}
+
+// Whether a value is within a tree of values, including its root. Packed
+// arrays hold no separate values to look for.
+bool contains_value(const value& root, const value* v) {
+    std::vector<const value*> pending{&root};
+    while (!pending.empty()) {
+        const auto* current{pending.back()};
+        pending.pop_back();
+        if (current == v) {
+            return true;
+        }
+        if (current->is_object()) {
+            current->for_each_member(
+                [&](const value::string_type& /*name*/, const value& member) {
+                    pending.push_back(&member);
+                });
+        } else if (current->is_array() &&
+                   !dynamic_cast<const array_impl&>(current->impl())
+                        .is_packed()) {
+            for (const auto& element : current->as_array()) {
+                pending.push_back(&element);
+            }
+        }
+    }
+    return false;
+}
+
+// Gets the values buffer of a column in the layout of the C API.
+const void* get_column_values(const column& c) noexcept {
+    switch (c.type) {
+    case column_type::boolean:
+        return c.boolean_values.data();
+    case column_type::int64:
+        return c.int64_values.data();
+    case column_type::uint64:
+        return c.uint64_values.data();
+    case column_type::float64:
+        return c.float64_values.data();
+    case column_type::string:
+    case column_type::json:
+        return c.string_data.data();
+    default:
+        return nullptr;
+    }
+}
+
+// Gets a resource for the given functions. Resources are never destroyed
+// because existing values may still reference them.
+memory_resource* get_c_memory_resource(langnes_json_malloc_fn_t malloc_fn,
+                                       langnes_json_free_fn_t free_fn,
+                                       void* ctx) {
+    static std::mutex mutex;
+    static auto* resources{new std::deque<c_memory_resource>};
+    std::lock_guard<std::mutex> lock{mutex};
+    for (auto& resource : *resources) {
+        if (resource.uses(malloc_fn, free_fn, ctx)) {
+            return &resource;
+        }
+    }
+    resources->emplace_back(malloc_fn, free_fn, ctx);
+    return &resources->back();
+}
+
 // NOLINTNEXTLINE(bugprone-exception-escape) - should never throw
 void set_object_members(value& object, langnes_json_object_member_t* members,
                         size_t length) noexcept {
@@ -114,6 +402,7 @@ void set_array_elements(value& array, langnes_json_value_t** elements,
         std::terminate();
     }
     auto& elements_{array.as_array()};
+    elements_.reserve(elements_.size() + length);
     for (size_t i{}; i < length; ++i) {
         // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
         auto* element{required_dynamic_cast<value*>(elements[i])};
@@ -141,6 +430,23 @@ LANGNES_JSON_API bool langnes_json_failed(langnes_json_error_code_t ec) {
     return !langnes_json_succeeded(ec);
 }
 
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_set_allocator(langnes_json_malloc_fn_t malloc_fn,
+                           langnes_json_free_fn_t free_fn, void* ctx) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!malloc_fn && !free_fn) {
+            set_default_resource(nullptr);
+            return;
+        }
+        if (!malloc_fn || !free_fn) {
+            throw invalid_argument{};
+        }
+        set_default_resource(get_c_memory_resource(malloc_fn, free_fn, ctx));
+    });
+}
+
 LANGNES_JSON_API langnes_json_error_code_t langnes_json_load_from_cstring(
     const char* input, langnes_json_value_t** result) {
     using namespace LANGNES_JSON_CXX_NS;
@@ -153,6 +459,39 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_load_from_cstring(
     });
 }
 
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_load_from_buffer(
+    const char* data, size_t length,
+    const langnes_json_parse_options_t* options,
+    langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!data || !result) {
+            throw invalid_argument{};
+        }
+        *result = new value{load(data, length, to_parse_options(options))};
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_validate(const char* data, size_t length, bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!data || !result) {
+            throw invalid_argument{};
+        }
+        *result = validate(data, length);
+    });
+}
+
+LANGNES_JSON_API bool langnes_json_validate_s(const char* data,
+                                              size_t length) {
+    bool result{};
+    langnes_json_check_error(langnes_json_validate(data, length, &result));
+    return result;
+}
+
 LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_to_string(
     langnes_json_value_t* json_value, langnes_json_string_t** result) {
     using namespace LANGNES_JSON_CXX_NS;
@@ -161,9 +500,25 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_to_string(
         if (!json_value || !result) {
             throw invalid_argument{};
         }
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        *result = reinterpret_cast<langnes_json_string_t*>(
-            new std::string{save(*required_dynamic_cast<value*>(json_value))});
+        *result =
+            new_c_string(save(*required_dynamic_cast<value*>(json_value)));
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_to_buffer(langnes_json_value_t* json_value, char* buffer,
+                            size_t buffer_size, size_t* required_size) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || (!buffer && buffer_size > 0) || !required_size) {
+            throw invalid_argument{};
+        }
+        *required_size = save(*required_dynamic_cast<value*>(json_value),
+                              buffer, buffer_size);
+        if (*required_size > buffer_size) {
+            throw out_of_range{"Buffer is too small"};
+        }
     });
 }
 
@@ -232,6 +587,91 @@ langnes_json_value_clone_s(langnes_json_value_t* json_value) {
     return result;
 }
 
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_equals(langnes_json_value_t* lhs, langnes_json_value_t* rhs,
+                          bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!lhs || !rhs || !result) {
+            throw invalid_argument{};
+        }
+        *result = *required_dynamic_cast<value*>(lhs) ==
+                  *required_dynamic_cast<value*>(rhs);
+    });
+}
+
+LANGNES_JSON_API bool langnes_json_value_equals_s(langnes_json_value_t* lhs,
+                                                  langnes_json_value_t* rhs) {
+    bool result{};
+    langnes_json_check_error(langnes_json_value_equals(lhs, rhs, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_hash(
+    langnes_json_value_t* json_value, bool cache, uint64_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        *result = required_dynamic_cast<value*>(json_value)->hash(cache);
+    });
+}
+
+LANGNES_JSON_API uint64_t
+langnes_json_value_hash_s(langnes_json_value_t* json_value, bool cache) {
+    uint64_t result{};
+    langnes_json_check_error(
+        langnes_json_value_hash(json_value, cache, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_get_by_pointer(
+    langnes_json_value_t* json_value, const char* pointer,
+    langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !pointer || !result) {
+            throw invalid_argument{};
+        }
+        *result = std::addressof(
+            required_dynamic_cast<value*>(json_value)->at_pointer(pointer));
+    });
+}
+
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_value_get_by_pointer_s(langnes_json_value_t* json_value,
+                                    const char* pointer) {
+    langnes_json_value_t* result{};
+    langnes_json_check_error(
+        langnes_json_value_get_by_pointer(json_value, pointer, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_merge_patch(
+    langnes_json_value_t* target, langnes_json_value_t* patch) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!target || !patch) {
+            throw invalid_argument{};
+        }
+        auto& target_value{*required_dynamic_cast<value*>(target)};
+        auto& patch_value{*required_dynamic_cast<value*>(patch)};
+        // The patch cannot be taken over if it is part of the target or the
+        // other way around.
+        if (contains_value(target_value, &patch_value) ||
+            contains_value(patch_value, &target_value)) {
+            throw invalid_argument{};
+        }
+        merge_patch(target_value, std::move(patch_value));
+        langnes_json_value_free(patch);
+    });
+}
+
 //
 // String
 //
@@ -245,7 +685,7 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_string_get_cstring(
             throw invalid_argument{};
         }
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        *result = reinterpret_cast<const std::string*>(str)->c_str();
+        *result = reinterpret_cast<const value::string_type*>(str)->c_str();
     });
 }
 
@@ -265,7 +705,7 @@ langnes_json_string_get_length(langnes_json_string_t* str, size_t* result) {
             throw invalid_argument{};
         }
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        *result = reinterpret_cast<const std::string*>(str)->size();
+        *result = reinterpret_cast<const value::string_type*>(str)->size();
     });
 }
 
@@ -281,8 +721,9 @@ langnes_json_string_free(langnes_json_string_t* str) {
     if (!str) {
         return langnes_json_error_invalid_argument;
     }
+    using string_type = LANGNES_JSON_CXX_NS::value::string_type;
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    delete reinterpret_cast<std::string*>(str);
+    delete reinterpret_cast<string_type*>(str);
     return langnes_json_error_ok;
 }
 
@@ -300,7 +741,7 @@ langnes_json_value_string_new_with_string(langnes_json_string_t* str,
             throw invalid_argument{};
         }
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        *result = new value{*reinterpret_cast<std::string*>(str)};
+        *result = new value{*reinterpret_cast<value::string_type*>(str)};
     });
 }
 
@@ -482,12 +923,8 @@ langnes_json_value_set_number(langnes_json_value_t* json_value, double value) {
     });
 }
 
-//
-// JSON boolean
-//
-
-LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_boolean_new(bool value, langnes_json_value_t** result) {
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_number_new_int64(
+    int64_t value, langnes_json_value_t** result) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
@@ -499,130 +936,239 @@ langnes_json_value_boolean_new(bool value, langnes_json_value_t** result) {
 }
 
 LANGNES_JSON_API langnes_json_value_t*
-langnes_json_value_boolean_new_s(bool value) {
+langnes_json_value_number_new_int64_s(int64_t value) {
     langnes_json_value_t* result{};
-    langnes_json_check_error(langnes_json_value_boolean_new(value, &result));
-    return result;
-}
-
-LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_is_boolean(langnes_json_value_t* json_value, bool* result) {
-    using namespace LANGNES_JSON_CXX_NS;
-    using namespace LANGNES_JSON_CXX_NS::detail;
-    return filter_error([&] {
-        if (!json_value || !result) {
-            throw invalid_argument{};
-        }
-        *result = required_dynamic_cast<value*>(json_value)->is_boolean();
-    });
-}
-
-LANGNES_JSON_API bool
-langnes_json_value_is_boolean_s(langnes_json_value_t* json_value) {
-    bool result{};
     langnes_json_check_error(
-        langnes_json_value_is_boolean(json_value, &result));
+        langnes_json_value_number_new_int64(value, &result));
     return result;
 }
 
-LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_get_boolean(langnes_json_value_t* json_value, bool* result) {
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_get_int64(
+    langnes_json_value_t* json_value, int64_t* result) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
         if (!json_value || !result) {
             throw invalid_argument{};
         }
-        *result = required_dynamic_cast<value*>(json_value)->as_boolean();
+        *result = required_dynamic_cast<value*>(json_value)->as_int64();
     });
 }
 
-LANGNES_JSON_API bool
-langnes_json_value_get_boolean_s(langnes_json_value_t* json_value) {
-    bool result{};
-    langnes_json_check_error(
-        langnes_json_value_get_boolean(json_value, &result));
+LANGNES_JSON_API int64_t
+langnes_json_value_get_int64_s(langnes_json_value_t* json_value) {
+    int64_t result{};
+    langnes_json_check_error(langnes_json_value_get_int64(json_value, &result));
     return result;
 }
 
 LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_set_boolean(langnes_json_value_t* json_value, bool value) {
+langnes_json_value_set_int64(langnes_json_value_t* json_value, int64_t value) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
         if (!json_value) {
             throw invalid_argument{};
         }
-        *required_dynamic_cast<class value*>(json_value) = value;
+        auto* value_{required_dynamic_cast<class value*>(json_value)};
+        *value_ = value;
     });
 }
 
-//
-// JSON null
-//
-
-LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_null_new(langnes_json_value_t** result) {
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_number_new_uint64(
+    uint64_t value, langnes_json_value_t** result) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
         if (!result) {
             throw invalid_argument{};
         }
-        *result = new LANGNES_JSON_CXX_NS::value{nullptr};
+        *result = new LANGNES_JSON_CXX_NS::value{value};
     });
 }
 
-LANGNES_JSON_API langnes_json_value_t* langnes_json_value_null_new_s() {
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_value_number_new_uint64_s(uint64_t value) {
     langnes_json_value_t* result{};
-    langnes_json_check_error(langnes_json_value_null_new(&result));
+    langnes_json_check_error(
+        langnes_json_value_number_new_uint64(value, &result));
     return result;
 }
 
-LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_is_null(langnes_json_value_t* json_value, bool* result) {
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_get_uint64(
+    langnes_json_value_t* json_value, uint64_t* result) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
         if (!json_value || !result) {
             throw invalid_argument{};
         }
-        *result = required_dynamic_cast<value*>(json_value)->is_null();
+        *result = required_dynamic_cast<value*>(json_value)->as_uint64();
     });
 }
 
-LANGNES_JSON_API bool
-langnes_json_value_is_null_s(langnes_json_value_t* json_value) {
-    bool result{};
-    langnes_json_check_error(langnes_json_value_is_null(json_value, &result));
+LANGNES_JSON_API uint64_t
+langnes_json_value_get_uint64_s(langnes_json_value_t* json_value) {
+    uint64_t result{};
+    langnes_json_check_error(
+        langnes_json_value_get_uint64(json_value, &result));
     return result;
 }
 
-LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_set_null(langnes_json_value_t* json_value) {
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_set_uint64(
+    langnes_json_value_t* json_value, uint64_t value) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
         if (!json_value) {
             throw invalid_argument{};
         }
-        *required_dynamic_cast<value*>(json_value) = nullptr;
+        auto* value_{required_dynamic_cast<class value*>(json_value)};
+        *value_ = value;
     });
 }
 
 //
-// JSON object
+// JSON boolean
 //
 
 LANGNES_JSON_API langnes_json_error_code_t
-langnes_json_value_object_new(langnes_json_value_t** result) {
+langnes_json_value_boolean_new(bool value, langnes_json_value_t** result) {
     using namespace LANGNES_JSON_CXX_NS;
     using namespace LANGNES_JSON_CXX_NS::detail;
     return filter_error([&] {
         if (!result) {
             throw invalid_argument{};
         }
-        *result = new value{make_object({})};
+        *result = new LANGNES_JSON_CXX_NS::value{value};
+    });
+}
+
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_value_boolean_new_s(bool value) {
+    langnes_json_value_t* result{};
+    langnes_json_check_error(langnes_json_value_boolean_new(value, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_is_boolean(langnes_json_value_t* json_value, bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        *result = required_dynamic_cast<value*>(json_value)->is_boolean();
+    });
+}
+
+LANGNES_JSON_API bool
+langnes_json_value_is_boolean_s(langnes_json_value_t* json_value) {
+    bool result{};
+    langnes_json_check_error(
+        langnes_json_value_is_boolean(json_value, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_get_boolean(langnes_json_value_t* json_value, bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        *result = required_dynamic_cast<value*>(json_value)->as_boolean();
+    });
+}
+
+LANGNES_JSON_API bool
+langnes_json_value_get_boolean_s(langnes_json_value_t* json_value) {
+    bool result{};
+    langnes_json_check_error(
+        langnes_json_value_get_boolean(json_value, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_set_boolean(langnes_json_value_t* json_value, bool value) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value) {
+            throw invalid_argument{};
+        }
+        *required_dynamic_cast<class value*>(json_value) = value;
+    });
+}
+
+//
+// JSON null
+//
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_null_new(langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = new LANGNES_JSON_CXX_NS::value{nullptr};
+    });
+}
+
+LANGNES_JSON_API langnes_json_value_t* langnes_json_value_null_new_s() {
+    langnes_json_value_t* result{};
+    langnes_json_check_error(langnes_json_value_null_new(&result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_is_null(langnes_json_value_t* json_value, bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        *result = required_dynamic_cast<value*>(json_value)->is_null();
+    });
+}
+
+LANGNES_JSON_API bool
+langnes_json_value_is_null_s(langnes_json_value_t* json_value) {
+    bool result{};
+    langnes_json_check_error(langnes_json_value_is_null(json_value, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_set_null(langnes_json_value_t* json_value) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value) {
+            throw invalid_argument{};
+        }
+        *required_dynamic_cast<value*>(json_value) = nullptr;
+    });
+}
+
+//
+// JSON object
+//
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_object_new(langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = new value{make_object({})};
     });
 }
 
@@ -689,9 +1235,13 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_object_get_value(
         if (!json_object || !member_name || !result) {
             throw invalid_argument{};
         }
-        *result = std::addressof(required_dynamic_cast<value*>(json_object)
-                                     ->as_object()
-                                     .at(member_name));
+        auto* member{
+            required_dynamic_cast<value*>(json_object)->find_member(
+                member_name)};
+        if (!member) {
+            throw out_of_range{"Member not found"};
+        }
+        *result = member;
     });
 }
 
@@ -760,8 +1310,12 @@ langnes_json_value_object_get_members_length(langnes_json_value_t* json_object,
         if (!json_object || !result) {
             throw invalid_argument{};
         }
-        *result =
-            required_dynamic_cast<value*>(json_object)->as_object().size();
+        const auto& object{*required_dynamic_cast<value*>(json_object)};
+        if (!object.is_object()) {
+            throw bad_access{};
+        }
+        // Keeps a shared object shape, unlike as_object().
+        *result = dynamic_cast<const object_impl&>(object.impl()).size();
     });
 }
 
@@ -782,11 +1336,14 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_object_get_member(
         if (!json_object || !result) {
             throw invalid_argument{};
         }
-        auto& entry{required_dynamic_cast<value*>(json_object)
-                        ->as_object()
-                        .entry_at(index)};
-        *result = langnes_json_object_member_t{entry.first.c_str(),
-                                               std::addressof(entry.second)};
+        auto& object{*required_dynamic_cast<value*>(json_object)};
+        if (!object.is_object()) {
+            throw bad_access{};
+        }
+        // Keeps a shared object shape, unlike as_object().
+        auto member{dynamic_cast<object_impl&>(object.impl()).member_at(index)};
+        *result =
+            langnes_json_object_member_t{member.first->c_str(), member.second};
     });
 }
 
@@ -889,7 +1446,12 @@ LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_get_length(
         if (!json_array || !result) {
             throw invalid_argument{};
         }
-        *result = required_dynamic_cast<value*>(json_array)->as_array().size();
+        const auto& array{*required_dynamic_cast<value*>(json_array)};
+        if (!array.is_array()) {
+            throw bad_access{};
+        }
+        // Keeps a packed array packed, unlike as_array().
+        *result = dynamic_cast<const array_impl&>(array.impl()).size();
     });
 }
 
@@ -913,6 +1475,18 @@ langnes_json_value_array_clear(langnes_json_value_t* json_array) {
     });
 }
 
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_reserve(
+    langnes_json_value_t* json_array, size_t capacity) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_array) {
+            throw invalid_argument{};
+        }
+        required_dynamic_cast<value*>(json_array)->as_array().reserve(capacity);
+    });
+}
+
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_value_array_push(langnes_json_value_t* json_array,
                               langnes_json_value_t* json_array_element) {
@@ -951,6 +1525,36 @@ langnes_json_value_array_get_item_s(langnes_json_value_t* value, size_t index) {
     return result;
 }
 
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_get_view(
+    langnes_json_value_t* json_array, langnes_json_array_view_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_array || !result) {
+            throw invalid_argument{};
+        }
+        auto& elements{required_dynamic_cast<value*>(json_array)->as_array()};
+        result->data = elements.empty() ? nullptr : elements.data();
+        result->stride = sizeof(value);
+        result->length = elements.size();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_value_array_get_numbers(
+    langnes_json_value_t* json_array, const double** data, size_t* length) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_array || !data || !length) {
+            throw invalid_argument{};
+        }
+        const auto* array{required_dynamic_cast<value*>(json_array)};
+        auto numbers{array->as_number_span()};
+        *data = numbers.empty() ? nullptr : numbers.data();
+        *length = numbers.size();
+    });
+}
+
 LANGNES_JSON_API langnes_json_error_code_t
 langnes_json_value_set_array(langnes_json_value_t* json_array) {
     using namespace LANGNES_JSON_CXX_NS;
@@ -984,4 +1588,825 @@ langnes_json_value_set_array_with_elements(langnes_json_value_t* json_array,
     });
 }
 
+//
+// Writer
+//
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_new(langnes_json_write_fn_t write_fn, void* ctx,
+                        bool validate_nesting, langnes_json_writer_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_writer_t*>(
+            new c_writer{write_fn, ctx, validate_nesting});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_free(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    if (!writer) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<c_writer*>(writer);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_flush(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [](c_writer& w) { w.flush(); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_writer_get_output(
+    langnes_json_writer_t* writer, const char** data, size_t* length) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) {
+        if (!data || !length) {
+            throw invalid_argument{};
+        }
+        if (!w.buf().collects_output()) {
+            throw invalid_state{"Output is passed to the write function"};
+        }
+        *data = w.buf().output().data();
+        *length = w.buf().output().size();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_is_complete(langnes_json_writer_t* writer, bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = w.get().is_complete();
+    });
+}
+
+LANGNES_JSON_API bool
+langnes_json_writer_is_complete_s(langnes_json_writer_t* writer) {
+    bool result{};
+    langnes_json_check_error(langnes_json_writer_is_complete(writer, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_begin_object(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [](c_writer& w) { w.get().begin_object(); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_end_object(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [](c_writer& w) { w.get().end_object(); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_begin_array(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [](c_writer& w) { w.get().begin_array(); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_end_array(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [](c_writer& w) { w.get().end_array(); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_key(langnes_json_writer_t* writer, const char* key) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) {
+        if (!key) {
+            throw invalid_argument{};
+        }
+        w.get().key(key);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_string(langnes_json_writer_t* writer, const char* data) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) {
+        if (!data) {
+            throw invalid_argument{};
+        }
+        w.get().string(data);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_number(langnes_json_writer_t* writer, double number) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) { w.get().number(number); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_int64(langnes_json_writer_t* writer, int64_t number) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) { w.get().number(number); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_uint64(langnes_json_writer_t* writer, uint64_t number) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) { w.get().number(number); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_boolean(langnes_json_writer_t* writer, bool boolean) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) { w.get().boolean(boolean); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_writer_null(langnes_json_writer_t* writer) {
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [](c_writer& w) { w.get().null(); });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_writer_value(
+    langnes_json_writer_t* writer, langnes_json_value_t* json_value) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_writer(writer, [&](c_writer& w) {
+        if (!json_value) {
+            throw invalid_argument{};
+        }
+        w.get().write(*required_dynamic_cast<value*>(json_value));
+    });
+}
+
+//
+// Columns
+//
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_value_to_columns(langnes_json_value_t* json_array,
+                              size_t max_threads,
+                              langnes_json_columns_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_array || !result) {
+            throw invalid_argument{};
+        }
+        auto columns{to_columns(*required_dynamic_cast<value*>(json_array),
+                                max_threads)};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_columns_t*>(
+            new std::vector<column>{std::move(columns)});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_columns_free(langnes_json_columns_t* columns) {
+    using namespace LANGNES_JSON_CXX_NS;
+    if (!columns) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<std::vector<column>*>(columns);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_columns_get_length(langnes_json_columns_t* columns,
+                                size_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_columns(columns, [&](std::vector<column>& c) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = c.size();
+    });
+}
+
+LANGNES_JSON_API size_t
+langnes_json_columns_get_length_s(langnes_json_columns_t* columns) {
+    size_t result{};
+    langnes_json_check_error(langnes_json_columns_get_length(columns, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_columns_get_column(langnes_json_columns_t* columns, size_t index,
+                                langnes_json_column_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_columns(columns, [&](std::vector<column>& c) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        const auto& source{c.at(index)};
+        auto is_string{source.type == column_type::string ||
+                       source.type == column_type::json};
+        *result = langnes_json_column_t{
+            source.name.c_str(),
+            static_cast<langnes_json_column_type_t>(source.type),
+            source.length,
+            source.null_count,
+            source.validity.empty() ? nullptr : source.validity.data(),
+            get_column_values(source),
+            is_string ? source.offsets.data() : nullptr};
+    });
+}
+
+LANGNES_JSON_API langnes_json_column_t
+langnes_json_columns_get_column_s(langnes_json_columns_t* columns,
+                                  size_t index) {
+    langnes_json_column_t result{};
+    langnes_json_check_error(
+        langnes_json_columns_get_column(columns, index, &result));
+    return result;
+}
+
+//
+// CBOR
+//
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_load_cbor(const uint8_t* data, size_t length,
+                       const langnes_json_parse_options_t* options,
+                       langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if ((!data && length > 0) || !result) {
+            throw invalid_argument{};
+        }
+        *result =
+            new value{load_cbor(data, length, to_parse_options(options))};
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_cbor_to_string(
+    langnes_json_value_t* json_value, langnes_json_string_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        std::ostringstream os{std::ios::binary};
+        save_cbor(os, *required_dynamic_cast<value*>(json_value));
+        *result = new_c_string(os.str());
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_cbor_to_buffer(langnes_json_value_t* json_value,
+                                 uint8_t* buffer, size_t buffer_size,
+                                 size_t* required_size) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || (!buffer && buffer_size > 0) || !required_size) {
+            throw invalid_argument{};
+        }
+        *required_size = save_cbor(*required_dynamic_cast<value*>(json_value),
+                                   buffer, buffer_size);
+        if (*required_size > buffer_size) {
+            throw out_of_range{"Buffer is too small"};
+        }
+    });
+}
+
+//
+// MessagePack
+//
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_load_msgpack(const uint8_t* data, size_t length,
+                          const langnes_json_parse_options_t* options,
+                          langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if ((!data && length > 0) || !result) {
+            throw invalid_argument{};
+        }
+        *result =
+            new value{load_msgpack(data, length, to_parse_options(options))};
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_msgpack_to_string(langnes_json_value_t* json_value,
+                                    langnes_json_string_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        std::ostringstream os{std::ios::binary};
+        save_msgpack(os, *required_dynamic_cast<value*>(json_value));
+        *result = new_c_string(os.str());
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_msgpack_to_buffer(langnes_json_value_t* json_value,
+                                    uint8_t* buffer, size_t buffer_size,
+                                    size_t* required_size) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || (!buffer && buffer_size > 0) || !required_size) {
+            throw invalid_argument{};
+        }
+        *required_size = save_msgpack(
+            *required_dynamic_cast<value*>(json_value), buffer, buffer_size);
+        if (*required_size > buffer_size) {
+            throw out_of_range{"Buffer is too small"};
+        }
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_new(const langnes_json_parse_options_t* options,
+                                 langnes_json_msgpack_decoder_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_msgpack_decoder_t*>(
+            new msgpack_decoder{to_parse_options(options)});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_free(langnes_json_msgpack_decoder_t* decoder) {
+    using namespace LANGNES_JSON_CXX_NS;
+    if (!decoder) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<msgpack_decoder*>(decoder);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_feed(langnes_json_msgpack_decoder_t* decoder,
+                                  const uint8_t* data, size_t length) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_msgpack_decoder(decoder, [&](msgpack_decoder& d) {
+        if (!data && length > 0) {
+            throw invalid_argument{};
+        }
+        d.feed(data, length);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_msgpack_decoder_next(langnes_json_msgpack_decoder_t* decoder,
+                                  langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_msgpack_decoder(decoder, [&](msgpack_decoder& d) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        value decoded;
+        *result = d.next(decoded) ? new value{std::move(decoded)} : nullptr;
+    });
+}
+
+//
+// Snapshot
+//
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_save_snapshot_to_file(
+    langnes_json_value_t* json_value, const char* path) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !path) {
+            throw invalid_argument{};
+        }
+        save_snapshot(*required_dynamic_cast<value*>(json_value), path);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_save_snapshot_to_string(langnes_json_value_t* json_value,
+                                     langnes_json_string_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!json_value || !result) {
+            throw invalid_argument{};
+        }
+        std::ostringstream os{std::ios::binary};
+        save_snapshot(os, *required_dynamic_cast<value*>(json_value));
+        *result = new_c_string(os.str());
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_snapshot_open(const char* path, langnes_json_snapshot_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!path || !result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_snapshot_t*>(
+            new snapshot{open_snapshot(path)});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_snapshot_open_buffer(const uint8_t* data, size_t length,
+                                  langnes_json_snapshot_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!data || !result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_snapshot_t*>(
+            new snapshot{open_snapshot(data, length)});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_snapshot_free(langnes_json_snapshot_t* snapshot) {
+    using namespace LANGNES_JSON_CXX_NS;
+    if (!snapshot) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<LANGNES_JSON_CXX_NS::snapshot*>(snapshot);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_snapshot_get_root(
+    langnes_json_snapshot_t* snapshot, langnes_json_element_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!snapshot || !result) {
+            throw invalid_argument{};
+        }
+        *result = to_c_element(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            *reinterpret_cast<LANGNES_JSON_CXX_NS::snapshot*>(snapshot));
+    });
+}
+
+LANGNES_JSON_API langnes_json_element_t
+langnes_json_snapshot_get_root_s(langnes_json_snapshot_t* snapshot) {
+    langnes_json_element_t result{};
+    langnes_json_check_error(langnes_json_snapshot_get_root(snapshot, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_type(
+    langnes_json_element_t element, langnes_json_value_type_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = static_cast<langnes_json_value_type_t>(e.get_type());
+    });
+}
+
+LANGNES_JSON_API langnes_json_value_type_t
+langnes_json_element_get_type_s(langnes_json_element_t element) {
+    langnes_json_value_type_t result{};
+    langnes_json_check_error(langnes_json_element_get_type(element, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_string(
+    langnes_json_element_t element, const char** data, size_t* length) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!data || !length) {
+            throw invalid_argument{};
+        }
+        auto s{e.as_string_span()};
+        *data = s.data();
+        *length = s.size();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_get_number(langnes_json_element_t element,
+                                double* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = e.as_number();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_int64(
+    langnes_json_element_t element, int64_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = e.as_int64();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_uint64(
+    langnes_json_element_t element, uint64_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = e.as_uint64();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_get_boolean(langnes_json_element_t element,
+                                 bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = e.as_boolean();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_get_length(
+    langnes_json_element_t element, size_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = e.size();
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_array_get_item(
+    langnes_json_element_t element, size_t index,
+    langnes_json_element_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = to_c_element(e[index]);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_object_get_value(langnes_json_element_t element,
+                                      const char* member_name,
+                                      langnes_json_element_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!member_name || !result) {
+            throw invalid_argument{};
+        }
+        *result = to_c_element(e[member_name]);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_element_object_get_member(langnes_json_element_t element,
+                                       size_t index, const char** name,
+                                       size_t* name_length,
+                                       langnes_json_element_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!name || !name_length || !result) {
+            throw invalid_argument{};
+        }
+        if (!e.is_object()) {
+            throw bad_access{};
+        }
+        if (index >= e.size()) {
+            throw out_of_range{"Index out of range"};
+        }
+        auto it{e.begin()};
+        it += index;
+        auto key{it.key()};
+        *name = key.data();
+        *name_length = key.size();
+        *result = to_c_element(*it);
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_element_materialize(
+    langnes_json_element_t element, langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_element(element, [&](const class element& e) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = new value{e.materialize()};
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_schema_compile(
+    langnes_json_value_t* schema, langnes_json_schema_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!schema || !result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_schema_t*>(
+            new compiled_schema{*required_dynamic_cast<value*>(schema)});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_schema_free(langnes_json_schema_t* schema) {
+    using namespace LANGNES_JSON_CXX_NS;
+    if (!schema) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<compiled_schema*>(schema);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_schema_validate(langnes_json_schema_t* schema,
+                             langnes_json_value_t* json_value, bool* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!schema || !json_value || !result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<compiled_schema*>(schema)->is_valid(
+            *required_dynamic_cast<value*>(json_value));
+    });
+}
+
+LANGNES_JSON_API bool
+langnes_json_schema_validate_s(langnes_json_schema_t* schema,
+                               langnes_json_value_t* json_value) {
+    bool result{};
+    langnes_json_check_error(
+        langnes_json_schema_validate(schema, json_value, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_load_validated(
+    const char* data, size_t length, langnes_json_schema_t* schema,
+    const langnes_json_parse_options_t* options,
+    langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!data || !schema || !result) {
+            throw invalid_argument{};
+        }
+        *result = new value{load_validated(
+            data, length,
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            *reinterpret_cast<compiled_schema*>(schema),
+            to_parse_options(options))};
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_query_compile(
+    const char* expression, langnes_json_query_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!expression || !result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_query_t*>(
+            new compiled_query{expression});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_free(langnes_json_query_t* query) {
+    using namespace LANGNES_JSON_CXX_NS;
+    if (!query) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<compiled_query*>(query);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t langnes_json_query_evaluate(
+    langnes_json_query_t* query, langnes_json_value_t* json_value,
+    size_t max_threads, langnes_json_query_results_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return filter_error([&] {
+        if (!query || !json_value || !result) {
+            throw invalid_argument{};
+        }
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto nodes{reinterpret_cast<compiled_query*>(query)->evaluate(
+            *required_dynamic_cast<value*>(json_value), max_threads)};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        *result = reinterpret_cast<langnes_json_query_results_t*>(
+            new std::vector<const value*>{std::move(nodes)});
+    });
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_results_free(langnes_json_query_results_t* results) {
+    using namespace LANGNES_JSON_CXX_NS;
+    if (!results) {
+        return langnes_json_error_invalid_argument;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    delete reinterpret_cast<std::vector<const value*>*>(results);
+    return langnes_json_error_ok;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_results_get_length(langnes_json_query_results_t* results,
+                                      size_t* result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_query_results(results, [&](std::vector<const value*>& r) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        *result = r.size();
+    });
+}
+
+LANGNES_JSON_API size_t
+langnes_json_query_results_get_length_s(langnes_json_query_results_t* results) {
+    size_t result{};
+    langnes_json_check_error(
+        langnes_json_query_results_get_length(results, &result));
+    return result;
+}
+
+LANGNES_JSON_API langnes_json_error_code_t
+langnes_json_query_results_get_item(langnes_json_query_results_t* results,
+                                    size_t index,
+                                    langnes_json_value_t** result) {
+    using namespace LANGNES_JSON_CXX_NS;
+    using namespace LANGNES_JSON_CXX_NS::detail;
+    return with_query_results(results, [&](std::vector<const value*>& r) {
+        if (!result) {
+            throw invalid_argument{};
+        }
+        // The C API has no const values.
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        *result = const_cast<value*>(r.at(index));
+    });
+}
+
+LANGNES_JSON_API langnes_json_value_t*
+langnes_json_query_results_get_item_s(langnes_json_query_results_t* results,
+                                      size_t index) {
+    langnes_json_value_t* result{};
+    langnes_json_check_error(
+        langnes_json_query_results_get_item(results, index, &result));
+    return result;
+}
+
 } // extern "C"
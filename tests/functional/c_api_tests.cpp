@@ -2,7 +2,10 @@
 
 #include <langnes_json/json.h>
 
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <string>
 
 // NOLINTBEGIN(cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay)
 // NOLINTBEGIN(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
@@ -13,6 +16,25 @@ namespace {
 const auto bad{langnes_json_failed};
 const auto good{langnes_json_succeeded};
 const auto load_cstr{langnes_json_load_from_cstring};
+
+struct allocation_counts {
+    size_t allocations;
+    size_t deallocations;
+};
+
+void* counting_malloc(size_t size, void* ctx) {
+    ++static_cast<allocation_counts*>(ctx)->allocations;
+    return malloc(size);
+}
+
+void counting_free(void* p, void* ctx) {
+    ++static_cast<allocation_counts*>(ctx)->deallocations;
+    free(p);
+}
+
+void append_output(const char* data, size_t length, void* ctx) {
+    static_cast<std::string*>(ctx)->append(data, length);
+}
 } // namespace
 
 TEST_CASE("Create empty JSON object and populate it") {
@@ -389,6 +411,55 @@ TEST_CASE("langnes_json_load_from_cstring - numbers") {
     REQUIRE(langnes_json_value_get_number_s(result) == 10);
 }
 
+TEST_CASE("langnes_json_load_from_cstring - 64-bit integers") {
+    langnes_json_value_t* result = NULL;
+    REQUIRE(good(load_cstr("[9007199254740993,-9223372036854775808,"
+                           "18446744073709551615,1.5,-1]",
+                           &result)));
+    REQUIRE(langnes_json_value_get_int64_s(
+                langnes_json_value_array_get_item_s(result, 0)) ==
+            9007199254740993);
+    REQUIRE(langnes_json_value_get_int64_s(
+                langnes_json_value_array_get_item_s(result, 1)) == INT64_MIN);
+    REQUIRE(langnes_json_value_get_uint64_s(
+                langnes_json_value_array_get_item_s(result, 2)) ==
+            UINT64_MAX);
+    int64_t i = 0;
+    uint64_t u = 0;
+    REQUIRE(langnes_json_value_get_int64(
+                langnes_json_value_array_get_item_s(result, 2), &i) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(langnes_json_value_get_int64(
+                langnes_json_value_array_get_item_s(result, 3), &i) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(langnes_json_value_get_uint64(
+                langnes_json_value_array_get_item_s(result, 4), &u) ==
+            langnes_json_error_out_of_range);
+    langnes_json_string_t* str = NULL;
+    REQUIRE(good(langnes_json_save_to_string(result, &str)));
+    REQUIRE(strcmp(langnes_json_string_get_cstring_s(str),
+                   "[9007199254740993,-9223372036854775808,"
+                   "18446744073709551615,1.5,-1]") == 0);
+    langnes_json_string_free(str);
+    langnes_json_value_free(result);
+}
+
+TEST_CASE("langnes_json_value_number_new_int64 - argument validity") {
+    SECTION("Should fail with NULL result") {
+        REQUIRE(bad(langnes_json_value_number_new_int64(1, NULL)));
+        REQUIRE(bad(langnes_json_value_number_new_uint64(1, NULL)));
+    }
+    SECTION("Should succeed with valid arguments") {
+        langnes_json_value_t* result = NULL;
+        REQUIRE(
+            good(langnes_json_value_number_new_uint64(UINT64_MAX, &result)));
+        REQUIRE(langnes_json_value_get_uint64_s(result) == UINT64_MAX);
+        REQUIRE(good(langnes_json_value_set_int64(result, INT64_MAX)));
+        REQUIRE(langnes_json_value_get_int64_s(result) == INT64_MAX);
+        langnes_json_value_free(result);
+    }
+}
+
 TEST_CASE("langnes_json_load_from_cstring - special chars in string") {
     langnes_json_value_t* result = NULL;
     REQUIRE(good(load_cstr("\"\\\"\\\\\\b\\f\\n\\r\\t\"", &result)));
@@ -397,6 +468,115 @@ TEST_CASE("langnes_json_load_from_cstring - special chars in string") {
     REQUIRE(strcmp(cstr, "\"\\\b\f\n\r\t") == 0);
 }
 
+TEST_CASE("langnes_json_set_allocator - argument validity") {
+    allocation_counts counts = {0, 0};
+    SECTION("Should fail with NULL free function") {
+        REQUIRE(
+            bad(langnes_json_set_allocator(counting_malloc, NULL, &counts)));
+    }
+    SECTION("Should fail with NULL malloc function") {
+        REQUIRE(bad(
+            langnes_json_set_allocator(NULL, counting_free, &counts)));
+    }
+    SECTION("Should succeed with valid arguments") {
+        REQUIRE(good(langnes_json_set_allocator(counting_malloc, counting_free,
+                                                &counts)));
+        REQUIRE(good(langnes_json_set_allocator(NULL, NULL, NULL)));
+    }
+}
+
+TEST_CASE("langnes_json_set_allocator") {
+    allocation_counts counts = {0, 0};
+    REQUIRE(good(langnes_json_set_allocator(counting_malloc, counting_free,
+                                            &counts)));
+    langnes_json_value_t* result = NULL;
+    REQUIRE(good(load_cstr("{\"a\":[1,2,{\"b\":null}]}", &result)));
+    // Restoring the default must not affect existing values.
+    REQUIRE(good(langnes_json_set_allocator(NULL, NULL, NULL)));
+    REQUIRE(counts.allocations > 0);
+    REQUIRE(counts.deallocations < counts.allocations);
+    langnes_json_value_free(result);
+    REQUIRE(counts.deallocations == counts.allocations);
+}
+
+TEST_CASE("langnes_json_load_from_buffer - argument validity") {
+    SECTION("Should fail with NULL data") {
+        langnes_json_value_t* result = NULL;
+        REQUIRE(bad(langnes_json_load_from_buffer(NULL, 0, NULL, &result)));
+    }
+    SECTION("Should fail with NULL result") {
+        REQUIRE(bad(langnes_json_load_from_buffer("{}", 2, NULL, NULL)));
+    }
+    SECTION("Should succeed with valid arguments") {
+        langnes_json_value_t* result = NULL;
+        REQUIRE(good(langnes_json_load_from_buffer("{}", 2, NULL, &result)));
+    }
+}
+
+TEST_CASE("langnes_json_load_from_buffer - slice of larger buffer") {
+    const char buffer[] = "xx[1,2]yy";
+    langnes_json_value_t* result = NULL;
+    REQUIRE(good(langnes_json_load_from_buffer(buffer + 2, 5, NULL, &result)));
+    REQUIRE(langnes_json_value_array_get_length_s(result) == 2);
+    langnes_json_value_free(result);
+    // Must not read beyond the given length.
+    REQUIRE(bad(langnes_json_load_from_buffer(buffer + 2, 4, NULL, &result)));
+}
+
+TEST_CASE("langnes_json_load_from_buffer - limits") {
+    langnes_json_value_t* result = NULL;
+    langnes_json_parse_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.max_depth = 2;
+    REQUIRE(good(langnes_json_load_from_buffer("[{}]", 4, &options, &result)));
+    langnes_json_value_free(result);
+    REQUIRE(langnes_json_load_from_buffer("[[[]]]", 6, &options, &result) ==
+            langnes_json_error_out_of_range);
+    options.max_depth = 0;
+    options.max_string_length = 3;
+    REQUIRE(good(
+        langnes_json_load_from_buffer("\"abc\"", 5, &options, &result)));
+    langnes_json_value_free(result);
+    REQUIRE(langnes_json_load_from_buffer("{\"abcd\":1}", 10, &options,
+                                          &result) ==
+            langnes_json_error_out_of_range);
+}
+
+TEST_CASE("langnes_json_load_from_buffer - raw numbers") {
+    const char* input = "[0.10000000000000000000000001,1e2]";
+    langnes_json_value_t* result = NULL;
+    langnes_json_parse_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.raw_numbers = true;
+    REQUIRE(good(langnes_json_load_from_buffer(input, strlen(input), &options,
+                                               &result)));
+    REQUIRE(langnes_json_value_get_number_s(
+                langnes_json_value_array_get_item_s(result, 1)) == 100);
+    langnes_json_string_t* str = NULL;
+    REQUIRE(good(langnes_json_save_to_string(result, &str)));
+    REQUIRE(strcmp(langnes_json_string_get_cstring_s(str), input) == 0);
+    langnes_json_string_free(str);
+    langnes_json_value_free(result);
+}
+
+TEST_CASE("langnes_json_load_from_buffer - shared object shapes") {
+    const char* input = "[{\"a\":1,\"b\":2},{\"a\":3,\"b\":4}]";
+    langnes_json_value_t* result = NULL;
+    langnes_json_parse_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.share_object_shapes = true;
+    REQUIRE(good(langnes_json_load_from_buffer(input, strlen(input), &options,
+                                               &result)));
+    langnes_json_value_t* row = langnes_json_value_array_get_item_s(result, 1);
+    REQUIRE(langnes_json_value_object_get_members_length_s(row) == 2);
+    REQUIRE(langnes_json_value_get_number_s(
+                langnes_json_value_object_get_value_s(row, "b")) == 4);
+    langnes_json_value_t* member = NULL;
+    REQUIRE(langnes_json_value_object_get_value(row, "c", &member) ==
+            langnes_json_error_out_of_range);
+    langnes_json_value_free(result);
+}
+
 TEST_CASE("langnes_json_save_to_string - argument validity") {
     SECTION("Should fail with NULL value") {
         langnes_json_string_t* result = NULL;
@@ -446,6 +626,50 @@ TEST_CASE("langnes_json_save_to_string - escape") {
     }
 }
 
+TEST_CASE("langnes_json_save_to_buffer - argument validity") {
+    char buffer[8];
+    size_t required_size = 0;
+    SECTION("Should fail with NULL value") {
+        REQUIRE(bad(langnes_json_save_to_buffer(NULL, buffer, sizeof(buffer),
+                                                &required_size)));
+    }
+    SECTION("Should fail with NULL buffer and non-zero size") {
+        langnes_json_value_t* json_value = langnes_json_value_null_new_s();
+        REQUIRE(bad(langnes_json_save_to_buffer(json_value, NULL,
+                                                sizeof(buffer),
+                                                &required_size)));
+    }
+    SECTION("Should fail with NULL required size") {
+        langnes_json_value_t* json_value = langnes_json_value_null_new_s();
+        REQUIRE(bad(langnes_json_save_to_buffer(json_value, buffer,
+                                                sizeof(buffer), NULL)));
+    }
+    SECTION("Should succeed with valid arguments") {
+        langnes_json_value_t* json_value = langnes_json_value_null_new_s();
+        REQUIRE(good(langnes_json_save_to_buffer(
+            json_value, buffer, sizeof(buffer), &required_size)));
+    }
+}
+
+TEST_CASE("langnes_json_save_to_buffer - required size") {
+    char buffer[8];
+    size_t required_size = 0;
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(good(load_cstr("[true,1]", &json_value)));
+    REQUIRE(langnes_json_save_to_buffer(json_value, NULL, 0, &required_size) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(required_size == 8);
+    REQUIRE(langnes_json_save_to_buffer(json_value, buffer, 4,
+                                        &required_size) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(required_size == 8);
+    REQUIRE(good(langnes_json_save_to_buffer(json_value, buffer,
+                                             sizeof(buffer), &required_size)));
+    REQUIRE(required_size == 8);
+    REQUIRE(memcmp(buffer, "[true,1]", 8) == 0);
+    langnes_json_value_free(json_value);
+}
+
 TEST_CASE("langnes_json_value_free - argument validity") {
     SECTION("Should fail with NULL value") {
         REQUIRE(bad(langnes_json_value_free(NULL)));
@@ -549,6 +773,44 @@ TEST_CASE("langnes_json_value_clone_s") {
     REQUIRE(langnes_json_value_get_number_s(cloned) == 123);
 }
 
+TEST_CASE("langnes_json_value_get_by_pointer - argument validity") {
+    langnes_json_value_t* json_value = langnes_json_value_object_new_s();
+    langnes_json_value_t* result = NULL;
+    SECTION("Should fail with NULL value") {
+        REQUIRE(bad(langnes_json_value_get_by_pointer(NULL, "", &result)));
+    }
+    SECTION("Should fail with NULL pointer") {
+        REQUIRE(
+            bad(langnes_json_value_get_by_pointer(json_value, NULL, &result)));
+    }
+    SECTION("Should fail with NULL result") {
+        REQUIRE(bad(langnes_json_value_get_by_pointer(json_value, "", NULL)));
+    }
+    SECTION("Should succeed with valid arguments") {
+        REQUIRE(
+            good(langnes_json_value_get_by_pointer(json_value, "", &result)));
+        REQUIRE(result == json_value);
+    }
+}
+
+TEST_CASE("langnes_json_value_get_by_pointer") {
+    langnes_json_value_t* json_value = NULL;
+    langnes_json_value_t* result = NULL;
+    REQUIRE(good(load_cstr("{\"a\":{\"b/c\":[1,{\"~\":2}]}}", &json_value)));
+    REQUIRE(langnes_json_value_get_number_s(langnes_json_value_get_by_pointer_s(
+                json_value, "/a/b~1c/1/~0")) == 2);
+    REQUIRE(langnes_json_value_get_by_pointer(json_value, "/a/x", &result) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(langnes_json_value_get_by_pointer(json_value, "/a/b~1c/2",
+                                              &result) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(langnes_json_value_get_by_pointer(json_value, "a", &result) ==
+            langnes_json_error_invalid_argument);
+    REQUIRE(langnes_json_value_get_by_pointer(json_value, "/~2", &result) ==
+            langnes_json_error_invalid_argument);
+    langnes_json_value_free(json_value);
+}
+
 TEST_CASE("langnes_json_string_get_cstring - argument validity") {
     SECTION("Should fail with NULL string") {
         const char* result = NULL;
@@ -1254,6 +1516,69 @@ TEST_CASE("langnes_json_value_array_get_item - index range") {
     REQUIRE(bad(langnes_json_value_array_get_item(json_value, 1, &result)));
 }
 
+TEST_CASE("langnes_json_value_array_get_view") {
+    SECTION("Should fail with NULL arguments") {
+        langnes_json_array_view_t view;
+        REQUIRE(bad(langnes_json_value_array_get_view(NULL, &view)));
+        langnes_json_value_t* json_value = langnes_json_value_array_new_s();
+        REQUIRE(bad(langnes_json_value_array_get_view(json_value, NULL)));
+        REQUIRE(bad(langnes_json_value_array_reserve(NULL, 1)));
+        langnes_json_value_free(json_value);
+    }
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(good(load_cstr("[1,2,3]", &json_value)));
+    REQUIRE(good(langnes_json_value_array_reserve(json_value, 4)));
+    langnes_json_array_view_t view;
+    REQUIRE(good(langnes_json_value_array_get_view(json_value, &view)));
+    REQUIRE(view.length == 3);
+    for (size_t i = 0; i < view.length; ++i) {
+        langnes_json_value_t* element =
+            (langnes_json_value_t*)((char*)view.data + i * view.stride);
+        REQUIRE(element == langnes_json_value_array_get_item_s(json_value, i));
+        REQUIRE(langnes_json_value_get_number_s(element) == (double)(i + 1));
+    }
+    langnes_json_value_free(json_value);
+}
+
+TEST_CASE("langnes_json_value_array_get_numbers") {
+    const double* data = NULL;
+    size_t length = 0;
+    SECTION("Should fail with NULL arguments") {
+        langnes_json_value_t* json_value = langnes_json_value_array_new_s();
+        REQUIRE(
+            bad(langnes_json_value_array_get_numbers(NULL, &data, &length)));
+        REQUIRE(bad(langnes_json_value_array_get_numbers(json_value, NULL,
+                                                         &length)));
+        REQUIRE(bad(langnes_json_value_array_get_numbers(json_value, &data,
+                                                         NULL)));
+        langnes_json_value_free(json_value);
+    }
+    const char* input = "[1.5,-2,3]";
+    langnes_json_value_t* json_value = NULL;
+    langnes_json_parse_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.pack_numeric_arrays = true;
+    REQUIRE(good(langnes_json_load_from_buffer(input, strlen(input), &options,
+                                               &json_value)));
+    REQUIRE(good(
+        langnes_json_value_array_get_numbers(json_value, &data, &length)));
+    REQUIRE(length == 3);
+    REQUIRE(data[0] == 1.5);
+    REQUIRE(data[1] == -2);
+    REQUIRE(data[2] == 3);
+    REQUIRE(langnes_json_value_array_get_length_s(json_value) == 3);
+    REQUIRE(good(
+        langnes_json_value_array_get_numbers(json_value, &data, &length)));
+    REQUIRE(length == 3);
+    REQUIRE(good(langnes_json_value_array_push(
+        json_value, langnes_json_value_boolean_new_s(true))));
+    REQUIRE(good(
+        langnes_json_value_array_get_numbers(json_value, &data, &length)));
+    REQUIRE(data == NULL);
+    REQUIRE(length == 0);
+    langnes_json_value_free(json_value);
+}
+
 TEST_CASE("langnes_json_value_set_array - argument validity") {
     SECTION("Should fail with NULL value") {
         REQUIRE(bad(langnes_json_value_set_array(NULL)));
@@ -1285,6 +1610,397 @@ TEST_CASE("langnes_json_value_set_array_with_elements - argument validity") {
     }
 }
 
+TEST_CASE("langnes_json_writer_new - argument validity") {
+    SECTION("Should fail with NULL result") {
+        REQUIRE(bad(langnes_json_writer_new(NULL, NULL, true, NULL)));
+    }
+    SECTION("Should succeed with valid arguments") {
+        langnes_json_writer_t* writer = NULL;
+        REQUIRE(good(langnes_json_writer_new(NULL, NULL, true, &writer)));
+        REQUIRE(writer != NULL);
+        REQUIRE(good(langnes_json_writer_free(writer)));
+    }
+}
+
+TEST_CASE("langnes_json_writer - collected output") {
+    langnes_json_writer_t* writer = NULL;
+    langnes_json_check_error(
+        langnes_json_writer_new(NULL, NULL, true, &writer));
+    langnes_json_value_t* json_value = langnes_json_value_null_new_s();
+    REQUIRE(good(langnes_json_writer_begin_object(writer)));
+    REQUIRE(good(langnes_json_writer_key(writer, "a\"b")));
+    REQUIRE(good(langnes_json_writer_begin_array(writer)));
+    REQUIRE(good(langnes_json_writer_number(writer, 1)));
+    REQUIRE(good(langnes_json_writer_string(writer, "x\n")));
+    REQUIRE(good(langnes_json_writer_boolean(writer, true)));
+    REQUIRE(good(langnes_json_writer_null(writer)));
+    REQUIRE(good(langnes_json_writer_value(writer, json_value)));
+    REQUIRE(good(langnes_json_writer_end_array(writer)));
+    REQUIRE(!langnes_json_writer_is_complete_s(writer));
+    SECTION("Should fail with value in place of key") {
+        REQUIRE(langnes_json_writer_number(writer, 1) ==
+                langnes_json_error_invalid_state);
+    }
+    SECTION("Should fail with mismatched end") {
+        REQUIRE(langnes_json_writer_end_array(writer) ==
+                langnes_json_error_invalid_state);
+    }
+    REQUIRE(good(langnes_json_writer_end_object(writer)));
+    REQUIRE(langnes_json_writer_is_complete_s(writer));
+    const char* data = NULL;
+    size_t length = 0;
+    REQUIRE(good(langnes_json_writer_get_output(writer, &data, &length)));
+    REQUIRE(std::string(data, length) ==
+            "{\"a\\\"b\":[1,\"x\\n\",true,null,null]}");
+    langnes_json_value_free(json_value);
+    langnes_json_writer_free(writer);
+}
+
+TEST_CASE("langnes_json_writer - non-finite numbers") {
+    langnes_json_writer_t* writer = NULL;
+    langnes_json_check_error(
+        langnes_json_writer_new(NULL, NULL, true, &writer));
+    REQUIRE(langnes_json_writer_number(writer, HUGE_VAL) ==
+            langnes_json_error_invalid_argument);
+    REQUIRE(langnes_json_writer_number(writer, NAN) ==
+            langnes_json_error_invalid_argument);
+    REQUIRE(!langnes_json_writer_is_complete_s(writer));
+    REQUIRE(good(langnes_json_writer_number(writer, 2)));
+    const char* data = NULL;
+    size_t length = 0;
+    REQUIRE(good(langnes_json_writer_get_output(writer, &data, &length)));
+    REQUIRE(std::string(data, length) == "2");
+    langnes_json_writer_free(writer);
+}
+
+TEST_CASE("langnes_json_writer - write function") {
+    std::string output;
+    langnes_json_writer_t* writer = NULL;
+    langnes_json_check_error(
+        langnes_json_writer_new(append_output, &output, false, &writer));
+    langnes_json_writer_begin_array(writer);
+    langnes_json_writer_string(writer, "a");
+    langnes_json_writer_end_array(writer);
+    const char* data = NULL;
+    size_t length = 0;
+    REQUIRE(langnes_json_writer_get_output(writer, &data, &length) ==
+            langnes_json_error_invalid_state);
+    REQUIRE(good(langnes_json_writer_flush(writer)));
+    REQUIRE(output == "[\"a\"]");
+    langnes_json_writer_free(writer);
+}
+
+TEST_CASE("langnes_json_value_to_columns") {
+    const char* input = "[{\"id\":1,\"name\":\"a\"},{\"id\":2}]";
+    langnes_json_value_t* rows = NULL;
+    langnes_json_check_error(langnes_json_load_from_cstring(input, &rows));
+    langnes_json_columns_t* columns = NULL;
+    REQUIRE(good(langnes_json_value_to_columns(rows, 0, &columns)));
+    REQUIRE(langnes_json_columns_get_length_s(columns) == 2);
+
+    langnes_json_column_t id = langnes_json_columns_get_column_s(columns, 0);
+    REQUIRE(std::string(id.name) == "id");
+    REQUIRE(id.type == langnes_json_column_type_int64);
+    REQUIRE(id.length == 2);
+    REQUIRE(id.validity == NULL);
+    REQUIRE(static_cast<const int64_t*>(id.values)[1] == 2);
+
+    langnes_json_column_t name = langnes_json_columns_get_column_s(columns, 1);
+    REQUIRE(name.type == langnes_json_column_type_string);
+    REQUIRE(name.null_count == 1);
+    REQUIRE(name.validity[0] == 0x1);
+    REQUIRE(name.offsets[2] == 1);
+    REQUIRE(static_cast<const char*>(name.values)[0] == 'a');
+
+    langnes_json_column_t missing = {};
+    REQUIRE(langnes_json_columns_get_column(columns, 2, &missing) ==
+            langnes_json_error_out_of_range);
+    langnes_json_columns_free(columns);
+
+    langnes_json_value_t* number = langnes_json_value_number_new_s(1);
+    REQUIRE(langnes_json_value_to_columns(number, 0, &columns) ==
+            langnes_json_error_bad_access);
+    langnes_json_value_free(number);
+    langnes_json_value_free(rows);
+}
+
+TEST_CASE("langnes_json_load_cbor") {
+    const uint8_t data[] = {0xa1, 0x61, 0x61, 0x82, 0x01, 0xf5};
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(
+        good(langnes_json_load_cbor(data, sizeof(data), NULL, &json_value)));
+    langnes_json_string_t* str = NULL;
+    langnes_json_check_error(langnes_json_save_to_string(json_value, &str));
+    REQUIRE(std::string(langnes_json_string_get_cstring_s(str)) ==
+            "{\"a\":[1,true]}");
+    langnes_json_string_free(str);
+
+    size_t required_size = 0;
+    REQUIRE(langnes_json_save_cbor_to_buffer(json_value, NULL, 0,
+                                             &required_size) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(required_size == sizeof(data));
+    uint8_t buffer[sizeof(data)] = {0};
+    REQUIRE(good(langnes_json_save_cbor_to_buffer(json_value, buffer,
+                                                  sizeof(buffer),
+                                                  &required_size)));
+    REQUIRE(std::memcmp(buffer, data, sizeof(data)) == 0);
+
+    REQUIRE(good(langnes_json_save_cbor_to_string(json_value, &str)));
+    REQUIRE(langnes_json_string_get_length_s(str) == sizeof(data));
+    langnes_json_string_free(str);
+    langnes_json_value_free(json_value);
+
+    const uint8_t truncated[] = {0x82, 0x01};
+    REQUIRE(langnes_json_load_cbor(truncated, sizeof(truncated), NULL,
+                                   &json_value) ==
+            langnes_json_error_parse_error);
+}
+
+TEST_CASE("langnes_json_load_msgpack") {
+    const uint8_t data[] = {0x81, 0xa1, 0x61, 0x92, 0x01, 0xc3};
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(good(
+        langnes_json_load_msgpack(data, sizeof(data), NULL, &json_value)));
+    langnes_json_string_t* str = NULL;
+    langnes_json_check_error(langnes_json_save_to_string(json_value, &str));
+    REQUIRE(std::string(langnes_json_string_get_cstring_s(str)) ==
+            "{\"a\":[1,true]}");
+    langnes_json_string_free(str);
+
+    size_t required_size = 0;
+    uint8_t buffer[sizeof(data)] = {0};
+    REQUIRE(good(langnes_json_save_msgpack_to_buffer(
+        json_value, buffer, sizeof(buffer), &required_size)));
+    REQUIRE(required_size == sizeof(data));
+    REQUIRE(std::memcmp(buffer, data, sizeof(data)) == 0);
+    REQUIRE(good(langnes_json_save_msgpack_to_string(json_value, &str)));
+    REQUIRE(langnes_json_string_get_length_s(str) == sizeof(data));
+    langnes_json_string_free(str);
+    langnes_json_value_free(json_value);
+}
+
+TEST_CASE("langnes_json_msgpack_decoder") {
+    const uint8_t data[] = {0x92, 0x01, 0x02, 0xc1};
+    langnes_json_msgpack_decoder_t* decoder = NULL;
+    REQUIRE(good(langnes_json_msgpack_decoder_new(NULL, &decoder)));
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(good(langnes_json_msgpack_decoder_feed(decoder, data, 2)));
+    REQUIRE(good(langnes_json_msgpack_decoder_next(decoder, &json_value)));
+    REQUIRE(json_value == NULL);
+    REQUIRE(good(langnes_json_msgpack_decoder_feed(decoder, data + 2, 2)));
+    REQUIRE(good(langnes_json_msgpack_decoder_next(decoder, &json_value)));
+    REQUIRE(langnes_json_value_array_get_length_s(json_value) == 2);
+    langnes_json_value_free(json_value);
+    REQUIRE(langnes_json_msgpack_decoder_next(decoder, &json_value) ==
+            langnes_json_error_parse_error);
+    langnes_json_msgpack_decoder_free(decoder);
+}
+
+TEST_CASE("langnes_json_snapshot") {
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring(
+        "{\"a\":[1,\"x\"],\"b\":true}", &json_value)));
+    langnes_json_string_t* image = NULL;
+    REQUIRE(good(langnes_json_save_snapshot_to_string(json_value, &image)));
+    langnes_json_value_free(json_value);
+
+    langnes_json_snapshot_t* snapshot = NULL;
+    REQUIRE(good(langnes_json_snapshot_open_buffer(
+        (const uint8_t*)langnes_json_string_get_cstring_s(image),
+        langnes_json_string_get_length_s(image), &snapshot)));
+    langnes_json_element_t root = langnes_json_snapshot_get_root_s(snapshot);
+    REQUIRE(langnes_json_element_get_type_s(root) ==
+            langnes_json_value_type_object);
+
+    const char* name = NULL;
+    size_t name_length = 0;
+    langnes_json_element_t a;
+    REQUIRE(good(langnes_json_element_object_get_member(root, 0, &name,
+                                                        &name_length, &a)));
+    REQUIRE(std::string(name, name_length) == "a");
+    size_t length = 0;
+    REQUIRE(good(langnes_json_element_get_length(a, &length)));
+    REQUIRE(length == 2);
+    langnes_json_element_t item;
+    REQUIRE(good(langnes_json_element_array_get_item(a, 1, &item)));
+    const char* data = NULL;
+    REQUIRE(good(langnes_json_element_get_string(item, &data, &length)));
+    REQUIRE(std::string(data, length) == "x");
+    REQUIRE(good(langnes_json_element_array_get_item(a, 0, &item)));
+    int64_t number = 0;
+    REQUIRE(good(langnes_json_element_get_int64(item, &number)));
+    REQUIRE(number == 1);
+    REQUIRE(langnes_json_element_array_get_item(a, 2, &item) ==
+            langnes_json_error_out_of_range);
+
+    langnes_json_element_t b;
+    REQUIRE(good(langnes_json_element_object_get_value(root, "b", &b)));
+    bool flag = false;
+    REQUIRE(good(langnes_json_element_get_boolean(b, &flag)));
+    REQUIRE(flag);
+    REQUIRE(langnes_json_element_get_int64(b, &number) ==
+            langnes_json_error_bad_access);
+
+    REQUIRE(good(langnes_json_element_materialize(a, &json_value)));
+    langnes_json_string_t* str = NULL;
+    langnes_json_check_error(langnes_json_save_to_string(json_value, &str));
+    REQUIRE(std::string(langnes_json_string_get_cstring_s(str)) ==
+            "[1,\"x\"]");
+    langnes_json_string_free(str);
+    langnes_json_value_free(json_value);
+    langnes_json_snapshot_free(snapshot);
+    langnes_json_string_free(image);
+
+    const uint8_t garbage[] = {0x00, 0x01, 0x02};
+    REQUIRE(langnes_json_snapshot_open_buffer(garbage, sizeof(garbage),
+                                              &snapshot) ==
+            langnes_json_error_parse_error);
+}
+
+TEST_CASE("langnes_json_value_equals") {
+    langnes_json_value_t* a = NULL;
+    langnes_json_value_t* b = NULL;
+    langnes_json_value_t* c = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring("{\"a\":1,\"b\":[true]}",
+                                                &a)));
+    REQUIRE(good(langnes_json_load_from_cstring("{\"b\":[true],\"a\":1}",
+                                                &b)));
+    REQUIRE(good(langnes_json_load_from_cstring("{\"a\":1}", &c)));
+    bool result = false;
+    REQUIRE(good(langnes_json_value_equals(a, b, &result)));
+    REQUIRE(result);
+    REQUIRE(!langnes_json_value_equals_s(a, c));
+    uint64_t hash = 0;
+    REQUIRE(good(langnes_json_value_hash(a, true, &hash)));
+    REQUIRE(hash == langnes_json_value_hash_s(b, false));
+    REQUIRE(hash != langnes_json_value_hash_s(c, false));
+    REQUIRE(langnes_json_value_hash(NULL, false, &hash) ==
+            langnes_json_error_invalid_argument);
+    langnes_json_value_free(a);
+    langnes_json_value_free(b);
+    langnes_json_value_free(c);
+}
+
+TEST_CASE("langnes_json_value_merge_patch") {
+    langnes_json_value_t* target = NULL;
+    langnes_json_value_t* patch = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring(
+        "{\"a\":\"b\",\"c\":{\"d\":\"e\",\"f\":\"g\"}}", &target)));
+    REQUIRE(good(langnes_json_load_from_cstring(
+        "{\"a\":\"z\",\"c\":{\"f\":null}}", &patch)));
+    REQUIRE(good(langnes_json_value_merge_patch(target, patch)));
+    langnes_json_value_t* expected = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring(
+        "{\"a\":\"z\",\"c\":{\"d\":\"e\"}}", &expected)));
+    REQUIRE(langnes_json_value_equals_s(target, expected));
+    REQUIRE(langnes_json_value_merge_patch(target, target) ==
+            langnes_json_error_invalid_argument);
+    langnes_json_value_t* nested = NULL;
+    REQUIRE(good(langnes_json_value_get_by_pointer(target, "/c", &nested)));
+    REQUIRE(langnes_json_value_merge_patch(target, nested) ==
+            langnes_json_error_invalid_argument);
+    REQUIRE(langnes_json_value_merge_patch(nested, target) ==
+            langnes_json_error_invalid_argument);
+    REQUIRE(langnes_json_value_equals_s(target, expected));
+    langnes_json_value_free(expected);
+    langnes_json_value_free(target);
+}
+
+TEST_CASE("langnes_json_schema") {
+    langnes_json_value_t* document = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring(
+        "{\"type\":\"array\",\"items\":{\"type\":\"integer\"},"
+        "\"maxItems\":2}",
+        &document)));
+    langnes_json_schema_t* schema = NULL;
+    REQUIRE(good(langnes_json_schema_compile(document, &schema)));
+    langnes_json_value_free(document);
+
+    langnes_json_value_t* v = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring("[1,2]", &v)));
+    bool result = false;
+    REQUIRE(good(langnes_json_schema_validate(schema, v, &result)));
+    REQUIRE(result);
+    langnes_json_value_free(v);
+    REQUIRE(good(langnes_json_load_validated("[3]", 3, schema, NULL, &v)));
+    REQUIRE(langnes_json_schema_validate_s(schema, v));
+    langnes_json_value_free(v);
+
+    REQUIRE(langnes_json_load_validated("[1,2,3]", 7, schema, NULL, &v) ==
+            langnes_json_error_validation_error);
+    REQUIRE(langnes_json_load_validated("[\"1\"]", 5, schema, NULL, &v) ==
+            langnes_json_error_validation_error);
+    REQUIRE(langnes_json_schema_free(schema) == langnes_json_error_ok);
+
+    REQUIRE(good(langnes_json_load_from_cstring("{\"type\":1}", &document)));
+    REQUIRE(langnes_json_schema_compile(document, &schema) ==
+            langnes_json_error_invalid_argument);
+    langnes_json_value_free(document);
+}
+
+TEST_CASE("langnes_json_query") {
+    langnes_json_value_t* document = NULL;
+    REQUIRE(good(langnes_json_load_from_cstring(
+        "{\"orders\":[{\"id\":1,\"total\":50},{\"id\":2,\"total\":150},"
+        "{\"id\":3,\"total\":250}]}",
+        &document)));
+    langnes_json_query_t* query = NULL;
+    REQUIRE(good(
+        langnes_json_query_compile("$.orders[?(@.total > 100)].id", &query)));
+    langnes_json_query_results_t* results = NULL;
+    REQUIRE(good(langnes_json_query_evaluate(query, document, 0, &results)));
+    REQUIRE(langnes_json_query_results_get_length_s(results) == 2);
+    langnes_json_value_t* item = NULL;
+    REQUIRE(good(langnes_json_query_results_get_item(results, 1, &item)));
+    REQUIRE(langnes_json_value_get_int64_s(item) == 3);
+    REQUIRE(langnes_json_query_results_get_item(results, 2, &item) ==
+            langnes_json_error_out_of_range);
+    REQUIRE(langnes_json_query_results_free(results) == langnes_json_error_ok);
+    REQUIRE(langnes_json_query_free(query) == langnes_json_error_ok);
+    REQUIRE(langnes_json_query_compile("$.orders[", &query) ==
+            langnes_json_error_invalid_argument);
+    langnes_json_value_free(document);
+}
+
+TEST_CASE("langnes_json_validate") {
+    const char* valid = "[1,{\"a\":null}]";
+    bool result = false;
+    REQUIRE(good(langnes_json_validate(valid, strlen(valid), &result)));
+    REQUIRE(result);
+    REQUIRE(!langnes_json_validate_s(valid, strlen(valid) - 1));
+    REQUIRE(!langnes_json_validate_s("\"\xff\"", 3));
+    REQUIRE(langnes_json_validate(NULL, 0, &result) ==
+            langnes_json_error_invalid_argument);
+
+    langnes_json_parse_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.validate_utf8 = true;
+    langnes_json_value_t* v = NULL;
+    REQUIRE(langnes_json_load_from_buffer("\"\xff\"", 3, &options, &v) ==
+            langnes_json_error_parse_error);
+}
+
+TEST_CASE("langnes_json_value_object_get_member - shared object shapes") {
+    const char* input = "[{\"a\":1,\"b\":2},{\"a\":3,\"b\":4}]";
+    langnes_json_parse_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.share_object_shapes = true;
+    langnes_json_value_t* json_value = NULL;
+    REQUIRE(good(langnes_json_load_from_buffer(input, strlen(input), &options,
+                                               &json_value)));
+    langnes_json_value_t* row =
+        langnes_json_value_array_get_item_s(json_value, 1);
+    langnes_json_value_t* b = langnes_json_value_object_get_value_s(row, "b");
+    langnes_json_object_member_t member =
+        langnes_json_value_object_get_member_s(row, 1);
+    REQUIRE(strcmp(member.name, "b") == 0);
+    REQUIRE(member.value == b);
+    REQUIRE(langnes_json_value_get_number_s(b) == 4);
+    REQUIRE(langnes_json_value_object_get_value_s(row, "b") == b);
+    langnes_json_value_free(json_value);
+}
+
 // NOLINTEND(modernize-raw-string-literal)
 // NOLINTEND(hicpp-use-nullptr,modernize-use-nullptr)
 // NOLINTEND(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
@@ -2,4 +2,1579 @@
 
 #include <langnes_json/json.hpp>
 
-TEST_CASE("Dummy functional test") {}
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+class counting_resource : public langnes::json::memory_resource {
+public:
+    size_t allocated() const noexcept { return m_allocated; }
+    size_t deallocated() const noexcept { return m_deallocated; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        m_allocated += bytes;
+        return langnes::json::new_delete_resource()->allocate(bytes,
+                                                              alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes,
+                       size_t alignment) noexcept override {
+        m_deallocated += bytes;
+        langnes::json::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+private:
+    size_t m_allocated{};
+    size_t m_deallocated{};
+};
+
+// Whether a function throws an exception of the given type.
+template<typename Exception, typename Fn>
+bool fails_with(Fn fn) {
+    try {
+        fn();
+    } catch (const Exception&) {
+        return true;
+    }
+    return false;
+}
+
+// Minimal stand-in for std::optional, which needs C++17.
+template<typename T>
+class maybe {
+public:
+    using value_type = T;
+
+    bool has_value() const noexcept { return m_has_value; }
+    void reset() noexcept { m_has_value = false; }
+    T& emplace() {
+        m_value = T{};
+        m_has_value = true;
+        return m_value;
+    }
+    const T& operator*() const noexcept { return m_value; }
+    T& operator*() noexcept { return m_value; }
+
+private:
+    T m_value{};
+    bool m_has_value{};
+};
+
+struct point {
+    double x;
+    double y;
+};
+
+LANGNES_JSON_FIELDS(point, x, y)
+
+struct user {
+    std::int64_t id;
+    std::string name;
+    std::vector<std::string> tags;
+    std::vector<point> path;
+    maybe<unsigned int> age;
+    bool active;
+};
+
+LANGNES_JSON_FIELDS(user, id, name, tags, path, age, active)
+} // namespace
+
+TEST_CASE("load with parse options") {
+    using namespace langnes::json;
+    parse_options options;
+    options.max_depth = 1;
+    REQUIRE(load("[1]", options).as_array().size() == 1);
+    bool errored{};
+    try {
+        load("[[1]]", options);
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+TEST_CASE("save into character array") {
+    using namespace langnes::json;
+    auto v{load(R"({"a":[null]})")};
+    std::string buffer(32, '\0');
+    auto length{save(v, &buffer[0], buffer.size())};
+    REQUIRE(length == 12);
+    REQUIRE(buffer.compare(0, length, R"({"a":[null]})") == 0);
+    REQUIRE(save(v, nullptr, 0) == 12);
+}
+
+TEST_CASE("memory resource") {
+    using namespace langnes::json;
+    counting_resource resource;
+    auto* previous{set_default_resource(&resource)};
+    {
+        auto v{load(R"({"a":[1,2,{"b":null}],"c":"d"})")};
+        set_default_resource(previous);
+        REQUIRE(resource.allocated() > 0);
+        // Copies use the current default resource.
+        auto copy{v.clone()};
+        auto allocated{resource.allocated()};
+        copy.as_object()["e"] = true;
+        REQUIRE(resource.allocated() == allocated);
+        REQUIRE(copy.as_object().entry_at(0).first == "a");
+        REQUIRE(copy.as_object().entry_at(2).first == "e");
+    }
+    REQUIRE(resource.deallocated() == resource.allocated());
+}
+
+TEST_CASE("scoped memory resource") {
+    using namespace langnes::json;
+    const std::string long_name(100, 'n');
+    const std::string long_string(200, 's');
+    auto json{R"({")" + long_name + R"(":")" + long_string + R"("})"};
+    counting_resource resource;
+    {
+        parse_options options{};
+        options.resource = &resource;
+        auto v{load(json, options)};
+        // Member names and strings come from the resource as well.
+        REQUIRE(resource.allocated() >= 300);
+        auto allocated{resource.allocated()};
+        // Other loads are not affected.
+        auto other{load(json)};
+        REQUIRE(resource.allocated() == allocated);
+        {
+            scoped_resource scope{&resource};
+            value s{long_string};
+            REQUIRE(resource.allocated() > allocated);
+        }
+        REQUIRE(get_default_resource() != &resource);
+    }
+    REQUIRE(resource.deallocated() == resource.allocated());
+}
+
+TEST_CASE("JSON pointer") {
+    using namespace langnes::json;
+    auto v{load(R"({"a":{"b":[10,20]},"":1,"01":2})")};
+    REQUIRE(v.at_pointer("/a/b/1").as_number() == 20);
+    REQUIRE(v.at_pointer("/").as_number() == 1);
+    REQUIRE(v.at_pointer("/01").as_number() == 2);
+    REQUIRE(&v.at_pointer("") == &v);
+    REQUIRE(v.find_pointer("/a/b/01") == nullptr);
+    REQUIRE(v.find_pointer("/a/b/-") == nullptr);
+    REQUIRE(v.find_pointer("/a/c") == nullptr);
+    // Lookups must not insert members.
+    REQUIRE(v.at_pointer("/a").as_object().size() == 1);
+    compiled_pointer pointer{"/a/b/0"};
+    REQUIRE(pointer.tokens().size() == 3);
+    v.at_pointer(pointer) = 30;
+    REQUIRE(v.find_pointer(pointer)->as_number() == 30);
+    bool errored{};
+    try {
+        v.at_pointer("/x");
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+TEST_CASE("lazy document") {
+    using namespace langnes::json;
+    auto doc{load_lazy(
+        R"( {"skip": {"x": ["}", {"y": "]"}]}, "user" : {"id": 7, )"
+        R"("name": "a\"b"}, "items": [1, [2], true, null]} )")};
+    REQUIRE(doc.is_object());
+    REQUIRE(doc.size() == 3);
+    REQUIRE(doc["user"]["id"].as_number() == 7);
+    REQUIRE(doc["user"]["name"].as_string() == "a\"b");
+    auto items{doc["items"]};
+    REQUIRE(items.size() == 4);
+    REQUIRE(items[1].is_array());
+    REQUIRE(items[2].as_boolean());
+    REQUIRE(items[3].is_null());
+    std::string keys;
+    for (auto it{doc.begin()}; it != doc.end(); ++it) {
+        keys += it.key();
+    }
+    REQUIRE(keys == "skipuseritems");
+    REQUIRE(doc.find("missing") == doc.end());
+    auto user{doc["user"].materialize()};
+    REQUIRE(user.as_object().at("id").as_number() == 7);
+    bool errored{};
+    try {
+        doc["missing"];
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+    errored = false;
+    try {
+        items.as_string();
+    } catch (const bad_access&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+    auto owned{load_lazy(std::string{"[{}, []]"})};
+    REQUIRE(owned[0].size() == 0);
+    REQUIRE(owned[1].begin() == owned[1].end());
+}
+
+TEST_CASE("load projected") {
+    using namespace langnes::json;
+    auto v{load_projected(
+        R"({"user": {"id": 1, "name": "a"}, "skip": [{"x": "]"}], )"
+        R"("items": [{"price": 2, "n": 3}, 4, {"price": 5}, {"n": 6}]})",
+        {"/user/id", "/items/*/price", "/items/1"})};
+    const auto& members{v.as_object()};
+    REQUIRE(members.size() == 2);
+    REQUIRE(members.at("user").as_object().size() == 1);
+    REQUIRE(members.at("user").as_object().at("id").as_number() == 1);
+    const auto& items{members.at("items").as_array()};
+    REQUIRE(items.size() == 4);
+    REQUIRE(items[0].as_object().size() == 1);
+    REQUIRE(items[0].as_object().at("price").as_number() == 2);
+    REQUIRE(items[1].as_number() == 4);
+    REQUIRE(items[2].as_object().at("price").as_number() == 5);
+    REQUIRE(items[3].as_object().empty());
+    auto skipped{load_projected(std::string{"[1, 2, {\"a\": 3}]"}, {"/2/a"})};
+    REQUIRE(skipped.as_array().size() == 3);
+    REQUIRE(skipped.as_array()[0].is_null());
+    REQUIRE(load_projected("[1]", {""}).as_array().size() == 1);
+}
+
+TEST_CASE("writer") {
+    using namespace langnes::json;
+    std::ostringstream os;
+    writer w{os};
+    w.begin_object().key("a").begin_array();
+    w.number(1).string("\"").boolean(false).null();
+    w.end_array().key(std::string{"b"}).write(make_object({}));
+    REQUIRE(!w.is_complete());
+    bool errored{};
+    try {
+        w.end_array();
+    } catch (const invalid_state&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+    w.end_object();
+    REQUIRE(w.is_complete());
+    REQUIRE(os.str() == R"({"a":[1,"\"",false,null],"b":{}})");
+    REQUIRE(load(os.str()).as_object().size() == 2);
+}
+
+TEST_CASE("writer - non-finite numbers") {
+    using namespace langnes::json;
+    std::ostringstream os;
+    writer w{os};
+    w.begin_array();
+    auto fails = [&](double v) {
+        try {
+            w.number(v);
+        } catch (const invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    REQUIRE(fails(std::numeric_limits<double>::quiet_NaN()));
+    REQUIRE(fails(std::numeric_limits<double>::infinity()));
+    REQUIRE(fails(-std::numeric_limits<double>::infinity()));
+    w.number(0.5).end_array();
+    REQUIRE(os.str() == "[0.5]");
+}
+
+TEST_CASE("64-bit integers") {
+    using namespace langnes::json;
+    auto v{load("[1234567890123456789,-5,18446744073709551615,2.0,2.5]")};
+    auto& elements{v.as_array()};
+    REQUIRE(elements[0].as_int64() == 1234567890123456789);
+    REQUIRE(elements[1].as_int64() == -5);
+    REQUIRE(elements[2].as_uint64() == 18446744073709551615U);
+    REQUIRE(elements[3].as_int64() == 2);
+    bool errored{};
+    try {
+        elements[4].as_int64();
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+    REQUIRE(save(v) == "[1234567890123456789,-5,18446744073709551615,2,2.5]");
+    // Modifying the number through a floating point reference
+    elements[0].as_number() = 0.5;
+    REQUIRE(save(elements[0]) == "0.5");
+    // makes it a double even if the value stays the same or rounds back.
+    value big{std::uint64_t{9007199254740993U}};
+    big.as_number() = 9007199254740992.0;
+    REQUIRE(save(big) == save(value{9007199254740992.0}));
+    REQUIRE(big.as_uint64() == 9007199254740992U);
+    value large{(std::int64_t{1} << 62) + 1};
+    large.as_number() += 1.0;
+    REQUIRE(large.as_int64() == std::int64_t{1} << 62);
+    REQUIRE(save(value{std::uint64_t{1} << 63U}) == "9223372036854775808");
+}
+
+TEST_CASE("shortest numbers") {
+    using namespace langnes::json;
+    REQUIRE(save(value{0.1}) == "0.1");
+    REQUIRE(save(value{1e-7}) == "1e-07");
+    REQUIRE(save(value{0.1 + 0.2}) == "0.30000000000000004");
+    // Denormals round-trip with few digits as well.
+    REQUIRE(save(value{5e-324}) == "5e-324");
+    REQUIRE(save(value{2.5e-320}) == "2.5e-320");
+    REQUIRE(load("4.9406564584124654e-324").as_number() == 5e-324);
+    REQUIRE(save(value{-1.7976931348623157e308}) ==
+            "-1.7976931348623157e+308");
+}
+
+TEST_CASE("raw numbers") {
+    using namespace langnes::json;
+    parse_options options;
+    options.raw_numbers = true;
+    const std::string input{"[123456789012345678901234567890,1.50,-0,7]"};
+    auto v{load(input, options)};
+    REQUIRE(save(v) == input);
+    auto& elements{v.as_array()};
+    REQUIRE(elements[1].as_number() == 1.5);
+    REQUIRE(elements[3].as_int64() == 7);
+    // Reading does not affect the output but modifying does.
+    REQUIRE(save(v) == input);
+    elements[1].as_number() = 2.5;
+    REQUIRE(save(v) == "[123456789012345678901234567890,2.5,-0,7]");
+    REQUIRE(save(v.clone()) == save(v));
+    // The text is kept out of line so that numbers stay small.
+    REQUIRE(sizeof(detail::number_impl) <= 4 * sizeof(void*));
+}
+
+TEST_CASE("contiguous arrays") {
+    using namespace langnes::json;
+    auto v{load("[[1,2],[3,4,5],[]]")};
+    const auto& elements{v.as_array()};
+    REQUIRE(elements.capacity() == 3);
+    REQUIRE(elements[0].as_array().capacity() == 2);
+    REQUIRE(elements[1].as_array().capacity() == 3);
+    REQUIRE(&elements[1] == elements.data() + 1);
+    auto copy{v};
+    copy.as_array().reserve(8);
+    REQUIRE(copy.as_array().capacity() >= 8);
+}
+
+TEST_CASE("packed numeric arrays") {
+    using namespace langnes::json;
+    parse_options options;
+    options.pack_numeric_arrays = true;
+    const std::string input{"[[1,-2.5,1e+100],[3,\"x\"],[9007199254740993]]"};
+    auto v{load(input, options)};
+    REQUIRE(save(v) == input);
+    const auto& rows{v.as_array()};
+    auto numbers{rows[0].as_number_span()};
+    REQUIRE(numbers.size() == 3);
+    REQUIRE(numbers[0] == 1);
+    REQUIRE(numbers[1] == -2.5);
+    REQUIRE(numbers[2] == 1e100);
+    // The last array is not exactly representable as doubles.
+    REQUIRE(rows[1].as_number_span().empty());
+    REQUIRE(rows[2].as_number_span().empty());
+    bool errored{};
+    try {
+        value{1}.as_number_span();
+    } catch (const bad_access&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+    // Reading the elements keeps the array packed.
+    const auto& elements{rows[0].as_array()};
+    REQUIRE(elements[1].as_number() == -2.5);
+    REQUIRE(&rows[0].as_array() == &elements);
+    REQUIRE(rows[0].as_number_span().data() == numbers.data());
+    // The first write promotes to the generic layout, keeping the elements
+    // handed out before.
+    auto copy{v.as_array()[0]};
+    const auto* first{&static_cast<const value&>(copy).as_array()[0]};
+    copy.as_array()[1] = "y";
+    REQUIRE(copy.as_number_span().empty());
+    REQUIRE(first == &copy.as_array()[0]);
+    copy.as_array().emplace_back(false);
+    REQUIRE(save(copy) == "[1,\"y\",1e+100,false]");
+    // Mutable access to the numbers after const access to the elements
+    // switches to the generic layout so that the elements stay valid.
+    auto other{v.as_array()[0]};
+    const auto& held{static_cast<const value&>(other).as_array()};
+    REQUIRE(other.as_number_span().empty());
+    REQUIRE(&held == &other.as_array());
+    REQUIRE(held.size() == 3);
+    REQUIRE(held[2].as_number() == 1e100);
+    // Generic arrays are not packed on demand.
+    auto generic{load("[0.1,2]")};
+    REQUIRE(generic.as_number_span().empty());
+    REQUIRE(make_array().as_number_span().empty());
+}
+
+TEST_CASE("struct binding") {
+    using namespace langnes::json;
+    auto u{load_as<user>(R"({"id":-7,"name":"a\"b","extra":{"x":[1]},)"
+                         R"("tags":["x","y"],"path":[{"x":1,"y":2.5}],)"
+                         R"("age":42,"active":true})")};
+    REQUIRE(u.id == -7);
+    REQUIRE(u.name == "a\"b");
+    REQUIRE(u.tags.size() == 2);
+    REQUIRE(u.tags[1] == "y");
+    REQUIRE(u.path.size() == 1);
+    REQUIRE(u.path[0].y == 2.5);
+    REQUIRE(u.age.has_value());
+    REQUIRE(*u.age == 42);
+    REQUIRE(u.active);
+    REQUIRE(save(u) == R"({"id":-7,"name":"a\"b","tags":["x","y"],)"
+                       R"("path":[{"x":1,"y":2.5}],"age":42,"active":true})");
+    u = load_as<user>(std::string{R"({"age":null,"tags":[]})"});
+    REQUIRE(!u.age.has_value());
+    REQUIRE(u.tags.empty());
+    REQUIRE(load_as<std::vector<int>>("[1, 2,3]").size() == 3);
+    bool errored{};
+    try {
+        load_as<user>(R"({"age":-1})");
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+namespace temperature {
+struct celsius {
+    double degrees;
+};
+
+void to_json(langnes::json::value& out, const celsius& in) {
+    out = langnes::json::value{in.degrees};
+}
+
+void from_json(const langnes::json::value& in, celsius& out) {
+    out.degrees = in.as_number();
+}
+} // namespace temperature
+
+TEST_CASE("typed conversions") {
+    using namespace langnes::json;
+    const std::vector<std::string> names{"a", "b"};
+    value v{names};
+    REQUIRE(save(v) == R"(["a","b"])");
+    REQUIRE(v.get<std::vector<std::string>>() == names);
+    // Strings of the value string type are moved out of rvalues.
+    auto moved{std::move(v).get<std::vector<value::string_type>>()};
+    REQUIRE(moved.size() == 2);
+    REQUIRE(moved[1] == "b");
+    REQUIRE(v.as_array()[0].as_string().empty());
+
+    const std::map<std::string, std::vector<double>> series{{"x", {1, 2.5}}};
+    value packed{series};
+    REQUIRE(save(packed) == R"({"x":[1,2.5]})");
+    REQUIRE(packed.as_object().at("x").as_number_span().size() == 2);
+    REQUIRE((packed.get<std::unordered_map<std::string,
+                                           std::vector<double>>>()
+                 .at("x")[1] == 2.5));
+
+    auto t{load(R"([1,"two",[true,false]])")
+               .get<std::tuple<int, std::string, std::array<bool, 2>>>()};
+    REQUIRE(std::get<0>(t) == 1);
+    REQUIRE(std::get<1>(t) == "two");
+    REQUIRE(!std::get<2>(t)[1]);
+    REQUIRE(save(value{std::make_pair(std::string{"k"}, 3U)}) == R"(["k",3])");
+
+    const std::vector<temperature::celsius> readings{{21.5}, {-3}};
+    REQUIRE(save(value{readings}) == "[21.5,-3]");
+    REQUIRE(load("[4]").get<std::vector<temperature::celsius>>()[0].degrees ==
+            4);
+
+    point p{1, 2};
+    REQUIRE(value{p}.as_object().at("y").as_number() == 2);
+    REQUIRE(load(R"({"x":3})").get<point>().x == 3);
+
+    bool errored{};
+    try {
+        load("[1,2]").get<std::array<int, 3>>();
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+    errored = false;
+    try {
+        load("300").get<std::uint8_t>();
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+TEST_CASE("shared object shapes") {
+    using namespace langnes::json;
+    std::string input{"["};
+    for (int i{}; i < 100; ++i) {
+        input += (i > 0 ? "," : "");
+        input += R"({"id":)" + std::to_string(i) + R"(,"name":"x"})";
+    }
+    input += "]";
+    parse_options options;
+    options.share_object_shapes = true;
+    counting_resource shared_resource;
+    counting_resource dict_resource;
+    auto* previous{set_default_resource(&shared_resource)};
+    auto v{load(input, options)};
+    set_default_resource(&dict_resource);
+    load(input);
+    set_default_resource(previous);
+    REQUIRE(shared_resource.allocated() < dict_resource.allocated());
+
+    const auto& rows{v.as_array()};
+    REQUIRE(rows[50].find_member("id")->as_int64() == 50);
+    REQUIRE(rows[50].find_member("missing") == nullptr);
+    REQUIRE(v.at_pointer("/99/name").as_string() == "x");
+    REQUIRE(save(rows[1]) == R"({"id":1,"name":"x"})");
+    // Adding a member switches to a private dict.
+    auto row{rows[2]};
+    row.as_object()["extra"] = true;
+    REQUIRE(row.find_member("extra")->as_boolean());
+    REQUIRE(row.find_member("id")->as_int64() == 2);
+    REQUIRE(rows[3].find_member("id")->as_int64() == 3);
+    // Duplicate names are not shared.
+    auto duplicates{load(R"([{"a":1,"a":2},{"a":3,"a":4}])", options)};
+    REQUIRE(duplicates.as_array()[1].as_object().size() == 1);
+    // Reading keeps the shared layout and what was found before.
+    const auto& shared{rows[4]};
+    const auto* id{shared.find_member("id")};
+    REQUIRE(shared.as_object().at("name").as_string() == "x");
+    REQUIRE(shared.find_member("id") == id);
+    REQUIRE(id->as_int64() == 4);
+    std::string names;
+    shared.for_each_member([&](string_ref name, const value& member) {
+        names += name.str() + save(member);
+    });
+    REQUIRE(names == R"(id4name"x")");
+    // Writes are seen by later reads.
+    auto copy{rows[5]};
+    static_cast<const value&>(copy).as_object();
+    *copy.find_member("id") = 6;
+    REQUIRE(static_cast<const value&>(copy).as_object().at("id").as_int64() ==
+            6);
+    // Members held through const access stay valid across mutable access,
+    // and const access does not copy the members.
+    auto held{rows[6]};
+    counting_resource access_resource;
+    const value::object_type* members{};
+    const value* name{};
+    {
+        scoped_resource scope{&access_resource};
+        members = &static_cast<const value&>(held).as_object();
+        name = &members->at("name");
+        REQUIRE(held.find_member("id")->as_int64() == 6);
+        REQUIRE(held.as_object().entry_at(0).first == "id");
+    }
+    REQUIRE(access_resource.allocated() == 0);
+    held.as_object()["name"] = "y";
+    REQUIRE(name->as_string() == "y");
+    held.as_object()["extra"] = false;
+    REQUIRE(members == &held.as_object());
+    REQUIRE(members->size() == 3);
+}
+
+TEST_CASE("columnar export") {
+    using namespace langnes::json;
+    auto rows{load(R"([
+        {"id":1,"name":"a","score":1.5,"ok":true,"tags":[1]},
+        {"id":2,"score":2,"ok":null,"tags":"x"},
+        {"name":"c","id":3,"score":3,"ok":false,"extra":null}
+    ])")};
+    auto columns{to_columns(rows, 2)};
+    REQUIRE(columns.size() == 6);
+
+    const auto& id{columns[0]};
+    REQUIRE(id.name == "id");
+    REQUIRE(id.type == column_type::int64);
+    REQUIRE(id.length == 3);
+    REQUIRE(id.null_count == 0);
+    REQUIRE(id.validity.empty());
+    REQUIRE(id.int64_values == std::vector<std::int64_t>({1, 2, 3}));
+
+    const auto& name{columns[1]};
+    REQUIRE(name.type == column_type::string);
+    REQUIRE(name.null_count == 1);
+    REQUIRE(name.validity == std::vector<std::uint8_t>({0x5}));
+    REQUIRE(name.offsets == std::vector<std::int64_t>({0, 1, 1, 2}));
+    REQUIRE(name.string_data == "ac");
+
+    REQUIRE(columns[2].type == column_type::float64);
+    REQUIRE(columns[2].float64_values == std::vector<double>({1.5, 2, 3}));
+
+    const auto& ok{columns[3]};
+    REQUIRE(ok.type == column_type::boolean);
+    REQUIRE(ok.validity == std::vector<std::uint8_t>({0x5}));
+    REQUIRE(ok.boolean_values == std::vector<std::uint8_t>({0x1}));
+
+    const auto& tags{columns[4]};
+    REQUIRE(tags.type == column_type::json);
+    REQUIRE(tags.string_data == R"([1]"x")");
+    REQUIRE(tags.offsets == std::vector<std::int64_t>({0, 3, 6, 6}));
+
+    REQUIRE(columns[5].name == "extra");
+    REQUIRE(columns[5].type == column_type::null);
+    REQUIRE(columns[5].null_count == 3);
+
+    // Rows with shared shapes give the same result.
+    parse_options options;
+    options.share_object_shapes = true;
+    auto shaped{to_columns(load(R"([{"a":1},{"a":2},{"b":"x"},{"a":3}])",
+                                options))};
+    REQUIRE(shaped.size() == 2);
+    REQUIRE(shaped[0].int64_values == std::vector<std::int64_t>({1, 2, 0, 3}));
+    REQUIRE(shaped[1].string_data == "x");
+
+    // Integers beyond int64 get an exact column of their own.
+    auto large{to_columns(load(R"([
+        {"u":18446744073709551615,"m":18446744073709551615},
+        {"u":1,"m":-1},
+        {"u":null,"m":0.5}
+    ])"))};
+    REQUIRE(large[0].type == column_type::uint64);
+    REQUIRE(large[0].uint64_values ==
+            std::vector<std::uint64_t>({18446744073709551615U, 1, 0}));
+    REQUIRE(large[0].validity == std::vector<std::uint8_t>({0x3}));
+    REQUIRE(large[1].type == column_type::json);
+    REQUIRE(large[1].string_data == "18446744073709551615-10.5");
+
+    bool errored{};
+    try {
+        to_columns(load("[1]"));
+    } catch (const bad_access&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+TEST_CASE("CBOR") {
+    using namespace langnes::json;
+    using bytes = std::vector<std::uint8_t>;
+    REQUIRE(save_cbor(load("0")) == bytes({0x00}));
+    REQUIRE(save_cbor(load("24")) == bytes({0x18, 0x18}));
+    REQUIRE(save_cbor(load("-1")) == bytes({0x20}));
+    REQUIRE(save_cbor(load("1.5")) == bytes({0xf9, 0x3e, 0x00}));
+    REQUIRE(save_cbor(load("100000.0")) ==
+            bytes({0x1a, 0x00, 0x01, 0x86, 0xa0}));
+    REQUIRE(save_cbor(load("3.4028234663852886e+38")) ==
+            bytes({0xfa, 0x7f, 0x7f, 0xff, 0xff}));
+    REQUIRE(save_cbor(load("1.1")) == bytes({0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99,
+                                             0x99, 0x99, 0x9a}));
+    REQUIRE(save_cbor(load("18446744073709551615")) ==
+            bytes({0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}));
+    REQUIRE(save_cbor(load(R"({"a":[1,"b",true,null]})")) ==
+            bytes({0xa1, 0x61, 0x61, 0x84, 0x01, 0x61, 0x62, 0xf5, 0xf6}));
+
+    auto input{R"({"id":-12345678901,"tags":["x","y"],"ratio":0.25,)"
+               R"("nested":{"ok":false,"none":null},"text":"aé"})"};
+    auto v{load(input)};
+    auto encoded{save_cbor(v)};
+    REQUIRE(save_cbor(load_cbor(encoded)) == encoded);
+    REQUIRE(load_cbor(encoded).at_pointer("/id").as_int64() == -12345678901);
+    REQUIRE(load_cbor(encoded).at_pointer("/text").as_string() == "aé");
+    parse_options packed;
+    packed.pack_numeric_arrays = true;
+    REQUIRE(save(load_cbor(save_cbor(load("[1,2.5,-3]", packed)))) ==
+            "[1,2.5,-3]");
+
+    // Indefinite lengths, tags, byte strings and non-finite floats.
+    REQUIRE(save(load_cbor(bytes({0x9f, 0x01, 0x82, 0x02, 0x03, 0xff}))) ==
+            "[1,[2,3]]");
+    REQUIRE(save(load_cbor(
+                bytes({0x7f, 0x62, 0x61, 0x62, 0x61, 0x63, 0xff}))) ==
+            R"("abc")");
+    REQUIRE(load_cbor(bytes({0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0}))
+                .as_int64() == 1363896240);
+    REQUIRE(load_cbor(bytes({0x43, 0x01, 0x02, 0x03})).as_string() == "AQID");
+    REQUIRE(load_cbor(bytes({0xf9, 0x7c, 0x00})).is_null());
+    REQUIRE(load_cbor(bytes({0xf7})).is_null());
+    REQUIRE(load_cbor(bytes({0x3b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                             0xff}))
+                .as_number() == -18446744073709551616.0);
+
+    auto fails = [](const bytes& data) {
+        try {
+            load_cbor(data);
+        } catch (const parse_error&) {
+            return true;
+        }
+        return false;
+    };
+    REQUIRE(fails({0x82, 0x01}));
+    REQUIRE(fails({0xa1, 0x01, 0x02}));
+    REQUIRE(fails({0x01, 0x02}));
+    REQUIRE(fails({0xff}));
+    REQUIRE(fails({0x9b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}));
+    // Text strings and map keys must be valid UTF-8, chunk by chunk.
+    REQUIRE(fails({0x62, 0xc3, 0x28}));
+    REQUIRE(fails({0xa1, 0x61, 0xff, 0x01}));
+    REQUIRE(fails({0x7f, 0x62, 0x61, 0xc3, 0x61, 0xa9, 0xff}));
+    REQUIRE(load_cbor(bytes({0x62, 0xc3, 0xa9})).as_string() == "\xc3\xa9");
+
+    parse_options limited;
+    limited.max_depth = 1;
+    bool errored{};
+    try {
+        load_cbor(bytes({0x81, 0x81, 0x01}), limited);
+    } catch (const out_of_range&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+TEST_CASE("MessagePack") {
+    using namespace langnes::json;
+    using bytes = std::vector<std::uint8_t>;
+    REQUIRE(save_msgpack(load("0")) == bytes({0x00}));
+    REQUIRE(save_msgpack(load("-1")) == bytes({0xff}));
+    REQUIRE(save_msgpack(load("-33")) == bytes({0xd0, 0xdf}));
+    REQUIRE(save_msgpack(load("128")) == bytes({0xcc, 0x80}));
+    REQUIRE(save_msgpack(load("65536")) ==
+            bytes({0xce, 0x00, 0x01, 0x00, 0x00}));
+    REQUIRE(save_msgpack(load("-9223372036854775808")) ==
+            bytes({0xd3, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+    REQUIRE(save_msgpack(load("1.5")) == bytes({0xca, 0x3f, 0xc0, 0x00, 0x00}));
+    REQUIRE(save_msgpack(load("1.1")) == bytes({0xcb, 0x3f, 0xf1, 0x99, 0x99,
+                                                0x99, 0x99, 0x99, 0x9a}));
+    REQUIRE(save_msgpack(load(R"({"a":[1,true,null]})")) ==
+            bytes({0x81, 0xa1, 0x61, 0x93, 0x01, 0xc3, 0xc0}));
+    auto long_string{save_msgpack(value{std::string(32, 'x')})};
+    REQUIRE(long_string.size() == 34);
+    REQUIRE(long_string[0] == 0xd9);
+    REQUIRE(long_string[1] == 32);
+
+    auto v{load(R"({"id":-12345678901,"big":18446744073709551615,)"
+                R"("tags":["x","y"],"ratio":0.25,"nested":{"ok":false}})")};
+    auto encoded{save_msgpack(v)};
+    REQUIRE(save_msgpack(load_msgpack(encoded)) == encoded);
+    REQUIRE(load_msgpack(encoded).at_pointer("/big").as_uint64() ==
+            18446744073709551615U);
+
+    REQUIRE(load_msgpack(bytes({0xc4, 0x03, 0x01, 0x02, 0x03})).as_string() ==
+            "AQID");
+    REQUIRE(load_msgpack(bytes({0xd6, 0xff, 0x00, 0x00, 0x00, 0x01}))
+                .as_string() == "AAAAAQ");
+    REQUIRE(load_msgpack(bytes({0xca, 0x7f, 0x80, 0x00, 0x00})).is_null());
+    REQUIRE(save(load_msgpack(bytes({0xdc, 0x00, 0x02, 0x01, 0xd1, 0xff,
+                                     0x00}))) == "[1,-256]");
+
+    auto fails = [](const bytes& data) {
+        try {
+            load_msgpack(data);
+        } catch (const parse_error&) {
+            return true;
+        }
+        return false;
+    };
+    REQUIRE(fails({0xc1}));
+    REQUIRE(fails({0x81, 0x01, 0x01}));
+    REQUIRE(fails({0x92, 0x01}));
+    REQUIRE(fails({0xdd, 0xff, 0xff, 0xff, 0xff}));
+    REQUIRE(fails({0x01, 0x02}));
+
+    // Consecutive values in a stream.
+    std::string stream_data{"\x92\x01\x02\xa1z", 5};
+    std::istringstream is{stream_data};
+    REQUIRE(save(load_msgpack(is)) == "[1,2]");
+    REQUIRE(load_msgpack(is).as_string() == "z");
+
+    // Values fed one byte at a time.
+    msgpack_decoder decoder;
+    auto data{save_msgpack(load(R"([{"a":1},{"a":2}])"))};
+    data.push_back(0xc3);
+    std::vector<value> decoded;
+    for (auto byte : data) {
+        decoder.feed(&byte, 1);
+        value result;
+        while (decoder.next(result)) {
+            decoded.push_back(std::move(result));
+        }
+    }
+    REQUIRE(decoded.size() == 2);
+    REQUIRE(save(decoded[0]) == R"([{"a":1},{"a":2}])");
+    REQUIRE(decoded[1].as_boolean());
+    REQUIRE(decoder.buffered_length() == 0);
+
+    // Every kind of header can be split, and each value is decoded once.
+    const std::vector<bytes> items{
+        {0xc5, 0x00, 0x02, 0xaa, 0xbb},
+        {0xd4, 0x01, 0x07},
+        {0xc7, 0x01, 0x05, 0x09},
+        {0xca, 0x3f, 0x80, 0x00, 0x00},
+        {0xd3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe},
+        {0xdc, 0x00, 0x01, 0x01},
+        {0xde, 0x00, 0x01, 0xa1, 'k', 0xc0},
+        {0xda, 0x00, 0x01, 's'},
+        {0x82, 0xa1, 'a', 0x90, 0xa1, 'b', 0xcd, 0x01, 0x00}};
+    for (const auto& item : items) {
+        msgpack_decoder split;
+        value result;
+        for (size_t i{}; i + 1 < item.size(); ++i) {
+            split.feed(&item[i], 1);
+            REQUIRE(!split.next(result));
+        }
+        split.feed(&item.back(), 1);
+        REQUIRE(split.next(result));
+        REQUIRE(result == load_msgpack(item));
+    }
+    const bytes malformed{0xc1, 0x01};
+    decoder.feed(malformed.data(), malformed.size());
+    value ignored;
+    REQUIRE(fails_with<parse_error>([&] { decoder.next(ignored); }));
+    REQUIRE(decoder.buffered_length() == 0);
+
+    // Deep nesting is limited even without a limit in the options.
+    bytes deep(2000, 0x91);
+    deep.push_back(0x01);
+    REQUIRE(fails_with<out_of_range>([&] { load_msgpack(deep); }));
+    std::fill(deep.begin(), deep.end() - 1, 0x81);
+    REQUIRE(fails_with<out_of_range>([&] { load_cbor(deep); }));
+    parse_options deeper;
+    deeper.max_depth = 3000;
+    REQUIRE(load_cbor(deep, deeper).is_array());
+}
+
+TEST_CASE("snapshot") {
+    using namespace langnes::json;
+    auto v{load(R"({"id":-12345678901,"big":18446744073709551615,)"
+                R"("name":"caf\u00e9","tags":["x","y"],"ratio":0.25,)"
+                R"("items":[{"id":1},{"id":2}],"none":null,"ok":true})")};
+    auto snap{open_snapshot(save_snapshot(v))};
+    REQUIRE(snap.is_object());
+    REQUIRE(snap.size() == 8);
+    REQUIRE(snap["id"].as_int64() == -12345678901);
+    REQUIRE(snap["big"].as_uint64() == 18446744073709551615U);
+    REQUIRE(snap["name"].as_string() == "caf\xc3\xa9");
+    REQUIRE(snap["ratio"].as_number() == 0.25);
+    REQUIRE(snap["none"].is_null());
+    REQUIRE(snap["ok"].as_boolean());
+    REQUIRE(snap["tags"][1].as_string() == "y");
+    REQUIRE(snap["items"][1]["id"].as_int64() == 2);
+    REQUIRE(snap.find("missing") == snap.end());
+    REQUIRE(save_snapshot(snap.materialize()) == save_snapshot(v));
+
+    std::string keys;
+    for (auto it{snap.begin()}; it != snap.end(); ++it) {
+        auto key{it.key()};
+        keys.append(key.data(), key.size()).push_back(',');
+    }
+    REQUIRE(keys == "id,big,name,tags,ratio,items,none,ok,");
+
+    // Views remain valid when the snapshot is moved.
+    auto items{snap["items"]};
+    auto moved{std::move(snap)};
+    REQUIRE(items[0]["id"].as_int64() == 1);
+
+    const char* path{"langnes_json_snapshot_test.bin"};
+    save_snapshot(v, path);
+    {
+        auto mapped{open_snapshot(path)};
+        REQUIRE(save_snapshot(mapped.materialize()) == save_snapshot(v));
+    }
+    std::remove(path);
+
+    auto fails = [](std::vector<std::uint8_t> data) {
+        try {
+            auto s{open_snapshot(std::move(data))};
+            s.materialize();
+        } catch (const parse_error&) {
+            return true;
+        }
+        return false;
+    };
+    auto data{save_snapshot(v)};
+    REQUIRE(!fails(data));
+    REQUIRE(fails({}));
+    REQUIRE(fails({data.begin(), data.end() - 1}));
+    auto corrupted{data};
+    corrupted[32] = 0xff;
+    REQUIRE(fails(corrupted));
+    corrupted = data;
+    // Make the root refer to itself as its first child.
+    std::fill(corrupted.begin() + 40, corrupted.begin() + 48, 0);
+    REQUIRE(fails(corrupted));
+
+    bool errored{};
+    try {
+        moved["id"].as_string();
+    } catch (const bad_access&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+
+    // Larger objects are looked up through the sorted index.
+    auto wide{make_object({})};
+    for (int i{20}; i > 0; --i) {
+        wide.as_object()[std::string{"k"} + std::to_string(i)] = i;
+    }
+    wide.as_object()[std::string{"k\0", 2}] = 0;
+    auto wide_snap{open_snapshot(save_snapshot(wide))};
+    for (int i{1}; i <= 20; ++i) {
+        auto name{std::string{"k"} + std::to_string(i)};
+        REQUIRE(wide_snap[name].as_int64() == i);
+    }
+    string_ref nul_name{"k\0", 2};
+    REQUIRE(wide_snap[nul_name].as_int64() == 0);
+    REQUIRE(wide_snap.begin().key().data()[1] == '2');
+    for (const char* name : {"", "a", "k", "k0", "k21", "k3x", "z"}) {
+        REQUIRE(wide_snap.find(name) == wide_snap.end());
+    }
+    REQUIRE(save_snapshot(wide_snap.materialize()) == save_snapshot(wide));
+}
+
+TEST_CASE("equality and hashing") {
+    using namespace langnes::json;
+    auto a{load(R"({"a":[1,"x"],"b":null})")};
+    auto b{load(R"({"b":null,"a":[1.0,"x"]})")};
+    REQUIRE(a == b);
+    REQUIRE(a.hash() == b.hash());
+    // Hashes are stable across runs.
+    REQUIRE(a.hash() == 3425635888318390232U);
+    REQUIRE(a != load(R"({"a":[1,"x"],"b":false})"));
+    REQUIRE(a != load(R"({"a":[1,"x"],"c":null})"));
+    REQUIRE(a != load(R"({"a":[1,"x"]})"));
+    REQUIRE(a.hash() != load(R"({"a":["x",1],"b":null})").hash());
+
+    REQUIRE(load("-0") == load("0"));
+    REQUIRE(load("18446744073709551615") != load("1.8446744073709552e19"));
+    REQUIRE(load("9007199254740993") != load("9007199254740992"));
+    REQUIRE(load("1").hash() == value{1.0}.hash());
+    REQUIRE(load("\"1\"") != load("1"));
+
+    // Packed arrays compare equal to generic ones.
+    parse_options pack_options;
+    pack_options.pack_numeric_arrays = true;
+    auto packed{load("[1,2.5]", pack_options)};
+    REQUIRE(packed.as_number_span().size() == 2);
+    auto generic{load("[1,2.5]")};
+    REQUIRE(packed == generic);
+    REQUIRE(packed.hash() == generic.hash());
+
+    // Objects with shared shapes compare equal to objects with dicts.
+    parse_options options;
+    options.share_object_shapes = true;
+    const std::string rows{R"([{"id":1,"name":"x"},{"id":1,"name":"x"}])"};
+    auto shared{load(rows, options)};
+    REQUIRE(shared.as_array()[0] == shared.as_array()[1]);
+    REQUIRE(shared == load(rows));
+    REQUIRE(shared.hash() == load(rows).hash());
+
+    // Cached hashes are discarded when a value is modified.
+    auto cached{a.clone()};
+    auto h{cached.hash(true)};
+    REQUIRE(cached.hash() == h);
+    cached.as_object()["c"] = true;
+    REQUIRE(cached.hash() != h);
+    REQUIRE(cached != a);
+
+    // Stale cached hashes do not affect equality.
+    auto outer{load(R"({"x":{"y":[1]}})")};
+    auto copy{outer};
+    auto& nested{outer.as_object()["x"].as_object()["y"].as_array()};
+    outer.hash(true);
+    copy.hash(true);
+    nested[0] = 2;
+    REQUIRE(outer != copy);
+    nested[0] = 1;
+    REQUIRE(outer == copy);
+    *outer.find_pointer("/x/y/0") = 3;
+    REQUIRE(outer != copy);
+    REQUIRE(outer.hash() != copy.hash());
+
+    // Modifying a nested value through a reference obtained before hashing
+    // discards the cached hashes of the enclosing values.
+    auto& item{outer.at_pointer("/x/y/0")};
+    item = 1;
+    auto outer_hash{outer.hash(true)};
+    REQUIRE(outer_hash == copy.hash(true));
+    REQUIRE(outer == copy);
+    item = 4;
+    REQUIRE(outer.hash() != outer_hash);
+    REQUIRE(outer != copy);
+    nested.push_back(value{5});
+    REQUIRE(outer.hash(true) != copy.hash(true));
+    REQUIRE(outer != copy);
+    nested.pop_back();
+    nested[0].as_number() = 1;
+    REQUIRE(outer.hash() == copy.hash());
+    REQUIRE(outer == copy);
+
+    std::unordered_set<value> seen;
+    seen.insert(a);
+    REQUIRE(seen.count(b) == 1);
+    REQUIRE(seen.count(load("{}")) == 0);
+}
+
+TEST_CASE("JSON Patch") {
+    using namespace langnes::json;
+    auto doc{load(R"({"foo":["bar","baz"],"obj":{"a":1}})")};
+    apply_patch(doc, load(R"([
+        {"op":"add","path":"/foo/1","value":"qux"},
+        {"op":"add","path":"/foo/-","value":"end"},
+        {"op":"remove","path":"/foo/0"},
+        {"op":"replace","path":"/obj/a","value":2},
+        {"op":"move","from":"/obj","path":"/moved"},
+        {"op":"copy","from":"/moved/a","path":"/a~1b"},
+        {"op":"test","path":"/foo","value":["qux","baz","end"]}
+    ])"));
+    REQUIRE(doc == load(R"({"foo":["qux","baz","end"],"moved":{"a":2},)"
+                        R"("a/b":2})"));
+    apply_patch(doc, load(R"([{"op":"replace","path":"","value":[1]}])"));
+    REQUIRE(save(doc) == "[1]");
+
+    auto fails = [](const char* patch) {
+        auto target{load(R"({"a":[1,2],"b":{}})")};
+        try {
+            apply_patch(target, load(patch));
+        } catch (const error& e) {
+            return e.code();
+        }
+        return error_code::ok;
+    };
+    REQUIRE(fails(R"([{"op":"test","path":"/a/0","value":2}])") ==
+            error_code::invalid_state);
+    REQUIRE(fails(R"([{"op":"remove","path":"/c"}])") ==
+            error_code::out_of_range);
+    REQUIRE(fails(R"([{"op":"add","path":"/a/3","value":0}])") ==
+            error_code::out_of_range);
+    REQUIRE(fails(R"([{"op":"move","from":"/b","path":"/b/c"}])") ==
+            error_code::invalid_argument);
+    REQUIRE(fails(R"([{"op":"add","path":"/c"}])") ==
+            error_code::invalid_argument);
+    REQUIRE(fails(R"([{"op":"frobnicate","path":"/a"}])") ==
+            error_code::invalid_argument);
+    REQUIRE(fails(R"({"op":"remove","path":"/a"})") ==
+            error_code::invalid_argument);
+
+    // A failing patch leaves the target unchanged.
+    auto unchanged{load(R"({"a":[1,2]})")};
+    auto failing{load(R"([{"op":"remove","path":"/a/0"},)"
+                      R"({"op":"test","path":"/a","value":[]}])")};
+    REQUIRE(fails_with<invalid_state>(
+        [&] { apply_patch(unchanged, std::move(failing)); }));
+    REQUIRE(save(unchanged) == R"({"a":[1,2]})");
+
+    // Values are moved out of an owned patch.
+    auto patch{load(R"([{"op":"add","path":"/x","value":{"y":true}}])")};
+    const auto* moved_from{&patch.as_array()[0].at_pointer("/value/y")};
+    auto target{make_object({})};
+    apply_patch(target, std::move(patch));
+    REQUIRE(&target.at_pointer("/x/y") == moved_from);
+}
+
+TEST_CASE("JSON Patch diff") {
+    using namespace langnes::json;
+    auto check = [](const char* from, const char* to) {
+        auto source{load(from)};
+        auto target{load(to)};
+        auto patch{diff(source, target)};
+        apply_patch(source, patch);
+        REQUIRE(source == target);
+        return patch;
+    };
+    REQUIRE(check(R"({"a":1,"b":[1,2]})", R"({"b":[1,2],"a":1})") ==
+            load("[]"));
+    REQUIRE(check(R"({"a":1,"b":2})", R"({"a":1,"c":3})") ==
+            load(R"([{"op":"remove","path":"/b"},)"
+                 R"({"op":"add","path":"/c","value":3}])"));
+    REQUIRE(check(R"({"a/b":{"c":1}})", R"({"a/b":{"c":2}})") ==
+            load(R"([{"op":"replace","path":"/a~1b/c","value":2}])"));
+    // Insertions and removals in the middle of arrays are aligned.
+    REQUIRE(check("[1,2,3,4,5]", "[1,2,9,3,4,5]") ==
+            load(R"([{"op":"add","path":"/2","value":9}])"));
+    REQUIRE(check("[1,2,3,4,5]", "[1,3,5]") ==
+            load(R"([{"op":"remove","path":"/1"},)"
+                 R"({"op":"remove","path":"/2"}])"));
+    REQUIRE(check(R"([{"id":1,"v":"a"},{"id":2}])",
+                  R"([{"id":1,"v":"b"},{"id":2}])") ==
+            load(R"([{"op":"replace","path":"/0/v","value":"b"}])"));
+    REQUIRE(check("[1,2]", R"({"a":1})") ==
+            load(R"([{"op":"replace","path":"","value":{"a":1}}])"));
+    check("[0,1,2,3,4,5,6,7,8,9]", "[9,8,7,6,5,4,3,2,1,0,10]");
+    check(R"([[1,2],{"a":[3]},"x",null])", R"([{"a":[3,4]},[2],"y"])");
+
+    // Shared object shapes and packed arrays are diffed without changing
+    // their layout.
+    parse_options options;
+    options.share_object_shapes = true;
+    options.pack_numeric_arrays = true;
+    const auto rows{load(R"([{"a":[1,2],"b":{"c":3}},{"a":[4],"b":{"c":5}}])",
+                         options)};
+    const auto changed{load(R"([{"a":[1,2],"b":{"c":3}},{"a":[4],"b":6}])",
+                            options)};
+    REQUIRE(diff(rows, rows.clone()) == load("[]"));
+    REQUIRE(diff(rows, changed) ==
+            load(R"([{"op":"replace","path":"/1/b","value":6}])"));
+    REQUIRE(rows.as_array()[0].at_pointer("/a").as_number_span().size() ==
+            2);
+}
+
+TEST_CASE("JSON Merge Patch") {
+    using namespace langnes::json;
+    auto target{load(R"({"title":"Goodbye!","author":{"givenName":"John",)"
+                     R"("familyName":"Doe"},"tags":["example","sample"],)"
+                     R"("content":"This will be unchanged"})")};
+    merge_patch(target, load(R"({"title":"Hello!","phoneNumber":"+01-123",)"
+                             R"("author":{"familyName":null},"tags":["x"],)"
+                             R"("new":{"a":null,"b":1}})"));
+    REQUIRE(target ==
+            load(R"({"title":"Hello!","author":{"givenName":"John"},)"
+                 R"("tags":["x"],"content":"This will be unchanged",)"
+                 R"("phoneNumber":"+01-123","new":{"b":1}})"));
+
+    auto scalar{load(R"({"a":1})")};
+    merge_patch(scalar, load("[1]"));
+    REQUIRE(save(scalar) == "[1]");
+    merge_patch(scalar, load(R"({"a":{"b":null}})"));
+    REQUIRE(save(scalar) == R"({"a":{}})");
+
+    // Subtrees are moved rather than copied.
+    auto patch{load(R"({"a":{"c":[1,2]}})")};
+    const auto* moved_from{&patch.at_pointer("/a/c").impl()};
+    merge_patch(scalar, std::move(patch));
+    REQUIRE(&scalar.at_pointer("/a/c").impl() == moved_from);
+}
+
+TEST_CASE("canonical JSON") {
+    using namespace langnes::json;
+    // Examples from RFC 8785.
+    REQUIRE(save_canonical(load(
+                R"({"numbers":[333333333.33333329,1E30,4.50,2e-3,)"
+                R"(0.000000000000000000000000001],"string":)"
+                R"("\u20ac$\u000F\nA'B\"\\\\\"\/",)"
+                R"("literals":[null,true,false]})")) ==
+            R"({"literals":[null,true,false],"numbers":[333333333.3333333,)"
+            R"(1e+30,4.5,0.002,1e-27],"string":")"
+            "\xe2\x82\xac"
+            R"($\u000f\nA'B\"\\\\\"/"})");
+    REQUIRE(save_canonical(load(
+                "{\"\\u20ac\":1,\"\\r\":2,\"\\ufb33\":3,\"1\":4,"
+                "\"\xf0\x9f\x98\x80\":5,\"\\u0080\":6,\"\\u00f6\":7}")) ==
+            "{\"\\r\":2,\"1\":4,\"\xc2\x80\":6,\"\xc3\xb6\":7,"
+            "\"\xe2\x82\xac\":1,\"\xf0\x9f\x98\x80\":5,"
+            "\"\xef\xac\xb3\":3}");
+
+    auto number = [](double v) { return save_canonical(value{v}); };
+    REQUIRE(number(-0.0) == "0");
+    REQUIRE(number(1e21) == "1e+21");
+    REQUIRE(number(1e20) == "100000000000000000000");
+    REQUIRE(number(1e-6) == "0.000001");
+    REQUIRE(number(1e-7) == "1e-7");
+    REQUIRE(number(-4.5e-7) == "-4.5e-7");
+    REQUIRE(number(5e-324) == "5e-324");
+    REQUIRE(number(1.7976931348623157e308) == "1.7976931348623157e+308");
+    REQUIRE(save_canonical(load("18446744073709551615")) ==
+            "18446744073709552000");
+
+    // Objects with shared shapes are sorted once per shape.
+    parse_options options;
+    options.share_object_shapes = true;
+    auto rows{load(R"([{"b":1,"a":{"d":1,"c":2}},{"b":2,"a":null}])",
+                   options)};
+    REQUIRE(save_canonical(rows) ==
+            R"([{"a":{"c":2,"d":1},"b":1},{"a":null,"b":2}])");
+    std::array<char, 8> buffer{};
+    REQUIRE(save_canonical(rows, buffer.data(), buffer.size()) == 44);
+    REQUIRE(std::string(buffer.data(), buffer.size()) == R"([{"a":{")");
+
+    bool errored{};
+    try {
+        save_canonical(value{std::numeric_limits<double>::infinity()});
+    } catch (const invalid_argument&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+}
+
+TEST_CASE("JSON Schema") {
+    using namespace langnes::json;
+    compiled_schema schema{load(R"({
+        "type": "object",
+        "required": ["id", "tags"],
+        "properties": {
+            "id": {"type": "integer", "minimum": 1},
+            "name": {"type": "string", "minLength": 2, "maxLength": 3},
+            "tags": {"type": "array", "items": {"$ref": "#/$defs/tag"},
+                     "uniqueItems": true},
+            "child": {"$ref": "#"}
+        },
+        "patternProperties": {"^x-": {"type": "boolean"}},
+        "additionalProperties": false,
+        "$defs": {"tag": {"enum": ["a", "b", 1.0]}}
+    })")};
+    REQUIRE(schema.is_valid(load(R"({"id":1,"tags":["a",1]})")));
+    REQUIRE(schema.is_valid(load(
+        R"({"id":2.0,"tags":[],"x-y":true,"name":"\u00e6\u00f8\u00e5",)"
+        R"("child":{"id":3,"tags":["b"]}})")));
+    REQUIRE(!schema.is_valid(load(R"({"id":0,"tags":[]})")));
+    REQUIRE(!schema.is_valid(load(R"({"id":1.5,"tags":[]})")));
+    REQUIRE(!schema.is_valid(load(R"({"id":1,"tags":["a","a"]})")));
+    REQUIRE(!schema.is_valid(load(R"({"id":1,"tags":[],"x-y":1})")));
+    REQUIRE(!schema.is_valid(load(R"({"id":1,"tags":[],"other":1})")));
+    REQUIRE(!schema.is_valid(load(R"({"id":1,"tags":[],"name":"abcd"})")));
+
+    auto failure = [&](const char* json) {
+        try {
+            schema.validate(load(json));
+        } catch (const validation_error& e) {
+            return e.pointer() + " " + e.keyword();
+        }
+        return std::string{};
+    };
+    REQUIRE(failure(R"({"id":1,"tags":["a"]})").empty());
+    REQUIRE(failure(R"([])") == " type");
+    REQUIRE(failure(R"({"id":1})") == " required");
+    REQUIRE(failure(R"({"id":1,"tags":["a","c"]})") == "/tags/1 enum");
+    REQUIRE(failure(R"({"id":1,"tags":[],"child":{"id":1,"tags":{}}})") ==
+            "/child/tags type");
+
+    // Loading stops at the first invalid member.
+    auto load_failure = [&](const std::string& json) {
+        try {
+            load_validated(json, schema);
+        } catch (const validation_error& e) {
+            return e.pointer() + " " + e.keyword();
+        }
+        return std::string{};
+    };
+    REQUIRE(load_failure(R"({"id":1,"tags":["a"],"child":)"
+                         R"({"id":2,"tags":["b",1]}})")
+                .empty());
+    REQUIRE(load_failure(R"({"id":1,"tags":["a","c"]})") == "/tags/1 enum");
+    REQUIRE(load_failure(R"({"child":{"id":"1",)") == "/child/id type");
+    REQUIRE(load_failure(R"({"tags":[],"x-y":null)") == "/x-y type");
+    REQUIRE(load_failure(R"({"id":1,"tags":[]})").empty());
+    REQUIRE(load_failure(R"({"tags":[]})") == " required");
+
+    parse_options options;
+    options.share_object_shapes = true;
+    auto rows{load_validated(
+        R"([{"id":1,"tags":[]},{"id":2,"tags":["a"]}])",
+        compiled_schema{load(R"({"items":{"$ref":"#/$defs/row"},)"
+                             R"("$defs":{"row":{"required":["id"]}}})")},
+        options)};
+    REQUIRE(rows == load(R"([{"id":1,"tags":[]},{"id":2,"tags":["a"]}])"));
+
+    // Only the first occurrence of a member name is kept, so loading agrees
+    // with validating the loaded value.
+    compiled_schema limited{
+        load(R"({"maxProperties":2,"properties":{"a":{"type":"number"}},)"
+             R"("additionalProperties":{"type":"string"}})")};
+    std::string repeated{R"({"a":1,"b":"x")"};
+    for (int i{}; i < 12; ++i) {
+        repeated += R"(,"a":"y","b":2)";
+    }
+    repeated += '}';
+    for (const auto* json : {R"({"a":1,"a":"x"})", R"({"a":1,"b":"x","a":2})",
+                             R"({"a":"x","a":1})", R"({"a":1,"b":"x","c":"y"})",
+                             repeated.c_str()}) {
+        auto expected{limited.is_valid(load(json))};
+        for (auto shared : {false, true}) {
+            parse_options shared_options;
+            shared_options.share_object_shapes = shared;
+            auto valid{true};
+            try {
+                load_validated(json, limited, shared_options);
+            } catch (const validation_error&) {
+                valid = false;
+            }
+            REQUIRE(valid == expected);
+        }
+    }
+    REQUIRE(limited.is_valid(load(repeated)));
+    REQUIRE(!limited.is_valid(load(R"({"a":"x","a":1})")));
+
+    // References are percent-encoded JSON pointers.
+    compiled_schema encoded{load(R"({"$ref":"#/$defs/a%25b%22c",)"
+                                 R"("$defs":{"a%b\"c":{"type":"string"}}})")};
+    REQUIRE(encoded.is_valid(load(R"("x")")));
+    REQUIRE(!encoded.is_valid(load("1")));
+
+    compiled_schema combined{load(R"({
+        "anyOf": [{"type": "string"}, {"type": "number", "multipleOf": 0.1}],
+        "not": {"const": 0.3},
+        "if": {"type": "number"}, "then": {"exclusiveMaximum": 1}
+    })")};
+    REQUIRE(combined.is_valid(load("0.7")));
+    REQUIRE(combined.is_valid(load(R"("x")")));
+    REQUIRE(!combined.is_valid(load("0.75")));
+    REQUIRE(!combined.is_valid(load("0.3")));
+    REQUIRE(!combined.is_valid(load("1")));
+    REQUIRE(!combined.is_valid(load("null")));
+
+    auto fails = [](const char* json) {
+        try {
+            compiled_schema{load(json)};
+        } catch (const invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    REQUIRE(fails(R"({"type":"text"})"));
+    REQUIRE(fails(R"({"$ref":"#/missing"})"));
+    REQUIRE(fails(R"({"$ref":"other.json"})"));
+    REQUIRE(fails(R"({"$ref":"#/a%2"})"));
+    REQUIRE(fails(R"({"$ref":"#/a%zz"})"));
+    REQUIRE(fails(R"({"allOf":[{"$ref":"#"}]})"));
+    REQUIRE(fails(R"({"pattern":"("})"));
+    REQUIRE(fails(R"({"pattern":"(a)\\1"})"));
+    REQUIRE(fails(R"({"minItems":-1})"));
+    REQUIRE(fails(R"({"unevaluatedProperties":false})"));
+    REQUIRE(fails(R"({"items":{"unevaluatedItems":false}})"));
+    REQUIRE(fails(R"({"dependentRequired":{"a":[1]}})"));
+    REQUIRE(compiled_schema{load(R"({"format":"email"})")}.is_valid(
+        load(R"("x")")));
+
+    // Patterns are matched without recursion.
+    compiled_schema lowercase{load(R"({"pattern":"^[a-z]*$"})")};
+    std::string long_string(200000, 'a');
+    REQUIRE(lowercase.is_valid(value{long_string}));
+    REQUIRE(!lowercase.is_valid(value{long_string + "A"}));
+
+    auto dependency_failure = [](const char* schema_json, const char* json) {
+        compiled_schema dependent{load(schema_json)};
+        std::string result;
+        try {
+            dependent.validate(load(json));
+        } catch (const validation_error& e) {
+            result = e.pointer() + " " + e.keyword();
+        }
+        std::string load_result;
+        try {
+            load_validated(json, dependent);
+        } catch (const validation_error& e) {
+            load_result = e.pointer() + " " + e.keyword();
+        }
+        REQUIRE(result == load_result);
+        return result;
+    };
+    const auto* legacy{R"({"dependencies":{"a":["b"],)"
+                       R"("c":{"properties":{"d":{"type":"string"}}}}})"};
+    REQUIRE(dependency_failure(legacy, R"({"a":1})") == " dependencies");
+    REQUIRE(dependency_failure(legacy, R"({"a":1,"b":2})").empty());
+    REQUIRE(dependency_failure(legacy, R"({"c":1,"d":2})") == "/d type");
+    REQUIRE(dependency_failure(legacy, R"({"d":2})").empty());
+    const auto* modern{R"({"dependentRequired":{"a":["b"]},)"
+                       R"("dependentSchemas":{"c":{"maxProperties":1}}})"};
+    REQUIRE(dependency_failure(modern, R"({"a":1})") ==
+            " dependentRequired");
+    REQUIRE(dependency_failure(modern, R"({"c":1,"d":2})") ==
+            " maxProperties");
+    REQUIRE(dependency_failure(modern, R"({"c":1})").empty());
+}
+
+TEST_CASE("JSONPath") {
+    using namespace langnes::json;
+    auto doc{load(R"({
+        "store": {
+            "book": [
+                {"category": "reference", "author": "Rees", "price": 8.95},
+                {"category": "fiction", "author": "Waugh", "price": 12.99},
+                {"category": "fiction", "author": "Melville", "price": 8.99,
+                 "isbn": "0-553-21311-3"},
+                {"category": "fiction", "author": "Tolkien", "price": 22.99,
+                 "isbn": "0-395-19395-8"}
+            ],
+            "bicycle": {"color": "red", "price": 399}
+        },
+        "limit": 10
+    })")};
+    auto strings = [&](const char* expression) {
+        std::string result;
+        for (const auto* v : compile_query(expression).evaluate(doc)) {
+            result += (result.empty() ? "" : ",") + save(*v);
+        }
+        return result;
+    };
+    REQUIRE(strings("$.store.book[*].author") ==
+            R"("Rees","Waugh","Melville","Tolkien")");
+    REQUIRE(strings("$['store']['book'][-1].author") == R"("Tolkien")");
+    REQUIRE(strings("$.store.book[0, 2].price") == "8.95,8.99");
+    REQUIRE(strings("$.store.book[1:3].author") == R"("Waugh","Melville")");
+    REQUIRE(strings("$.store.book[::-2].author") == R"("Tolkien","Waugh")");
+    REQUIRE(strings("$.store.book[?@.isbn].author") ==
+            R"("Melville","Tolkien")");
+    REQUIRE(strings("$.store.book[?!@.isbn].author") == R"("Rees","Waugh")");
+    REQUIRE(strings("$.store.book[?(@.price < $.limit)].author") ==
+            R"("Rees","Melville")");
+    REQUIRE(strings("$.store.book[?@.category == 'fiction' && "
+                    "(@.price > 20 || @.author == \"Waugh\")].author") ==
+            R"("Waugh","Tolkien")");
+    REQUIRE(strings("$..book[?@.missing == @.other].author") ==
+            R"("Rees","Waugh","Melville","Tolkien")");
+    REQUIRE(strings("$.store.bicycle[?@ == 'red']") == R"("red")");
+    REQUIRE(strings("$.store..price").size() ==
+            std::string{"8.95,12.99,8.99,22.99,399"}.size());
+    REQUIRE(strings("$.store.book[?@.price > 'a']").empty());
+    REQUIRE(strings("$.nothing[0]").empty());
+    REQUIRE(strings("$").size() > 100);
+
+    // Results refer to the document.
+    auto nodes{compile_query("$.store.bicycle.color").evaluate(doc)};
+    REQUIRE(nodes.size() == 1);
+    REQUIRE(nodes[0] == &doc.at_pointer("/store/bicycle/color"));
+
+    // Large arrays are split between threads without changing the order.
+    std::string orders{"{\"orders\":["};
+    for (int i{}; i < 50000; ++i) {
+        orders += (i == 0 ? "" : ",");
+        orders += R"({"id":)" + std::to_string(i) + R"(,"total":)" +
+                  std::to_string(i % 200) + "}";
+    }
+    orders += "]}";
+    auto orders_doc{load(orders)};
+    auto query{compile_query("$.orders[?(@.total > 100)].id")};
+    auto parallel{query.evaluate(orders_doc, 4)};
+    auto sequential{query.evaluate(orders_doc, 1)};
+    REQUIRE(parallel == sequential);
+    REQUIRE(parallel.size() == 24750);
+    REQUIRE(parallel[0]->as_int64() == 101);
+    REQUIRE(parallel.back()->as_int64() == 49999);
+
+    // Threads share the nodes of absolute paths, which reading leaves
+    // unchanged even with raw numbers, packed arrays and shared shapes.
+    parse_options options;
+    options.raw_numbers = true;
+    options.pack_numeric_arrays = true;
+    options.share_object_shapes = true;
+    std::string totals{R"("limit":100,"totals":[)"};
+    for (int i{}; i < 50000; ++i) {
+        totals += (i == 0 ? "" : ",") + std::to_string(i % 200);
+    }
+    orders.insert(1, totals + "],");
+    auto raw_doc{load(orders, options)};
+    auto raw_query{compile_query("$.orders[?@.total > $.limit].id")};
+    REQUIRE(raw_query.evaluate(raw_doc, 8).size() == 24750);
+    REQUIRE(compile_query("$.totals[?@ > $.limit]").evaluate(raw_doc, 8) ==
+            compile_query("$.totals[?@ > $.limit]").evaluate(raw_doc, 1));
+
+    auto fails = [](const char* expression) {
+        try {
+            compile_query(expression);
+        } catch (const invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    REQUIRE(fails("store"));
+    REQUIRE(fails("$.store["));
+    REQUIRE(fails("$[01]"));
+    REQUIRE(fails("$[-0]"));
+    REQUIRE(fails("$[0:02]"));
+    REQUIRE(fails("$[::-01]"));
+    REQUIRE(!fails("$[0, -1, 10:0:-1]"));
+    REQUIRE(fails("$[?@.a == ]"));
+    REQUIRE(fails("$[?@[*] == 1]"));
+    REQUIRE(fails("$[9007199254740992]"));
+    REQUIRE(fails("$['a"));
+}
+
+TEST_CASE("validate") {
+    using namespace langnes::json;
+    REQUIRE(validate(R"({"a":[1,-2.5e+3,true,false,null,{}],"b":"\u00e6\n"})"));
+    REQUIRE(validate(" [ ] "));
+    REQUIRE(validate("0"));
+    REQUIRE(validate(std::string{"\"long ASCII text followed by \xc3\xa6\""}));
+    REQUIRE(validate("\"\xf0\x9f\x98\x80\""));
+    REQUIRE(!validate(""));
+    REQUIRE(!validate("{"));
+    REQUIRE(!validate("[1,]"));
+    REQUIRE(!validate(R"({"a":1,})"));
+    REQUIRE(!validate(R"({"a" 1})"));
+    REQUIRE(!validate(R"({1:1})"));
+    REQUIRE(!validate("[1]]"));
+    REQUIRE(!validate("[}"));
+    REQUIRE(!validate("01"));
+    REQUIRE(!validate("1."));
+    REQUIRE(!validate("-"));
+    REQUIRE(!validate("tru"));
+    REQUIRE(!validate("1 2"));
+    REQUIRE(!validate(R"("\x41")"));
+    REQUIRE(!validate(R"("\u12")"));
+    REQUIRE(!validate("\"a\tb\""));
+    // Invalid UTF-8: a stray continuation byte, an overlong encoding, a
+    // surrogate, a code point beyond U+10FFFF and a truncated sequence.
+    REQUIRE(!validate("\"abcdefgh\x80\""));
+    REQUIRE(!validate("\"\xc0\xaf\""));
+    REQUIRE(!validate("\"\xed\xa0\x80\""));
+    REQUIRE(!validate("\"\xf4\x90\x80\x80\""));
+    REQUIRE(!validate("\"\xe2\x82\""));
+
+    // Nesting beyond the inline stack.
+    std::string deep(5000, '[');
+    deep += std::string(5000, ']');
+    REQUIRE(validate(deep));
+    deep.back() = '}';
+    REQUIRE(!validate(deep));
+
+    parse_options options;
+    options.validate_utf8 = true;
+    REQUIRE(load("\"\xc3\xa6\"", options).as_string() == "\xc3\xa6");
+    REQUIRE(load("\"\xc3\"").as_string() == "\xc3");
+    bool errored{};
+    try {
+        load("{\"\xc3\":1}", options);
+    } catch (const parse_error&) {
+        errored = true;
+    }
+    REQUIRE(errored);
+
+    // Escaped surrogates are checked the same way as when loading.
+    for (const auto* json :
+         {R"("\ud83d\ude00")", R"("\uD83D\uDE00")", R"("\u00e6\ud7ff")",
+          R"("\ud800")", R"("\udc00")", R"("\ud800x")", R"("\ud800\n")",
+          R"("\ud800\u0041")", R"("\ud800\ud800\udc00")",
+          R"(["\ude00\ud83d"])", R"({"\udbff":1})"}) {
+        auto loads{true};
+        try {
+            load(json, options);
+        } catch (const parse_error&) {
+            loads = false;
+        }
+        REQUIRE(validate(json) == loads);
+    }
+    REQUIRE(validate(R"("\udbff\udfff")"));
+    REQUIRE(!validate(R"("\udbff")"));
+}
+
+TEST_CASE("Unescape strings") {
+    using namespace langnes::json;
+    REQUIRE(load(R"("\u000aA")").as_string() == "\nA");
+    REQUIRE(load(R"("\u00e6\u00F8\u00e5")").as_string() ==
+            "\xc3\xa6\xc3\xb8\xc3\xa5");
+    REQUIRE(load(R"("\u4f60\u597d!")").as_string() ==
+            "\xe4\xbd\xa0\xe5\xa5\xbd!");
+    REQUIRE(load(R"("\ud83d\ude00\uD83D\uDC4D")").as_string() ==
+            "\xf0\x9f\x98\x80\xf0\x9f\x91\x8d");
+    REQUIRE(load(R"({"\ud83d\ude00":1})").as_object().count(
+                "\xf0\x9f\x98\x80") == 1);
+    REQUIRE(load(R"("\t\"\\\/\b\f\n\r")").as_string() ==
+            "\t\"\\/\b\f\n\r");
+    // Lone surrogates are kept as they are unless UTF-8 is validated.
+    REQUIRE(load(R"("\ud83d\n")").as_string() == "\xed\xa0\xbd\n");
+    REQUIRE(load(R"("\ude00\ud83d")").as_string() ==
+            "\xed\xb8\x80\xed\xa0\xbd");
+    parse_options options;
+    options.validate_utf8 = true;
+    auto fails = [&](const char* json) {
+        try {
+            load(json, options);
+        } catch (const parse_error&) {
+            return true;
+        }
+        return false;
+    };
+    REQUIRE(!fails(R"("\ud83d\ude00")"));
+    REQUIRE(fails(R"("\ud83d")"));
+    REQUIRE(fails(R"("\ud83dx")"));
+    REQUIRE(fails(R"("\u12")"));
+    REQUIRE(fails(R"("\u12g4")"));
+}
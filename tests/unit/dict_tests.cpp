@@ -0,0 +1,40 @@
+#include "langnes_json/detail/dict.hpp"
+#include "langnes_json/test_driver.hpp"
+
+#include <string>
+
+TEST_CASE("dict") {
+    using namespace langnes::json::detail;
+    SECTION("Keeps insertion order and finds keys") {
+        dict<std::string, int> d;
+        for (int i{}; i < 100; ++i) {
+            d.emplace(std::to_string(i), i);
+        }
+        REQUIRE(d.size() == 100);
+        REQUIRE(d.entry_at(42).first == "42");
+        REQUIRE(d.at("99") == 99);
+        REQUIRE(d.count("100") == 0);
+        REQUIRE(d.find("7") != d.end());
+        // Existing keys keep their values.
+        REQUIRE(!d.emplace("3", 0).second);
+        REQUIRE(d.at("3") == 3);
+    }
+    SECTION("Erasing moves the last entry into the gap") {
+        dict<std::string, int> d;
+        for (int i{}; i < 20; ++i) {
+            d.emplace(std::to_string(i), i);
+        }
+        d.erase("5");
+        REQUIRE(d.size() == 19);
+        REQUIRE(d.count("5") == 0);
+        REQUIRE(d.entry_at(5).first == "19");
+        REQUIRE(d.at("19") == 19);
+        d.erase(d.find("19"));
+        REQUIRE(d.entry_at(5).first == "18");
+        for (int i{}; i < 18; ++i) {
+            REQUIRE(d.count(std::to_string(i)) == (i == 5 ? 0 : 1));
+        }
+        d.erase("missing");
+        REQUIRE(d.size() == 18);
+    }
+}
@@ -0,0 +1,56 @@
+#include "langnes_json/detail/parallel.hpp"
+#include "langnes_json/test_driver.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallel_for") {
+    using namespace langnes::json::detail;
+    auto thread_count = [](size_t count, size_t item_cost) {
+        std::set<std::thread::id> ids;
+        std::mutex mutex;
+        std::vector<int> visited(count);
+        parallel_for(count, item_cost, 8, [&](size_t index) {
+            std::lock_guard<std::mutex> lock{mutex};
+            ids.insert(std::this_thread::get_id());
+            ++visited[index];
+        });
+        for (auto v : visited) {
+            REQUIRE(v == 1);
+        }
+        return ids;
+    };
+    SECTION("Small workloads stay on the calling thread") {
+        auto ids{thread_count(100, 1)};
+        REQUIRE(ids.size() == 1);
+        REQUIRE(*ids.begin() == std::this_thread::get_id());
+        REQUIRE(thread_count(3, parallel_work_per_thread / 2).size() == 1);
+        REQUIRE(thread_count(0, 1).empty());
+        REQUIRE(thread_count(0, 0).empty());
+    }
+    SECTION("Threads are given enough work each") {
+        REQUIRE(thread_count(4, parallel_work_per_thread / 2).size() <= 2);
+        REQUIRE(thread_count(1000, parallel_work_per_thread).size() <= 8);
+    }
+    SECTION("Rethrows the first exception") {
+        std::atomic<size_t> calls{0};
+        auto threw{false};
+        try {
+            parallel_for(16, parallel_work_per_thread, 4, [&](size_t index) {
+                ++calls;
+                if (index == 3) {
+                    throw std::runtime_error{"failed"};
+                }
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        REQUIRE(threw);
+        REQUIRE(calls == 16);
+    }
+}
@@ -0,0 +1,84 @@
+#include "langnes_json/detail/regex.hpp"
+#include "langnes_json/test_driver.hpp"
+
+#include <string>
+
+TEST_CASE("regex") {
+    using namespace langnes::json;
+    using namespace langnes::json::detail;
+    auto search = [](const char* pattern, const std::string& text) {
+        return regex{pattern}.search(text);
+    };
+    SECTION("Literals, anchors and alternation") {
+        REQUIRE(search("", ""));
+        REQUIRE(search("b", "abc"));
+        REQUIRE(!search("^b", "abc"));
+        REQUIRE(search("^a|c$", "xc"));
+        REQUIRE(!search("^(a|c)$", "ac"));
+        REQUIRE(search("^(?:ab|cd)+$", "abcdab"));
+        REQUIRE(search("^(?<name>x)y$", "xy"));
+        REQUIRE(search("\\bfoo\\b", "a foo."));
+        REQUIRE(!search("\\bfoo\\b", "afoo"));
+        REQUIRE(search("\\Boo", "foo"));
+        REQUIRE(search("a{}", "a{}"));
+        REQUIRE(search("^\\$\\.\\\\$", "$.\\"));
+    }
+    SECTION("Quantifiers") {
+        REQUIRE(search("^a*$", ""));
+        REQUIRE(search("^a+?b$", "aab"));
+        REQUIRE(!search("^a+b$", "b"));
+        REQUIRE(search("^ab?c$", "ac"));
+        REQUIRE(search("^a{2}$", "aa"));
+        REQUIRE(!search("^a{2}$", "aaa"));
+        REQUIRE(search("^a{2,}$", "aaaa"));
+        REQUIRE(search("^a{1,3}$", "aaa"));
+        REQUIRE(!search("^a{1,3}$", "aaaa"));
+        REQUIRE(search("^(a*)*$", "aaa"));
+    }
+    SECTION("Character classes") {
+        REQUIRE(search("^[a-c]+$", "abcba"));
+        REQUIRE(!search("^[a-c]+$", "abd"));
+        REQUIRE(search("^[^a-c]$", "d"));
+        REQUIRE(search("^[-a]+$", "-a-"));
+        REQUIRE(search("^[\\d\\s]+$", "1 2\t3"));
+        REQUIRE(!search("\\D", "123"));
+        REQUIRE(search("^\\w+$", "a_1"));
+        REQUIRE(search("^[\\W]$", "-"));
+        REQUIRE(search("^.$", "\xc3\xa6"));
+        REQUIRE(!search("^.$", "\n"));
+        REQUIRE(search("^[\\u00e6-\\u00f8]$", "\xc3\xb8"));
+        REQUIRE(search("^\\ud83d\\ude00$", "\xf0\x9f\x98\x80"));
+        REQUIRE(search("^\\x41\\t$", "A\t"));
+        REQUIRE(!search("[]", "a"));
+    }
+    SECTION("Long texts take linear time without recursion") {
+        std::string text(200000, 'a');
+        REQUIRE(search("^[a-z]*$", text));
+        REQUIRE(search("^(a|aa)*$", text));
+        text += '!';
+        REQUIRE(!search("^(a+)+$", text));
+    }
+    SECTION("Should throw when the pattern is malformed or unsupported") {
+        for (const auto* pattern :
+             {"(", ")", "[a", "a**", "*", "a{2,1}", "\\1", "(?=a)", "(?!a)",
+              "(?<=a)", "\\p{L}", "[z-a]", "^*", "\\", "a{100000}",
+              "((a{100}){100}){100}"}) {
+            bool errored{};
+            try {
+                regex{pattern};
+            } catch (const invalid_argument&) {
+                errored = true;
+            }
+            REQUIRE(errored);
+        }
+        std::string nested(1000, '(');
+        nested.append(1000, ')');
+        bool errored{};
+        try {
+            regex{nested};
+        } catch (const invalid_argument&) {
+            errored = true;
+        }
+        REQUIRE(errored);
+    }
+}
@@ -24,3 +24,14 @@ TEST_CASE("to_utf8_char") {
         REQUIRE(errored);
     }
 }
+
+TEST_CASE("combine_surrogates") {
+    using namespace langnes::json::detail;
+    REQUIRE(is_high_surrogate(0xd83d));
+    REQUIRE(!is_high_surrogate(0xdc00));
+    REQUIRE(is_low_surrogate(0xde00));
+    REQUIRE(!is_low_surrogate(0xdbff));
+    REQUIRE(combine_surrogates(0xd83d, 0xde00) == 0x1f600);
+    REQUIRE(combine_surrogates(0xd800, 0xdc00) == 0x10000);
+    REQUIRE(combine_surrogates(0xdbff, 0xdfff) == 0x10ffff);
+}